@@ -50,6 +50,7 @@ enum_displacement_methods = (
 enum_bvh_layouts = (
     ('BVH2', "BVH2", "", 1),
     ('BVH4', "BVH4", "", 2),
+    ('BVH8', "BVH8", "", 4),
     )
 
 enum_bvh_types = (
@@ -295,6 +296,33 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick mesh lights according to their estimated contribution at the shading point, "
+                            "rather than by their area (less noise in scenes with many mesh lights)",
+                default=False,
+                )
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Automatically stop sampling pixels once their noise is below the threshold, "
+                            "spending samples on the noisier parts of the image instead (CPU only)",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Noise Threshold",
+                description="Noise level at which pixels stop sampling, lower values give less noise "
+                            "but longer render times",
+                min=0.0, max=1.0,
+                default=0.01,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Min Samples",
+                description="Minimum number of samples a pixel takes before adaptive sampling may stop it, "
+                            "zero to use the square root of the number of samples",
+                min=0, max=4096,
+                default=0,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -679,9 +707,10 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_bvh_layout = EnumProperty(
                 name="BVH Layout",
                 items=enum_bvh_layouts,
-                default='BVH4',
+                default='BVH8',
                 )
         cls.debug_use_cpu_split_kernel = BoolProperty(name="Split Kernel", default=False)
+        cls.debug_use_cpu_ray_stream = BoolProperty(name="Ray Stream", default=True)
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
         cls.debug_use_cuda_split_kernel = BoolProperty(name="Split Kernel", default=False)
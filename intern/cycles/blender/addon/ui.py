@@ -172,6 +172,14 @@ class CYCLES_RENDER_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
+        sub.prop(cscene, "use_light_tree")
+
+        sub = col.column(align=True)
+        sub.prop(cscene, "use_adaptive_sampling")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_adaptive_sampling
+        subsub.prop(cscene, "adaptive_threshold")
+        subsub.prop(cscene, "adaptive_min_samples")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
@@ -1625,6 +1633,7 @@ class CYCLES_RENDER_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_bvh_layout")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        col.prop(cscene, "debug_use_cpu_ray_stream")
 
         col.separator()
 
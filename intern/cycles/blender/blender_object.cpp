@@ -344,6 +344,7 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 
 	/* test if we need to sync */
 	bool object_updated = false;
+	bool object_existed = (object_map.find(key) != NULL);
 
 	if(object_map.sync(&object, b_ob, b_parent, key))
 		object_updated = true;
@@ -377,6 +378,9 @@ Object *BlenderSync::sync_object(BL::Object& b_parent,
 	if(object_updated || (object->mesh && object->mesh->need_update) || tfm != object->tfm) {
 		object->name = b_ob.name().c_str();
 		object->pass_id = b_ob.pass_index();
+		if(object_existed && tfm != object->tfm) {
+			object->transform_animated = true;
+		}
 		object->tfm = tfm;
 		object->motion.clear();
 
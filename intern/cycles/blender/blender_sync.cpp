@@ -285,6 +285,16 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
 
+	bool use_light_tree = get_boolean(cscene, "use_light_tree");
+	if(integrator->use_light_tree != use_light_tree) {
+		scene->light_manager->tag_update(scene);
+	}
+	integrator->use_light_tree = use_light_tree;
+
+	integrator->use_adaptive_sampling = get_boolean(cscene, "use_adaptive_sampling");
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
+
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
 	int transmission_samples = get_int(cscene, "transmission_samples");
@@ -616,6 +626,15 @@ array<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 		Pass::add(PASS_VOLUME_INDIRECT, passes);
 	}
 
+	/* Internal passes for adaptive sampling, not exposed to Blender. */
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
+	if(get_boolean(cscene, "use_adaptive_sampling") &&
+	   session_params.device.has_adaptive_sampling)
+	{
+		Pass::add(PASS_ADAPTIVE_AUX_BUFFER, passes);
+		Pass::add(PASS_SAMPLE_COUNT, passes);
+	}
+
 	return passes;
 }
 
@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -38,6 +39,7 @@ const char *bvh_layout_name(BVHLayout layout)
 	switch(layout) {
 		case BVH_LAYOUT_BVH2: return "BVH2";
 		case BVH_LAYOUT_BVH4: return "BVH4";
+		case BVH_LAYOUT_BVH8: return "BVH8";
 		case BVH_LAYOUT_NONE: return "NONE";
 		case BVH_LAYOUT_ALL:  return "ALL";
 	}
@@ -83,6 +85,9 @@ int BVHStackEntry::encodeIdx() const
 BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 : params(params_), objects(objects_)
 {
+	top_level_nodes_size = 0;
+	top_level_leaf_nodes_size = 0;
+	top_level_prims_size = 0;
 }
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
@@ -92,6 +97,8 @@ BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 			return new BVH2(params, objects);
 		case BVH_LAYOUT_BVH4:
 			return new BVH4(params, objects);
+		case BVH_LAYOUT_BVH8:
+			return new BVH8(params, objects);
 		case BVH_LAYOUT_NONE:
 		case BVH_LAYOUT_ALL:
 			break;
@@ -151,6 +158,18 @@ void BVH::refit(Progress& progress)
 	refit_nodes();
 }
 
+void BVH::refit_top_level(Progress& progress)
+{
+	/* Only nodes of the top level are refitted to the current object bounds,
+	 * primitives and the merged instance BVHs are left as they are. */
+	assert(params.top_level);
+
+	if(progress.get_cancel()) return;
+
+	progress.set_substatus("Refitting top level BVH nodes");
+	refit_nodes();
+}
+
 void BVH::refit_primitives(int start, int end, BoundBox& bbox, uint& visibility)
 {
 	/* Refit range of primitives. */
@@ -291,8 +310,12 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * BVH's are stored in global arrays. This function merges them into the
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
-	/* TODO(sergey): This code needs adjustment for wider BVH than 4. */
 	const bool use_qbvh = (params.bvh_layout == BVH_LAYOUT_BVH4);
+	const bool use_obvh = (params.bvh_layout == BVH_LAYOUT_BVH8);
+
+	top_level_nodes_size = nodes_size;
+	top_level_leaf_nodes_size = leaf_nodes_size;
+	top_level_prims_size = pack.prim_index.size();
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -469,14 +492,26 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
 				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-					nsize = use_qbvh
-					            ? BVH_UNALIGNED_QNODE_SIZE
-					            : BVH_UNALIGNED_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 13: 0;
+					if(use_obvh) {
+						nsize = BVH_UNALIGNED_ONODE_SIZE;
+						nsize_bbox = 26;
+					}
+					else {
+						nsize = use_qbvh
+						            ? BVH_UNALIGNED_QNODE_SIZE
+						            : BVH_UNALIGNED_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 13: 0;
+					}
 				}
 				else {
-					nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 7: 0;
+					if(use_obvh) {
+						nsize = BVH_ONODE_SIZE;
+						nsize_bbox = 14;
+					}
+					else {
+						nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 7: 0;
+					}
 				}
 
 				memcpy(pack_nodes + pack_nodes_offset,
@@ -489,7 +524,7 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				data.z += (data.z < 0)? -noffset_leaf: noffset;
 				data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
+				if(use_qbvh || use_obvh) {
 					data.x += (data.x < 0)? -noffset_leaf: noffset;
 					data.y += (data.y < 0)? -noffset_leaf: noffset;
 				}
@@ -503,6 +538,16 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				       &bvh_nodes[i + nsize_bbox+1],
 				       sizeof(int4) * (nsize - (nsize_bbox+1)));
 
+				/* Octo nodes have children indices split across two slots. */
+				if(use_obvh) {
+					int4 data1 = bvh_nodes[i + nsize_bbox + 1];
+					data1.x += (data1.x < 0)? -noffset_leaf: noffset;
+					data1.y += (data1.y < 0)? -noffset_leaf: noffset;
+					data1.z += (data1.z < 0)? -noffset_leaf: noffset;
+					data1.w += (data1.w < 0)? -noffset_leaf: noffset;
+					pack_nodes[pack_nodes_offset + nsize_bbox + 1] = data1;
+				}
+
 				pack_nodes_offset += nsize;
 				i += nsize;
 			}
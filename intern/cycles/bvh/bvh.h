@@ -82,11 +82,18 @@ public:
 	BVHParams params;
 	vector<Object*> objects;
 
+	/* Size of the top level part of the packed arrays, instance BVHs are
+	 * merged in after it. */
+	size_t top_level_nodes_size;
+	size_t top_level_leaf_nodes_size;
+	size_t top_level_prims_size;
+
 	static BVH *create(const BVHParams& params, const vector<Object*>& objects);
 	virtual ~BVH() {}
 
 	void build(Progress& progress);
 	void refit(Progress& progress);
+	void refit_top_level(Progress& progress);
 
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
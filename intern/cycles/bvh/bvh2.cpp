@@ -237,8 +237,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -253,7 +251,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		const int c0 = data[0].x;
 		const int c1 = data[0].y;
 
-		BVH::refit_primitives(c0, c1, bbox, visibility);
+		if(c0 < 0) {
+			/* Object instance leaf of the top level BVH. */
+			BVH::refit_primitives(~c0, ~c0 + 1, bbox, visibility);
+		}
+		else {
+			BVH::refit_primitives(c0, c1, bbox, visibility);
+		}
 
 		/* TODO(sergey): De-duplicate with pack_leaf(). */
 		float4 leaf_data[BVH_NODE_LEAF_SIZE];
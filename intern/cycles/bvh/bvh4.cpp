@@ -365,8 +365,6 @@ void BVH4::pack_nodes(const BVHNode *root)
 
 void BVH4::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -379,7 +377,13 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		int4 *data = &pack.leaf_nodes[idx];
 		int4 c = data[0];
 
-		BVH::refit_primitives(c.x, c.y, bbox, visibility);
+		if(c.x < 0) {
+			/* Object instance leaf of the top level BVH. */
+			BVH::refit_primitives(~c.x, ~c.x + 1, bbox, visibility);
+		}
+		else {
+			BVH::refit_primitives(c.x, c.y, bbox, visibility);
+		}
 
 		/* TODO(sergey): This is actually a copy of pack_leaf(),
 		 * but this chunk of code only knows actual data and has
@@ -125,6 +125,56 @@ int BVHNode::getSubtreeSize(BVH_STAT stat) const
 				cnt += has_unaligned? 1: 0;
 			}
 			return cnt;
+		case BVH_STAT_ONODE_COUNT:
+			cnt = 1;
+			for(int i = 0; i < num_children(); i++) {
+				BVHNode *node = get_child(i);
+				if(node->is_leaf()) {
+					cnt += 1;
+					continue;
+				}
+				for(int j = 0; j < node->num_children(); j++) {
+					BVHNode *node_j = node->get_child(j);
+					if(node_j->is_leaf()) {
+						cnt += 1;
+						continue;
+					}
+					for(int k = 0; k < node_j->num_children(); k++) {
+						cnt += node_j->get_child(k)->getSubtreeSize(stat);
+					}
+				}
+			}
+			return cnt;
+		case BVH_STAT_ALIGNED_INNER_ONODE_COUNT:
+		case BVH_STAT_UNALIGNED_INNER_ONODE_COUNT:
+			{
+				bool has_unaligned = false;
+				for(int i = 0; i < num_children(); i++) {
+					BVHNode *node = get_child(i);
+					if(node->is_leaf()) {
+						has_unaligned |= node->is_unaligned;
+						continue;
+					}
+					for(int j = 0; j < node->num_children(); j++) {
+						BVHNode *node_j = node->get_child(j);
+						if(node_j->is_leaf()) {
+							has_unaligned |= node_j->is_unaligned;
+							continue;
+						}
+						for(int k = 0; k < node_j->num_children(); k++) {
+							cnt += node_j->get_child(k)->getSubtreeSize(stat);
+							has_unaligned |= node_j->get_child(k)->is_unaligned;
+						}
+					}
+				}
+				if(stat == BVH_STAT_UNALIGNED_INNER_ONODE_COUNT) {
+					cnt += has_unaligned? 1: 0;
+				}
+				else {
+					cnt += has_unaligned? 0: 1;
+				}
+			}
+			return cnt;
 		case BVH_STAT_ALIGNED_LEAF_COUNT:
 			cnt = (is_leaf() && !is_unaligned) ? 1 : 0;
 			break;
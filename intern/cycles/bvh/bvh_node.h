@@ -36,6 +36,9 @@ enum BVH_STAT {
 	BVH_STAT_UNALIGNED_INNER_COUNT,
 	BVH_STAT_ALIGNED_INNER_QNODE_COUNT,
 	BVH_STAT_UNALIGNED_INNER_QNODE_COUNT,
+	BVH_STAT_ONODE_COUNT,
+	BVH_STAT_ALIGNED_INNER_ONODE_COUNT,
+	BVH_STAT_UNALIGNED_INNER_ONODE_COUNT,
 	BVH_STAT_ALIGNED_LEAF_COUNT,
 	BVH_STAT_UNALIGNED_LEAF_COUNT,
 	BVH_STAT_DEPTH,
@@ -175,6 +175,9 @@ public:
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>             path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int, int)>   path_trace_stream_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int, int)>        adaptive_stopping_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int, int, int)>   adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)> convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, int, int, int, int, int)>   shader_kernel;
@@ -212,6 +215,9 @@ public:
 	  texture_info(this, "__texture_info", MEM_TEXTURE),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(path_trace_stream),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -691,6 +697,7 @@ public:
 		float *render_buffer = (float*)tile.buffer;
 		int start_sample = tile.start_sample;
 		int end_sample = tile.start_sample + tile.num_samples;
+		bool use_ray_stream = DebugFlags().cpu.ray_stream;
 
 		for(int sample = start_sample; sample < end_sample; sample++) {
 			if(task.get_cancel() || task_pool.canceled()) {
@@ -698,16 +705,47 @@ public:
 					break;
 			}
 
-			for(int y = tile.y; y < tile.y + tile.h; y++) {
-				for(int x = tile.x; x < tile.x + tile.w; x++) {
-					path_trace_kernel()(kg, render_buffer,
-					                    sample, x, y, tile.offset, tile.stride);
+			if(use_ray_stream) {
+				path_trace_stream_kernel()(kg, render_buffer, sample,
+				                           tile.x, tile.y, tile.w, tile.h,
+				                           tile.offset, tile.stride);
+			}
+			else {
+				for(int y = tile.y; y < tile.y + tile.h; y++) {
+					for(int x = tile.x; x < tile.x + tile.w; x++) {
+						path_trace_kernel()(kg, render_buffer,
+						                    sample, x, y, tile.offset, tile.stride);
+					}
 				}
 			}
 
 			tile.sample = sample + 1;
 
 			task.update_progress(&tile, tile.w*tile.h);
+
+			/* Stop once all pixels in the tile converged, the tile manager then
+			 * hands out the next tile to this thread. Also done for the last
+			 * sample, progressive and viewport renders take one sample per call,
+			 * converged pixels are then skipped by the following calls. */
+			if(task.adaptive_sampling &&
+			   tile.sample >= task.adaptive_min_samples &&
+			   tile.sample % task.adaptive_step == 0)
+			{
+				bool any = adaptive_stopping_kernel()(kg, render_buffer,
+				                                      tile.x, tile.y, tile.w, tile.h,
+				                                      tile.offset, tile.stride);
+				if(!any) {
+					tile.sample = end_sample;
+					task.update_progress(&tile, tile.w*tile.h*(end_sample - sample - 1));
+					break;
+				}
+			}
+		}
+
+		if(task.adaptive_sampling) {
+			adaptive_adjust_samples_kernel()(kg, render_buffer, tile.sample,
+			                                 tile.x, tile.y, tile.w, tile.h,
+			                                 tile.offset, tile.stride);
 		}
 	}
 
@@ -1050,7 +1088,14 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	if (system_cpu_support_sse2()) {
 		info.bvh_layout_mask |= BVH_LAYOUT_BVH4;
 	}
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	/* Octo BVH traversal is only compiled into the AVX2 kernel. */
+	if (DebugFlags().cpu.has_avx2() && system_cpu_support_avx2()) {
+		info.bvh_layout_mask |= BVH_LAYOUT_BVH8;
+	}
+#endif
 	info.has_volume_decoupled = true;
+	info.has_adaptive_sampling = true;
 	info.has_osl = true;
 	info.has_half_images = true;
 
@@ -135,6 +135,7 @@ void device_opencl_info(vector<DeviceInfo>& devices)
 		info.use_split_kernel = OpenCLInfo::kernel_use_split(platform_name,
 		                                                     device_type);
 		info.has_volume_decoupled = false;
+		info.has_adaptive_sampling = false;
 		info.bvh_layout_mask = BVH_LAYOUT_BVH2;
 		info.id = id;
 		devices.push_back(info);
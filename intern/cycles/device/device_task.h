@@ -79,6 +79,10 @@ public:
 	bool need_finish_queue;
 	bool integrator_branched;
 	int2 requested_tile_size;
+
+	bool adaptive_sampling;
+	int adaptive_min_samples;
+	int adaptive_step;
 protected:
 	double last_update_time;
 };
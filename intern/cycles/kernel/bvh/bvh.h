@@ -34,6 +34,11 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -337,6 +342,11 @@ ccl_device_intersect uint scene_intersect_volume_all(KernelGlobals *kg,
 }
 #endif  /* __VOLUME_RECORD_ALL__ */
 
+/* Ray stream traversal */
+
+#ifdef __RAY_STREAM__
+#  include "kernel/bvh/bvh_stream.h"
+#endif
 
 /* Ray offset to avoid self intersection.
  *
@@ -0,0 +1,317 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Ray stream traversal of wide BVH.
+ *
+ * Instead of traversing the BVH once per ray, a stream of coherent rays (such
+ * as camera rays of neighbour pixels) traverses it together. Every visited
+ * node is fetched once and its child boxes are tested against packets of four
+ * rays, which are stored as structure of arrays. Each stack entry carries the
+ * mask of rays which entered the node, so rays which miss a child drop out of
+ * its subtree without affecting others.
+ *
+ * Only supports scenes where all geometry is in the top level BVH and made of
+ * static triangles, other scenes are to use single ray traversal.
+ */
+
+/* Streams hold rays of square blocks of pixels. */
+#define RAY_STREAM_BLOCK_SIZE 8
+#define RAY_STREAM_SIZE (RAY_STREAM_BLOCK_SIZE * RAY_STREAM_BLOCK_SIZE)
+#define RAY_STREAM_PACKETS (RAY_STREAM_SIZE / 4)
+
+typedef struct RayStream {
+	/* Ray origin, direction and inverse direction, four rays per packet. */
+	ssef P_x[RAY_STREAM_PACKETS], P_y[RAY_STREAM_PACKETS], P_z[RAY_STREAM_PACKETS];
+	ssef dir_x[RAY_STREAM_PACKETS], dir_y[RAY_STREAM_PACKETS], dir_z[RAY_STREAM_PACKETS];
+	ssef idir_x[RAY_STREAM_PACKETS], idir_y[RAY_STREAM_PACKETS], idir_z[RAY_STREAM_PACKETS];
+#ifdef __KERNEL_AVX2__
+	ssef P_idir_x[RAY_STREAM_PACKETS], P_idir_y[RAY_STREAM_PACKETS], P_idir_z[RAY_STREAM_PACKETS];
+#endif
+	/* Distance to the closest intersection found so far. */
+	ssef t[RAY_STREAM_PACKETS];
+} RayStream;
+
+typedef struct RayStreamStackItem {
+	int addr;
+	float dist;
+	uint64_t ray_mask;
+} RayStreamStackItem;
+
+#ifdef __OBVH__
+#  define RAY_STREAM_STACK_SIZE BVH_OSTACK_SIZE
+#else
+#  define RAY_STREAM_STACK_SIZE BVH_QSTACK_SIZE
+#endif
+
+ccl_device_inline bool scene_intersect_stream_supported(KernelGlobals *kg)
+{
+#ifdef __KERNEL_DEBUG__
+	/* Traversal statistics are only gathered by single ray traversal. */
+	return false;
+#else
+	if(kernel_data.bvh.have_motion ||
+	   kernel_data.bvh.have_curves ||
+	   kernel_data.bvh.have_instancing)
+	{
+		return false;
+	}
+#  ifdef __OBVH__
+	if(kernel_data.bvh.bvh_layout == BVH_LAYOUT_BVH8) {
+		return true;
+	}
+#  endif
+	return kernel_data.bvh.bvh_layout == BVH_LAYOUT_BVH4;
+#endif  /* __KERNEL_DEBUG__ */
+}
+
+/* Test rays of the mask against all children of an inner node, and push hit
+ * children together with their ray masks, closest one on top of the stack.
+ *
+ * Aligned QBVH and OBVH nodes store the same rows of child bounds followed by
+ * child indices, only differing in number of children per row.
+ */
+ccl_device_inline void ray_stream_inner_node(const RayStream *stream,
+                                             const uint64_t ray_mask,
+                                             const float *rows,
+                                             const int width,
+                                             RayStreamStackItem *traversal_stack,
+                                             int *stack_ptr)
+{
+	/* Gather packets with active rays once for all children. */
+	int packets[RAY_STREAM_PACKETS];
+	int packet_masks[RAY_STREAM_PACKETS];
+	int num_packets = 0;
+	for(int packet = 0; packet < RAY_STREAM_PACKETS; packet++) {
+		const int packet_mask = (int)(ray_mask >> (packet * 4)) & 0xf;
+		if(packet_mask != 0) {
+			packets[num_packets] = packet;
+			packet_masks[num_packets] = packet_mask;
+			num_packets++;
+		}
+	}
+
+	const int stack_base = *stack_ptr;
+
+	for(int c = 0; c < width; c++) {
+		const int child = __float_as_int(rows[6*width + c]);
+		/* Unused child slots point to the root. */
+		if(child == 0) {
+			continue;
+		}
+
+		const ssef min_x(rows[0*width + c]), max_x(rows[1*width + c]);
+		const ssef min_y(rows[2*width + c]), max_y(rows[3*width + c]);
+		const ssef min_z(rows[4*width + c]), max_z(rows[5*width + c]);
+
+		uint64_t child_mask = 0;
+		ssef child_dist(FLT_MAX);
+
+		for(int i = 0; i < num_packets; i++) {
+			const int packet = packets[i];
+#ifdef __KERNEL_AVX2__
+			const ssef tx0 = msub(min_x, stream->idir_x[packet], stream->P_idir_x[packet]);
+			const ssef tx1 = msub(max_x, stream->idir_x[packet], stream->P_idir_x[packet]);
+			const ssef ty0 = msub(min_y, stream->idir_y[packet], stream->P_idir_y[packet]);
+			const ssef ty1 = msub(max_y, stream->idir_y[packet], stream->P_idir_y[packet]);
+			const ssef tz0 = msub(min_z, stream->idir_z[packet], stream->P_idir_z[packet]);
+			const ssef tz1 = msub(max_z, stream->idir_z[packet], stream->P_idir_z[packet]);
+#else
+			const ssef tx0 = (min_x - stream->P_x[packet]) * stream->idir_x[packet];
+			const ssef tx1 = (max_x - stream->P_x[packet]) * stream->idir_x[packet];
+			const ssef ty0 = (min_y - stream->P_y[packet]) * stream->idir_y[packet];
+			const ssef ty1 = (max_y - stream->P_y[packet]) * stream->idir_y[packet];
+			const ssef tz0 = (min_z - stream->P_z[packet]) * stream->idir_z[packet];
+			const ssef tz1 = (max_z - stream->P_z[packet]) * stream->idir_z[packet];
+#endif
+
+			const ssef tnear = max4(min(tx0, tx1), min(ty0, ty1), min(tz0, tz1), ssef(0.0f));
+			const ssef tfar = min4(max(tx0, tx1), max(ty0, ty1), max(tz0, tz1), stream->t[packet]);
+			const int hit = (int)movemask(tnear <= tfar) & packet_masks[i];
+
+			if(hit != 0) {
+				child_mask |= (uint64_t)hit << (packet * 4);
+				child_dist = min(child_dist, select(sseb(hit), tnear, ssef(FLT_MAX)));
+			}
+		}
+
+		if(child_mask == 0) {
+			continue;
+		}
+
+		/* Insertion sort of pushed children, so closest one is traversed first. */
+		const float dist = reduce_min(child_dist);
+		int i = ++(*stack_ptr);
+		kernel_assert(i < RAY_STREAM_STACK_SIZE);
+		while(i > stack_base + 1 && traversal_stack[i - 1].dist < dist) {
+			traversal_stack[i] = traversal_stack[i - 1];
+			i--;
+		}
+		traversal_stack[i].addr = child;
+		traversal_stack[i].dist = dist;
+		traversal_stack[i].ray_mask = child_mask;
+	}
+}
+
+ccl_device_inline void ray_stream_leaf(KernelGlobals *kg,
+                                       RayStream *stream,
+                                       Intersection *isect,
+                                       const uint64_t ray_mask,
+                                       const int leaf_addr,
+                                       const uint visibility)
+{
+	const float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, leaf_addr);
+#ifdef __VISIBILITY_FLAG__
+	if((__float_as_uint(leaf.z) & visibility) == 0) {
+		return;
+	}
+#endif
+
+	const int prim_addr_start = __float_as_int(leaf.x);
+	const int prim_addr_end = __float_as_int(leaf.y);
+	kernel_assert((__float_as_int(leaf.w) & PRIMITIVE_ALL) == PRIMITIVE_TRIANGLE);
+
+	for(int packet = 0; packet < RAY_STREAM_PACKETS; packet++) {
+		unsigned int packet_mask = (unsigned int)(ray_mask >> (packet * 4)) & 0xf;
+		while(packet_mask != 0) {
+			const int lane = __bscf(packet_mask);
+			const int ray_index = packet * 4 + lane;
+			const float3 P = make_float3(stream->P_x[packet][lane],
+			                             stream->P_y[packet][lane],
+			                             stream->P_z[packet][lane]);
+			const float3 dir = make_float3(stream->dir_x[packet][lane],
+			                               stream->dir_y[packet][lane],
+			                               stream->dir_z[packet][lane]);
+			for(int prim_addr = prim_addr_start; prim_addr < prim_addr_end; prim_addr++) {
+				kernel_assert(kernel_tex_fetch(__prim_type, prim_addr) == __float_as_uint(leaf.w));
+				triangle_intersect(kg,
+				                   &isect[ray_index],
+				                   P,
+				                   dir,
+				                   visibility,
+				                   OBJECT_NONE,
+				                   prim_addr);
+			}
+			stream->t[packet][lane] = isect[ray_index].t;
+		}
+	}
+}
+
+/* Find closest intersection for every ray of the stream, same as calling
+ * scene_intersect() for each of them. Requires scene_intersect_stream_supported().
+ */
+ccl_device void scene_intersect_stream(KernelGlobals *kg,
+                                       const Ray *rays,
+                                       const int num_rays,
+                                       const uint visibility,
+                                       Intersection *isect)
+{
+	kernel_assert(num_rays <= RAY_STREAM_SIZE);
+
+	RayStream stream;
+	uint64_t ray_mask = 0;
+
+	for(int packet = 0; packet < RAY_STREAM_PACKETS; packet++) {
+		for(int lane = 0; lane < 4; lane++) {
+			const int ray_index = packet * 4 + lane;
+			float3 P = make_float3(0.0f, 0.0f, 0.0f);
+			float3 dir = make_float3(1.0f, 1.0f, 1.0f);
+			float t = -FLT_MAX;
+
+			if(ray_index < num_rays) {
+				const Ray *ray = &rays[ray_index];
+				isect[ray_index].t = ray->t;
+				isect[ray_index].u = 0.0f;
+				isect[ray_index].v = 0.0f;
+				isect[ray_index].prim = PRIM_NONE;
+				isect[ray_index].object = OBJECT_NONE;
+
+				if(isfinite(ray->P.x)) {
+					P = ray->P;
+					dir = bvh_clamp_direction(ray->D);
+					t = ray->t;
+					ray_mask |= (uint64_t)1 << ray_index;
+				}
+			}
+
+			const float3 idir = bvh_inverse_direction(dir);
+			stream.P_x[packet][lane] = P.x;
+			stream.P_y[packet][lane] = P.y;
+			stream.P_z[packet][lane] = P.z;
+			stream.dir_x[packet][lane] = dir.x;
+			stream.dir_y[packet][lane] = dir.y;
+			stream.dir_z[packet][lane] = dir.z;
+			stream.idir_x[packet][lane] = idir.x;
+			stream.idir_y[packet][lane] = idir.y;
+			stream.idir_z[packet][lane] = idir.z;
+#ifdef __KERNEL_AVX2__
+			stream.P_idir_x[packet][lane] = P.x * idir.x;
+			stream.P_idir_y[packet][lane] = P.y * idir.y;
+			stream.P_idir_z[packet][lane] = P.z * idir.z;
+#endif
+			stream.t[packet][lane] = t;
+		}
+	}
+
+	if(ray_mask == 0) {
+		return;
+	}
+
+	RayStreamStackItem traversal_stack[RAY_STREAM_STACK_SIZE];
+	int stack_ptr = 0;
+	traversal_stack[0].addr = kernel_data.bvh.root;
+	traversal_stack[0].dist = 0.0f;
+	traversal_stack[0].ray_mask = ray_mask;
+
+	while(stack_ptr >= 0) {
+		const int node_addr = traversal_stack[stack_ptr].addr;
+		const uint64_t node_ray_mask = traversal_stack[stack_ptr].ray_mask;
+		--stack_ptr;
+
+		if(node_addr < 0) {
+			ray_stream_leaf(kg, &stream, isect, node_ray_mask, -node_addr-1, visibility);
+			continue;
+		}
+
+#ifdef __VISIBILITY_FLAG__
+		const float4 inodes = kernel_tex_fetch(__bvh_nodes, node_addr);
+		if((__float_as_uint(inodes.x) & visibility) == 0) {
+			continue;
+		}
+#endif
+
+		/* Child bounds rows start after node header. */
+		const float *rows;
+		int width;
+#ifdef __OBVH__
+		if(kernel_data.bvh.bvh_layout == BVH_LAYOUT_BVH8) {
+			rows = (const float*)&kernel_tex_fetch(__bvh_nodes, node_addr+2);
+			width = 8;
+		}
+		else
+#endif
+		{
+			rows = (const float*)&kernel_tex_fetch(__bvh_nodes, node_addr+1);
+			width = 4;
+		}
+
+		ray_stream_inner_node(&stream,
+		                      node_ray_mask,
+		                      rows,
+		                      width,
+		                      traversal_stack,
+		                      &stack_ptr);
+	}
+}
@@ -0,0 +1,173 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_ADAPTIVE_SAMPLING_H__
+#define __KERNEL_ADAPTIVE_SAMPLING_H__
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive Sampling
+ *
+ * Pixels stop sampling once the combined pass and the auxiliary buffer, which
+ * holds only every second sample, agree within the noise threshold. See
+ * "A Hierarchical Automatic Stopping Condition for Monte Carlo Global
+ * Illumination" by Dammertz et al.
+ *
+ * The alpha channel of the auxiliary buffer flags converged pixels. */
+
+ccl_device_inline ccl_global float *kernel_adaptive_pixel_buffer(KernelGlobals *kg,
+                                                                 ccl_global float *buffer,
+                                                                 int x, int y,
+                                                                 int offset, int stride)
+{
+	return buffer + (offset + x + y*stride)*kernel_data.film.pass_stride;
+}
+
+/* Per pixel convergence test. */
+ccl_device void kernel_adaptive_stopping(KernelGlobals *kg,
+                                         ccl_global float *buffer)
+{
+	ccl_global float *aux = buffer + kernel_data.film.pass_adaptive_aux_buffer;
+	if(aux[3] != 0.0f) {
+		return;
+	}
+
+	const float num_samples = buffer[kernel_data.film.pass_sample_count];
+	const float num_half_samples = floorf(num_samples*0.5f);
+	if(num_half_samples == 0.0f) {
+		return;
+	}
+
+	/* Scale the auxiliary buffer to the same number of samples as the
+	 * combined pass, the error is relative to the square root of the
+	 * intensity to match perceived noise. */
+	const float3 I = make_float3(buffer[0], buffer[1], buffer[2]);
+	const float3 A = make_float3(aux[0], aux[1], aux[2])*(num_samples/num_half_samples);
+	const float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	                    (num_samples*0.0001f + sqrtf(max(I.x + I.y + I.z, 0.0f)));
+
+	if(error < kernel_data.integrator.adaptive_threshold*num_samples) {
+		aux[3] = 1.0f;
+	}
+}
+
+/* Mark neighbors of unconverged pixels as unconverged along a row, so noisy
+ * regions don't leave isolated pixels behind. Returns true when any pixel in
+ * the row is not converged. */
+ccl_device bool kernel_adaptive_filter_x(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int y, int x, int w,
+                                         int offset, int stride)
+{
+	const int aux_offset = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int px = x; px < x + w; px++) {
+		ccl_global float *pixel = kernel_adaptive_pixel_buffer(kg, buffer, px, y, offset, stride);
+
+		if(pixel[aux_offset] == 0.0f) {
+			any = true;
+			if(px > x && !prev) {
+				ccl_global float *left = kernel_adaptive_pixel_buffer(kg, buffer, px - 1, y, offset, stride);
+				left[aux_offset] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_offset] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+/* Same as above, along a column. */
+ccl_device bool kernel_adaptive_filter_y(KernelGlobals *kg,
+                                         ccl_global float *buffer,
+                                         int x, int y, int h,
+                                         int offset, int stride)
+{
+	const int aux_offset = kernel_data.film.pass_adaptive_aux_buffer + 3;
+	bool any = false;
+	bool prev = false;
+
+	for(int py = y; py < y + h; py++) {
+		ccl_global float *pixel = kernel_adaptive_pixel_buffer(kg, buffer, x, py, offset, stride);
+
+		if(pixel[aux_offset] == 0.0f) {
+			any = true;
+			if(py > y && !prev) {
+				ccl_global float *top = kernel_adaptive_pixel_buffer(kg, buffer, x, py - 1, offset, stride);
+				top[aux_offset] = 0.0f;
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				pixel[aux_offset] = 0.0f;
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+/* Pixels that stopped early hold fewer samples than the rest of the tile.
+ * Scale their passes up to the given number of samples, so the buffer can be
+ * normalized by the tile sample count as usual. Passes that are written only
+ * for the first sample are left untouched. */
+ccl_device void kernel_adaptive_adjust_samples(KernelGlobals *kg,
+                                               ccl_global float *buffer,
+                                               int sample)
+{
+	const int sample_count_offset = kernel_data.film.pass_sample_count;
+	const float num_samples = buffer[sample_count_offset];
+
+	if(num_samples == 0.0f || num_samples >= (float)sample) {
+		return;
+	}
+
+	const int flag = kernel_data.film.pass_flag;
+	const int depth_offset = (flag & PASSMASK(DEPTH))? kernel_data.film.pass_depth: -1;
+	const int object_id_offset = (flag & PASSMASK(OBJECT_ID))? kernel_data.film.pass_object_id: -1;
+	const int material_id_offset = (flag & PASSMASK(MATERIAL_ID))? kernel_data.film.pass_material_id: -1;
+	const int converged_offset = kernel_data.film.pass_adaptive_aux_buffer + 3;
+
+	const float scale = (float)sample/num_samples;
+
+	for(int i = 0; i < kernel_data.film.pass_stride; i++) {
+		if(i == depth_offset ||
+		   i == object_id_offset ||
+		   i == material_id_offset ||
+		   i == sample_count_offset ||
+		   i == converged_offset)
+		{
+			continue;
+		}
+		buffer[i] *= scale;
+	}
+
+	buffer[sample_count_offset] = (float)sample;
+}
+
+CCL_NAMESPACE_END
+
+#endif /* __KERNEL_ADAPTIVE_SAMPLING_H__ */
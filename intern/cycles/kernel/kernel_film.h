@@ -45,6 +45,20 @@ ccl_device uchar4 film_float_to_byte(float4 color)
 	return result;
 }
 
+/* With adaptive sampling, pixels may hold fewer samples than the tile. */
+ccl_device_inline float film_sample_scale(KernelGlobals *kg,
+                                          ccl_global float *buffer,
+                                          float sample_scale)
+{
+	if(kernel_data.film.pass_sample_count) {
+		const float num_samples = buffer[kernel_data.film.pass_sample_count];
+		if(num_samples > 0.0f) {
+			return 1.0f/num_samples;
+		}
+	}
+	return sample_scale;
+}
+
 ccl_device void kernel_film_convert_to_byte(KernelGlobals *kg,
 	ccl_global uchar4 *rgba, ccl_global float *buffer,
 	float sample_scale, int x, int y, int offset, int stride)
@@ -54,6 +68,7 @@ ccl_device void kernel_film_convert_to_byte(KernelGlobals *kg,
 
 	rgba += index;
 	buffer += index*kernel_data.film.pass_stride;
+	sample_scale = film_sample_scale(kg, buffer, sample_scale);
 
 	/* map colors */
 	float4 irradiance = *((ccl_global float4*)buffer);
@@ -70,7 +85,10 @@ ccl_device void kernel_film_convert_to_half_float(KernelGlobals *kg,
 	/* buffer offset */
 	int index = offset + x + y*stride;
 
-	ccl_global float4 *in = (ccl_global float4*)(buffer + index*kernel_data.film.pass_stride);
+	buffer += index*kernel_data.film.pass_stride;
+	sample_scale = film_sample_scale(kg, buffer, sample_scale);
+
+	ccl_global float4 *in = (ccl_global float4*)buffer;
 	ccl_global half *out = (ccl_global half*)rgba + index*4;
 
 	float exposure = kernel_data.film.exposure;
@@ -773,6 +773,123 @@ ccl_device bool lamp_light_eval(KernelGlobals *kg, int lamp, float3 P, float3 D,
 	return true;
 }
 
+/* Light Tree */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int index, float3 P)
+{
+	/* Estimated contribution of the emitters in the node to P, from their
+	 * power, distance and the bounds of their orientation, see
+	 * "Importance Sampling of Many Lights with Adaptive Tree Splitting"
+	 * by Conty and Kulla. */
+	const ccl_global KernelLightTreeNode *knode = &kernel_tex_fetch(__light_tree_nodes, index);
+
+	if(knode->energy == 0.0f)
+		return 0.0f;
+
+	const float3 bounds_min = make_float3(knode->bounds_min[0], knode->bounds_min[1], knode->bounds_min[2]);
+	const float3 bounds_max = make_float3(knode->bounds_max[0], knode->bounds_max[1], knode->bounds_max[2]);
+	const float radius_squared = 0.25f*len_squared(bounds_max - bounds_min);
+
+	const float3 V = P - 0.5f*(bounds_min + bounds_max);
+	const float distance_squared = len_squared(V);
+
+	/* Inside the bounding sphere emitters may face P from any direction,
+	 * clamp the distance to avoid the singularity. */
+	if(distance_squared <= radius_squared)
+		return knode->energy/max(radius_squared, 1e-8f);
+
+	const float3 axis = make_float3(knode->axis[0], knode->axis[1], knode->axis[2]);
+	const float distance = sqrtf(distance_squared);
+
+	/* Emitters are two-sided, so is their orientation cone. */
+	const float theta = safe_acosf(fabsf(dot(axis, V))/distance);
+	const float theta_u = safe_asinf(sqrtf(radius_squared/distance_squared));
+	const float theta_i = theta - knode->theta_o - theta_u;
+
+	if(theta_i >= M_PI_2_F)
+		return 0.0f;
+
+	const float cos_theta_i = (theta_i > 0.0f)? cosf(theta_i): 1.0f;
+	return knode->energy*cos_theta_i/distance_squared;
+}
+
+/* Pick a leaf by descending the tree, choosing children proportional to
+ * their importance at P. Returns the index into the light distribution, and
+ * rescales randu to be reused for sampling the emitter. */
+ccl_device int light_tree_sample(KernelGlobals *kg, float3 P, float *randu, float *pdf)
+{
+	float r = *randu;
+	float tree_pdf = 1.0f;
+	int index = 0;
+	int child = kernel_tex_fetch(__light_tree_nodes, index).child;
+
+	while(child >= 0) {
+		const float importance_left = light_tree_node_importance(kg, index + 1, P);
+		const float importance_right = light_tree_node_importance(kg, child, P);
+		const float importance = importance_left + importance_right;
+
+		if(importance == 0.0f) {
+			*pdf = 0.0f;
+			return -1;
+		}
+
+		const float p_left = importance_left/importance;
+
+		if(r < p_left || importance_right == 0.0f) {
+			r = min(r/p_left, 1.0f);
+			tree_pdf *= p_left;
+			index = index + 1;
+		}
+		else {
+			const float p_right = importance_right/importance;
+			r = min((r - p_left)/p_right, 1.0f);
+			tree_pdf *= p_right;
+			index = child;
+		}
+
+		child = kernel_tex_fetch(__light_tree_nodes, index).child;
+	}
+
+	*randu = r;
+	*pdf = tree_pdf;
+	return ~child;
+}
+
+/* Probability of light_tree_sample picking the given triangle at P,
+ * computed bottom up from its leaf. */
+ccl_device float light_tree_pdf(KernelGlobals *kg, int object, int prim, float3 P)
+{
+	const uint map_offset = kernel_tex_fetch(__light_tree_leaf_map, object*2);
+	if(map_offset == 0)
+		return 0.0f;
+
+	const uint tri_offset = kernel_tex_fetch(__light_tree_leaf_map, object*2 + 1);
+	int index = (int)kernel_tex_fetch(__light_tree_leaf_map, map_offset + prim - tri_offset);
+	if(index < 0)
+		return 0.0f;
+
+	float pdf = 1.0f;
+	int parent = kernel_tex_fetch(__light_tree_nodes, index).parent;
+
+	while(parent >= 0) {
+		const int left = parent + 1;
+		const int right = kernel_tex_fetch(__light_tree_nodes, parent).child;
+		const float importance_left = light_tree_node_importance(kg, left, P);
+		const float importance_right = light_tree_node_importance(kg, right, P);
+		const float importance = importance_left + importance_right;
+
+		if(importance == 0.0f)
+			return 0.0f;
+
+		pdf *= ((index == left)? importance_left: importance_right)/importance;
+
+		index = parent;
+		parent = kernel_tex_fetch(__light_tree_nodes, parent).parent;
+	}
+
+	return pdf;
+}
+
 /* Triangle Light */
 
 /* returns true if the triangle is has motion blur or an instancing transform applied */
@@ -806,9 +923,17 @@ ccl_device_inline bool triangle_world_space_vertices(KernelGlobals *kg, int obje
 	return has_motion;
 }
 
-ccl_device_inline float triangle_light_pdf_area(KernelGlobals *kg, const float3 Ng, const float3 I, float t)
+ccl_device_inline float triangle_light_select_pdf(KernelGlobals *kg, int object, int prim, float area, float3 P)
+{
+	/* Probability of picking the triangle, by its area or from the light tree. */
+	if(kernel_data.integrator.use_light_tree)
+		return kernel_data.integrator.pdf_light_tree * light_tree_pdf(kg, object, prim, P);
+
+	return area * kernel_data.integrator.pdf_triangles;
+}
+
+ccl_device_inline float triangle_light_pdf_area(const float pdf, const float3 Ng, const float3 I, float t)
 {
-	float pdf = kernel_data.integrator.pdf_triangles;
 	float cos_pi = fabsf(dot(Ng, I));
 
 	if(cos_pi == 0.0f)
@@ -833,10 +958,11 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 	const float3 N = cross(e0, e1);
 	const float distance_to_plane = fabsf(dot(N, sd->I * t))/dot(N, N);
 
+	/* sd contains the point on the light source
+	 * calculate Px, the point that we're shading */
+	const float3 Px = sd->P + sd->I * t;
+
 	if(longest_edge_squared > distance_to_plane*distance_to_plane) {
-		/* sd contains the point on the light source
-		 * calculate Px, the point that we're shading */
-		const float3 Px = sd->P + sd->I * t;
 		const float3 v0_p = V[0] - Px;
 		const float3 v1_p = V[1] - Px;
 		const float3 v2_p = V[2] - Px;
@@ -864,30 +990,30 @@ ccl_device_forceinline float triangle_light_pdf(KernelGlobals *kg, ShaderData *s
 			else {
 				area = 0.5f * len(N);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = triangle_light_select_pdf(kg, sd->object, sd->prim, area, Px);
 			return pdf / solid_angle;
 		}
 	}
 	else {
-		float pdf = triangle_light_pdf_area(kg, sd->Ng, sd->I, t);
+		const float area = 0.5f * len(N);
+		if(UNLIKELY(area == 0.0f)) {
+			return 0.0f;
+		}
+		float area_pre = area;
 		if(has_motion) {
-			const float	area = 0.5f * len(N);
-			if(UNLIKELY(area == 0.0f)) {
-				return 0.0f;
-			}
 			/* scale the PDF.
 			 * area = the area the sample was taken from
 			 * area_pre = the are from which pdf_triangles was calculated from */
 			triangle_world_space_vertices(kg, sd->object, sd->prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			pdf = pdf * area_pre / area;
+			area_pre = triangle_area(V[0], V[1], V[2]);
 		}
-		return pdf;
+		const float pdf = triangle_light_select_pdf(kg, sd->object, sd->prim, area_pre, Px);
+		return triangle_light_pdf_area(pdf / area, sd->Ng, sd->I, t);
 	}
 }
 
 ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, int object,
-	float randu, float randv, float time, LightSample *ls, const float3 P)
+	float randu, float randv, float time, float tree_pdf, LightSample *ls, const float3 P)
 {
 	/* A naive heuristic to decide between costly solid angle sampling
 	 * and simple area sampling, comparing the distance to the triangle plane
@@ -1005,7 +1131,7 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 				triangle_world_space_vertices(kg, object, prim, -1.0f, V);
 				area = triangle_area(V[0], V[1], V[2]);
 			}
-			const float pdf = area * kernel_data.integrator.pdf_triangles;
+			const float pdf = (kernel_data.integrator.use_light_tree)? tree_pdf: area * kernel_data.integrator.pdf_triangles;
 			ls->pdf = pdf / solid_angle;
 		}
 	}
@@ -1019,14 +1145,20 @@ ccl_device_forceinline void triangle_light_sample(KernelGlobals *kg, int prim, i
 		ls->P = u * V[0] + v * V[1] + t * V[2];
 		/* compute incoming direction, distance and pdf */
 		ls->D = normalize_len(ls->P - P, &ls->t);
-		ls->pdf = triangle_light_pdf_area(kg, ls->Ng, -ls->D, ls->t);
-		if(has_motion && area != 0.0f) {
-			/* scale the PDF.
-			 * area = the area the sample was taken from
-			 * area_pre = the are from which pdf_triangles was calculated from */
-			triangle_world_space_vertices(kg, object, prim, -1.0f, V);
-			const float area_pre = triangle_area(V[0], V[1], V[2]);
-			ls->pdf = ls->pdf * area_pre / area;
+		if(UNLIKELY(area == 0.0f)) {
+			ls->pdf = 0.0f;
+		}
+		else {
+			float area_pre = area;
+			if(has_motion) {
+				/* scale the PDF.
+				 * area = the area the sample was taken from
+				 * area_pre = the are from which pdf_triangles was calculated from */
+				triangle_world_space_vertices(kg, object, prim, -1.0f, V);
+				area_pre = triangle_area(V[0], V[1], V[2]);
+			}
+			const float pdf = (kernel_data.integrator.use_light_tree)? tree_pdf: area_pre * kernel_data.integrator.pdf_triangles;
+			ls->pdf = triangle_light_pdf_area(pdf / area, ls->Ng, -ls->D, ls->t);
 		}
 		ls->u = u;
 		ls->v = v;
@@ -1087,7 +1219,32 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, &randu);
+	int index;
+	float tree_pdf = 0.0f;
+
+	if(kernel_data.integrator.use_light_tree) {
+		/* Triangles keep their share of samples, but are picked from the
+		 * light tree. Lamps are picked uniformly, as in the distribution. */
+		const float pdf_light_tree = kernel_data.integrator.pdf_light_tree;
+
+		if(randu < pdf_light_tree) {
+			randu /= pdf_light_tree;
+			index = light_tree_sample(kg, P, &randu, &tree_pdf);
+			if(index < 0)
+				return false;
+			tree_pdf *= pdf_light_tree;
+		}
+		else {
+			const int num_lights = kernel_data.integrator.num_all_lights;
+			const float u = (randu - pdf_light_tree)/(1.0f - pdf_light_tree) * num_lights;
+			const int lamp_index = clamp(float_to_int(u), 0, num_lights - 1);
+			randu = clamp(u - lamp_index, 0.0f, 1.0f);
+			index = kernel_data.integrator.num_distribution - num_lights + lamp_index;
+		}
+	}
+	else {
+		index = light_distribution_sample(kg, &randu);
+	}
 
 	/* fetch light data */
 	const ccl_global KernelLightDistribution *kdistribution = &kernel_tex_fetch(__light_distribution, index);
@@ -1097,7 +1254,7 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 		int object = kdistribution->mesh_light.object_id;
 		int shader_flag = kdistribution->mesh_light.shader_flag;
 
-		triangle_light_sample(kg, prim, object, randu, randv, time, ls, P);
+		triangle_light_sample(kg, prim, object, randu, randv, time, tree_pdf, ls, P);
 		ls->shader |= shader_flag;
 		return (ls->pdf > 0.0f);
 	}
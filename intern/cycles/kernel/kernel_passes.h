@@ -332,6 +332,22 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+/* Adaptive sampling: returns false for pixels that already converged,
+ * otherwise the sample is counted for the pixel. */
+ccl_device_inline bool kernel_need_sample_pixel(KernelGlobals *kg,
+                                                ccl_global float *buffer)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer) {
+		if(buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f) {
+			return false;
+		}
+	}
+	if(kernel_data.film.pass_sample_count) {
+		kernel_write_pass_float(buffer + kernel_data.film.pass_sample_count, 1.0f);
+	}
+	return true;
+}
+
 ccl_device_inline void kernel_write_result(KernelGlobals *kg,
                                            ccl_global float *buffer,
                                            int sample,
@@ -342,6 +358,13 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg,
 
 	kernel_write_pass_float4(buffer, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
 
+	/* Every second sample goes into the auxiliary buffer as well, to estimate
+	 * the error of the combined pass for adaptive sampling. */
+	if(kernel_data.film.pass_adaptive_aux_buffer && (sample & 1)) {
+		kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer,
+		                         make_float4(L_sum.x, L_sum.y, L_sum.z, 0.0f));
+	}
+
 	kernel_write_light_passes(kg, buffer, L);
 
 #ifdef __DENOISING_FEATURES__
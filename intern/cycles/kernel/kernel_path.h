@@ -566,7 +566,8 @@ ccl_device_forceinline void kernel_path_integrate(
 	Ray *ray,
 	PathRadiance *L,
 	ccl_global float *buffer,
-	ShaderData *emission_sd)
+	ShaderData *emission_sd,
+	const Intersection *first_isect)
 {
 	/* Shader data memory used for both volumes and surfaces, saves stack space. */
 	ShaderData sd;
@@ -582,7 +583,17 @@ ccl_device_forceinline void kernel_path_integrate(
 	for(;;) {
 		/* Find intersection with objects in scene. */
 		Intersection isect;
-		bool hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		bool hit;
+
+		if(first_isect != NULL) {
+			/* Camera ray was already traced as part of a ray stream. */
+			isect = *first_isect;
+			hit = (isect.prim != PRIM_NONE);
+			first_isect = NULL;
+		}
+		else {
+			hit = kernel_path_scene_intersect(kg, state, ray, &isect, L);
+		}
 
 		/* Find intersection with lamps and compute emission for MIS. */
 		kernel_path_lamp_emission(kg, state, ray, throughput, &isect, &sd, L);
@@ -725,6 +736,10 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 
 	buffer += index*pass_stride;
 
+	if(!kernel_need_sample_pixel(kg, buffer)) {
+		return;
+	}
+
 	/* Initialize random numbers and sample ray. */
 	uint rng_hash;
 	Ray ray;
@@ -754,11 +769,116 @@ ccl_device void kernel_path_trace(KernelGlobals *kg,
 	                      &ray,
 	                      &L,
 	                      buffer,
-	                      emission_sd);
+	                      emission_sd,
+	                      NULL);
 
 	kernel_write_result(kg, buffer, sample, &L);
 }
 
+#ifdef __RAY_STREAM__
+/* Path trace a block of pixels, tracing their camera rays together as a ray
+ * stream. Like ray queues of the split kernel, the stream only holds pixels
+ * with a valid camera ray, keeping packets dense for border renders and
+ * panoramic cameras.
+ */
+ccl_device_noinline void kernel_path_trace_stream_block(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int w, int h, int offset, int stride,
+	ShaderData *emission_sd)
+{
+	int pass_stride = kernel_data.film.pass_stride;
+
+	/* Initialize random numbers, sample rays and state. */
+	Ray ray[RAY_STREAM_SIZE];
+	PathState state[RAY_STREAM_SIZE];
+	int ray_index[RAY_STREAM_SIZE];
+	int num_rays = 0;
+
+	for(int py = y; py < y + h; py++) {
+		for(int px = x; px < x + w; px++) {
+			const int index = offset + px + py*stride;
+			if(!kernel_need_sample_pixel(kg, buffer + index*pass_stride)) {
+				continue;
+			}
+
+			uint rng_hash;
+			kernel_path_trace_setup(kg, sample, px, py, &rng_hash, &ray[num_rays]);
+
+			if(ray[num_rays].t == 0.0f) {
+				continue;
+			}
+
+			path_state_init(kg, emission_sd, &state[num_rays], rng_hash, sample, &ray[num_rays]);
+			ray_index[num_rays] = index;
+			num_rays++;
+		}
+	}
+
+	if(num_rays == 0) {
+		return;
+	}
+
+	/* All camera rays share the same visibility. */
+	Intersection isect[RAY_STREAM_SIZE];
+	scene_intersect_stream(kg,
+	                       ray,
+	                       num_rays,
+	                       path_state_ray_visibility(kg, &state[0]),
+	                       isect);
+
+	/* Integrate, starting from the stream intersections. */
+	for(int i = 0; i < num_rays; i++) {
+		ccl_global float *pixel_buffer = buffer + ray_index[i]*pass_stride;
+		float3 throughput = make_float3(1.0f, 1.0f, 1.0f);
+
+		PathRadiance L;
+		path_radiance_init(&L, kernel_data.film.use_light_pass);
+
+		kernel_path_integrate(kg,
+		                      &state[i],
+		                      throughput,
+		                      &ray[i],
+		                      &L,
+		                      pixel_buffer,
+		                      emission_sd,
+		                      &isect[i]);
+
+		kernel_write_result(kg, pixel_buffer, sample, &L);
+	}
+}
+
+ccl_device void kernel_path_trace_stream(KernelGlobals *kg,
+	ccl_global float *buffer,
+	int sample, int x, int y, int w, int h, int offset, int stride)
+{
+	if(!scene_intersect_stream_supported(kg)) {
+		for(int py = y; py < y + h; py++) {
+			for(int px = x; px < x + w; px++) {
+				kernel_path_trace(kg, buffer, sample, px, py, offset, stride);
+			}
+		}
+		return;
+	}
+
+	ShaderDataTinyStorage emission_sd_storage;
+	ShaderData *emission_sd = AS_SHADER_DATA(&emission_sd_storage);
+
+	/* Square blocks of pixels are more coherent than rows. */
+	for(int block_y = y; block_y < y + h; block_y += RAY_STREAM_BLOCK_SIZE) {
+		for(int block_x = x; block_x < x + w; block_x += RAY_STREAM_BLOCK_SIZE) {
+			kernel_path_trace_stream_block(kg,
+			                               buffer,
+			                               sample,
+			                               block_x, block_y,
+			                               min(RAY_STREAM_BLOCK_SIZE, x + w - block_x),
+			                               min(RAY_STREAM_BLOCK_SIZE, y + h - block_y),
+			                               offset, stride,
+			                               emission_sd);
+		}
+	}
+}
+#endif  /* __RAY_STREAM__ */
+
 #endif  /* __SPLIT_KERNEL__ */
 
 CCL_NAMESPACE_END
@@ -81,6 +81,10 @@ CCL_NAMESPACE_BEGIN
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
+#    define __RAY_STREAM__
+#  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
 #  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
@@ -415,6 +419,8 @@ typedef enum PassType {
 	PASS_RAY_BOUNCES,
 #endif
 	PASS_RENDER_TIME,
+	PASS_ADAPTIVE_AUX_BUFFER,
+	PASS_SAMPLE_COUNT,
 	PASS_CATEGORY_MAIN_END = 31,
 
 	PASS_MIST = 32,
@@ -1272,7 +1278,9 @@ typedef struct KernelFilm {
 	int pass_denoising_clean;
 	int denoising_flags;
 
-	int pad1, pad2, pad3;
+	int pass_adaptive_aux_buffer;
+	int pass_sample_count;
+	int pad1;
 
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversed_nodes;
@@ -1368,6 +1376,16 @@ typedef struct KernelIntegrator {
 	int start_sample;
 
 	int max_closures;
+
+	/* light tree */
+	int use_light_tree;
+	float pdf_light_tree;
+
+	/* adaptive sampling */
+	int adaptive_min_samples;
+	int adaptive_step;
+	float adaptive_threshold;
+	int pad1, pad2, pad3;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1376,8 +1394,9 @@ typedef enum KernelBVHLayout {
 
 	BVH_LAYOUT_BVH2 = (1 << 0),
 	BVH_LAYOUT_BVH4 = (1 << 1),
+	BVH_LAYOUT_BVH8 = (1 << 2),
 
-	BVH_LAYOUT_DEFAULT = BVH_LAYOUT_BVH4,
+	BVH_LAYOUT_DEFAULT = BVH_LAYOUT_BVH8,
 	BVH_LAYOUT_ALL = (unsigned int)(-1),
 } KernelBVHLayout;
 
@@ -1515,6 +1534,24 @@ typedef struct KernelLightDistribution {
 } KernelLightDistribution;
 static_assert_align(KernelLightDistribution, 16);
 
+/* Node of the light tree used for importance sampling of mesh lights. Nodes
+ * are stored depth first, the left child of an inner node directly follows
+ * it. Emitters are two-sided, so the orientation cone is around a line and
+ * theta_o is at most pi/2. */
+typedef struct KernelLightTreeNode {
+	float bounds_min[3];
+	float energy;
+	float bounds_max[3];
+	float theta_o;
+	float axis[3];
+	int parent;
+	/* Right child of inner nodes, ~index into the light distribution
+	 * for leaves. */
+	int child;
+	int pad1, pad2, pad3;
+} KernelLightTreeNode;
+static_assert_align(KernelLightTreeNode, 16);
+
 typedef struct KernelParticle {
 	int index;
 	float age;
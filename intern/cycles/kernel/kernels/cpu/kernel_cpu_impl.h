@@ -32,6 +32,7 @@
 
 #    include "kernel/kernels/cpu/kernel_cpu_image.h"
 #    include "kernel/kernel_film.h"
+#    include "kernel/kernel_adaptive_sampling.h"
 #    include "kernel/kernel_path.h"
 #    include "kernel/kernel_path_branched.h"
 #    include "kernel/kernel_bake.h"
@@ -99,6 +100,97 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+void KERNEL_FUNCTION_FULL_NAME(path_trace_stream)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int w, int h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, path_trace_stream);
+#else
+#  ifdef __BRANCHED_PATH__
+	if(kernel_data.integrator.branched) {
+		for(int py = y; py < y + h; py++) {
+			for(int px = x; px < x + w; px++) {
+				kernel_branched_path_trace(kg,
+				                           buffer,
+				                           sample,
+				                           px, py,
+				                           offset,
+				                           stride);
+			}
+		}
+	}
+	else
+#  endif
+	{
+#  ifdef __RAY_STREAM__
+		kernel_path_trace_stream(kg, buffer, sample, x, y, w, h, offset, stride);
+#  else
+		for(int py = y; py < y + h; py++) {
+			for(int px = x; px < x + w; px++) {
+				kernel_path_trace(kg, buffer, sample, px, py, offset, stride);
+			}
+		}
+#  endif
+	}
+#endif /* KERNEL_STUB */
+}
+
+/* Adaptive Sampling */
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int x, int y,
+                                                  int w, int h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+	return false;
+#else
+	for(int py = y; py < y + h; py++) {
+		for(int px = x; px < x + w; px++) {
+			kernel_adaptive_stopping(kg, kernel_adaptive_pixel_buffer(kg, buffer, px, py, offset, stride));
+		}
+	}
+
+	bool any = false;
+	for(int py = y; py < y + h; py++) {
+		any |= kernel_adaptive_filter_x(kg, buffer, py, x, w, offset, stride);
+	}
+	for(int px = x; px < x + w; px++) {
+		any |= kernel_adaptive_filter_y(kg, buffer, px, y, h, offset, stride);
+	}
+	return any;
+#endif /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int sample,
+                                                        int x, int y,
+                                                        int w, int h,
+                                                        int offset,
+                                                        int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#else
+	for(int py = y; py < y + h; py++) {
+		for(int px = x; px < x + w; px++) {
+			kernel_adaptive_adjust_samples(kg,
+			                               kernel_adaptive_pixel_buffer(kg, buffer, px, py, offset, stride),
+			                               sample);
+		}
+	}
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -67,6 +67,11 @@ NODE_DEFINE(Integrator)
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
+
+	SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.01f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
 
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
@@ -175,6 +180,17 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 		kintegrator->light_inv_rr_threshold = 0.0f;
 	}
 
+	/* Adaptive sampling, convergence is tested every few samples once a
+	 * minimum number of samples was taken, automatic minimum by default. */
+	if(adaptive_min_samples > 0) {
+		kintegrator->adaptive_min_samples = adaptive_min_samples;
+	}
+	else {
+		kintegrator->adaptive_min_samples = max(4, (int)sqrtf((float)aa_samples));
+	}
+	kintegrator->adaptive_step = 4;
+	kintegrator->adaptive_threshold = adaptive_threshold;
+
 	/* sobol directions table */
 	int max_samples = 1;
 
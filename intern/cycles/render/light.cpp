@@ -19,6 +19,7 @@
 #include "render/integrator.h"
 #include "render/film.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/object.h"
 #include "render/scene.h"
@@ -291,6 +292,18 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	KernelLightDistribution *distribution = dscene->light_distribution.alloc(num_distribution + 1);
 	float totarea = 0.0f;
 
+	/* light tree over triangles, with per object maps from triangles to leaves */
+	bool use_light_tree = scene->integrator->use_light_tree && num_triangles > 0;
+	vector<LightTreePrimitive> tree_primitives;
+	vector<size_t> tree_map_slots;
+	vector<uint> leaf_map;
+
+	if(use_light_tree) {
+		tree_primitives.reserve(num_triangles);
+		tree_map_slots.reserve(num_triangles);
+		leaf_map.resize(scene->objects.size()*2, 0);
+	}
+
 	/* triangles */
 	size_t offset = 0;
 	int j = 0;
@@ -327,6 +340,26 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		}
 
 		size_t mesh_num_triangles = mesh->num_triangles();
+		size_t map_offset = 0;
+		vector<float> shader_strength;
+
+		if(use_light_tree) {
+			map_offset = leaf_map.size();
+			leaf_map[object_id*2] = (uint)map_offset;
+			leaf_map[object_id*2 + 1] = (uint)mesh->tri_offset;
+			leaf_map.resize(map_offset + mesh_num_triangles, ~0u);
+
+			/* Estimate emitted power from constant emission shaders, others
+			 * are assumed to emit with unit strength. */
+			shader_strength.resize(mesh->used_shaders.size(), 1.0f);
+			for(size_t k = 0; k < mesh->used_shaders.size(); k++) {
+				float3 emission;
+				if(mesh->used_shaders[k]->is_constant_emission(&emission)) {
+					shader_strength[k] = max(average(emission), 0.0f);
+				}
+			}
+		}
+
 		for(size_t i = 0; i < mesh_num_triangles; i++) {
 			int shader_index = mesh->shader[i];
 			Shader *shader = (shader_index < mesh->used_shaders.size())
@@ -334,6 +367,8 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 			                         : scene->default_surface;
 
 			if(shader->use_mis && shader->has_surface_emission) {
+				const int distribution_index = offset;
+
 				distribution[offset].totarea = totarea;
 				distribution[offset].prim = i + mesh->tri_offset;
 				distribution[offset].mesh_light.shader_flag = shader_flag;
@@ -354,7 +389,22 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_light_tree && area > 0.0f) {
+					LightTreePrimitive prim;
+					prim.bounds = BoundBox(p1);
+					prim.bounds.grow(p2);
+					prim.bounds.grow(p3);
+					prim.cone = LightTreeCone(normalize(cross(p2 - p1, p3 - p1)), 0.0f);
+					prim.energy = area * ((shader_index < shader_strength.size())
+					                              ? shader_strength[shader_index]
+					                              : 1.0f);
+					prim.distribution_index = distribution_index;
+					tree_primitives.push_back(prim);
+					tree_map_slots.push_back(map_offset + i);
+				}
 			}
 		}
 
@@ -446,6 +496,48 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 		/* CDF */
 		dscene->light_distribution.copy_to_device();
 
+		/* Light tree */
+		kintegrator->use_light_tree = false;
+		kintegrator->pdf_light_tree = 0.0f;
+
+		if(use_light_tree && !tree_primitives.empty()) {
+			progress.set_status("Updating Lights", "Building light tree");
+
+			vector<KernelLightTreeNode> nodes;
+			vector<int> leaf_nodes;
+			LightTree tree(tree_primitives);
+			tree.build(nodes, leaf_nodes);
+
+			/* Without any emitted power estimate there is nothing to
+			 * importance sample, keep using the area distribution. */
+			if(nodes[0].energy > 0.0f) {
+				KernelLightTreeNode *knodes = dscene->light_tree_nodes.alloc(nodes.size());
+				memcpy(knodes, &nodes[0], sizeof(KernelLightTreeNode)*nodes.size());
+
+				for(size_t i = 0; i < leaf_nodes.size(); i++) {
+					leaf_map[tree_map_slots[i]] = (uint)leaf_nodes[i];
+				}
+
+				uint *kleaf_map = dscene->light_tree_leaf_map.alloc(leaf_map.size());
+				memcpy(kleaf_map, &leaf_map[0], sizeof(uint)*leaf_map.size());
+
+				dscene->light_tree_nodes.copy_to_device();
+				dscene->light_tree_leaf_map.copy_to_device();
+
+				/* The tree replaces the area distribution of triangles, which
+				 * keeps its share of light samples. */
+				kintegrator->use_light_tree = true;
+				kintegrator->pdf_light_tree = (num_lights)? 0.5f: 1.0f;
+
+				VLOG(1) << "Light tree built with " << nodes.size() << " nodes.";
+			}
+		}
+
+		if(!kintegrator->use_light_tree) {
+			dscene->light_tree_nodes.free();
+			dscene->light_tree_leaf_map.free();
+		}
+
 		/* Portals */
 		if(num_portals > 0) {
 			kintegrator->portal_offset = light_index;
@@ -460,12 +552,16 @@ void LightManager::device_update_distribution(Device *, DeviceScene *dscene, Sce
 	}
 	else {
 		dscene->light_distribution.free();
+		dscene->light_tree_nodes.free();
+		dscene->light_tree_leaf_map.free();
 
 		kintegrator->num_distribution = 0;
 		kintegrator->num_all_lights = 0;
 		kintegrator->pdf_triangles = 0.0f;
 		kintegrator->pdf_lights = 0.0f;
 		kintegrator->use_lamp_mis = false;
+		kintegrator->use_light_tree = false;
+		kintegrator->pdf_light_tree = 0.0f;
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
@@ -869,6 +965,8 @@ void LightManager::device_update(Device *device, DeviceScene *dscene, Scene *sce
 void LightManager::device_free(Device *, DeviceScene *dscene)
 {
 	dscene->light_distribution.free();
+	dscene->light_tree_nodes.free();
+	dscene->light_tree_leaf_map.free();
 	dscene->lights.free();
 	dscene->light_background_marginal_cdf.free();
 	dscene->light_background_conditional_cdf.free();
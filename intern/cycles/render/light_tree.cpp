@@ -0,0 +1,275 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+#define LIGHT_TREE_NUM_BINS 12
+
+static inline int light_tree_bin(float centroid, float centroid_min, float inv_extent)
+{
+	return clamp((int)((centroid - centroid_min)*inv_extent), 0, LIGHT_TREE_NUM_BINS - 1);
+}
+
+/* Cone */
+
+LightTreeCone LightTreeCone::merge(const LightTreeCone& a, const LightTreeCone& b)
+{
+	/* Emitters are two-sided, pick the direction of b closest to a. */
+	float3 b_axis = (dot(a.axis, b.axis) < 0.0f)? -b.axis: b.axis;
+	const float theta_d = safe_acosf(dot(a.axis, b_axis));
+
+	if(a.theta_o >= M_PI_2_F || theta_d + b.theta_o <= a.theta_o) {
+		return a;
+	}
+	if(theta_d + a.theta_o <= b.theta_o) {
+		return LightTreeCone(b_axis, b.theta_o);
+	}
+
+	const float theta_o = 0.5f*(a.theta_o + theta_d + b.theta_o);
+	if(theta_o >= M_PI_2_F) {
+		return LightTreeCone(a.axis, M_PI_2_F);
+	}
+
+	/* Rotate axis of a towards b, so the new cone touches both. */
+	float ortho_len;
+	const float3 ortho = normalize_len(b_axis - a.axis*dot(a.axis, b_axis), &ortho_len);
+	if(ortho_len == 0.0f) {
+		return LightTreeCone(a.axis, theta_o);
+	}
+
+	const float theta_r = theta_o - a.theta_o;
+	const float3 axis = normalize(a.axis*cosf(theta_r) + ortho*sinf(theta_r));
+	return LightTreeCone(axis, theta_o);
+}
+
+float LightTreeCone::measure() const
+{
+	/* Integral of the cosine weighted emission over the bounding cone, see
+	 * "Importance Sampling of Many Lights with Adaptive Tree Splitting"
+	 * by Conty and Kulla. */
+	const float theta_e = M_PI_2_F;
+	const float theta_w = min(theta_o + theta_e, M_PI_F);
+	const float cos_o = cosf(theta_o);
+	const float sin_o = sinf(theta_o);
+	return M_2PI_F*(1.0f - cos_o) +
+	       M_PI_2_F*(2.0f*theta_w*sin_o - cosf(theta_o - 2.0f*theta_w) - 2.0f*theta_o*sin_o + cos_o);
+}
+
+/* Tree */
+
+LightTree::LightTree(vector<LightTreePrimitive>& primitives)
+: primitives(primitives), nodes(NULL), leaf_nodes(NULL)
+{
+}
+
+void LightTree::build(vector<KernelLightTreeNode>& nodes_, vector<int>& leaf_nodes_)
+{
+	nodes = &nodes_;
+	leaf_nodes = &leaf_nodes_;
+
+	nodes->clear();
+	leaf_nodes->clear();
+
+	if(primitives.empty()) {
+		return;
+	}
+
+	build_primitives.resize(primitives.size());
+	for(size_t i = 0; i < primitives.size(); i++) {
+		const LightTreePrimitive& prim = primitives[i];
+		BuildPrimitive& build_prim = build_primitives[i];
+
+		build_prim.bounds = prim.bounds;
+		build_prim.centroid = prim.bounds.center();
+		build_prim.cone = prim.cone;
+		build_prim.energy = prim.energy;
+		build_prim.index = i;
+	}
+
+	nodes->reserve(primitives.size()*2 - 1);
+	leaf_nodes->resize(primitives.size(), -1);
+
+	recursive_build(0, primitives.size(), -1);
+
+	build_primitives.free_memory();
+}
+
+int LightTree::recursive_build(int start, int end, int parent)
+{
+	BoundBox bounds = BoundBox::empty;
+	BoundBox centroid_bounds = BoundBox::empty;
+	LightTreeCone cone = build_primitives[start].cone;
+	float energy = 0.0f;
+
+	for(int i = start; i < end; i++) {
+		const BuildPrimitive& prim = build_primitives[i];
+
+		bounds.grow(prim.bounds);
+		centroid_bounds.grow(prim.centroid);
+		if(i != start) {
+			cone = LightTreeCone::merge(cone, prim.cone);
+		}
+		energy += prim.energy;
+	}
+
+	const int index = nodes->size();
+	nodes->push_back(KernelLightTreeNode());
+
+	KernelLightTreeNode& node = (*nodes)[index];
+	memset(&node, 0, sizeof(node));
+
+	node.bounds_min[0] = bounds.min.x;
+	node.bounds_min[1] = bounds.min.y;
+	node.bounds_min[2] = bounds.min.z;
+	node.energy = energy;
+	node.bounds_max[0] = bounds.max.x;
+	node.bounds_max[1] = bounds.max.y;
+	node.bounds_max[2] = bounds.max.z;
+	node.theta_o = cone.theta_o;
+	node.axis[0] = cone.axis.x;
+	node.axis[1] = cone.axis.y;
+	node.axis[2] = cone.axis.z;
+	node.parent = parent;
+
+	if(end - start == 1) {
+		const BuildPrimitive& prim = build_primitives[start];
+		node.child = ~primitives[prim.index].distribution_index;
+		(*leaf_nodes)[prim.index] = index;
+		return index;
+	}
+
+	const int mid = find_split(start, end, bounds, centroid_bounds);
+
+	/* Left child directly follows the node, node reference is invalidated
+	 * by the children being added. */
+	recursive_build(start, mid, index);
+	const int right = recursive_build(mid, end, index);
+	(*nodes)[index].child = right;
+
+	return index;
+}
+
+int LightTree::find_split(int start, int end,
+                          const BoundBox& bounds,
+                          const BoundBox& centroid_bounds)
+{
+	struct Bin {
+		BoundBox bounds;
+		LightTreeCone cone;
+		float energy;
+		int count;
+	};
+
+	const float3 extent = centroid_bounds.size();
+	const float3 bounds_extent = bounds.size();
+	const float max_bounds_extent = max3(bounds_extent);
+
+	/* Binned split minimizing the surface area orientation heuristic, which
+	 * weights energy by the spatial and angular extent of the children. */
+	float best_cost = FLT_MAX;
+	int best_dim = -1;
+	int best_bin = 0;
+
+	for(int dim = 0; dim < 3; dim++) {
+		if(extent[dim] == 0.0f) {
+			continue;
+		}
+
+		Bin bins[LIGHT_TREE_NUM_BINS];
+		for(int b = 0; b < LIGHT_TREE_NUM_BINS; b++) {
+			bins[b].bounds = BoundBox::empty;
+			bins[b].energy = 0.0f;
+			bins[b].count = 0;
+		}
+
+		const float inv_extent = LIGHT_TREE_NUM_BINS/extent[dim];
+		for(int i = start; i < end; i++) {
+			const BuildPrimitive& prim = build_primitives[i];
+			const int b = light_tree_bin(prim.centroid[dim], centroid_bounds.min[dim], inv_extent);
+
+			bins[b].bounds.grow(prim.bounds);
+			bins[b].cone = (bins[b].count)? LightTreeCone::merge(bins[b].cone, prim.cone): prim.cone;
+			bins[b].energy += prim.energy;
+			bins[b].count++;
+		}
+
+		/* Costs of all splits from the right side, then sweep from the left. */
+		float right_cost[LIGHT_TREE_NUM_BINS];
+		Bin right = bins[LIGHT_TREE_NUM_BINS - 1];
+		for(int b = LIGHT_TREE_NUM_BINS - 1; b > 0; b--) {
+			if(b != LIGHT_TREE_NUM_BINS - 1 && bins[b].count) {
+				right.bounds.grow(bins[b].bounds);
+				right.cone = (right.count)? LightTreeCone::merge(right.cone, bins[b].cone): bins[b].cone;
+				right.energy += bins[b].energy;
+				right.count += bins[b].count;
+			}
+			right_cost[b] = (right.count)? right.energy*right.bounds.safe_area()*right.cone.measure(): 0.0f;
+		}
+
+		/* Penalize splitting thin boxes along their short sides. */
+		const float regularization = (bounds_extent[dim] > 0.0f)? max_bounds_extent/bounds_extent[dim]: 1.0f;
+
+		Bin left = bins[0];
+		for(int b = 1; b < LIGHT_TREE_NUM_BINS; b++) {
+			if(b != 1 && bins[b - 1].count) {
+				left.bounds.grow(bins[b - 1].bounds);
+				left.cone = (left.count)? LightTreeCone::merge(left.cone, bins[b - 1].cone): bins[b - 1].cone;
+				left.energy += bins[b - 1].energy;
+				left.count += bins[b - 1].count;
+			}
+			if(left.count == 0 || left.count == end - start) {
+				continue;
+			}
+
+			const float left_cost = left.energy*left.bounds.safe_area()*left.cone.measure();
+			const float cost = regularization*(left_cost + right_cost[b]);
+
+			if(cost < best_cost) {
+				best_cost = cost;
+				best_dim = dim;
+				best_bin = b;
+			}
+		}
+	}
+
+	if(best_dim != -1) {
+		const int dim = best_dim;
+		const float centroid_min = centroid_bounds.min[dim];
+		const float inv_extent = LIGHT_TREE_NUM_BINS/extent[dim];
+
+		int mid = start;
+		for(int i = start; i < end; i++) {
+			if(light_tree_bin(build_primitives[i].centroid[dim], centroid_min, inv_extent) < best_bin) {
+				swap(build_primitives[i], build_primitives[mid]);
+				mid++;
+			}
+		}
+
+		if(mid != start && mid != end) {
+			return mid;
+		}
+	}
+
+	/* Coincident centroids or degenerate costs, split in the middle. */
+	return (start + end)/2;
+}
+
+CCL_NAMESPACE_END
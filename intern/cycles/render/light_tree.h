@@ -0,0 +1,90 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_boundbox.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounding cone of emitter normals. Emitters are two-sided, so the axis
+ * only defines a line and theta_o is at most M_PI_2_F. */
+
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+
+	LightTreeCone() : axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f) {}
+	LightTreeCone(const float3& axis, float theta_o) : axis(axis), theta_o(theta_o) {}
+
+	static LightTreeCone merge(const LightTreeCone& a, const LightTreeCone& b);
+
+	/* Solid angle measure of the cone, used as orientation cost. */
+	float measure() const;
+};
+
+/* Single emitter in the light tree. */
+
+struct LightTreePrimitive {
+	BoundBox bounds;
+	LightTreeCone cone;
+	float energy;
+	/* Index into the light distribution. */
+	int distribution_index;
+};
+
+/* Light Tree
+ *
+ * Binary tree over emitters with their bounds, orientation and power, so the
+ * kernel can pick emitters according to their estimated contribution at the
+ * shading point. Leaves hold a single emitter. */
+
+class LightTree {
+public:
+	explicit LightTree(vector<LightTreePrimitive>& primitives);
+
+	/* Build nodes depth first. leaf_nodes receives the node index of the
+	 * leaf holding each primitive, in the order they were passed in. */
+	void build(vector<KernelLightTreeNode>& nodes, vector<int>& leaf_nodes);
+
+protected:
+	struct BuildPrimitive {
+		BoundBox bounds;
+		float3 centroid;
+		LightTreeCone cone;
+		float energy;
+		int index;
+	};
+
+	int recursive_build(int start, int end, int parent);
+	int find_split(int start, int end,
+	               const BoundBox& bounds,
+	               const BoundBox& centroid_bounds);
+
+	vector<LightTreePrimitive>& primitives;
+	vector<BuildPrimitive> build_primitives;
+	vector<KernelLightTreeNode> *nodes;
+	vector<int> *leaf_nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif /* __LIGHT_TREE_H__ */
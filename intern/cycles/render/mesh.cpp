@@ -35,6 +35,7 @@
 
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
+#include "util/util_md5.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
 
@@ -1030,6 +1031,80 @@ void Mesh::pack_patches(uint *patch_data, uint vert_offset, uint face_offset, ui
 	}
 }
 
+/* Hash mesh data in chunks, since MD5 appending takes an int size. */
+static void bvh_key_append(MD5Hash& md5, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t*)data;
+	const size_t chunk_size = 1 << 30;
+
+	md5.append((const uint8_t*)&size, sizeof(size));
+	while(size > 0) {
+		const size_t num_bytes = min(size, chunk_size);
+		md5.append(bytes, (int)num_bytes);
+		bytes += num_bytes;
+		size -= num_bytes;
+	}
+}
+
+/* Only hash the coordinates, the padding of float3 is not initialized in
+ * all code paths. */
+static void bvh_key_append_float3(MD5Hash& md5, const float3 *data, size_t size)
+{
+	float buffer[3*1024];
+	size_t num_floats = 0;
+
+	md5.append((const uint8_t*)&size, sizeof(size));
+	for(size_t i = 0; i < size; i++) {
+		buffer[num_floats++] = data[i].x;
+		buffer[num_floats++] = data[i].y;
+		buffer[num_floats++] = data[i].z;
+		if(num_floats == sizeof(buffer)/sizeof(float)) {
+			md5.append((const uint8_t*)buffer, sizeof(buffer));
+			num_floats = 0;
+		}
+	}
+	if(num_floats) {
+		md5.append((const uint8_t*)buffer, (int)(num_floats*sizeof(float)));
+	}
+}
+
+static string mesh_bvh_key(const Mesh *mesh, const BVHParams& params)
+{
+	MD5Hash md5;
+
+	bvh_key_append(md5, &params.bvh_layout, sizeof(params.bvh_layout));
+	bvh_key_append(md5, &params.use_spatial_split, sizeof(params.use_spatial_split));
+	bvh_key_append(md5, &params.use_unaligned_nodes, sizeof(params.use_unaligned_nodes));
+	bvh_key_append(md5, &params.num_motion_triangle_steps, sizeof(params.num_motion_triangle_steps));
+	bvh_key_append(md5, &params.num_motion_curve_steps, sizeof(params.num_motion_curve_steps));
+
+	bvh_key_append_float3(md5, mesh->verts.data(), mesh->verts.size());
+	bvh_key_append(md5, mesh->triangles.data(), mesh->triangles.size()*sizeof(int));
+	bvh_key_append_float3(md5, mesh->curve_keys.data(), mesh->curve_keys.size());
+	bvh_key_append(md5, mesh->curve_radius.data(), mesh->curve_radius.size()*sizeof(float));
+	bvh_key_append(md5, mesh->curve_first_key.data(), mesh->curve_first_key.size()*sizeof(int));
+
+	bvh_key_append(md5, &mesh->use_motion_blur, sizeof(mesh->use_motion_blur));
+	if(mesh->use_motion_blur) {
+		bvh_key_append(md5, &mesh->motion_steps, sizeof(mesh->motion_steps));
+
+		const Attribute *attr = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+		if(attr) {
+			bvh_key_append_float3(md5,
+			                      attr->data_float3(),
+			                      mesh->verts.size()*(mesh->motion_steps - 1));
+		}
+		attr = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+		if(attr) {
+			bvh_key_append_float3(md5,
+			                      attr->data_float3(),
+			                      mesh->curve_keys.size()*(mesh->motion_steps - 1));
+		}
+	}
+
+	return md5.get_hex();
+}
+
 void Mesh::compute_bvh(Device *device,
                        DeviceScene *dscene,
                        SceneParams *params,
@@ -1055,7 +1130,25 @@ void Mesh::compute_bvh(Device *device,
 		vector<Object*> objects;
 		objects.push_back(&object);
 
-		if(bvh && !need_update_rebuild) {
+		BVHParams bparams;
+		bparams.use_spatial_split = params->use_bvh_spatial_split;
+		bparams.bvh_layout = BVHParams::best_bvh_layout(
+		        params->bvh_layout,
+		        device->info.bvh_layout_mask);
+		bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
+		                              params->use_bvh_unaligned_nodes;
+		bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
+		bparams.num_motion_curve_steps = params->num_bvh_time_steps;
+
+		/* Meshes are synchronized again on many updates without any change to
+		 * their geometry, in which case the existing BVH is still valid. */
+		const string key = mesh_bvh_key(this, bparams);
+
+		if(bvh && key == bvh_key) {
+			progress->set_status(msg, "Reusing BVH");
+			bvh->objects = objects;
+		}
+		else if(bvh && !need_update_rebuild) {
 			progress->set_status(msg, "Refitting BVH");
 			bvh->objects = objects;
 			bvh->refit(*progress);
@@ -1063,20 +1156,12 @@ void Mesh::compute_bvh(Device *device,
 		else {
 			progress->set_status(msg, "Building BVH");
 
-			BVHParams bparams;
-			bparams.use_spatial_split = params->use_bvh_spatial_split;
-			bparams.bvh_layout = BVHParams::best_bvh_layout(
-			        params->bvh_layout,
-			        device->info.bvh_layout_mask);
-			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
-			                              params->use_bvh_unaligned_nodes;
-			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
-			bparams.num_motion_curve_steps = params->num_bvh_time_steps;
-
 			delete bvh;
 			bvh = BVH::create(bparams, objects);
 			MEM_GUARDED_CALL(progress, bvh->build, *progress);
 		}
+
+		bvh_key = (progress->get_cancel())? "": key;
 	}
 
 	need_update = false;
@@ -1166,10 +1251,12 @@ MeshManager::MeshManager()
 {
 	need_update = true;
 	need_flags_update = true;
+	bvh = NULL;
 }
 
 MeshManager::~MeshManager()
 {
+	delete bvh;
 }
 
 void MeshManager::update_osl_attributes(Device *device, Scene *scene, vector<AttributeRequestSet>& mesh_attributes)
@@ -1845,11 +1932,10 @@ void MeshManager::device_update_mesh(Device *,
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+static BVHParams top_level_bvh_params(Device *device,
+                                      DeviceScene *dscene,
+                                      Scene *scene)
 {
-	/* bvh build */
-	progress.set_status("Updating Scene BVH", "Building");
-
 	BVHParams bparams;
 	bparams.top_level = true;
 	bparams.bvh_layout = BVHParams::best_bvh_layout(
@@ -1860,15 +1946,37 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	                              scene->params.use_bvh_unaligned_nodes;
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
+	return bparams;
+}
+
+/* Keep the first size elements of an array, used to drop the merged instance
+ * BVHs from the top level arrays. */
+template<typename T>
+static void bvh_array_copy_front(array<T>& to, const array<T>& from, size_t size)
+{
+	to.resize(size);
+	if(size) {
+		memcpy(to.data(), from.data(), sizeof(T)*size);
+	}
+}
+
+void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+{
+	/* bvh build */
+	progress.set_status("Updating Scene BVH", "Building");
+
+	BVHParams bparams = top_level_bvh_params(device, dscene, scene);
 
 	VLOG(1) << "Using " << bvh_layout_name(bparams.bvh_layout)
 	        << " layout.";
 
-	BVH *bvh = BVH::create(bparams, scene->objects);
+	delete bvh;
+	bvh = BVH::create(bparams, scene->objects);
 	bvh->build(progress);
 
 	if(progress.get_cancel()) {
 		delete bvh;
+		bvh = NULL;
 		return;
 	}
 
@@ -1877,6 +1985,19 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	PackedBVH& pack = bvh->pack;
 
+	/* Top level part of the arrays needed for refitting, the rest is moved
+	 * to the device. */
+	array<int4> top_level_nodes;
+	array<int4> top_level_leaf_nodes;
+	array<int> top_level_prim_index;
+	array<int> top_level_prim_type;
+	array<int> top_level_prim_object;
+	bvh_array_copy_front(top_level_nodes, pack.nodes, bvh->top_level_nodes_size);
+	bvh_array_copy_front(top_level_leaf_nodes, pack.leaf_nodes, bvh->top_level_leaf_nodes_size);
+	bvh_array_copy_front(top_level_prim_index, pack.prim_index, bvh->top_level_prims_size);
+	bvh_array_copy_front(top_level_prim_type, pack.prim_type, bvh->top_level_prims_size);
+	bvh_array_copy_front(top_level_prim_object, pack.prim_object, bvh->top_level_prims_size);
+
 	if(pack.nodes.size()) {
 		dscene->bvh_nodes.steal_data(pack.nodes);
 		dscene->bvh_nodes.copy_to_device();
@@ -1922,7 +2043,86 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 	dscene->data.bvh.bvh_layout = bparams.bvh_layout;
 	dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
 
-	delete bvh;
+	pack.nodes.steal_data(top_level_nodes);
+	pack.leaf_nodes.steal_data(top_level_leaf_nodes);
+	pack.prim_index.steal_data(top_level_prim_index);
+	pack.prim_type.steal_data(top_level_prim_type);
+	pack.prim_object.steal_data(top_level_prim_object);
+
+	/* Remember what the top level was built from. */
+	bvh_meshes.clear();
+	bvh_visibility.clear();
+	bvh_transform_applied.clear();
+	foreach(Object *object, scene->objects) {
+		bvh_meshes.push_back(object->mesh);
+		bvh_visibility.push_back(object->visibility_for_tracing());
+		bvh_transform_applied.push_back(object->mesh->transform_applied);
+	}
+}
+
+bool MeshManager::can_refit_bvh(Device *device, DeviceScene *dscene, Scene *scene)
+{
+	if(!bvh || bvh->objects != scene->objects) {
+		return false;
+	}
+
+	const BVHParams bparams = top_level_bvh_params(device, dscene, scene);
+	if(bparams.bvh_layout != bvh->params.bvh_layout ||
+	   bparams.use_spatial_split != bvh->params.use_spatial_split ||
+	   bparams.use_unaligned_nodes != bvh->params.use_unaligned_nodes ||
+	   bparams.num_motion_triangle_steps != bvh->params.num_motion_triangle_steps ||
+	   bparams.num_motion_curve_steps != bvh->params.num_motion_curve_steps)
+	{
+		return false;
+	}
+
+	/* Meshes with transform applied are part of the top level, any change to
+	 * them or to the object visibility stored in primitives needs a rebuild. */
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		const Object *object = scene->objects[i];
+		if(object->mesh != bvh_meshes[i] ||
+		   object->mesh->need_update ||
+		   object->mesh->transform_applied != bvh_transform_applied[i] ||
+		   object->visibility_for_tracing() != bvh_visibility[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+void MeshManager::device_refit_bvh(Device * /*device*/,
+                                   DeviceScene *dscene,
+                                   Scene *scene,
+                                   Progress& progress)
+{
+	progress.set_status("Updating Scene BVH", "Refitting");
+
+	Scene::MotionType need_motion = scene->need_motion();
+	bool motion_blur = need_motion == Scene::MOTION_BLUR;
+
+	foreach(Object *object, scene->objects) {
+		object->compute_bounds(motion_blur);
+	}
+
+	bvh->refit_top_level(progress);
+
+	if(progress.get_cancel()) return;
+
+	/* Only the top level nodes changed, which come first in the arrays. */
+	progress.set_status("Updating Scene BVH", "Copying BVH to device");
+
+	PackedBVH& pack = bvh->pack;
+
+	if(pack.nodes.size()) {
+		memcpy(dscene->bvh_nodes.data(), pack.nodes.data(), sizeof(int4)*pack.nodes.size());
+		dscene->bvh_nodes.copy_to_device();
+	}
+	if(pack.leaf_nodes.size()) {
+		memcpy(dscene->bvh_leaf_nodes.data(), pack.leaf_nodes.data(), sizeof(int4)*pack.leaf_nodes.size());
+		dscene->bvh_leaf_nodes.copy_to_device();
+	}
 }
 
 void MeshManager::device_update_preprocess(Device *device,
@@ -2067,6 +2267,20 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 			if(shader->need_update_mesh)
 				mesh->need_update = true;
 		}
+	}
+
+	/* When only objects moved, for example in an animation rendered with
+	 * persistent data, mesh data and instance BVHs on the device are still
+	 * valid and the top level BVH is refitted to the new object bounds. */
+	if(can_refit_bvh(device, dscene, scene)) {
+		device_refit_bvh(device, dscene, scene, progress);
+		if(progress.get_cancel()) return;
+
+		need_update = false;
+		return;
+	}
+
+	foreach(Mesh *mesh, scene->meshes) {
 
 		if(mesh->need_update) {
 			/* Update normals. */
@@ -2234,6 +2448,9 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 void MeshManager::device_free(Device *device, DeviceScene *dscene)
 {
+	delete bvh;
+	bvh = NULL;
+
 	dscene->bvh_nodes.free();
 	dscene->bvh_leaf_nodes.free();
 	dscene->object_node.free();
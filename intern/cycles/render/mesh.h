@@ -26,6 +26,7 @@
 #include "util/util_list.h"
 #include "util/util_map.h"
 #include "util/util_param.h"
+#include "util/util_string.h"
 #include "util/util_transform.h"
 #include "util/util_types.h"
 #include "util/util_vector.h"
@@ -240,6 +241,9 @@ public:
 
 	/* BVH */
 	BVH *bvh;
+	/* Hash of the geometry and parameters the BVH was built from, so it can
+	 * be reused when the mesh is synchronized again with the same content. */
+	string bvh_key;
 	size_t tri_offset;
 	size_t vert_offset;
 
@@ -333,6 +337,14 @@ public:
 	bool need_update;
 	bool need_flags_update;
 
+	/* Top level BVH from the last full update, kept so that changes to object
+	 * transforms only can be handled by refitting it. Only the top level part
+	 * of its packed arrays is kept, instance BVHs are merged on the device. */
+	BVH *bvh;
+	vector<Mesh*> bvh_meshes;
+	vector<uint> bvh_visibility;
+	vector<bool> bvh_transform_applied;
+
 	MeshManager();
 	~MeshManager();
 
@@ -376,6 +388,18 @@ protected:
 	                       Scene *scene,
 	                       Progress& progress);
 
+	/* Check whether the top level BVH can be refitted instead of rebuilt,
+	 * which is the case when meshes are unchanged and the objects only have
+	 * new transforms. */
+	bool can_refit_bvh(Device *device,
+	                   DeviceScene *dscene,
+	                   Scene *scene);
+
+	void device_refit_bvh(Device *device,
+	                      DeviceScene *dscene,
+	                      Scene *scene,
+	                      Progress& progress);
+
 	void device_update_displacement_images(Device *device,
 	                                       Scene *scene,
 	                                       Progress& progress);
@@ -106,6 +106,7 @@ Object::Object()
 {
 	particle_system = NULL;
 	particle_index = 0;
+	transform_animated = false;
 	bounds = BoundBox::empty;
 }
 
@@ -805,7 +806,8 @@ void ObjectManager::apply_static_transforms(DeviceScene *dscene, Scene *scene, P
 		 * Could be solved by moving reference counter to Mesh.
 		 */
 		if((mesh_users[object->mesh] == 1 && !object->mesh->has_surface_bssrdf) &&
-		   !object->mesh->has_true_displacement() && object->mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
+		   !object->mesh->has_true_displacement() && object->mesh->subdivision_type == Mesh::SUBDIVISION_NONE &&
+		   !(object->transform_animated && !object->mesh->transform_applied))
 		{
 			if(!(motion_blur && object->use_motion())) {
 				if(!object->mesh->transform_applied) {
@@ -61,6 +61,11 @@ public:
 	ParticleSystem *particle_system;
 	int particle_index;
 
+	/* Transform changed between updates of the same scene, such objects are
+	 * not flattened into the top level BVH so that following transform
+	 * changes only need it to be refitted. */
+	bool transform_animated;
+
 	Object();
 	~Object();
 
@@ -102,6 +102,8 @@ public:
 
 	/* lights */
 	device_vector<KernelLightDistribution> light_distribution;
+	device_vector<KernelLightTreeNode> light_tree_nodes;
+	device_vector<uint> light_tree_leaf_map;
 	device_vector<KernelLight> lights;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
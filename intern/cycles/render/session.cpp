@@ -951,6 +951,15 @@ void Session::render()
 	task.requested_tile_size = params.tile_size;
 	task.passes_size = tile_manager.params.get_passes_size();
 
+	if(scene->integrator->use_adaptive_sampling &&
+	   Pass::contains(tile_manager.params.passes, PASS_ADAPTIVE_AUX_BUFFER))
+	{
+		const KernelIntegrator& kintegrator = scene->dscene.data.integrator;
+		task.adaptive_sampling = true;
+		task.adaptive_min_samples = kintegrator.adaptive_min_samples;
+		task.adaptive_step = kintegrator.adaptive_step;
+	}
+
 	if(params.use_denoising) {
 		task.denoising_radius = params.denoising_radius;
 		task.denoising_strength = params.denoising_strength;
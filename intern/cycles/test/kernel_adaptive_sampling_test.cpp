@@ -0,0 +1,201 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "kernel/kernel_compat_cpu.h"
+#include "kernel/kernel_math.h"
+#include "kernel/kernel_types.h"
+#include "kernel/split/kernel_split_data.h"
+#include "kernel/kernel_globals.h"
+#include "kernel/kernel_adaptive_sampling.h"
+
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Pass layout of the test buffers. */
+enum {
+	PASS_OFFSET_COMBINED = 0,
+	PASS_OFFSET_DEPTH = 4,
+	PASS_OFFSET_OBJECT_ID = 5,
+	PASS_OFFSET_MATERIAL_ID = 6,
+	PASS_OFFSET_AUX = 7,
+	PASS_OFFSET_SAMPLE_COUNT = 11,
+	PASS_STRIDE = 12,
+};
+
+class AdaptiveSamplingTest : public testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		memset(&globals.__data, 0, sizeof(globals.__data));
+		globals.__data.film.pass_flag = PASSMASK(COMBINED) |
+		                                PASSMASK(DEPTH) |
+		                                PASSMASK(OBJECT_ID) |
+		                                PASSMASK(MATERIAL_ID);
+		globals.__data.film.pass_stride = PASS_STRIDE;
+		globals.__data.film.pass_depth = PASS_OFFSET_DEPTH;
+		globals.__data.film.pass_object_id = PASS_OFFSET_OBJECT_ID;
+		globals.__data.film.pass_material_id = PASS_OFFSET_MATERIAL_ID;
+		globals.__data.film.pass_adaptive_aux_buffer = PASS_OFFSET_AUX;
+		globals.__data.film.pass_sample_count = PASS_OFFSET_SAMPLE_COUNT;
+		globals.__data.integrator.adaptive_threshold = 0.01f;
+	}
+
+	/* Buffer of w*h pixels, the converged flags are given per pixel. */
+	void buffer_init(int w, int h, const float *converged)
+	{
+		buffer.clear();
+		buffer.resize(w*h*PASS_STRIDE, 0.0f);
+		for(int i = 0; i < w*h; i++) {
+			buffer[i*PASS_STRIDE + PASS_OFFSET_AUX + 3] = converged[i];
+		}
+	}
+
+	float converged(int i)
+	{
+		return buffer[i*PASS_STRIDE + PASS_OFFSET_AUX + 3];
+	}
+
+	KernelGlobals globals;
+	vector<float> buffer;
+};
+
+}  // namespace
+
+TEST_F(AdaptiveSamplingTest, stopping) {
+	KernelGlobals *kg = &globals;
+	const float flags[4] = {0.0f, 0.0f, 0.0f, 1.0f};
+	buffer_init(4, 1, flags);
+
+	/* 8 samples, the auxiliary buffer holds half of them with the same value. */
+	for(int i = 0; i < 4; i++) {
+		float *pixel = &buffer[i*PASS_STRIDE];
+		pixel[PASS_OFFSET_SAMPLE_COUNT] = 8.0f;
+		for(int c = 0; c < 3; c++) {
+			pixel[PASS_OFFSET_COMBINED + c] = 8.0f;
+			pixel[PASS_OFFSET_AUX + c] = 4.0f;
+		}
+	}
+	/* Noisy: the auxiliary buffer doesn't agree with the combined pass. */
+	buffer[1*PASS_STRIDE + PASS_OFFSET_AUX] = 0.0f;
+	/* Not enough samples to compare. */
+	buffer[2*PASS_STRIDE + PASS_OFFSET_SAMPLE_COUNT] = 1.0f;
+	/* Already converged, left untouched. */
+	buffer[3*PASS_STRIDE + PASS_OFFSET_AUX] = 0.0f;
+
+	for(int i = 0; i < 4; i++) {
+		kernel_adaptive_stopping(kg, &buffer[i*PASS_STRIDE]);
+	}
+
+	EXPECT_EQ(converged(0), 1.0f);
+	EXPECT_EQ(converged(1), 0.0f);
+	EXPECT_EQ(converged(2), 0.0f);
+	EXPECT_EQ(converged(3), 1.0f);
+	EXPECT_EQ(buffer[3*PASS_STRIDE + PASS_OFFSET_AUX], 0.0f);
+}
+
+TEST_F(AdaptiveSamplingTest, filter_x) {
+	KernelGlobals *kg = &globals;
+	const float flags[6] = {1.0f, 1.0f, 0.0f, 1.0f, 1.0f, 1.0f};
+	buffer_init(6, 1, flags);
+
+	/* Unconverged pixels spread to both neighbors in the row. */
+	EXPECT_TRUE(kernel_adaptive_filter_x(kg, &buffer[0], 0, 0, 6, 0, 6));
+	const float expected[6] = {1.0f, 0.0f, 0.0f, 0.0f, 1.0f, 1.0f};
+	for(int i = 0; i < 6; i++) {
+		EXPECT_EQ(converged(i), expected[i]) << "pixel " << i;
+	}
+
+	/* A converged row is reported as such. */
+	const float flags_all[6] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+	buffer_init(6, 1, flags_all);
+	EXPECT_FALSE(kernel_adaptive_filter_x(kg, &buffer[0], 0, 0, 6, 0, 6));
+	for(int i = 0; i < 6; i++) {
+		EXPECT_EQ(converged(i), 1.0f) << "pixel " << i;
+	}
+}
+
+TEST_F(AdaptiveSamplingTest, filter_y) {
+	KernelGlobals *kg = &globals;
+	/* Column x=1 of a 2x5 tile, column x=0 must not be touched. */
+	const float flags[10] = {1.0f, 0.0f,
+	                         1.0f, 1.0f,
+	                         1.0f, 1.0f,
+	                         1.0f, 0.0f,
+	                         1.0f, 1.0f};
+	buffer_init(2, 5, flags);
+
+	EXPECT_TRUE(kernel_adaptive_filter_y(kg, &buffer[0], 1, 0, 5, 0, 2));
+	const float expected[10] = {1.0f, 0.0f,
+	                            1.0f, 0.0f,
+	                            1.0f, 0.0f,
+	                            1.0f, 0.0f,
+	                            1.0f, 0.0f};
+	for(int i = 0; i < 10; i++) {
+		EXPECT_EQ(converged(i), expected[i]) << "pixel " << i;
+	}
+
+	EXPECT_FALSE(kernel_adaptive_filter_y(kg, &buffer[0], 0, 0, 5, 0, 2));
+}
+
+TEST_F(AdaptiveSamplingTest, adjust_samples) {
+	KernelGlobals *kg = &globals;
+	const float flags[2] = {1.0f, 0.0f};
+	buffer_init(2, 1, flags);
+
+	for(int i = 0; i < 2; i++) {
+		float *pixel = &buffer[i*PASS_STRIDE];
+		for(int c = 0; c < 4; c++) {
+			pixel[PASS_OFFSET_COMBINED + c] = 1.0f;
+		}
+		pixel[PASS_OFFSET_DEPTH] = 3.0f;
+		pixel[PASS_OFFSET_OBJECT_ID] = 5.0f;
+		pixel[PASS_OFFSET_MATERIAL_ID] = 7.0f;
+		pixel[PASS_OFFSET_AUX] = 0.5f;
+	}
+	/* Stopped after 4 samples, while the tile got 16. */
+	buffer[PASS_OFFSET_SAMPLE_COUNT] = 4.0f;
+	buffer[PASS_STRIDE + PASS_OFFSET_SAMPLE_COUNT] = 16.0f;
+
+	kernel_adaptive_adjust_samples(kg, &buffer[0], 16);
+	kernel_adaptive_adjust_samples(kg, &buffer[PASS_STRIDE], 16);
+
+	/* Accumulated passes are scaled, passes written for the first sample only are not. */
+	const float *pixel = &buffer[0];
+	for(int c = 0; c < 4; c++) {
+		EXPECT_EQ(pixel[PASS_OFFSET_COMBINED + c], 4.0f);
+	}
+	EXPECT_EQ(pixel[PASS_OFFSET_AUX], 2.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_DEPTH], 3.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_OBJECT_ID], 5.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_MATERIAL_ID], 7.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_AUX + 3], 1.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_SAMPLE_COUNT], 16.0f);
+
+	/* Pixels that got all samples are left as they are. */
+	pixel = &buffer[PASS_STRIDE];
+	for(int c = 0; c < 4; c++) {
+		EXPECT_EQ(pixel[PASS_OFFSET_COMBINED + c], 1.0f);
+	}
+	EXPECT_EQ(pixel[PASS_OFFSET_DEPTH], 3.0f);
+	EXPECT_EQ(pixel[PASS_OFFSET_SAMPLE_COUNT], 16.0f);
+}
+
+CCL_NAMESPACE_END
@@ -32,7 +32,8 @@ DebugFlags::CPU::CPU()
     sse3(true),
     sse2(true),
     bvh_layout(BVH_LAYOUT_DEFAULT),
-    split_kernel(false)
+    split_kernel(false),
+    ray_stream(true)
 {
 	reset();
 }
@@ -59,6 +60,7 @@ void DebugFlags::CPU::reset()
 
 	bvh_layout = BVH_LAYOUT_DEFAULT;
 	split_kernel = false;
+	ray_stream = true;
 }
 
 DebugFlags::CUDA::CUDA()
@@ -147,7 +149,8 @@ std::ostream& operator <<(std::ostream &os,
 	   << "  SSE3       : " << string_from_bool(debug_flags.cpu.sse3) << "\n"
 	   << "  SSE2       : " << string_from_bool(debug_flags.cpu.sse2) << "\n"
 	   << "  BVH layout : " << bvh_layout_name(debug_flags.cpu.bvh_layout) << "\n"
-	   << "  Split      : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n";
+	   << "  Split      : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n"
+	   << "  Ray stream : " << string_from_bool(debug_flags.cpu.ray_stream) << "\n";
 
 	os << "CUDA flags:\n"
 	   << " Adaptive Compile: " << string_from_bool(debug_flags.cuda.adaptive_compile) << "\n";
@@ -65,6 +65,11 @@ public:
 
 		/* Whether split kernel is used */
 		bool split_kernel;
+
+		/* Whether camera rays of neighbour pixels are traced together as
+		 * ray streams.
+		 */
+		bool ray_stream;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
@@ -1058,6 +1058,7 @@ class USERPREF_PT_file(Panel):
         col.label(text="Save & Load:")
         col.prop(paths, "use_relative_paths")
         col.prop(paths, "use_file_compression")
+        col.prop(paths, "use_library_index")
         col.prop(paths, "use_load_ui")
         col.prop(paths, "use_filter_files")
         col.prop(paths, "show_hidden_files_datablocks")
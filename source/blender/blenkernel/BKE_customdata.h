@@ -352,6 +352,12 @@ void CustomData_to_bmesh_block(const struct CustomData *source,
                                struct CustomData *dest, int src_index, void **dest_block, bool use_default_init);
 void CustomData_from_bmesh_block(const struct CustomData *source, 
                                  struct CustomData *dest, void *src_block, int dest_index);
+/* same as above, a whole layer at a time for all elements, in order of the non-bmesh elements */
+void CustomData_to_bmesh_blocks(const struct CustomData *source,
+                                struct CustomData *dest, int src_index, void ***dest_blocks, int count,
+                                bool use_default_init);
+void CustomData_from_bmesh_blocks(const struct CustomData *source,
+                                  struct CustomData *dest, void *const *src_blocks, int dest_index, int count);
 
 void CustomData_file_write_prepare(
         struct CustomData *data,
@@ -50,6 +50,7 @@ struct MEdge;
 struct MVert;
 struct MDeformVert;
 struct MDisps;
+struct MeshDeformNormalsCache;
 struct Object;
 struct CustomData;
 struct DerivedMesh;
@@ -178,6 +179,11 @@ void BKE_mesh_calc_normals_poly(
         const struct MLoop *mloop, const struct MPoly *mpolys,
         int numLoops, int numPolys, float (*r_polyNors)[3],
         const bool only_face_normals);
+void BKE_mesh_calc_normals_poly_partial(
+        struct MVert *mverts, float (*r_vertnors)[3], int numVerts,
+        const struct MLoop *mloop, const struct MPoly *mpolys,
+        int numLoops, int numPolys, float (*r_polynors)[3],
+        const unsigned int *verts_dirty, unsigned int *r_verts_update);  /* BLI_bitmap */
 void BKE_mesh_calc_normals(struct Mesh *me);
 void BKE_mesh_calc_normals_tessface(
         struct MVert *mverts, int numVerts,
@@ -271,6 +277,21 @@ void BKE_mesh_normals_loop_split(
         struct MPoly *mpolys, const float (*polynors)[3], const int numPolys,
         const bool use_split_normals, const float split_angle,
         MLoopNorSpaceArray *r_lnors_spacearr, short (*clnors_data)[2], int *r_loop_to_poly);
+bool BKE_mesh_normals_loop_split_partial(
+        const struct MVert *mverts, const struct MEdge *medges,
+        const struct MLoop *mloops, float (*r_loopnors)[3], const int numLoops,
+        const struct MPoly *mpolys, const float (*polynors)[3],
+        const bool use_split_normals, const float split_angle,
+        MLoopNorSpaceArray *lnors_spacearr, short (*clnors_data)[2], const int *loop_to_poly,
+        const unsigned int *verts_update);  /* BLI_bitmap */
+
+bool BKE_mesh_calc_normals_deform_cached(
+        struct MeshDeformNormalsCache **cache_p,
+        struct MVert *mverts, const int numVerts, struct MEdge *medges, const int numEdges,
+        struct MLoop *mloops, float (*r_loopnors)[3], const int numLoops,
+        struct MPoly *mpolys, float (*r_polynors)[3], const int numPolys,
+        const bool use_split_normals, const float split_angle, short (*clnors_data)[2]);
+void BKE_mesh_deform_normals_cache_free(struct MeshDeformNormalsCache *cache);
 
 void BKE_mesh_normals_loop_custom_set(
         const struct MVert *mverts, const int numVerts, struct MEdge *medges, const int numEdges,
@@ -1744,6 +1744,38 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/**
+ * Calculate normals of a mesh which only had its vertices moved by deform modifiers,
+ * re-using the normals from the previous evaluation of the object, so only normals
+ * around vertices which moved since then are updated.
+ */
+static void dm_calc_deform_normals_cached(
+        Object *ob, DerivedMesh *dm, const bool do_loop_normals, const float split_angle)
+{
+	float (*pnors)[3], (*lnors)[3] = NULL;
+
+	BLI_assert(dm->type == DM_TYPE_CDDM);
+
+	pnors = CustomData_get_layer(&dm->polyData, CD_NORMAL);
+	if (!pnors) {
+		pnors = CustomData_add_layer(&dm->polyData, CD_NORMAL, CD_CALLOC, NULL, dm->numPolyData);
+	}
+	if (do_loop_normals) {
+		lnors = CustomData_get_layer(&dm->loopData, CD_NORMAL);
+		if (!lnors) {
+			lnors = CustomData_add_layer(&dm->loopData, CD_NORMAL, CD_CALLOC, NULL, dm->numLoopData);
+		}
+	}
+
+	BKE_mesh_calc_normals_deform_cached(
+	        &ob->deform_normals_cache,
+	        CDDM_get_verts(dm), dm->numVertData, CDDM_get_edges(dm), dm->numEdgeData,
+	        CDDM_get_loops(dm), lnors, dm->numLoopData, CDDM_get_polys(dm), pnors, dm->numPolyData,
+	        do_loop_normals, split_angle, CustomData_get_layer(&dm->loopData, CD_CUSTOMLOOPNORMAL));
+
+	dm->dirty &= ~DM_DIRTY_NORMALS;
+}
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1790,6 +1822,7 @@ static void mesh_calc_modifiers(
 
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = me->smoothresh;
+	bool normals_done = false;
 
 	VirtualModifierData virtualModifierData;
 
@@ -2198,6 +2231,12 @@ static void mesh_calc_modifiers(
 		
 		if (deformedVerts) {
 			CDDM_apply_vert_coords(finaldm, deformedVerts);
+
+			/* Only deform modifiers, normals of the previous evaluation can be partially updated. */
+			if (useCache && !sculpt_dyntopo) {
+				dm_calc_deform_normals_cached(ob, finaldm, do_loop_normals, loop_normals_split_angle);
+				normals_done = true;
+			}
 		}
 
 		/* In this case, we should never have weight-modifying modifiers in stack... */
@@ -2213,7 +2252,12 @@ static void mesh_calc_modifiers(
 			add_orco_dm(ob, NULL, *r_deform, NULL, CD_ORCO);
 	}
 
-	if (do_loop_normals) {
+	if (useCache && !normals_done && ob->deform_normals_cache) {
+		BKE_mesh_deform_normals_cache_free(ob->deform_normals_cache);
+		ob->deform_normals_cache = NULL;
+	}
+
+	if (do_loop_normals && !normals_done) {
 		/* Compute loop normals (note: will compute poly and vert normals as well, if needed!) */
 		DM_calc_loop_normals(finaldm, do_loop_normals, loop_normals_split_angle);
 	}
@@ -3292,6 +3292,125 @@ void CustomData_from_bmesh_block(const CustomData *source, CustomData *dest,
 
 }
 
+/**
+ * Same as #CustomData_to_bmesh_block, but for all elements at once, copying a whole
+ * layer at a time. Source layers are read sequentially instead of matching layers
+ * for every single block.
+ *
+ * \param dest_blocks: Pointers to the blocks of the elements \a src_index .. \a src_index + \a count
+ * (typically the #BMHeader.data), allocated when NULL.
+ * NULL entries are skipped (source elements without a matching BMesh element).
+ */
+void CustomData_to_bmesh_blocks(const CustomData *source, CustomData *dest,
+                                int src_index, void ***dest_blocks, int count, bool use_default_init)
+{
+	int dest_i, src_i, i;
+
+	for (i = 0; i < count; i++) {
+		if (dest_blocks[i] && *dest_blocks[i] == NULL) {
+			CustomData_bmesh_alloc_block(dest, dest_blocks[i]);
+		}
+	}
+
+	/* copies a layer at a time */
+	dest_i = 0;
+	for (src_i = 0; src_i <= source->totlayer; ++src_i) {
+		const int src_type = (src_i < source->totlayer) ? source->layers[src_i].type : CD_NUMTYPES;
+
+		/* find the first dest layer with type >= the source type
+		 * (this should work because layers are ordered by type)
+		 */
+		while (dest_i < dest->totlayer && dest->layers[dest_i].type < src_type) {
+			if (use_default_init) {
+				for (i = 0; i < count; i++) {
+					if (dest_blocks[i]) {
+						CustomData_bmesh_set_default_n(dest, dest_blocks[i], dest_i);
+					}
+				}
+			}
+			dest_i++;
+		}
+
+		/* if there are no more dest layers, we're done */
+		if (dest_i >= dest->totlayer) break;
+
+		/* if we found a matching layer, copy the data */
+		if (dest->layers[dest_i].type == src_type) {
+			const LayerTypeInfo *typeInfo = layerType_getInfo(src_type);
+			const int offset = dest->layers[dest_i].offset;
+			const char *src_data = POINTER_OFFSET(source->layers[src_i].data, (size_t)src_index * typeInfo->size);
+
+			for (i = 0; i < count; i++, src_data += typeInfo->size) {
+				if (dest_blocks[i] == NULL) {
+					continue;
+				}
+				void *dest_data = POINTER_OFFSET(*dest_blocks[i], offset);
+				if (typeInfo->copy)
+					typeInfo->copy(src_data, dest_data, 1);
+				else
+					memcpy(dest_data, src_data, typeInfo->size);
+			}
+
+			/* if there are multiple source & dest layers of the same type,
+			 * we don't want to copy all source layers to the same dest, so
+			 * increment dest_i
+			 */
+			dest_i++;
+		}
+	}
+}
+
+/**
+ * Same as #CustomData_from_bmesh_block, but for all elements at once, filling
+ * a whole destination layer at a time.
+ *
+ * \param src_blocks: Blocks of the destination elements \a dest_index .. \a dest_index + \a count.
+ */
+void CustomData_from_bmesh_blocks(const CustomData *source, CustomData *dest,
+                                  void *const *src_blocks, int dest_index, int count)
+{
+	int dest_i, src_i, i;
+
+	/* copies a layer at a time */
+	dest_i = 0;
+	for (src_i = 0; src_i < source->totlayer; ++src_i) {
+
+		/* find the first dest layer with type >= the source type
+		 * (this should work because layers are ordered by type)
+		 */
+		while (dest_i < dest->totlayer && dest->layers[dest_i].type < source->layers[src_i].type) {
+			dest_i++;
+		}
+
+		/* if there are no more dest layers, we're done */
+		if (dest_i >= dest->totlayer) return;
+
+		/* if we found a matching layer, copy the data */
+		if (dest->layers[dest_i].type == source->layers[src_i].type) {
+			const LayerTypeInfo *typeInfo = layerType_getInfo(dest->layers[dest_i].type);
+			const int offset = source->layers[src_i].offset;
+			char *dst_data = POINTER_OFFSET(dest->layers[dest_i].data, (size_t)dest_index * typeInfo->size);
+
+			if (typeInfo->copy) {
+				for (i = 0; i < count; i++, dst_data += typeInfo->size) {
+					typeInfo->copy(POINTER_OFFSET(src_blocks[i], offset), dst_data, 1);
+				}
+			}
+			else {
+				for (i = 0; i < count; i++, dst_data += typeInfo->size) {
+					memcpy(dst_data, POINTER_OFFSET(src_blocks[i], offset), typeInfo->size);
+				}
+			}
+
+			/* if there are multiple source & dest layers of the same type,
+			 * we don't want to copy all source layers to the same dest, so
+			 * increment dest_i
+			 */
+			dest_i++;
+		}
+	}
+}
+
 void CustomData_file_write_info(int type, const char **r_struct_name, int *r_struct_num)
 {
 	const LayerTypeInfo *typeInfo = layerType_getInfo(type);
@@ -42,6 +42,7 @@
 #include "BLI_mempool.h"
 #include "BLI_math.h"
 #include "BLI_edgehash.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_bitmap.h"
 #include "BLI_polyfill_2d.h"
 #include "BLI_linklist.h"
@@ -188,6 +189,50 @@ static void mesh_calc_normals_poly_cb(
 	BKE_mesh_calc_poly_normal(mp, data->mloop + mp->loopstart, data->mverts, data->pnors[pidx]);
 }
 
+/**
+ * Inline version of #BKE_mesh_calc_poly_normal, also calculates normalized edge-vectors,
+ * used to weight the poly normal by corner angle.
+ */
+BLI_INLINE void mesh_calc_poly_normal_edgevecs(
+        const MPoly *mp, const MLoop *ml, const MVert *mverts,
+        float r_pnor[3], float (*r_edgevecbuf)[3])
+{
+	const int nverts = mp->totloop;
+	int i_prev = nverts - 1;
+	const float *v_prev = mverts[ml[i_prev].v].co;
+	const float *v_curr;
+
+	zero_v3(r_pnor);
+	/* Newell's Method */
+	for (int i = 0; i < nverts; i++) {
+		v_curr = mverts[ml[i].v].co;
+		add_newell_cross_v3_v3v3(r_pnor, v_prev, v_curr);
+
+		/* Unrelated to normalize, calculate edge-vector */
+		sub_v3_v3v3(r_edgevecbuf[i_prev], v_prev, v_curr);
+		normalize_v3(r_edgevecbuf[i_prev]);
+		i_prev = i;
+
+		v_prev = v_curr;
+	}
+	if (UNLIKELY(normalize_v3(r_pnor) == 0.0f)) {
+		r_pnor[2] = 1.0f; /* other axes set to 0.0 */
+	}
+}
+
+/**
+ * Angle weight of a corner, from the edge-vectors of #mesh_calc_poly_normal_edgevecs.
+ */
+BLI_INLINE float mesh_calc_poly_corner_weight(float (*edgevecbuf)[3], const int nverts, const int i)
+{
+	const float *prev_edge = edgevecbuf[(i == 0) ? nverts - 1 : i - 1];
+	const float *cur_edge = edgevecbuf[i];
+
+	/* calculate angle between the two poly edges incident on
+	 * this vertex */
+	return saacos(-dot_v3v3(cur_edge, prev_edge));
+}
+
 static void mesh_calc_normals_poly_prepare_cb(
         void *__restrict userdata, 
         const int pidx,
@@ -204,52 +249,18 @@ static void mesh_calc_normals_poly_prepare_cb(
 
 	const int nverts = mp->totloop;
 	float (*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)nverts);
-	int i;
 
 	/* Polygon Normal and edge-vector */
-	/* inline version of #BKE_mesh_calc_poly_normal, also does edge-vectors */
-	{
-		int i_prev = nverts - 1;
-		const float *v_prev = mverts[ml[i_prev].v].co;
-		const float *v_curr;
-
-		zero_v3(pnor);
-		/* Newell's Method */
-		for (i = 0; i < nverts; i++) {
-			v_curr = mverts[ml[i].v].co;
-			add_newell_cross_v3_v3v3(pnor, v_prev, v_curr);
-
-			/* Unrelated to normalize, calculate edge-vector */
-			sub_v3_v3v3(edgevecbuf[i_prev], v_prev, v_curr);
-			normalize_v3(edgevecbuf[i_prev]);
-			i_prev = i;
-
-			v_prev = v_curr;
-		}
-		if (UNLIKELY(normalize_v3(pnor) == 0.0f)) {
-			pnor[2] = 1.0f; /* other axes set to 0.0 */
-		}
-	}
+	mesh_calc_poly_normal_edgevecs(mp, ml, mverts, pnor, edgevecbuf);
 
 	/* accumulate angle weighted face normal */
 	/* inline version of #accumulate_vertex_normals_poly_v3,
 	 * split between this threaded callback and #mesh_calc_normals_poly_accum_cb. */
-	{
-		const float *prev_edge = edgevecbuf[nverts - 1];
-
-		for (i = 0; i < nverts; i++) {
-			const int lidx = mp->loopstart + i;
-			const float *cur_edge = edgevecbuf[i];
+	for (int i = 0; i < nverts; i++) {
+		const float fac = mesh_calc_poly_corner_weight(edgevecbuf, nverts, i);
 
-			/* calculate angle between the two poly edges incident on
-			 * this vertex */
-			const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
-
-			/* Store for later accumulation */
-			mul_v3_v3fl(lnors_weighted[lidx], pnor, fac);
-
-			prev_edge = cur_edge;
-		}
+		/* Store for later accumulation */
+		mul_v3_v3fl(lnors_weighted[mp->loopstart + i], pnor, fac);
 	}
 }
 
@@ -332,6 +343,146 @@ void BKE_mesh_calc_normals_poly(
 	MEM_freeN(lnors_weighted);
 }
 
+typedef struct MeshCalcNormalsPartialData {
+	const MPoly *mpolys;
+	const MLoop *mloop;
+	const MVert *mverts;
+	float (*pnors)[3];
+	const BLI_bitmap *verts_dirty;
+	char *polys_update;
+} MeshCalcNormalsPartialData;
+
+static void mesh_calc_normals_poly_partial_cb(
+        void *__restrict userdata,
+        const int pidx,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	MeshCalcNormalsPartialData *data = userdata;
+	const MPoly *mp = &data->mpolys[pidx];
+	const MLoop *ml = &data->mloop[mp->loopstart];
+
+	for (int i = 0; i < mp->totloop; i++) {
+		if (BLI_BITMAP_TEST(data->verts_dirty, ml[i].v)) {
+			float (*edgevecbuf)[3] = BLI_array_alloca(edgevecbuf, (size_t)mp->totloop);
+			mesh_calc_poly_normal_edgevecs(mp, ml, data->mverts, data->pnors[pidx], edgevecbuf);
+			data->polys_update[pidx] = true;
+			break;
+		}
+	}
+}
+
+/**
+ * Update normals after only some vertices moved,
+ * (e.g. when a deform modifier only affects a small, weighted region).
+ *
+ * Only polys using a vertex tagged in \a verts_dirty get their normal recalculated,
+ * and only vertices of those polys get their normal re-accumulated.
+ *
+ * \param r_polynors: Poly normals, these must be valid for all polys not using dirty vertices,
+ * (typically from a previous call to #BKE_mesh_calc_normals_poly).
+ * \param r_vertnors: Optional, when given it's updated for the same vertices as the MVert normals.
+ * \param verts_dirty: Bitmap of vertices which moved since normals were last calculated.
+ * \param r_verts_update: Optional bitmap (cleared by the caller) of vertices which normals were updated,
+ * pass it on to #BKE_mesh_normals_loop_split_partial.
+ */
+void BKE_mesh_calc_normals_poly_partial(
+        MVert *mverts, float (*r_vertnors)[3], int numVerts,
+        const MLoop *mloop, const MPoly *mpolys,
+        int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
+        const BLI_bitmap *verts_dirty, BLI_bitmap *r_verts_update)
+{
+	BLI_assert((r_polynors != NULL) || (numPolys == 0));
+
+	char *polys_update = MEM_calloc_arrayN((size_t)numPolys, sizeof(*polys_update), __func__);
+	BLI_bitmap *verts_update = r_verts_update ? r_verts_update : BLI_BITMAP_NEW(numVerts, __func__);
+	float (*vnors)[3] = r_vertnors;
+	int mp_index;
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.min_iter_per_thread = 1024;
+
+	/* Re-calculate normals of polys using dirty vertices. */
+	MeshCalcNormalsPartialData data = {
+	    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = r_polynors,
+	    .verts_dirty = verts_dirty, .polys_update = polys_update,
+	};
+	BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_partial_cb, &settings);
+
+	/* All vertices of updated polys need their normal re-accumulated. */
+	for (mp_index = 0; mp_index < numPolys; mp_index++) {
+		if (polys_update[mp_index]) {
+			const MPoly *mp = &mpolys[mp_index];
+			const MLoop *ml = &mloop[mp->loopstart];
+			for (int i = 0; i < mp->totloop; i++) {
+				BLI_BITMAP_ENABLE(verts_update, ml[i].v);
+			}
+		}
+	}
+
+	if (vnors == NULL) {
+		vnors = MEM_malloc_arrayN((size_t)numVerts, sizeof(*vnors), __func__);
+	}
+	for (int v_index = 0; v_index < numVerts; v_index++) {
+		if (BLI_BITMAP_TEST(verts_update, v_index)) {
+			zero_v3(vnors[v_index]);
+		}
+	}
+
+	/* Accumulate from all polys using an updated vertex, including unchanged ones,
+	 * this is done in the same order as #BKE_mesh_calc_normals_poly so results match. */
+	for (mp_index = 0; mp_index < numPolys; mp_index++) {
+		const MPoly *mp = &mpolys[mp_index];
+		const MLoop *ml = &mloop[mp->loopstart];
+		const int nverts = mp->totloop;
+		float (*edgevecbuf)[3] = NULL;
+		float pnor_temp[3];
+		int i;
+
+		for (i = 0; i < nverts; i++) {
+			if (BLI_BITMAP_TEST(verts_update, ml[i].v)) {
+				break;
+			}
+		}
+		if (i == nverts) {
+			continue;
+		}
+
+		edgevecbuf = BLI_array_alloca(edgevecbuf, (size_t)nverts);
+		mesh_calc_poly_normal_edgevecs(mp, ml, mverts, pnor_temp, edgevecbuf);
+
+		for (; i < nverts; i++) {
+			if (BLI_BITMAP_TEST(verts_update, ml[i].v)) {
+				float lnor_weighted[3];
+				mul_v3_v3fl(lnor_weighted, r_polynors[mp_index],
+				            mesh_calc_poly_corner_weight(edgevecbuf, nverts, i));
+				add_v3_v3(vnors[ml[i].v], lnor_weighted);
+			}
+		}
+	}
+
+	/* Normalize and validate, as #mesh_calc_normals_poly_finalize_cb does. */
+	for (int v_index = 0; v_index < numVerts; v_index++) {
+		if (BLI_BITMAP_TEST(verts_update, v_index)) {
+			MVert *mv = &mverts[v_index];
+			float *no = vnors[v_index];
+
+			if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+				normalize_v3_v3(no, mv->co);
+			}
+			normal_float_to_short_v3(mv->no, no);
+		}
+	}
+
+	if (vnors != r_vertnors) {
+		MEM_freeN(vnors);
+	}
+	if (verts_update != r_verts_update) {
+		MEM_freeN(verts_update);
+	}
+	MEM_freeN(polys_update);
+}
+
 void BKE_mesh_calc_normals(Mesh *mesh)
 {
 #ifdef DEBUG_TIME
@@ -709,6 +860,11 @@ typedef struct LoopSplitTaskDataCommon {
 	int numEdges;
 	int numLoops;
 	int numPolys;
+
+	/* Owned by #loop_split_generator. */
+	char *loop_fan_start;          /* Loops from which a fan (or single loop) is walked. */
+	int *poly_fans_offset;         /* Index of the first fan starting in each poly (numPolys + 1 items). */
+	MLoopNorSpace *lnor_spaces;    /* Spaces of all fans, allocated at once. */
 } LoopSplitTaskDataCommon;
 
 #define INDEX_UNSET INT_MIN
@@ -720,7 +876,6 @@ static void mesh_edges_sharp_tag(
         LoopSplitTaskDataCommon *data,
         const bool check_angle, const float split_angle, const bool do_sharp_edges_tag)
 {
-	const MVert *mverts = data->mverts;
 	const MEdge *medges = data->medges;
 	const MLoop *mloops = data->mloops;
 
@@ -729,7 +884,6 @@ static void mesh_edges_sharp_tag(
 	const int numEdges = data->numEdges;
 	const int numPolys = data->numPolys;
 
-	float (*loopnors)[3] = data->loopnors;  /* Note: loopnors may be NULL here. */
 	const float (*polynors)[3] = data->polynors;
 
 	int (*edge_to_loops)[2] = data->edge_to_loops;
@@ -755,13 +909,6 @@ static void mesh_edges_sharp_tag(
 
 			loop_to_poly[ml_curr_index] = mp_index;
 
-			/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
-			 * those later!
-			 */
-			if (loopnors) {
-				normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
-			}
-
 			/* Check whether current edge might be smooth or sharp */
 			if ((e2l[0] | e2l[1]) == 0) {
 				/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
@@ -1176,41 +1323,13 @@ static void loop_split_worker_do(
 	}
 }
 
-static void loop_split_worker(TaskPool * __restrict pool, void *taskdata, int UNUSED(threadid))
-{
-	LoopSplitTaskDataCommon *common_data = BLI_task_pool_userdata(pool);
-	LoopSplitTaskData *data = taskdata;
-
-	/* Temp edge vectors stack, only used when computing lnor spacearr. */
-	BLI_Stack *edge_vectors = common_data->lnors_spacearr ? BLI_stack_new(sizeof(float[3]), __func__) : NULL;
-
-#ifdef DEBUG_TIME
-	TIMEIT_START_AVERAGED(loop_split_worker);
-#endif
-
-	for (int i = 0; i < LOOP_SPLIT_TASK_BLOCK_SIZE; i++, data++) {
-		/* A NULL ml_curr is used to tag ended data! */
-		if (data->ml_curr == NULL) {
-			break;
-		}
-
-		loop_split_worker_do(common_data, data, edge_vectors);
-	}
-
-	if (edge_vectors) {
-		BLI_stack_free(edge_vectors);
-	}
-
-#ifdef DEBUG_TIME
-	TIMEIT_END_AVERAGED(loop_split_worker);
-#endif
-}
-
-/* Check whether gievn loop is part of an unknown-so-far cyclic smooth fan, or not.
- * Needed because cyclic smooth fans have no obvious 'entry point', and yet we need to walk them once, and only once. */
+/* Check whether given loop is the start of a cyclic smooth fan, or not.
+ * Needed because cyclic smooth fans have no obvious 'entry point', and yet we need to walk them once, and only once.
+ * The first loop of the fan in polygons order is used, this way each loop can be checked independently
+ * (from different threads). */
 static bool loop_split_generator_check_cyclic_smooth_fan(
         const MLoop *mloops, const MPoly *mpolys,
-        const int (*edge_to_loops)[2], const int *loop_to_poly, const int *e2l_prev, BLI_bitmap *skip_loops,
+        const int (*edge_to_loops)[2], const int *loop_to_poly, const int *e2l_prev,
         const MLoop *ml_curr, const MLoop *ml_prev, const int ml_curr_index, const int ml_prev_index,
         const int mp_curr_index)
 {
@@ -1235,9 +1354,6 @@ static bool loop_split_generator_check_cyclic_smooth_fan(
 	BLI_assert(mlfan_vert_index >= 0);
 	BLI_assert(mpfan_curr_index >= 0);
 
-	BLI_assert(!BLI_BITMAP_TEST(skip_loops, mlfan_vert_index));
-	BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
-
 	while (true) {
 		/* Find next loop of the smooth fan. */
 		BKE_mesh_loop_manifold_fan_around_vert_next(
@@ -1251,175 +1367,209 @@ static bool loop_split_generator_check_cyclic_smooth_fan(
 			return false;
 		}
 		/* Smooth loop/edge... */
-		else if (BLI_BITMAP_TEST(skip_loops, mlfan_vert_index)) {
-			if (mlfan_vert_index == ml_curr_index) {
-				/* We walked around a whole cyclic smooth fan without finding any already-processed loop, means we can
-				 * use initial ml_curr/ml_prev edge as start for this smooth fan. */
-				return true;
-			}
-			/* ... already checked in some previous looping, we can abort. */
-			return false;
+		else if (mlfan_vert_index == ml_curr_index) {
+			/* We walked around a whole cyclic smooth fan without finding any loop coming before this one,
+			 * means we can use initial ml_curr/ml_prev edge as start for this smooth fan. */
+			return true;
 		}
-		else {
-			/* ... we can skip it in future, and keep checking the smooth fan. */
-			BLI_BITMAP_ENABLE(skip_loops, mlfan_vert_index);
+		else if ((mpfan_curr_index < mp_curr_index) ||
+		         (mpfan_curr_index == mp_curr_index && mlfan_vert_index < ml_curr_index))
+		{
+			/* ... this fan is handled from a previous loop, we can abort. */
+			return false;
 		}
 	}
 }
 
-static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
+typedef struct LoopSplitGeneratorTLS {
+	/* Temp edge vectors stack, only used when computing lnor spacearr. */
+	BLI_Stack *edge_vectors;
+} LoopSplitGeneratorTLS;
+
+/* First pass, find loops from which smooth fans (or single loops) are walked, and count them per polygon. */
+static void loop_split_generator_fans_find_cb(
+        void *__restrict userdata,
+        const int mp_index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
 {
-	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+	LoopSplitTaskDataCommon *common_data = userdata;
 	float (*loopnors)[3] = common_data->loopnors;
 
+	const MVert *mverts = common_data->mverts;
 	const MLoop *mloops = common_data->mloops;
 	const MPoly *mpolys = common_data->mpolys;
 	const int *loop_to_poly = common_data->loop_to_poly;
-	const int (*edge_to_loops)[2] = common_data->edge_to_loops;
-	const int numLoops = common_data->numLoops;
-	const int numPolys = common_data->numPolys;
+	const int (*edge_to_loops)[2] = (const int (*)[2])common_data->edge_to_loops;
 
-	const MPoly *mp;
-	int mp_index;
+	const MPoly *mp = &mpolys[mp_index];
+	const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+	int ml_curr_index = mp->loopstart;
+	int ml_prev_index = ml_last_index;
+	int fans_num = 0;
 
-	const MLoop *ml_curr;
-	const MLoop *ml_prev;
-	int ml_curr_index;
-	int ml_prev_index;
+	const MLoop *ml_curr = &mloops[ml_curr_index];
+	const MLoop *ml_prev = &mloops[ml_prev_index];
 
-	BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
+	for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+		const int *e2l_curr = edge_to_loops[ml_curr->e];
+		const int *e2l_prev = edge_to_loops[ml_prev->e];
 
-	LoopSplitTaskData *data_buff = NULL;
-	int data_idx = 0;
+		/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
+		 * those later!
+		 */
+		normal_short_to_float_v3(loopnors[ml_curr_index], mverts[ml_curr->v].no);
+
+		/* A smooth edge, we have to check for cyclic smooth fan case.
+		 * If this loop is the 'entry point' of a cyclic smooth fan, we can do it using that loop/edge,
+		 * otherwise we can skip it. */
+		if (IS_EDGE_SHARP(e2l_curr) ||
+		    loop_split_generator_check_cyclic_smooth_fan(
+		            mloops, mpolys, edge_to_loops, loop_to_poly, e2l_prev,
+		            ml_curr, ml_prev, ml_curr_index, ml_prev_index, mp_index))
+		{
+			common_data->loop_fan_start[ml_curr_index] = true;
+			fans_num++;
+		}
 
-	/* Temp edge vectors stack, only used when computing lnor spacearr (and we are not multi-threading). */
-	BLI_Stack *edge_vectors = NULL;
+		ml_prev = ml_curr;
+		ml_prev_index = ml_curr_index;
+	}
 
-#ifdef DEBUG_TIME
-	TIMEIT_START_AVERAGED(loop_split_generator);
-#endif
+	common_data->poly_fans_offset[mp_index] = fans_num;
+}
 
-	if (!pool) {
-		if (lnors_spacearr) {
-			edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
-		}
-	}
+/* Second pass, compute normals (and lnor spaces) of all fans starting in a polygon. */
+static void loop_split_generator_fans_calc_cb(
+        void *__restrict userdata,
+        const int mp_index,
+        const ParallelRangeTLS *__restrict tls)
+{
+	LoopSplitTaskDataCommon *common_data = userdata;
+	LoopSplitGeneratorTLS *tls_data = tls->userdata_chunk;
+	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+	float (*loopnors)[3] = common_data->loopnors;
 
-	/* We now know edges that can be smoothed (with their vector, and their two loops), and edges that will be hard!
-	 * Now, time to generate the normals.
-	 */
-	for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-		float (*lnors)[3];
-		const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
-		ml_curr_index = mp->loopstart;
-		ml_prev_index = ml_last_index;
+	const MLoop *mloops = common_data->mloops;
+	const MPoly *mpolys = common_data->mpolys;
+	const int (*edge_to_loops)[2] = (const int (*)[2])common_data->edge_to_loops;
 
-		ml_curr = &mloops[ml_curr_index];
-		ml_prev = &mloops[ml_prev_index];
-		lnors = &loopnors[ml_curr_index];
+	const MPoly *mp = &mpolys[mp_index];
+	const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+	int ml_curr_index = mp->loopstart;
+	int ml_prev_index = ml_last_index;
+	int fan_index = common_data->poly_fans_offset[mp_index];
+
+	const MLoop *ml_curr = &mloops[ml_curr_index];
+	const MLoop *ml_prev = &mloops[ml_prev_index];
 
-		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++, lnors++) {
+	for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+		if (common_data->loop_fan_start[ml_curr_index]) {
 			const int *e2l_curr = edge_to_loops[ml_curr->e];
 			const int *e2l_prev = edge_to_loops[ml_prev->e];
+			LoopSplitTaskData data = {NULL};
+
+			data.ml_curr = ml_curr;
+			data.ml_prev = ml_prev;
+			data.ml_curr_index = ml_curr_index;
+			data.mp_index = mp_index;
+			if (lnors_spacearr) {
+				data.lnor_space = &common_data->lnor_spaces[fan_index];
+			}
+			fan_index++;
 
-//			printf("Checking loop %d / edge %u / vert %u (sharp edge: %d, skiploop: %d)...",
-//			       ml_curr_index, ml_curr->e, ml_curr->v, IS_EDGE_SHARP(e2l_curr), BLI_BITMAP_TEST_BOOL(skip_loops, ml_curr_index));
-
-			/* A smooth edge, we have to check for cyclic smooth fan case.
-			 * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge as
-			 * 'entry point', otherwise we can skip it. */
-			/* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
-			 * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around the vert during
-			 * actual computation of clnor & clnorspace. However, this would complicate the code, add more memory usage,
-			 * and despite its logical complexity, loop_manifold_fan_around_vert_next() is quite cheap in term of
-			 * CPU cycles, so really think it's not worth it. */
-			if (!IS_EDGE_SHARP(e2l_curr) &&
-			    (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-			     !loop_split_generator_check_cyclic_smooth_fan(
-			              mloops, mpolys, edge_to_loops, loop_to_poly, e2l_prev, skip_loops,
-			              ml_curr, ml_prev, ml_curr_index, ml_prev_index, mp_index)))
-			{
-//				printf("SKIPPING!\n");
+			if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
+				data.lnor = &loopnors[ml_curr_index];
 			}
+			/* We *do not need* to check/tag loops as already computed!
+			 * Due to the fact a loop only links to one of its two edges, a same fan *will never be walked
+			 * more than once!*
+			 * Since we consider edges having neighbor polys with inverted (flipped) normals as sharp, we are sure
+			 * that no fan will be skipped, even only considering the case (sharp curr_edge, smooth prev_edge),
+			 * and not the alternative (smooth curr_edge, sharp prev_edge).
+			 * All this due/thanks to link between normals and loop ordering (i.e. winding).
+			 */
 			else {
-				LoopSplitTaskData *data, data_local;
+				data.ml_prev_index = ml_prev_index;
+				data.e2l_prev = e2l_prev;  /* Also tag as 'fan' task. */
+				if (lnors_spacearr && tls_data->edge_vectors == NULL) {
+					tls_data->edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+				}
+			}
 
-//				printf("PROCESSING!\n");
+			loop_split_worker_do(common_data, &data, tls_data->edge_vectors);
+		}
 
-				if (pool) {
-					if (data_idx == 0) {
-						data_buff = MEM_calloc_arrayN(LOOP_SPLIT_TASK_BLOCK_SIZE, sizeof(*data_buff), __func__);
-					}
-					data = &data_buff[data_idx];
-				}
-				else {
-					data = &data_local;
-					memset(data, 0, sizeof(*data));
-				}
+		ml_prev = ml_curr;
+		ml_prev_index = ml_curr_index;
+	}
+	BLI_assert(fan_index == common_data->poly_fans_offset[mp_index + 1]);
+}
 
-				if (IS_EDGE_SHARP(e2l_curr) && IS_EDGE_SHARP(e2l_prev)) {
-					data->lnor = lnors;
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-#if 0  /* Not needed for 'single' loop. */
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = NULL;  /* Tag as 'single' task. */
-#endif
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-					}
-				}
-				/* We *do not need* to check/tag loops as already computed!
-				 * Due to the fact a loop only links to one of its two edges, a same fan *will never be walked
-				 * more than once!*
-				 * Since we consider edges having neighbor polys with inverted (flipped) normals as sharp, we are sure
-				 * that no fan will be skipped, even only considering the case (sharp curr_edge, smooth prev_edge),
-				 * and not the alternative (smooth curr_edge, sharp prev_edge).
-				 * All this due/thanks to link between normals and loop ordering (i.e. winding).
-				 */
-				else {
-#if 0  /* Not needed for 'fan' loops. */
-					data->lnor = lnors;
+static void loop_split_generator_fans_calc_finalize(
+        void *__restrict UNUSED(userdata),
+        void *__restrict userdata_chunk)
+{
+	LoopSplitGeneratorTLS *tls_data = userdata_chunk;
+
+	if (tls_data->edge_vectors) {
+		BLI_stack_free(tls_data->edge_vectors);
+	}
+}
+
+/**
+ * Find all smooth fans (and single loops), then compute their normals (and lnor spaces).
+ *
+ * Both passes loop over polygons independently, so they are threaded.
+ * In between, the number of fans starting in each polygon gives where their lnor spaces are,
+ * those are allocated all at once.
+ */
+static void loop_split_generator(LoopSplitTaskDataCommon *common_data, const bool use_threading)
+{
+	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
+	const int numLoops = common_data->numLoops;
+	const int numPolys = common_data->numPolys;
+	int fans_num = 0;
+
+#ifdef DEBUG_TIME
+	TIMEIT_START_AVERAGED(loop_split_generator);
 #endif
-					data->ml_curr = ml_curr;
-					data->ml_prev = ml_prev;
-					data->ml_curr_index = ml_curr_index;
-					data->ml_prev_index = ml_prev_index;
-					data->e2l_prev = e2l_prev;  /* Also tag as 'fan' task. */
-					data->mp_index = mp_index;
-					if (lnors_spacearr) {
-						data->lnor_space = BKE_lnor_space_create(lnors_spacearr);
-					}
-				}
 
-				if (pool) {
-					data_idx++;
-					if (data_idx == LOOP_SPLIT_TASK_BLOCK_SIZE) {
-						BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
-						data_idx = 0;
-					}
-				}
-				else {
-					loop_split_worker_do(common_data, data, edge_vectors);
-				}
-			}
+	common_data->loop_fan_start = MEM_calloc_arrayN((size_t)numLoops, sizeof(*common_data->loop_fan_start), __func__);
+	common_data->poly_fans_offset = MEM_malloc_arrayN(
+	        (size_t)numPolys + 1, sizeof(*common_data->poly_fans_offset), __func__);
 
-			ml_prev = ml_curr;
-			ml_prev_index = ml_curr_index;
-		}
-	}
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = use_threading;
+	settings.min_iter_per_thread = LOOP_SPLIT_TASK_BLOCK_SIZE;
+
+	BLI_task_parallel_range(0, numPolys, common_data, loop_split_generator_fans_find_cb, &settings);
 
-	/* Last block of data... Since it is calloc'ed and we use first NULL item as stopper, everything is fine. */
-	if (pool && data_idx) {
-		BLI_task_pool_push(pool, loop_split_worker, data_buff, true, TASK_PRIORITY_LOW);
+	/* Counts to offsets. */
+	for (int mp_index = 0; mp_index < numPolys; mp_index++) {
+		const int poly_fans_num = common_data->poly_fans_offset[mp_index];
+		common_data->poly_fans_offset[mp_index] = fans_num;
+		fans_num += poly_fans_num;
 	}
+	common_data->poly_fans_offset[numPolys] = fans_num;
 
-	if (edge_vectors) {
-		BLI_stack_free(edge_vectors);
+	if (lnors_spacearr) {
+		common_data->lnor_spaces = BLI_memarena_calloc(
+		        lnors_spacearr->mem, sizeof(*common_data->lnor_spaces) * (size_t)max_ii(fans_num, 1));
 	}
-	MEM_freeN(skip_loops);
+
+	LoopSplitGeneratorTLS tls_data = {NULL};
+	settings.userdata_chunk = &tls_data;
+	settings.userdata_chunk_size = sizeof(tls_data);
+	settings.func_finalize = loop_split_generator_fans_calc_finalize;
+
+	BLI_task_parallel_range(0, numPolys, common_data, loop_split_generator_fans_calc_cb, &settings);
+
+	MEM_freeN(common_data->loop_fan_start);
+	MEM_freeN(common_data->poly_fans_offset);
+	common_data->loop_fan_start = NULL;
+	common_data->poly_fans_offset = NULL;
+	common_data->lnor_spaces = NULL;
 
 #ifdef DEBUG_TIME
 	TIMEIT_END_AVERAGED(loop_split_generator);
@@ -1520,23 +1670,8 @@ void BKE_mesh_normals_loop_split(
 	/* This first loop check which edges are actually smooth, and compute edge vectors. */
 	mesh_edges_sharp_tag(&common_data, check_angle, split_angle, false);
 
-	if (numLoops < LOOP_SPLIT_TASK_BLOCK_SIZE * 8) {
-		/* Not enough loops to be worth the whole threading overhead... */
-		loop_split_generator(NULL, &common_data);
-	}
-	else {
-		TaskScheduler *task_scheduler;
-		TaskPool *task_pool;
-
-		task_scheduler = BLI_task_scheduler_get();
-		task_pool = BLI_task_pool_create(task_scheduler, &common_data);
-
-		loop_split_generator(task_pool, &common_data);
-
-		BLI_task_pool_work_and_wait(task_pool);
-
-		BLI_task_pool_free(task_pool);
-	}
+	/* Not enough loops to be worth the whole threading overhead otherwise... */
+	loop_split_generator(&common_data, numLoops >= LOOP_SPLIT_TASK_BLOCK_SIZE * 8);
 
 	MEM_freeN(edge_to_loops);
 	if (!r_loop_to_poly) {
@@ -1554,6 +1689,390 @@ void BKE_mesh_normals_loop_split(
 #endif
 }
 
+/* Normalized vector from the pivot vertex along given edge. */
+BLI_INLINE void loop_split_edge_vector(
+        const MVert *mverts, const MEdge *me, const unsigned int mv_pivot_index, float r_vec[3])
+{
+	const unsigned int mv_other_index = (me->v1 == mv_pivot_index) ? me->v2 : me->v1;
+
+	sub_v3_v3v3(r_vec, mverts[mv_other_index].co, mverts[mv_pivot_index].co);
+	normalize_v3(r_vec);
+}
+
+BLI_INLINE void loop_split_space_reset(MLoopNorSpace *lnor_space)
+{
+	/* Same state as a newly created space, only loops are kept. */
+	zero_v3(lnor_space->vec_lnor);
+	zero_v3(lnor_space->vec_ref);
+	zero_v3(lnor_space->vec_ortho);
+	lnor_space->ref_alpha = lnor_space->ref_beta = 0.0f;
+}
+
+/**
+ * Partial version of #BKE_mesh_normals_loop_split, only updates loops using vertices tagged in \a verts_update
+ * (see #BKE_mesh_calc_normals_poly_partial).
+ *
+ * Smooth fans are not searched again, the ones cached in \a lnors_spacearr by a previous
+ * #BKE_mesh_normals_loop_split call are re-used (so topology and sharp edges must be unchanged),
+ * only their normals and spaces are re-calculated.
+ *
+ * \param loop_to_poly: As returned in \a r_loop_to_poly by #BKE_mesh_normals_loop_split.
+ * \return false when cached fans can't be re-used because sharpness depends on geometry (split angle),
+ * nothing is done then and a full #BKE_mesh_normals_loop_split is needed.
+ */
+bool BKE_mesh_normals_loop_split_partial(
+        const MVert *mverts, const MEdge *medges,
+        const MLoop *mloops, float (*r_loopnors)[3], const int numLoops,
+        const MPoly *mpolys, const float (*polynors)[3],
+        const bool use_split_normals, const float split_angle,
+        MLoopNorSpaceArray *lnors_spacearr, short (*clnors_data)[2], const int *loop_to_poly,
+        const BLI_bitmap *verts_update)
+{
+	int ml_index;
+
+	if (!use_split_normals) {
+		/* Same as in #BKE_mesh_normals_loop_split. */
+		for (ml_index = 0; ml_index < numLoops; ml_index++) {
+			const unsigned int mv_index = mloops[ml_index].v;
+			if (BLI_BITMAP_TEST(verts_update, mv_index)) {
+				const int mp_index = loop_to_poly[ml_index];
+				if ((mpolys[mp_index].flag & ME_SMOOTH) == 0) {
+					copy_v3_v3(r_loopnors[ml_index], polynors[mp_index]);
+				}
+				else {
+					normal_short_to_float_v3(r_loopnors[ml_index], mverts[mv_index].no);
+				}
+			}
+		}
+		return true;
+	}
+
+	if ((split_angle < (float)M_PI) && (clnors_data == NULL)) {
+		/* Moving vertices may change which edges are sharp, so fans may have changed too. */
+		return false;
+	}
+
+	BLI_assert(lnors_spacearr && lnors_spacearr->lspacearr);
+	BLI_assert(lnors_spacearr->data_type == MLNOR_SPACEARR_LOOP_INDEX);
+
+	BLI_bitmap *done_loops = BLI_BITMAP_NEW(numLoops, __func__);
+	BLI_Stack *edge_vectors = BLI_stack_new(sizeof(float[3]), __func__);
+	/* Loops of current fan, in the order they are walked by #split_loop_nor_fan_do. */
+	int *fan_loops = NULL;
+	int fan_loops_alloc = 0;
+
+	for (ml_index = 0; ml_index < numLoops; ml_index++) {
+		if (!BLI_BITMAP_TEST(verts_update, mloops[ml_index].v) || BLI_BITMAP_TEST(done_loops, ml_index)) {
+			continue;
+		}
+
+		MLoopNorSpace *lnor_space = lnors_spacearr->lspacearr[ml_index];
+		const unsigned int mv_pivot_index = mloops[ml_index].v;
+
+		if (lnor_space->flags & MLNOR_SPACE_IS_SINGLE) {
+			/* See #split_loop_nor_single_do. */
+			const int mp_index = loop_to_poly[ml_index];
+			const MPoly *mp = &mpolys[mp_index];
+			const int ml_prev_index = (ml_index == mp->loopstart) ? mp->loopstart + mp->totloop - 1 : ml_index - 1;
+			float vec_curr[3], vec_prev[3];
+
+			BLI_assert(GET_INT_FROM_POINTER(lnor_space->loops) == ml_index);
+
+			copy_v3_v3(r_loopnors[ml_index], polynors[mp_index]);
+
+			loop_split_edge_vector(mverts, &medges[mloops[ml_index].e], mv_pivot_index, vec_curr);
+			loop_split_edge_vector(mverts, &medges[mloops[ml_prev_index].e], mv_pivot_index, vec_prev);
+
+			loop_split_space_reset(lnor_space);
+			BKE_lnor_space_define(lnor_space, r_loopnors[ml_index], vec_curr, vec_prev, NULL);
+
+			if (clnors_data) {
+				BKE_lnor_space_custom_data_to_normal(lnor_space, clnors_data[ml_index], r_loopnors[ml_index]);
+			}
+			BLI_BITMAP_ENABLE(done_loops, ml_index);
+		}
+		else {
+			/* See #split_loop_nor_fan_do, loops are prepended while walking the fan,
+			 * so the last one in the list is where the walk started. */
+			float lnor[3] = {0.0f, 0.0f, 0.0f};
+			float vec_org[3], vec_curr[3], vec_own[3];
+			unsigned int me_org_index;
+			int fan_loops_num = 0;
+
+			for (LinkNode *node = lnor_space->loops; node; node = node->next) {
+				if (fan_loops_num == fan_loops_alloc) {
+					fan_loops_alloc = max_ii(fan_loops_alloc * 2, 16);
+					fan_loops = MEM_reallocN(fan_loops, sizeof(*fan_loops) * (size_t)fan_loops_alloc);
+				}
+				fan_loops[fan_loops_num++] = GET_INT_FROM_POINTER(node->link);
+			}
+			BLI_assert(fan_loops_num > 0);
+
+			me_org_index = mloops[fan_loops[fan_loops_num - 1]].e;
+			loop_split_edge_vector(mverts, &medges[me_org_index], mv_pivot_index, vec_org);
+			BLI_stack_push(edge_vectors, vec_org);
+
+			for (int i = fan_loops_num - 1; i >= 0; i--) {
+				/* Each poly of the fan is entered by the edge of its loop, and left by the edge of the previous loop
+				 * (that's the winding all smooth fans have). */
+				const int mlfan_index = fan_loops[i];
+				const int mpfan_index = loop_to_poly[mlfan_index];
+				const MPoly *mpfan = &mpolys[mpfan_index];
+				const int mlfan_prev_index = (mlfan_index == mpfan->loopstart) ?
+				                             mpfan->loopstart + mpfan->totloop - 1 : mlfan_index - 1;
+				const unsigned int me_curr_index = mloops[mlfan_prev_index].e;
+
+				loop_split_edge_vector(mverts, &medges[mloops[mlfan_index].e], mv_pivot_index, vec_own);
+				loop_split_edge_vector(mverts, &medges[me_curr_index], mv_pivot_index, vec_curr);
+
+				madd_v3_v3fl(lnor, polynors[mpfan_index], saacos(dot_v3v3(vec_curr, vec_own)));
+
+				if (me_curr_index != me_org_index) {
+					BLI_stack_push(edge_vectors, vec_curr);
+				}
+				BLI_BITMAP_ENABLE(done_loops, mlfan_index);
+			}
+
+			float lnor_len = normalize_v3(lnor);
+			if (UNLIKELY(lnor_len == 0.0f)) {
+				/* Use previous normal as fallback! */
+				copy_v3_v3(lnor, r_loopnors[fan_loops[0]]);
+				lnor_len = 1.0f;
+			}
+
+			loop_split_space_reset(lnor_space);
+			BKE_lnor_space_define(lnor_space, lnor, vec_org, vec_curr, edge_vectors);
+
+			if (clnors_data) {
+				/* Custom normals of a fan were already validated by the full calculation. */
+				BKE_lnor_space_custom_data_to_normal(lnor_space, clnors_data[fan_loops[fan_loops_num - 1]], lnor);
+			}
+
+			for (int i = 0; i < fan_loops_num; i++) {
+				copy_v3_v3(r_loopnors[fan_loops[i]], lnor);
+			}
+		}
+	}
+
+	MEM_SAFE_FREE(fan_loops);
+	BLI_stack_free(edge_vectors);
+	MEM_freeN(done_loops);
+
+	return true;
+}
+
+/**
+ * Normals of a mesh which vertices were moved (typically by deform-only modifiers),
+ * kept between evaluations so only normals around vertices that moved since need updating.
+ */
+typedef struct MeshDeformNormalsCache {
+	int totvert, totedge, totloop, totpoly;
+	/* Hash of topology, sharp/smooth flags and custom normals, the cached fans depend on them. */
+	uint32_t topology_hash;
+	bool use_loop_normals, use_split_normals;
+	float split_angle;
+
+	/* Coordinates normals were calculated for. */
+	float (*vert_cos)[3];
+	short (*vert_nos)[3];
+	float (*polynors)[3];
+	float (*loopnors)[3];
+	int *loop_to_poly;
+	MLoopNorSpaceArray lnors_spacearr;
+} MeshDeformNormalsCache;
+
+static uint32_t mesh_deform_normals_topology_hash(
+        const MEdge *medges, const int numEdges, const MLoop *mloops, const int numLoops,
+        const MPoly *mpolys, const int numPolys, const short (*clnors_data)[2])
+{
+	BLI_HashMurmur2A mm2;
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)medges, sizeof(*medges) * (size_t)numEdges);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)mloops, sizeof(*mloops) * (size_t)numLoops);
+	BLI_hash_mm2a_add(&mm2, (const unsigned char *)mpolys, sizeof(*mpolys) * (size_t)numPolys);
+	if (clnors_data) {
+		BLI_hash_mm2a_add(&mm2, (const unsigned char *)clnors_data, sizeof(*clnors_data) * (size_t)numLoops);
+	}
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+static MeshDeformNormalsCache *mesh_deform_normals_cache_ensure(
+        MeshDeformNormalsCache **cache_p,
+        const int numVerts, const int numEdges, const int numLoops, const int numPolys,
+        const bool use_loop_normals)
+{
+	MeshDeformNormalsCache *cache = *cache_p;
+
+	if (cache &&
+	    (cache->totvert == numVerts) && (cache->totedge == numEdges) &&
+	    (cache->totloop == numLoops) && (cache->totpoly == numPolys) &&
+	    (cache->use_loop_normals == use_loop_normals))
+	{
+		return cache;
+	}
+
+	if (cache) {
+		BKE_mesh_deform_normals_cache_free(cache);
+	}
+
+	cache = MEM_callocN(sizeof(*cache), __func__);
+	cache->totvert = numVerts;
+	cache->totedge = numEdges;
+	cache->totloop = numLoops;
+	cache->totpoly = numPolys;
+	cache->use_loop_normals = use_loop_normals;
+
+	cache->vert_cos = MEM_malloc_arrayN((size_t)numVerts, sizeof(*cache->vert_cos), __func__);
+	cache->vert_nos = MEM_malloc_arrayN((size_t)numVerts, sizeof(*cache->vert_nos), __func__);
+	cache->polynors = MEM_malloc_arrayN((size_t)numPolys, sizeof(*cache->polynors), __func__);
+	if (use_loop_normals) {
+		cache->loopnors = MEM_malloc_arrayN((size_t)numLoops, sizeof(*cache->loopnors), __func__);
+		cache->loop_to_poly = MEM_malloc_arrayN((size_t)numLoops, sizeof(*cache->loop_to_poly), __func__);
+	}
+
+	*cache_p = cache;
+	return cache;
+}
+
+/**
+ * Calculate vertex, poly and optionally loop normals of a mesh which only had its vertices moved
+ * since the previous call with the same \a cache_p, (e.g. by deform-only modifiers).
+ *
+ * When topology, flags and settings match the cached ones, only normals around vertices which moved
+ * are updated, using #BKE_mesh_calc_normals_poly_partial and #BKE_mesh_normals_loop_split_partial.
+ * Otherwise normals are fully calculated, and the cache is reset.
+ *
+ * \param cache_p: Cache owned by the caller, created when NULL,
+ * free with #BKE_mesh_deform_normals_cache_free.
+ * \param r_loopnors: Optional, loop normals are only calculated when given.
+ * \return true when normals were partially updated from the cache.
+ */
+bool BKE_mesh_calc_normals_deform_cached(
+        MeshDeformNormalsCache **cache_p,
+        MVert *mverts, const int numVerts, MEdge *medges, const int numEdges,
+        MLoop *mloops, float (*r_loopnors)[3], const int numLoops,
+        MPoly *mpolys, float (*r_polynors)[3], const int numPolys,
+        const bool use_split_normals, const float split_angle, short (*clnors_data)[2])
+{
+	MeshDeformNormalsCache *cache = *cache_p;
+	const bool use_loop_normals = (r_loopnors != NULL);
+	const short (*clnors_hash)[2] = use_loop_normals ? (const short (*)[2])clnors_data : NULL;
+	BLI_bitmap *verts_dirty = NULL, *verts_update = NULL;
+	bool use_partial = false;
+	int i;
+
+	if (cache &&
+	    (cache->totvert == numVerts) && (cache->totedge == numEdges) &&
+	    (cache->totloop == numLoops) && (cache->totpoly == numPolys) &&
+	    (cache->use_loop_normals == use_loop_normals) &&
+	    (!use_loop_normals ||
+	     ((cache->use_split_normals == use_split_normals) && (cache->split_angle == split_angle))) &&
+	    (cache->topology_hash == mesh_deform_normals_topology_hash(
+	             medges, numEdges, mloops, numLoops, mpolys, numPolys, clnors_hash)))
+	{
+		int verts_dirty_num = 0;
+
+		verts_dirty = BLI_BITMAP_NEW(numVerts, __func__);
+		for (i = 0; i < numVerts; i++) {
+			if (!equals_v3v3(mverts[i].co, cache->vert_cos[i])) {
+				BLI_BITMAP_ENABLE(verts_dirty, i);
+				verts_dirty_num++;
+			}
+		}
+
+		/* When most vertices moved, a full update is cheaper. */
+		use_partial = (verts_dirty_num <= numVerts / 2);
+	}
+
+	if (use_partial) {
+		verts_update = BLI_BITMAP_NEW(numVerts, __func__);
+		for (i = 0; i < numVerts; i++) {
+			copy_v3_v3_short(mverts[i].no, cache->vert_nos[i]);
+		}
+
+		BKE_mesh_calc_normals_poly_partial(
+		        mverts, NULL, numVerts, mloops, mpolys, numLoops, numPolys, cache->polynors,
+		        verts_dirty, verts_update);
+		memcpy(r_polynors, cache->polynors, sizeof(*r_polynors) * (size_t)numPolys);
+
+		for (i = 0; i < numVerts; i++) {
+			if (BLI_BITMAP_TEST(verts_dirty, i)) {
+				copy_v3_v3(cache->vert_cos[i], mverts[i].co);
+			}
+			if (BLI_BITMAP_TEST(verts_update, i)) {
+				copy_v3_v3_short(cache->vert_nos[i], mverts[i].no);
+			}
+		}
+	}
+	else {
+		cache = mesh_deform_normals_cache_ensure(cache_p, numVerts, numEdges, numLoops, numPolys, use_loop_normals);
+
+		BKE_mesh_calc_normals_poly(
+		        mverts, NULL, numVerts, mloops, mpolys, numLoops, numPolys, r_polynors, false);
+		memcpy(cache->polynors, r_polynors, sizeof(*r_polynors) * (size_t)numPolys);
+
+		for (i = 0; i < numVerts; i++) {
+			copy_v3_v3(cache->vert_cos[i], mverts[i].co);
+			copy_v3_v3_short(cache->vert_nos[i], mverts[i].no);
+		}
+	}
+
+	if (use_loop_normals) {
+		/* Fans can't be re-used when sharp edges depend on the split angle,
+		 * loop normals are fully calculated then, but vertex and poly normals stay partial. */
+		if (use_partial &&
+		    BKE_mesh_normals_loop_split_partial(
+		        mverts, medges, mloops, cache->loopnors, numLoops, mpolys, (const float (*)[3])cache->polynors,
+		        use_split_normals, split_angle, &cache->lnors_spacearr, clnors_data, cache->loop_to_poly,
+		        verts_update))
+		{
+			memcpy(r_loopnors, cache->loopnors, sizeof(*r_loopnors) * (size_t)numLoops);
+		}
+		else {
+			if (cache->lnors_spacearr.mem) {
+				BKE_lnor_spacearr_clear(&cache->lnors_spacearr);
+			}
+			BKE_mesh_normals_loop_split(
+			        mverts, numVerts, medges, numEdges, mloops, r_loopnors, numLoops,
+			        mpolys, (const float (*)[3])r_polynors, numPolys,
+			        use_split_normals, split_angle, use_split_normals ? &cache->lnors_spacearr : NULL,
+			        clnors_data, cache->loop_to_poly);
+			memcpy(cache->loopnors, r_loopnors, sizeof(*r_loopnors) * (size_t)numLoops);
+		}
+	}
+
+	if (!use_partial) {
+		/* Hashed after the full calculation, which may have validated custom normals. */
+		cache->topology_hash = mesh_deform_normals_topology_hash(
+		        medges, numEdges, mloops, numLoops, mpolys, numPolys, clnors_hash);
+		cache->use_split_normals = use_split_normals;
+		cache->split_angle = split_angle;
+	}
+
+	if (verts_dirty) {
+		MEM_freeN(verts_dirty);
+	}
+	if (verts_update) {
+		MEM_freeN(verts_update);
+	}
+
+	return use_partial;
+}
+
+void BKE_mesh_deform_normals_cache_free(MeshDeformNormalsCache *cache)
+{
+	MEM_freeN(cache->vert_cos);
+	MEM_freeN(cache->vert_nos);
+	MEM_freeN(cache->polynors);
+	MEM_SAFE_FREE(cache->loopnors);
+	MEM_SAFE_FREE(cache->loop_to_poly);
+	if (cache->lnors_spacearr.mem) {
+		BKE_lnor_spacearr_free(&cache->lnors_spacearr);
+	}
+	MEM_freeN(cache);
+}
+
 #undef INDEX_UNSET
 #undef INDEX_INVALID
 #undef IS_EDGE_SHARP
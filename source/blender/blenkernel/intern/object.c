@@ -464,6 +464,11 @@ void BKE_object_free(Object *ob)
 		ob->curve_cache = NULL;
 	}
 
+	if (ob->deform_normals_cache) {
+		BKE_mesh_deform_normals_cache_free(ob->deform_normals_cache);
+		ob->deform_normals_cache = NULL;
+	}
+
 	BKE_previewimg_free(&ob->preview);
 }
 
@@ -1168,6 +1173,7 @@ void BKE_object_copy_data(Main *UNUSED(bmain), Object *ob_dst, const Object *ob_
 	
 	ob_dst->derivedDeform = NULL;
 	ob_dst->derivedFinal = NULL;
+	ob_dst->deform_normals_cache = NULL;
 
 	BLI_listbase_clear(&ob_dst->gpulamp);
 	BLI_listbase_clear(&ob_dst->pc_ids);
@@ -0,0 +1,132 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BLI_GHASH_FLAT_H__
+#define __BLI_GHASH_FLAT_H__
+
+/** \file BLI_ghash_flat.h
+ *  \ingroup bli
+ *
+ * GHashFlat is an open-addressing hash-map (unordered key, value pairs).
+ *
+ * Unlike #GHash, keys and values are stored inline in a single array, next to
+ * an array of one metadata byte per slot, which is probed 16 slots at a time.
+ * This avoids a pointer chase (and likely a cache miss) per lookup, at the
+ * cost of entries moving in memory when the hash grows.
+ *
+ * \note Pointers returned by #BLI_ghash_flat_lookup_p and
+ * #BLI_ghash_flat_ensure_p are only valid until the next insertion.
+ */
+
+#include "BLI_sys_types.h" /* for bool */
+#include "BLI_compiler_attrs.h"
+
+#include "BLI_ghash.h"  /* for callback types */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct GHashFlat GHashFlat;
+
+typedef struct GHashFlatIterator {
+	GHashFlat *gh;
+	struct GHashFlatEntry *curr_entry;
+	unsigned int curr_slot;
+} GHashFlatIterator;
+
+/** \name GHashFlat API
+ *
+ * Defined in ``BLI_ghash_flat.c``
+ * \{ */
+
+GHashFlat *BLI_ghash_flat_new_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_new(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+void   BLI_ghash_flat_free(GHashFlat *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void   BLI_ghash_flat_reserve(GHashFlat *gh, const unsigned int nentries_reserve);
+void   BLI_ghash_flat_insert(GHashFlat *gh, void *key, void *val);
+bool   BLI_ghash_flat_reinsert(
+        GHashFlat *gh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_ghash_flat_lookup(GHashFlat *gh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void  *BLI_ghash_flat_lookup_default(GHashFlat *gh, const void *key, void *val_default) ATTR_WARN_UNUSED_RESULT;
+void **BLI_ghash_flat_lookup_p(GHashFlat *gh, const void *key) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_flat_ensure_p(GHashFlat *gh, void *key, void ***r_val) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_flat_remove(GHashFlat *gh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+void  *BLI_ghash_flat_popkey(GHashFlat *gh, const void *key, GHashKeyFreeFP keyfreefp) ATTR_WARN_UNUSED_RESULT;
+bool   BLI_ghash_flat_haskey(GHashFlat *gh, const void *key) ATTR_WARN_UNUSED_RESULT;
+void   BLI_ghash_flat_clear(GHashFlat *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp);
+unsigned int BLI_ghash_flat_len(GHashFlat *gh) ATTR_WARN_UNUSED_RESULT;
+
+/**
+ * Specialized hashes, hashing and comparison of the keys is inlined.
+ */
+GHashFlat *BLI_ghash_flat_ptr_new_ex(
+        const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_ptr_new(
+        const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_int_new_ex(
+        const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_int_new(
+        const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_str_new_ex(
+        const char *info, const unsigned int nentries_reserve) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+GHashFlat *BLI_ghash_flat_str_new(
+        const char *info) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT;
+
+/** \} */
+
+/** \name GHashFlat Iterator
+ * \{ */
+
+void           BLI_ghash_flatIterator_init(GHashFlatIterator *ghi, GHashFlat *gh);
+void           BLI_ghash_flatIterator_step(GHashFlatIterator *ghi);
+
+BLI_INLINE void  *BLI_ghash_flatIterator_getKey(GHashFlatIterator *ghi) ATTR_WARN_UNUSED_RESULT;
+BLI_INLINE void  *BLI_ghash_flatIterator_getValue(GHashFlatIterator *ghi) ATTR_WARN_UNUSED_RESULT;
+BLI_INLINE void **BLI_ghash_flatIterator_getValue_p(GHashFlatIterator *ghi) ATTR_WARN_UNUSED_RESULT;
+BLI_INLINE bool   BLI_ghash_flatIterator_done(GHashFlatIterator *ghi) ATTR_WARN_UNUSED_RESULT;
+
+struct _ghf_Entry { void *key, *val; };
+BLI_INLINE void  *BLI_ghash_flatIterator_getKey(GHashFlatIterator *ghi)     { return  ((struct _ghf_Entry *)ghi->curr_entry)->key; }
+BLI_INLINE void  *BLI_ghash_flatIterator_getValue(GHashFlatIterator *ghi)   { return  ((struct _ghf_Entry *)ghi->curr_entry)->val; }
+BLI_INLINE void **BLI_ghash_flatIterator_getValue_p(GHashFlatIterator *ghi) { return &((struct _ghf_Entry *)ghi->curr_entry)->val; }
+BLI_INLINE bool   BLI_ghash_flatIterator_done(GHashFlatIterator *ghi)       { return !ghi->curr_entry; }
+/* disallow further access */
+#ifdef __GNUC__
+#  pragma GCC poison _ghf_Entry
+#else
+#  define _ghf_Entry void
+#endif
+
+#define GHASH_FLAT_ITER(gh_iter_, ghash_) \
+	for (BLI_ghash_flatIterator_init(&gh_iter_, ghash_); \
+	     BLI_ghash_flatIterator_done(&gh_iter_) == false; \
+	     BLI_ghash_flatIterator_step(&gh_iter_))
+
+/** \} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __BLI_GHASH_FLAT_H__ */
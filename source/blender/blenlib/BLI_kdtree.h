@@ -66,6 +66,13 @@ void BLI_kdtree_range_search_cb(
         const KDTree *tree, const float co[3], float range,
         bool (*search_cb)(void *user_data, int index, const float co[3], float dist_sq), void *user_data);
 
+void BLI_kdtree_find_nearest_batch(
+        const KDTree *tree, const float (*co)[3], const unsigned int co_len,
+        KDTreeNearest *r_nearest) ATTR_NONNULL(1, 4);
+void BLI_kdtree_range_search_batch(
+        const KDTree *tree, const float (*co)[3], const unsigned int co_len, const float range,
+        KDTreeNearest **r_nearest, int *r_nearest_len) ATTR_NONNULL(1, 5, 6);
+
 int BLI_kdtree_calc_duplicates_fast(
         const KDTree *tree, const float range, bool use_index_order,
         int *doubles);
@@ -61,6 +61,12 @@ void      **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr) ATTR_
 void        BLI_mempool_as_array(BLI_mempool *pool, void *data) ATTR_NONNULL(1, 2);
 void       *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1, 2);
 
+void        BLI_mempool_thread_cache_init(BLI_mempool *pool, const int num_threads) ATTR_NONNULL(1);
+void        BLI_mempool_thread_cache_flush(BLI_mempool *pool) ATTR_NONNULL(1);
+void       *BLI_mempool_alloc_thread(BLI_mempool *pool, const int thread_id) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void       *BLI_mempool_calloc_thread(BLI_mempool *pool, const int thread_id) ATTR_MALLOC ATTR_WARN_UNUSED_RESULT ATTR_NONNULL(1);
+void        BLI_mempool_free_thread(BLI_mempool *pool, void *addr, const int thread_id) ATTR_NONNULL(1, 2);
+
 #ifndef NDEBUG
 void        BLI_mempool_set_memory_debug(void);
 #endif
@@ -42,7 +42,9 @@ struct BLI_mempool;
 /* Task Scheduler
  * 
  * Central scheduler that holds running threads ready to execute tasks. A single
- * queue holds the task from all pools.
+ * queue holds the task from all pools pushed from outside of the scheduler
+ * threads, tasks pushed from within running tasks go to the per-thread local
+ * queues, from which idle threads steal work.
  *
  * Init/exit must be called before/after any task pools are created/freed, and
  * must be called from the main threads. All other scheduler and pool functions
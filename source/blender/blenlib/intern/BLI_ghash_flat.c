@@ -0,0 +1,701 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/blenlib/intern/BLI_ghash_flat.c
+ *  \ingroup bli
+ *
+ * A general (pointer -> pointer) open-addressing hash table.
+ *
+ * Slots are split into groups of #GHASH_FLAT_GROUP_SIZE. For every slot there
+ * is a control byte, which is either empty, deleted, or holds 7 bits of the
+ * key's hash. Lookup compares control bytes of a whole group against the hash
+ * bits at once (using SSE2 when available), and only compares keys of the
+ * slots which matched. Groups are probed using triangular numbers, which
+ * visits every group for power of two sizes.
+ *
+ * Keys and values are stored inline in the slots array, so unlike #GHash
+ * there is no per-entry allocation and no pointer chasing.
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <limits.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_sys_types.h"  /* for intptr_t support */
+#include "BLI_utildefines.h"
+#include "BLI_math_base.h"
+#include "BLI_math_bits.h"
+
+#include "BLI_ghash_flat.h"  /* own include */
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
+/* keep last */
+#include "BLI_strict_flags.h"
+
+/* -------------------------------------------------------------------- */
+/** \name Structs & Constants
+ * \{ */
+
+#define GHASH_FLAT_GROUP_SIZE 16
+#define GHASH_FLAT_SLOTS_MIN GHASH_FLAT_GROUP_SIZE
+
+/**
+ * Max load, including deleted slots. Probing of a group stops at the first
+ * group which has an empty slot, so there must always be some.
+ */
+#define GHASH_FLAT_LIMIT_GROW(_nslots) (((_nslots) * 7) / 8)
+
+/* Control bytes, full slots store 7 bits of the hash (top bit unset). */
+#define CTRL_EMPTY   ((uint8_t)0x80)
+#define CTRL_DELETED ((uint8_t)0xfe)
+
+#define CTRL_IS_FULL(_ctrl) (((_ctrl) & 0x80) == 0)
+
+/* Split hash into the part which chooses the first group to probe, and the
+ * part which is stored in the control byte. */
+#define HASH_H1(_hash) (_hash)
+#define HASH_H2(_hash) ((uint8_t)((_hash) >> 25))
+
+/* WARNING! Keep in sync with ugly _ghf_Entry in header!!! */
+typedef struct GHashFlatEntry {
+	void *key;
+	void *val;
+} GHashFlatEntry;
+
+/* Specializations which avoid calling hash and comparison callbacks. */
+typedef enum eGHashFlatKeyType {
+	GHASH_FLAT_KEY_GENERIC = 0,
+	GHASH_FLAT_KEY_PTR,
+	GHASH_FLAT_KEY_INT,
+	GHASH_FLAT_KEY_STR,
+} eGHashFlatKeyType;
+
+struct GHashFlat {
+	GHashHashFP hashfp;
+	GHashCmpFP cmpfp;
+	eGHashFlatKeyType key_type;
+
+	GHashFlatEntry *entries;
+	/* Control bytes, one per slot, stored in the same allocation as entries. */
+	uint8_t *ctrl;
+	uint nslots;
+	uint group_mask;
+	uint limit_grow;
+
+	uint nentries;
+	uint ndeleted;
+};
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Internal Utility API
+ * \{ */
+
+BLI_INLINE uint ghash_flat_keyhash(GHashFlat *gh, const void *key)
+{
+	uint hash;
+	switch (gh->key_type) {
+		case GHASH_FLAT_KEY_PTR:
+		{
+			/* Same as BLI_ghashutil_ptrhash. */
+			size_t y = (size_t)key;
+			y = (y >> 4) | (y << (8 * sizeof(void *) - 4));
+			hash = (uint)y;
+			break;
+		}
+		case GHASH_FLAT_KEY_INT:
+		{
+			/* Same as BLI_ghashutil_uinthash. */
+			uint y = (uint)(uintptr_t)key;
+			y += ~(y << 16);
+			y ^=  (y >>  5);
+			y +=  (y <<  3);
+			y ^=  (y >> 13);
+			y += ~(y <<  9);
+			y ^=  (y >> 17);
+			hash = y;
+			break;
+		}
+		case GHASH_FLAT_KEY_STR:
+			hash = BLI_ghashutil_strhash_p(key);
+			break;
+		default:
+			hash = gh->hashfp(key);
+			break;
+	}
+	/* Spread bits of the hash (murmur3 finalizer), so both the group index and
+	 * the control byte are meaningful even for hashes which only use some of
+	 * the bits (pointers, small integers). */
+	hash ^= hash >> 16;
+	hash *= 0x85ebca6bu;
+	hash ^= hash >> 13;
+	hash *= 0xc2b2ae35u;
+	hash ^= hash >> 16;
+	return hash;
+}
+
+/**
+ * \return true when the keys are equal.
+ */
+BLI_INLINE bool ghash_flat_keyeq(GHashFlat *gh, const void *a, const void *b)
+{
+	switch (gh->key_type) {
+		case GHASH_FLAT_KEY_PTR:
+		case GHASH_FLAT_KEY_INT:
+			return (a == b);
+		case GHASH_FLAT_KEY_STR:
+			return STREQ(a, b);
+		default:
+			return !gh->cmpfp(a, b);
+	}
+}
+
+/**
+ * \return bit-mask of the slots in the group which control byte equals \a ctrl_value.
+ */
+BLI_INLINE uint ghash_flat_group_match(const uint8_t *group_ctrl, const uint8_t ctrl_value)
+{
+#ifdef __SSE2__
+	const __m128i ctrl = _mm_loadu_si128((const __m128i *)group_ctrl);
+	return (uint)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)ctrl_value)));
+#else
+	uint mask = 0;
+	for (uint i = 0; i < GHASH_FLAT_GROUP_SIZE; i++) {
+		if (group_ctrl[i] == ctrl_value) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+#endif
+}
+
+/**
+ * \return bit-mask of the slots in the group which are empty or deleted.
+ */
+BLI_INLINE uint ghash_flat_group_match_free(const uint8_t *group_ctrl)
+{
+#ifdef __SSE2__
+	/* Both empty and deleted have top bit set. */
+	return (uint)_mm_movemask_epi8(_mm_loadu_si128((const __m128i *)group_ctrl));
+#else
+	uint mask = 0;
+	for (uint i = 0; i < GHASH_FLAT_GROUP_SIZE; i++) {
+		if (!CTRL_IS_FULL(group_ctrl[i])) {
+			mask |= (1u << i);
+		}
+	}
+	return mask;
+#endif
+}
+
+/**
+ * Smallest power of two number of slots which can hold \a nentries.
+ */
+static uint ghash_flat_nslots_for(const uint nentries)
+{
+	uint nslots = GHASH_FLAT_SLOTS_MIN;
+	while (GHASH_FLAT_LIMIT_GROW(nslots) <= nentries) {
+		nslots <<= 1;
+	}
+	return nslots;
+}
+
+static void ghash_flat_slots_alloc(GHashFlat *gh, const uint nslots)
+{
+	BLI_assert(is_power_of_2_i((int)nslots));
+	BLI_assert(nslots >= GHASH_FLAT_SLOTS_MIN);
+
+	gh->entries = MEM_mallocN((sizeof(GHashFlatEntry) + sizeof(uint8_t)) * nslots, __func__);
+	gh->ctrl = (uint8_t *)(gh->entries + nslots);
+	memset(gh->ctrl, CTRL_EMPTY, nslots);
+
+	gh->nslots = nslots;
+	gh->group_mask = (nslots / GHASH_FLAT_GROUP_SIZE) - 1;
+	gh->limit_grow = GHASH_FLAT_LIMIT_GROW(nslots);
+	gh->ndeleted = 0;
+}
+
+/**
+ * Find slot to insert new entry to, key must not be in the hash already.
+ */
+BLI_INLINE uint ghash_flat_find_free_slot(GHashFlat *gh, const uint hash)
+{
+	uint group = HASH_H1(hash) & gh->group_mask;
+	for (uint step = 1; ; step++) {
+		const uint mask = ghash_flat_group_match_free(&gh->ctrl[group * GHASH_FLAT_GROUP_SIZE]);
+		if (mask != 0) {
+			return group * GHASH_FLAT_GROUP_SIZE + bitscan_forward_uint(mask);
+		}
+		group = (group + step) & gh->group_mask;
+	}
+}
+
+BLI_INLINE void ghash_flat_slot_set(
+        GHashFlat *gh, const uint slot, const uint hash, void *key, void *val)
+{
+	if (gh->ctrl[slot] == CTRL_DELETED) {
+		gh->ndeleted--;
+	}
+	gh->ctrl[slot] = HASH_H2(hash);
+	gh->entries[slot].key = key;
+	gh->entries[slot].val = val;
+}
+
+/**
+ * Re-insert all entries into a new slots array, also gets rid of deleted slots.
+ */
+static void ghash_flat_rehash(GHashFlat *gh, const uint nslots)
+{
+	GHashFlatEntry *entries_old = gh->entries;
+	const uint8_t *ctrl_old = gh->ctrl;
+	const uint nslots_old = gh->nslots;
+
+	ghash_flat_slots_alloc(gh, nslots);
+
+	for (uint i = 0; i < nslots_old; i++) {
+		if (CTRL_IS_FULL(ctrl_old[i])) {
+			const uint hash = ghash_flat_keyhash(gh, entries_old[i].key);
+			const uint slot = ghash_flat_find_free_slot(gh, hash);
+			ghash_flat_slot_set(gh, slot, hash, entries_old[i].key, entries_old[i].val);
+		}
+	}
+
+	MEM_freeN(entries_old);
+}
+
+/**
+ * Make room for one more entry.
+ */
+BLI_INLINE void ghash_flat_ensure_free_slot(GHashFlat *gh)
+{
+	if (UNLIKELY(gh->nentries + gh->ndeleted >= gh->limit_grow)) {
+		/* When most of the load comes from deleted slots, only clean them up. */
+		const uint nslots = ((gh->nentries + 1) * 2 > gh->limit_grow) ? gh->nslots * 2 : gh->nslots;
+		ghash_flat_rehash(gh, nslots);
+	}
+}
+
+BLI_INLINE uint ghash_flat_lookup_slot(GHashFlat *gh, const void *key, const uint hash)
+{
+	const uint8_t h2 = HASH_H2(hash);
+	uint group = HASH_H1(hash) & gh->group_mask;
+	for (uint step = 1; ; step++) {
+		const uint8_t *group_ctrl = &gh->ctrl[group * GHASH_FLAT_GROUP_SIZE];
+		uint mask = ghash_flat_group_match(group_ctrl, h2);
+		while (mask != 0) {
+			const uint slot = group * GHASH_FLAT_GROUP_SIZE + bitscan_forward_clear_uint(&mask);
+			if (ghash_flat_keyeq(gh, key, gh->entries[slot].key)) {
+				return slot;
+			}
+		}
+		/* Key would have been put into this group if it was in the hash. */
+		if (ghash_flat_group_match(group_ctrl, CTRL_EMPTY) != 0) {
+			return UINT_MAX;
+		}
+		group = (group + step) & gh->group_mask;
+	}
+}
+
+BLI_INLINE GHashFlatEntry *ghash_flat_lookup_entry(GHashFlat *gh, const void *key)
+{
+	const uint slot = ghash_flat_lookup_slot(gh, key, ghash_flat_keyhash(gh, key));
+	return (slot != UINT_MAX) ? &gh->entries[slot] : NULL;
+}
+
+static void ghash_flat_remove_slot(GHashFlat *gh, const uint slot)
+{
+	const uint8_t *group_ctrl = &gh->ctrl[slot & ~(uint)(GHASH_FLAT_GROUP_SIZE - 1)];
+	/* A group which still has empty slots was never full, so no key was
+	 * placed further in a probe sequence because of it, and the slot can be
+	 * made empty right away. */
+	if (ghash_flat_group_match(group_ctrl, CTRL_EMPTY) != 0) {
+		gh->ctrl[slot] = CTRL_EMPTY;
+	}
+	else {
+		gh->ctrl[slot] = CTRL_DELETED;
+		gh->ndeleted++;
+	}
+	gh->nentries--;
+}
+
+static GHashFlat *ghash_flat_new(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, eGHashFlatKeyType key_type, const char *info,
+        const uint nentries_reserve)
+{
+	GHashFlat *gh = MEM_mallocN(sizeof(*gh), info);
+
+	gh->hashfp = hashfp;
+	gh->cmpfp = cmpfp;
+	gh->key_type = key_type;
+	gh->nentries = 0;
+
+	ghash_flat_slots_alloc(gh, ghash_flat_nslots_for(nentries_reserve));
+
+	return gh;
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name GHashFlat Public API
+ * \{ */
+
+/**
+ * Creates a new, empty GHashFlat.
+ *
+ * \param hashfp: Hash callback.
+ * \param cmpfp: Comparison callback.
+ * \param info: Identifier string for the GHashFlat.
+ * \param nentries_reserve: Optionally reserve the number of members that the hash will hold.
+ * Use this to avoid resizing buckets if the size is known or can be closely approximated.
+ * \return  An empty GHashFlat.
+ */
+GHashFlat *BLI_ghash_flat_new_ex(
+        GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info,
+        const uint nentries_reserve)
+{
+	return ghash_flat_new(hashfp, cmpfp, GHASH_FLAT_KEY_GENERIC, info, nentries_reserve);
+}
+
+/**
+ * Wraps #BLI_ghash_flat_new_ex with zero entries reserved.
+ */
+GHashFlat *BLI_ghash_flat_new(GHashHashFP hashfp, GHashCmpFP cmpfp, const char *info)
+{
+	return BLI_ghash_flat_new_ex(hashfp, cmpfp, info, 0);
+}
+
+/**
+ * Reserve given amount of entries (resize \a gh accordingly if needed).
+ */
+void BLI_ghash_flat_reserve(GHashFlat *gh, const uint nentries_reserve)
+{
+	const uint nslots = ghash_flat_nslots_for(nentries_reserve);
+	if (nslots > gh->nslots) {
+		ghash_flat_rehash(gh, nslots);
+	}
+}
+
+/**
+ * \return size of the GHashFlat.
+ */
+uint BLI_ghash_flat_len(GHashFlat *gh)
+{
+	return gh->nentries;
+}
+
+/**
+ * Insert a key/value pair into the \a gh.
+ *
+ * \note Duplicates are not checked,
+ * the caller is expected to ensure elements are unique.
+ */
+void BLI_ghash_flat_insert(GHashFlat *gh, void *key, void *val)
+{
+	BLI_assert(!BLI_ghash_flat_haskey(gh, key));
+
+	ghash_flat_ensure_free_slot(gh);
+
+	const uint hash = ghash_flat_keyhash(gh, key);
+	ghash_flat_slot_set(gh, ghash_flat_find_free_slot(gh, hash), hash, key, val);
+	gh->nentries++;
+}
+
+/**
+ * Inserts a new value to a key that may already be in ghash.
+ *
+ * Avoids #BLI_ghash_flat_remove, #BLI_ghash_flat_insert calls (double lookups)
+ *
+ * \returns true if a new key has been added.
+ */
+bool BLI_ghash_flat_reinsert(
+        GHashFlat *gh, void *key, void *val, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint hash = ghash_flat_keyhash(gh, key);
+	const uint slot = ghash_flat_lookup_slot(gh, key, hash);
+	if (slot != UINT_MAX) {
+		GHashFlatEntry *e = &gh->entries[slot];
+		if (keyfreefp) {
+			keyfreefp(e->key);
+		}
+		if (valfreefp) {
+			valfreefp(e->val);
+		}
+		e->key = key;
+		e->val = val;
+		return false;
+	}
+
+	ghash_flat_ensure_free_slot(gh);
+	ghash_flat_slot_set(gh, ghash_flat_find_free_slot(gh, hash), hash, key, val);
+	gh->nentries++;
+	return true;
+}
+
+/**
+ * Lookup the value of \a key in \a gh.
+ *
+ * \param key: The key to lookup.
+ * \returns the value for \a key or NULL.
+ *
+ * \note When NULL is a valid value, use #BLI_ghash_flat_lookup_p to differentiate a missing key
+ * from a key with a NULL value. (Avoids calling #BLI_ghash_flat_haskey before #BLI_ghash_flat_lookup)
+ */
+void *BLI_ghash_flat_lookup(GHashFlat *gh, const void *key)
+{
+	GHashFlatEntry *e = ghash_flat_lookup_entry(gh, key);
+	return e ? e->val : NULL;
+}
+
+/**
+ * A version of #BLI_ghash_flat_lookup which accepts a fallback argument.
+ */
+void *BLI_ghash_flat_lookup_default(GHashFlat *gh, const void *key, void *val_default)
+{
+	GHashFlatEntry *e = ghash_flat_lookup_entry(gh, key);
+	return e ? e->val : val_default;
+}
+
+/**
+ * Lookup a pointer to the value of \a key in \a gh.
+ *
+ * \param key: The key to lookup.
+ * \returns the pointer to value for \a key or NULL.
+ *
+ * \note The pointer is only valid until the next insertion into \a gh.
+ */
+void **BLI_ghash_flat_lookup_p(GHashFlat *gh, const void *key)
+{
+	GHashFlatEntry *e = ghash_flat_lookup_entry(gh, key);
+	return e ? &e->val : NULL;
+}
+
+/**
+ * Ensure \a key is exists in \a gh.
+ *
+ * This handles the common situation where the caller needs ensure a key is added to \a gh,
+ * constructing a new value in the case the key isn't found.
+ * Otherwise use the existing value.
+ *
+ * \param key: The key to lookup.
+ * \param r_val: The pointer to assign the new value, valid until the next insertion.
+ * \returns true when the value didn't need to be added.
+ * (when false, the caller _must_ initialize the value).
+ */
+bool BLI_ghash_flat_ensure_p(GHashFlat *gh, void *key, void ***r_val)
+{
+	const uint hash = ghash_flat_keyhash(gh, key);
+	uint slot = ghash_flat_lookup_slot(gh, key, hash);
+	const bool haskey = (slot != UINT_MAX);
+	if (!haskey) {
+		ghash_flat_ensure_free_slot(gh);
+		slot = ghash_flat_find_free_slot(gh, hash);
+		ghash_flat_slot_set(gh, slot, hash, key, NULL);
+		gh->nentries++;
+	}
+	*r_val = &gh->entries[slot].val;
+	return haskey;
+}
+
+/**
+ * Remove \a key from \a gh, or return false if the key wasn't found.
+ *
+ * \param key: The key to remove.
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ * \return true if \a key was removed from \a gh.
+ */
+bool BLI_ghash_flat_remove(GHashFlat *gh, const void *key, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	const uint slot = ghash_flat_lookup_slot(gh, key, ghash_flat_keyhash(gh, key));
+	if (slot == UINT_MAX) {
+		return false;
+	}
+	GHashFlatEntry *e = &gh->entries[slot];
+	if (keyfreefp) {
+		keyfreefp(e->key);
+	}
+	if (valfreefp) {
+		valfreefp(e->val);
+	}
+	ghash_flat_remove_slot(gh, slot);
+	return true;
+}
+
+/**
+ * Remove \a key from \a gh, returning the value or NULL if the key wasn't found.
+ *
+ * \param key: The key to remove.
+ * \param keyfreefp: Optional callback to free the key.
+ * \return the value of \a key int \a gh or NULL.
+ */
+void *BLI_ghash_flat_popkey(GHashFlat *gh, const void *key, GHashKeyFreeFP keyfreefp)
+{
+	const uint slot = ghash_flat_lookup_slot(gh, key, ghash_flat_keyhash(gh, key));
+	if (slot == UINT_MAX) {
+		return NULL;
+	}
+	GHashFlatEntry *e = &gh->entries[slot];
+	void *val = e->val;
+	if (keyfreefp) {
+		keyfreefp(e->key);
+	}
+	ghash_flat_remove_slot(gh, slot);
+	return val;
+}
+
+/**
+ * \return true if the \a key is in \a gh.
+ */
+bool BLI_ghash_flat_haskey(GHashFlat *gh, const void *key)
+{
+	return (ghash_flat_lookup_entry(gh, key) != NULL);
+}
+
+static void ghash_flat_free_entries(GHashFlat *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	if (keyfreefp || valfreefp) {
+		for (uint i = 0; i < gh->nslots; i++) {
+			if (CTRL_IS_FULL(gh->ctrl[i])) {
+				if (keyfreefp) {
+					keyfreefp(gh->entries[i].key);
+				}
+				if (valfreefp) {
+					valfreefp(gh->entries[i].val);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Reset \a gh clearing all entries, keeps allocated slots.
+ *
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ */
+void BLI_ghash_flat_clear(GHashFlat *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	ghash_flat_free_entries(gh, keyfreefp, valfreefp);
+	memset(gh->ctrl, CTRL_EMPTY, gh->nslots);
+	gh->nentries = 0;
+	gh->ndeleted = 0;
+}
+
+/**
+ * Frees the GHashFlat and its members.
+ *
+ * \param gh: The GHashFlat to free.
+ * \param keyfreefp: Optional callback to free the key.
+ * \param valfreefp: Optional callback to free the value.
+ */
+void BLI_ghash_flat_free(GHashFlat *gh, GHashKeyFreeFP keyfreefp, GHashValFreeFP valfreefp)
+{
+	ghash_flat_free_entries(gh, keyfreefp, valfreefp);
+	MEM_freeN(gh->entries);
+	MEM_freeN(gh);
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name GHashFlat Iterator API
+ * \{ */
+
+BLI_INLINE void ghash_flat_iterator_find_full(GHashFlatIterator *ghi, uint slot)
+{
+	GHashFlat *gh = ghi->gh;
+	for (; slot < gh->nslots; slot++) {
+		if (CTRL_IS_FULL(gh->ctrl[slot])) {
+			ghi->curr_slot = slot;
+			ghi->curr_entry = &gh->entries[slot];
+			return;
+		}
+	}
+	ghi->curr_slot = gh->nslots;
+	ghi->curr_entry = NULL;
+}
+
+/**
+ * Init an already allocated GHashFlatIterator.
+ *
+ * \note The hash must not be modified while iterating.
+ *
+ * \param ghi: The GHashFlatIterator to initialize.
+ * \param gh: The GHashFlat to iterate over.
+ */
+void BLI_ghash_flatIterator_init(GHashFlatIterator *ghi, GHashFlat *gh)
+{
+	ghi->gh = gh;
+	ghash_flat_iterator_find_full(ghi, 0);
+}
+
+/**
+ * Steps a GHashFlatIterator to the next item.
+ *
+ * \param ghi: The GHashFlatIterator to step.
+ */
+void BLI_ghash_flatIterator_step(GHashFlatIterator *ghi)
+{
+	if (ghi->curr_entry) {
+		ghash_flat_iterator_find_full(ghi, ghi->curr_slot + 1);
+	}
+}
+
+/** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Specialized GHashFlat Creation Functions
+ * \{ */
+
+GHashFlat *BLI_ghash_flat_ptr_new_ex(const char *info, const uint nentries_reserve)
+{
+	return ghash_flat_new(BLI_ghashutil_ptrhash, BLI_ghashutil_ptrcmp, GHASH_FLAT_KEY_PTR, info, nentries_reserve);
+}
+GHashFlat *BLI_ghash_flat_ptr_new(const char *info)
+{
+	return BLI_ghash_flat_ptr_new_ex(info, 0);
+}
+
+GHashFlat *BLI_ghash_flat_int_new_ex(const char *info, const uint nentries_reserve)
+{
+	return ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, GHASH_FLAT_KEY_INT, info, nentries_reserve);
+}
+GHashFlat *BLI_ghash_flat_int_new(const char *info)
+{
+	return BLI_ghash_flat_int_new_ex(info, 0);
+}
+
+GHashFlat *BLI_ghash_flat_str_new_ex(const char *info, const uint nentries_reserve)
+{
+	return ghash_flat_new(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, GHASH_FLAT_KEY_STR, info, nentries_reserve);
+}
+GHashFlat *BLI_ghash_flat_str_new(const char *info)
+{
+	return BLI_ghash_flat_str_new_ex(info, 0);
+}
+
+/** \} */
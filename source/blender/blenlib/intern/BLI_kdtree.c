@@ -29,7 +29,14 @@
 
 #include "BLI_math.h"
 #include "BLI_kdtree.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
 #include "BLI_utildefines.h"
+
+#ifdef __SSE2__
+#  include <emmintrin.h>
+#endif
+
 #include "BLI_strict_flags.h"
 
 typedef struct KDTreeNode_head {
@@ -61,6 +68,13 @@ struct KDTree {
 
 #define KD_NODE_UNSET ((uint)-1)
 
+/* Balance sub-trees with at least this many nodes in their own task. */
+#define KD_BALANCE_TASK_MIN 4096
+/* Batch queries test sub-trees with this many nodes (or less) linearly. */
+#define KD_BATCH_LEAF_SIZE 8
+/* Only thread batch queries with at least this many points. */
+#define KD_BATCH_THREAD_MIN 256
+
 /**
  * Creates or free a kdtree
  */
@@ -113,18 +127,15 @@ void BLI_kdtree_insert(KDTree *tree, int index, const float co[3])
 #endif
 }
 
-static uint kdtree_balance(KDTreeNode *nodes, uint totnode, uint axis, const uint ofs)
+/**
+ * Partition \a nodes around the median on \a axis (quicksort style).
+ * \return The median, which is also the size of the left side.
+ */
+static uint kdtree_balance_partition(KDTreeNode *nodes, uint totnode, uint axis)
 {
-	KDTreeNode *node;
 	float co;
 	uint left, right, median, i, j;
 
-	if (totnode <= 0)
-		return KD_NODE_UNSET;
-	else if (totnode == 1)
-		return 0 + ofs;
-	
-	/* quicksort style sorting around median */
 	left = 0;
 	right = totnode - 1;
 	median = totnode / 2;
@@ -151,9 +162,25 @@ static uint kdtree_balance(KDTreeNode *nodes, uint totnode, uint axis, const uin
 			left = i + 1;
 	}
 
+	nodes[median].d = axis;
+
+	return median;
+}
+
+static uint kdtree_balance(KDTreeNode *nodes, uint totnode, uint axis, const uint ofs)
+{
+	KDTreeNode *node;
+	uint median;
+
+	if (totnode <= 0)
+		return KD_NODE_UNSET;
+	else if (totnode == 1)
+		return 0 + ofs;
+	
+	median = kdtree_balance_partition(nodes, totnode, axis);
+
 	/* set node and sort subnodes */
 	node = &nodes[median];
-	node->d = axis;
 	axis = (axis + 1) % 3;
 	node->left = kdtree_balance(nodes, median, axis, ofs);
 	node->right = kdtree_balance(nodes + median + 1, (totnode - (median + 1)), axis, (median + 1) + ofs);
@@ -161,9 +188,84 @@ static uint kdtree_balance(KDTreeNode *nodes, uint totnode, uint axis, const uin
 	return median + ofs;
 }
 
+/**
+ * Each sub-tree is a contiguous range of nodes, so both sides of a split can be balanced in parallel,
+ * the result is identical to #kdtree_balance.
+ */
+typedef struct KDTreeBalanceTaskData {
+	KDTreeNode *nodes;
+	uint totnode, axis, ofs;
+	uint *r_root;
+} KDTreeBalanceTaskData;
+
+static void kdtree_balance_threaded(
+        TaskPool *__restrict pool, const int thread_id,
+        KDTreeNode *nodes, uint totnode, uint axis, const uint ofs,
+        uint *r_root);
+
+static void kdtree_balance_task(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	const KDTreeBalanceTaskData *data = taskdata;
+	kdtree_balance_threaded(pool, thread_id, data->nodes, data->totnode, data->axis, data->ofs, data->r_root);
+}
+
+static void kdtree_balance_threaded(
+        TaskPool *__restrict pool, const int thread_id,
+        KDTreeNode *nodes, uint totnode, uint axis, const uint ofs,
+        uint *r_root)
+{
+	KDTreeNode *node;
+	uint median;
+
+	if (totnode < KD_BALANCE_TASK_MIN) {
+		*r_root = kdtree_balance(nodes, totnode, axis, ofs);
+		return;
+	}
+
+	median = kdtree_balance_partition(nodes, totnode, axis);
+
+	node = &nodes[median];
+	axis = (axis + 1) % 3;
+	*r_root = median + ofs;
+
+	/* balance the left side in a new task, the right side in this one */
+	KDTreeBalanceTaskData *data = MEM_mallocN(sizeof(*data), __func__);
+	data->nodes = nodes;
+	data->totnode = median;
+	data->axis = axis;
+	data->ofs = ofs;
+	data->r_root = &node->left;
+	BLI_task_pool_push_from_thread(pool, kdtree_balance_task, data, true, TASK_PRIORITY_HIGH, thread_id);
+
+	kdtree_balance_threaded(
+	        pool, thread_id,
+	        nodes + median + 1, (totnode - (median + 1)), axis, (median + 1) + ofs,
+	        &node->right);
+}
+
 void BLI_kdtree_balance(KDTree *tree)
 {
-	tree->root = kdtree_balance(tree->nodes, tree->totnode, 0, 0);
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+
+	if ((tree->totnode >= KD_BALANCE_TASK_MIN * 2) &&
+	    (BLI_task_scheduler_num_threads(scheduler) > 1))
+	{
+		TaskPool *pool = BLI_task_pool_create(scheduler, NULL);
+		KDTreeBalanceTaskData data = {
+			.nodes = tree->nodes,
+			.totnode = tree->totnode,
+			.axis = 0,
+			.ofs = 0,
+			.r_root = &tree->root,
+		};
+		/* the first task is pushed from the thread which created the pool */
+		BLI_task_pool_push(pool, kdtree_balance_task, &data, false, TASK_PRIORITY_HIGH);
+		BLI_task_pool_work_and_wait(pool);
+		BLI_task_pool_free(pool);
+	}
+	else {
+		tree->root = kdtree_balance(tree->nodes, tree->totnode, 0, 0);
+	}
 
 #ifdef DEBUG
 	tree->is_balanced = true;
@@ -794,3 +896,306 @@ int BLI_kdtree_calc_duplicates_fast(
 }
 
 /** \} */
+
+/* -------------------------------------------------------------------- */
+/** \name Batch Queries
+ *
+ * Search for many points at once, the points are split over threads.
+ *
+ * A balanced tree is implicit in the node array, every sub-tree is a contiguous range of nodes
+ * with its root in the middle. This allows small sub-trees to be tested linearly
+ * (4 nodes at once when SSE2 is available) instead of visiting every node.
+ * \{ */
+
+typedef struct KDTreeSubTree {
+	uint ofs, len;
+	/* minimum squared distance to any node in this sub-tree */
+	float dist_sq;
+} KDTreeSubTree;
+
+/* enough for the depth of a balanced tree with 2^32 nodes (at most 2 items are added per level) */
+#define KD_SUBTREE_STACK_SIZE 66
+
+BLI_INLINE void kdtree_leaf_find_nearest(
+        const KDTreeNode *nodes, const uint len, const float co[3],
+        float *r_min_dist, const KDTreeNode **r_min_node)
+{
+	uint i = 0;
+
+#ifdef __SSE2__
+	const __m128 co_x = _mm_set1_ps(co[0]);
+	const __m128 co_y = _mm_set1_ps(co[1]);
+	const __m128 co_z = _mm_set1_ps(co[2]);
+
+	for (; i + 4 <= len; i += 4) {
+		const KDTreeNode *n = &nodes[i];
+		const __m128 d_x = _mm_sub_ps(_mm_setr_ps(n[0].co[0], n[1].co[0], n[2].co[0], n[3].co[0]), co_x);
+		const __m128 d_y = _mm_sub_ps(_mm_setr_ps(n[0].co[1], n[1].co[1], n[2].co[1], n[3].co[1]), co_y);
+		const __m128 d_z = _mm_sub_ps(_mm_setr_ps(n[0].co[2], n[1].co[2], n[2].co[2], n[3].co[2]), co_z);
+		const __m128 dist_sq = _mm_add_ps(
+		        _mm_add_ps(_mm_mul_ps(d_x, d_x), _mm_mul_ps(d_y, d_y)), _mm_mul_ps(d_z, d_z));
+		const int mask = _mm_movemask_ps(_mm_cmplt_ps(dist_sq, _mm_set1_ps(*r_min_dist)));
+
+		if (mask) {
+			float dist_sq_array[4];
+			_mm_storeu_ps(dist_sq_array, dist_sq);
+			for (uint j = 0; j < 4; j++) {
+				if ((mask & (1 << j)) && (dist_sq_array[j] < *r_min_dist)) {
+					*r_min_dist = dist_sq_array[j];
+					*r_min_node = &n[j];
+				}
+			}
+		}
+	}
+#endif  /* __SSE2__ */
+
+	for (; i < len; i++) {
+		const float dist_sq = len_squared_v3v3(nodes[i].co, co);
+		if (dist_sq < *r_min_dist) {
+			*r_min_dist = dist_sq;
+			*r_min_node = &nodes[i];
+		}
+	}
+}
+
+static void kdtree_find_nearest_batch_single(
+        const KDTree *tree, const float co[3],
+        KDTreeNearest *r_nearest)
+{
+	const KDTreeNode *nodes = tree->nodes;
+	const KDTreeNode *min_node = NULL;
+	KDTreeSubTree stack[KD_SUBTREE_STACK_SIZE];
+	float min_dist = FLT_MAX;
+	uint cur = 0;
+
+	stack[cur++] = (KDTreeSubTree){0, tree->totnode, 0.0f};
+
+	while (cur--) {
+		const KDTreeSubTree sub = stack[cur];
+
+		if (sub.dist_sq >= min_dist) {
+			continue;
+		}
+
+		if (sub.len <= KD_BATCH_LEAF_SIZE) {
+			kdtree_leaf_find_nearest(&nodes[sub.ofs], sub.len, co, &min_dist, &min_node);
+			continue;
+		}
+
+		const uint median = sub.len / 2;
+		const KDTreeNode *node = &nodes[sub.ofs + median];
+		const float dist_sq = len_squared_v3v3(node->co, co);
+		if (dist_sq < min_dist) {
+			min_dist = dist_sq;
+			min_node = node;
+		}
+
+		const float dist_plane = co[node->d] - node->co[node->d];
+		KDTreeSubTree sub_left = {sub.ofs, median, sub.dist_sq};
+		KDTreeSubTree sub_right = {sub.ofs + median + 1, sub.len - (median + 1), sub.dist_sq};
+
+		/* add the far side first, so the near side is searched first */
+		if (dist_plane < 0.0f) {
+			sub_right.dist_sq = max_ff(sub.dist_sq, dist_plane * dist_plane);
+			stack[cur++] = sub_right;
+			stack[cur++] = sub_left;
+		}
+		else {
+			sub_left.dist_sq = max_ff(sub.dist_sq, dist_plane * dist_plane);
+			stack[cur++] = sub_left;
+			stack[cur++] = sub_right;
+		}
+		BLI_assert(cur <= KD_SUBTREE_STACK_SIZE);
+	}
+
+	if (min_node) {
+		r_nearest->index = min_node->index;
+		r_nearest->dist = sqrtf(min_dist);
+		copy_v3_v3(r_nearest->co, min_node->co);
+	}
+	else {
+		r_nearest->index = -1;
+		r_nearest->dist = FLT_MAX;
+		zero_v3(r_nearest->co);
+	}
+}
+
+BLI_INLINE void kdtree_leaf_range_search(
+        const KDTreeNode *nodes, const uint len, const float co[3], const float range_sq,
+        KDTreeNearest **r_foundstack, uint *r_foundstack_tot_alloc, uint *r_found)
+{
+	uint i = 0;
+
+#ifdef __SSE2__
+	const __m128 co_x = _mm_set1_ps(co[0]);
+	const __m128 co_y = _mm_set1_ps(co[1]);
+	const __m128 co_z = _mm_set1_ps(co[2]);
+	const __m128 range_sq_v = _mm_set1_ps(range_sq);
+
+	for (; i + 4 <= len; i += 4) {
+		const KDTreeNode *n = &nodes[i];
+		const __m128 d_x = _mm_sub_ps(_mm_setr_ps(n[0].co[0], n[1].co[0], n[2].co[0], n[3].co[0]), co_x);
+		const __m128 d_y = _mm_sub_ps(_mm_setr_ps(n[0].co[1], n[1].co[1], n[2].co[1], n[3].co[1]), co_y);
+		const __m128 d_z = _mm_sub_ps(_mm_setr_ps(n[0].co[2], n[1].co[2], n[2].co[2], n[3].co[2]), co_z);
+		const __m128 dist_sq = _mm_add_ps(
+		        _mm_add_ps(_mm_mul_ps(d_x, d_x), _mm_mul_ps(d_y, d_y)), _mm_mul_ps(d_z, d_z));
+		const int mask = _mm_movemask_ps(_mm_cmple_ps(dist_sq, range_sq_v));
+
+		if (mask) {
+			float dist_sq_array[4];
+			_mm_storeu_ps(dist_sq_array, dist_sq);
+			for (uint j = 0; j < 4; j++) {
+				if (mask & (1 << j)) {
+					add_in_range(r_foundstack, r_foundstack_tot_alloc, (*r_found)++,
+					             n[j].index, dist_sq_array[j], n[j].co);
+				}
+			}
+		}
+	}
+#endif  /* __SSE2__ */
+
+	for (; i < len; i++) {
+		const float dist_sq = len_squared_v3v3(nodes[i].co, co);
+		if (dist_sq <= range_sq) {
+			add_in_range(r_foundstack, r_foundstack_tot_alloc, (*r_found)++,
+			             nodes[i].index, dist_sq, nodes[i].co);
+		}
+	}
+}
+
+static int kdtree_range_search_batch_single(
+        const KDTree *tree, const float co[3], const float range,
+        KDTreeNearest **r_nearest)
+{
+	const KDTreeNode *nodes = tree->nodes;
+	KDTreeSubTree stack[KD_SUBTREE_STACK_SIZE];
+	KDTreeNearest *foundstack = NULL;
+	const float range_sq = range * range;
+	uint cur = 0, found = 0, totfoundstack = 0;
+
+	stack[cur++] = (KDTreeSubTree){0, tree->totnode, 0.0f};
+
+	while (cur--) {
+		const KDTreeSubTree sub = stack[cur];
+
+		if (sub.len <= KD_BATCH_LEAF_SIZE) {
+			kdtree_leaf_range_search(&nodes[sub.ofs], sub.len, co, range_sq, &foundstack, &totfoundstack, &found);
+			continue;
+		}
+
+		const uint median = sub.len / 2;
+		const KDTreeNode *node = &nodes[sub.ofs + median];
+		const float dist_sq = len_squared_v3v3(node->co, co);
+		if (dist_sq <= range_sq) {
+			add_in_range(&foundstack, &totfoundstack, found++, node->index, dist_sq, node->co);
+		}
+
+		if (co[node->d] - range <= node->co[node->d]) {
+			stack[cur++] = (KDTreeSubTree){sub.ofs, median, 0.0f};
+		}
+		if (co[node->d] + range >= node->co[node->d]) {
+			stack[cur++] = (KDTreeSubTree){sub.ofs + median + 1, sub.len - (median + 1), 0.0f};
+		}
+		BLI_assert(cur <= KD_SUBTREE_STACK_SIZE);
+	}
+
+	if (found)
+		qsort(foundstack, found, sizeof(KDTreeNearest), range_compare);
+
+	*r_nearest = foundstack;
+
+	return (int)found;
+}
+
+typedef struct KDTreeBatchData {
+	const KDTree *tree;
+	const float (*co)[3];
+	float range;
+	KDTreeNearest *r_nearest;
+	KDTreeNearest **r_nearest_range;
+	int *r_nearest_range_len;
+} KDTreeBatchData;
+
+static void kdtree_find_nearest_batch_cb(
+        void *__restrict userdata,
+        const int iter,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const KDTreeBatchData *data = userdata;
+	kdtree_find_nearest_batch_single(data->tree, data->co[iter], &data->r_nearest[iter]);
+}
+
+static void kdtree_range_search_batch_cb(
+        void *__restrict userdata,
+        const int iter,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	const KDTreeBatchData *data = userdata;
+	data->r_nearest_range_len[iter] = kdtree_range_search_batch_single(
+	        data->tree, data->co[iter], data->range, &data->r_nearest_range[iter]);
+}
+
+static void kdtree_batch_settings(ParallelRangeSettings *settings, const uint co_len)
+{
+	BLI_parallel_range_settings_defaults(settings);
+	settings->use_threading = (co_len >= KD_BATCH_THREAD_MIN);
+	settings->scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+	settings->min_iter_per_thread = KD_BATCH_THREAD_MIN / 4;
+}
+
+/**
+ * Find the nearest node for every point in \a co,
+ * an index of -1 is written to \a r_nearest when the tree is empty.
+ *
+ * \param r_nearest: An array sized \a co_len.
+ */
+void BLI_kdtree_find_nearest_batch(
+        const KDTree *tree, const float (*co)[3], const uint co_len,
+        KDTreeNearest *r_nearest)
+{
+	KDTreeBatchData data = {
+		.tree = tree,
+		.co = co,
+		.r_nearest = r_nearest,
+	};
+	ParallelRangeSettings settings;
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+	BLI_assert((tree->root == KD_NODE_UNSET) || (tree->root == tree->totnode / 2));
+
+	kdtree_batch_settings(&settings, co_len);
+	BLI_task_parallel_range(0, (int)co_len, &data, kdtree_find_nearest_batch_cb, &settings);
+}
+
+/**
+ * Range search for every point in \a co, results match #BLI_kdtree_range_search.
+ *
+ * \param r_nearest: An array sized \a co_len, each item is set to an array sorted by distance
+ * (or NULL when nothing is found), these need to be freed.
+ * \param r_nearest_len: An array sized \a co_len, the number of nodes found for each point.
+ */
+void BLI_kdtree_range_search_batch(
+        const KDTree *tree, const float (*co)[3], const uint co_len, const float range,
+        KDTreeNearest **r_nearest, int *r_nearest_len)
+{
+	KDTreeBatchData data = {
+		.tree = tree,
+		.co = co,
+		.range = range,
+		.r_nearest_range = r_nearest,
+		.r_nearest_range_len = r_nearest_len,
+	};
+	ParallelRangeSettings settings;
+
+#ifdef DEBUG
+	BLI_assert(tree->is_balanced == true);
+#endif
+	BLI_assert((tree->root == KD_NODE_UNSET) || (tree->root == tree->totnode / 2));
+
+	kdtree_batch_settings(&settings, co_len);
+	BLI_task_parallel_range(0, (int)co_len, &data, kdtree_range_search_batch_cb, &settings);
+}
+
+/** \} */
@@ -36,6 +36,8 @@
  * - Freeing chunks.
  * - Iterating over allocated chunks
  *   (optionally when using the #BLI_MEMPOOL_ALLOW_ITER flag).
+ * - Allocating and freeing from multiple threads,
+ *   through per-thread caches (see #BLI_mempool_thread_cache_init).
  */
 
 #include <string.h>
@@ -93,6 +95,13 @@
 /* optimize pool size */
 #define USE_CHUNK_POW2
 
+/* number of elements moved between a thread cache and the shared free list at once */
+#define MEMPOOL_THREAD_CACHE_BATCH 64
+/* a thread cache holding more than this gives a batch back to the pool */
+#define MEMPOOL_THREAD_CACHE_MAX (MEMPOOL_THREAD_CACHE_BATCH * 2)
+
+#define MEMPOOL_CACHE_LINE_SIZE 64
+
 
 #ifndef NDEBUG
 static bool mempool_debug_memset = false;
@@ -120,6 +129,19 @@ typedef struct BLI_mempool_chunk {
 #endif
 } BLI_mempool_chunk;
 
+/**
+ * Per-thread list of free elements, see #BLI_mempool_thread_cache_init.
+ *
+ * Elements in this list are counted as used by the pool,
+ * so they are never given back when all other elements are freed.
+ */
+typedef struct BLI_mempool_thread_cache {
+	BLI_freenode *free;
+	uint len;
+	/* avoid false sharing between threads */
+	char _pad[MEMPOOL_CACHE_LINE_SIZE - sizeof(BLI_freenode *) - sizeof(uint)];
+} BLI_mempool_thread_cache;
+
 /**
  * The mempool, stores and tracks memory \a chunks and elements within those chunks \a free.
  */
@@ -141,6 +163,11 @@ struct BLI_mempool {
 #ifdef USE_TOTALLOC
 	uint totalloc;          /* number of elements allocated in total */
 #endif
+
+	/* optional per-thread caches, the lock protects the members above while they are in use */
+	BLI_mempool_thread_cache *thread_caches;
+	uint thread_caches_len;
+	uint32_t thread_caches_lock;
 };
 
 #define MEMPOOL_ELEM_SIZE_MIN (sizeof(void *) * 2)
@@ -337,6 +364,9 @@ BLI_mempool *BLI_mempool_create(uint esize, uint totelem,
 #endif
 	pool->totused = 0;
 
+	pool->thread_caches = NULL;
+	pool->thread_caches_len = 0;
+
 	if (totelem) {
 		/* allocate the actual chunks */
 		for (i = 0; i < maxchunks; i++) {
@@ -474,16 +504,218 @@ void BLI_mempool_free(BLI_mempool *pool, void *addr)
 	}
 }
 
+/** \name Thread Caches
+ *
+ * Allocating from many threads at once, without a lock per allocation.
+ *
+ * Each thread allocates from and frees into its own list of free elements,
+ * which is refilled from (or drained into) the pool's shared free list
+ * in batches, under a lock.
+ * Elements keep living in the pool's chunks, so iteration still sees
+ * every allocated element.
+ *
+ * \note While other threads use the pool, only the threaded functions may be called.
+ * \{ */
+
+/**
+ * Enable per-thread caches for this pool.
+ *
+ * \param num_threads  The number of thread caches,
+ * \a thread_id arguments must be in the range ``[0, num_threads)``.
+ * For task pools, this is #BLI_task_scheduler_num_threads.
+ */
+void BLI_mempool_thread_cache_init(BLI_mempool *pool, const int num_threads)
+{
+	BLI_assert(pool->thread_caches == NULL);
+	BLI_assert(num_threads > 0);
+
+	pool->thread_caches_len = (uint)num_threads;
+	pool->thread_caches = MEM_mallocN_aligned(
+	        sizeof(*pool->thread_caches) * (size_t)num_threads, MEMPOOL_CACHE_LINE_SIZE, __func__);
+	for (uint i = 0; i < pool->thread_caches_len; i++) {
+		pool->thread_caches[i].free = NULL;
+		pool->thread_caches[i].len = 0;
+	}
+	pool->thread_caches_lock = 0;
+}
+
+/* Simple spin-lock using atomics, since this file is also built without BLI_threads (for makesdna).
+ * The lock is only held to move a batch of elements. */
+BLI_INLINE void mempool_thread_cache_lock(BLI_mempool *pool)
+{
+	while (atomic_cas_uint32(&pool->thread_caches_lock, 0, 1) != 0) {
+		/* pass */
+	}
+}
+
+BLI_INLINE void mempool_thread_cache_unlock(BLI_mempool *pool)
+{
+	atomic_cas_uint32(&pool->thread_caches_lock, 1, 0);
+}
+
+/**
+ * Move a batch of free elements from the pool into the thread cache.
+ */
+static void mempool_thread_cache_refill(BLI_mempool *pool, BLI_mempool_thread_cache *tcache)
+{
+	BLI_freenode *free_pop;
+	uint i;
+
+	mempool_thread_cache_lock(pool);
+	for (i = 0; i < MEMPOOL_THREAD_CACHE_BATCH; i++) {
+		if (UNLIKELY(pool->free == NULL)) {
+			BLI_mempool_chunk *mpchunk = mempool_chunk_alloc(pool);
+			mempool_chunk_add(pool, mpchunk, NULL);
+		}
+		free_pop = pool->free;
+		pool->free = free_pop->next;
+
+		free_pop->next = tcache->free;
+		tcache->free = free_pop;
+	}
+	pool->totused += MEMPOOL_THREAD_CACHE_BATCH;
+	mempool_thread_cache_unlock(pool);
+
+	tcache->len += MEMPOOL_THREAD_CACHE_BATCH;
+}
+
+/**
+ * Move a batch of free elements from the thread cache back into the pool.
+ */
+static void mempool_thread_cache_drain(BLI_mempool *pool, BLI_mempool_thread_cache *tcache, const uint len)
+{
+	BLI_freenode *head, *tail;
+	uint i;
+
+	BLI_assert(len != 0 && len <= tcache->len);
+
+	head = tail = tcache->free;
+	for (i = 1; i < len; i++) {
+		tail = tail->next;
+	}
+	tcache->free = tail->next;
+	tcache->len -= len;
+
+	mempool_thread_cache_lock(pool);
+	tail->next = pool->free;
+	pool->free = head;
+	pool->totused -= len;
+	mempool_thread_cache_unlock(pool);
+}
+
+void *BLI_mempool_alloc_thread(BLI_mempool *pool, const int thread_id)
+{
+	BLI_mempool_thread_cache *tcache;
+	BLI_freenode *free_pop;
+
+	BLI_assert((uint)thread_id < pool->thread_caches_len);
+	tcache = &pool->thread_caches[thread_id];
+
+	if (UNLIKELY(tcache->free == NULL)) {
+		mempool_thread_cache_refill(pool, tcache);
+	}
+
+	free_pop = tcache->free;
+	tcache->free = free_pop->next;
+	tcache->len--;
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+		free_pop->freeword = USEDWORD;
+	}
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_ALLOC(pool, free_pop, pool->esize);
+#endif
+
+	return (void *)free_pop;
+}
+
+void *BLI_mempool_calloc_thread(BLI_mempool *pool, const int thread_id)
+{
+	void *retval = BLI_mempool_alloc_thread(pool, thread_id);
+	memset(retval, 0, (size_t)pool->esize);
+	return retval;
+}
+
+/**
+ * Free an element into the cache of \a thread_id,
+ * which doesn't need to be the thread that allocated it.
+ */
+void BLI_mempool_free_thread(BLI_mempool *pool, void *addr, const int thread_id)
+{
+	BLI_mempool_thread_cache *tcache;
+	BLI_freenode *newhead = addr;
+
+	BLI_assert((uint)thread_id < pool->thread_caches_len);
+	tcache = &pool->thread_caches[thread_id];
+
+#ifndef NDEBUG
+	if (UNLIKELY(mempool_debug_memset)) {
+		memset(addr, 255, pool->esize);
+	}
+#endif
+
+	if (pool->flag & BLI_MEMPOOL_ALLOW_ITER) {
+#ifndef NDEBUG
+		/* this will detect double free's */
+		BLI_assert(newhead->freeword != FREEWORD);
+#endif
+		newhead->freeword = FREEWORD;
+	}
+
+	newhead->next = tcache->free;
+	tcache->free = newhead;
+	tcache->len++;
+
+#ifdef WITH_MEM_VALGRIND
+	VALGRIND_MEMPOOL_FREE(pool, addr);
+#endif
+
+	if (UNLIKELY(tcache->len > MEMPOOL_THREAD_CACHE_MAX)) {
+		mempool_thread_cache_drain(pool, tcache, MEMPOOL_THREAD_CACHE_BATCH);
+	}
+}
+
+/**
+ * Give all elements held by thread caches back to the pool's free list,
+ * so they can be reused by #BLI_mempool_alloc.
+ *
+ * Not thread-safe, call once threads are done with the pool.
+ */
+void BLI_mempool_thread_cache_flush(BLI_mempool *pool)
+{
+	for (uint i = 0; i < pool->thread_caches_len; i++) {
+		BLI_mempool_thread_cache *tcache = &pool->thread_caches[i];
+		if (tcache->len) {
+			mempool_thread_cache_drain(pool, tcache, tcache->len);
+		}
+	}
+}
+
+/** \} */
+
+/**
+ * Number of elements currently in use, excluding elements held by thread caches.
+ */
+static uint mempool_len(BLI_mempool *pool)
+{
+	uint totused = pool->totused;
+	for (uint i = 0; i < pool->thread_caches_len; i++) {
+		totused -= pool->thread_caches[i].len;
+	}
+	return totused;
+}
+
 int BLI_mempool_len(BLI_mempool *pool)
 {
-	return (int)pool->totused;
+	return (int)mempool_len(pool);
 }
 
 void *BLI_mempool_findelem(BLI_mempool *pool, uint index)
 {
 	BLI_assert(pool->flag & BLI_MEMPOOL_ALLOW_ITER);
 
-	if (index < pool->totused) {
+	if (index < mempool_len(pool)) {
 		/* we could have some faster mem chunk stepping code inline */
 		BLI_mempool_iter iter;
 		void *elem;
@@ -514,7 +746,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
 	while ((elem = BLI_mempool_iterstep(&iter))) {
 		*p++ = elem;
 	}
-	BLI_assert((uint)(p - data) == pool->totused);
+	BLI_assert((uint)(p - data) == mempool_len(pool));
 }
 
 /**
@@ -522,7 +754,7 @@ void BLI_mempool_as_table(BLI_mempool *pool, void **data)
  */
 void **BLI_mempool_as_tableN(BLI_mempool *pool, const char *allocstr)
 {
-	void **data = MEM_mallocN((size_t)pool->totused * sizeof(void *), allocstr);
+	void **data = MEM_mallocN((size_t)mempool_len(pool) * sizeof(void *), allocstr);
 	BLI_mempool_as_table(pool, data);
 	return data;
 }
@@ -541,7 +773,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
 		memcpy(p, elem, (size_t)esize);
 		p = NODE_STEP_NEXT(p);
 	}
-	BLI_assert((uint)(p - (char *)data) == pool->totused * esize);
+	BLI_assert((uint)(p - (char *)data) == mempool_len(pool) * esize);
 }
 
 /**
@@ -549,7 +781,7 @@ void BLI_mempool_as_array(BLI_mempool *pool, void *data)
  */
 void *BLI_mempool_as_arrayN(BLI_mempool *pool, const char *allocstr)
 {
-	char *data = MEM_mallocN((size_t)(pool->totused * pool->esize), allocstr);
+	char *data = MEM_mallocN((size_t)(mempool_len(pool) * pool->esize), allocstr);
 	BLI_mempool_as_array(pool, data);
 	return data;
 }
@@ -743,6 +975,10 @@ void BLI_mempool_clear_ex(BLI_mempool *pool, const int totelem_reserve)
 	/* re-initialize */
 	pool->free = NULL;
 	pool->totused = 0;
+	for (uint i = 0; i < pool->thread_caches_len; i++) {
+		pool->thread_caches[i].free = NULL;
+		pool->thread_caches[i].len = 0;
+	}
 #ifdef USE_TOTALLOC
 	pool->totalloc = 0;
 #endif
@@ -772,6 +1008,10 @@ void BLI_mempool_destroy(BLI_mempool *pool)
 {
 	mempool_chunk_free_all(pool->chunks);
 
+	if (pool->thread_caches) {
+		MEM_freeN(pool->thread_caches);
+	}
+
 #ifdef WITH_MEM_VALGRIND
 	VALGRIND_DESTROY_MEMPOOL(pool);
 #endif
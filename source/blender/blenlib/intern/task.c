@@ -52,8 +52,13 @@
 /* Number of tasks which are pushed directly to local thread queue.
  *
  * This allows thread to fetch next task without locking the whole queue.
+ * Other threads which ran out of work steal tasks from this queue, so it is
+ * sized to hold the whole set of children of a typical graph node.
+ *
+ * NOTE: Must be power of two.
  */
-#define LOCAL_QUEUE_SIZE 1
+#define LOCAL_QUEUE_SIZE 1024
+#define LOCAL_QUEUE_MASK (LOCAL_QUEUE_SIZE - 1)
 
 /* Number of tasks which are allowed to be scheduled in a delayed manner.
  *
@@ -136,17 +141,45 @@ typedef struct TaskMemPoolStats {
 } TaskMemPoolStats;
 #endif
 
+/* Entry of the local queue.
+ *
+ * Pool is stored next to the task so thieves can check whether they are
+ * allowed to take the task without dereferencing memory of a task which
+ * might have been taken and freed by another thread already.
+ */
+typedef struct TaskQueueItem {
+	Task *task;
+	TaskPool *pool;
+} TaskQueueItem;
+
+/* Per-thread work-stealing queue (Chase-Lev deque with fixed capacity).
+ *
+ * Owner thread pushes and pops tasks at the bottom without any locks, other
+ * threads are stealing tasks from the top. Only the owner modifies bottom,
+ * top is only ever advanced using CAS, which resolves the race between the
+ * owner and thieves for the last task in the queue.
+ *
+ * Indices are never wrapped, only the slot index is, so the queue is empty
+ * when top equals bottom. Differences are interpreted as signed to survive
+ * integer overflow of the counters.
+ */
+typedef struct TaskLocalQueue {
+	size_t top;
+	size_t bottom;
+	TaskQueueItem items[LOCAL_QUEUE_SIZE];
+} TaskLocalQueue;
+
 typedef struct TaskThreadLocalStorage {
 	/* Memory pool for faster task allocation.
 	 * The idea is to re-use memory of finished/discarded tasks by this thread.
 	 */
 	TaskMemPool task_mempool;
 
-	/* Local queue keeps thread alive by keeping small amount of tasks ready
-	 * to be picked up without causing global thread locks for synchronization.
+	/* Local queue keeps thread alive by keeping tasks ready to be picked up
+	 * without causing global thread locks for synchronization. Idle threads
+	 * steal tasks from here.
 	 */
-	int num_local_queue;
-	Task *local_queue[LOCAL_QUEUE_SIZE];
+	TaskLocalQueue local_queue;
 
 	/* Thread can be marked for delayed tasks push. This is helpful when it's
 	 * know that lots of subsequent task pushed will happen from the same thread
@@ -164,10 +197,21 @@ typedef struct TaskThreadLocalStorage {
 struct TaskPool {
 	TaskScheduler *scheduler;
 
-	volatile size_t num;
+	/* Number of tasks which are pushed to the pool and not finished yet,
+	 * including the ones which are sitting in the threads local queues.
+	 *
+	 * Modified atomically, the mutex is only used to notify threads which are
+	 * waiting for this number to change.
+	 */
+	size_t num;
 	ThreadMutex num_mutex;
 	ThreadCondition num_cond;
 
+	/* Set when the thread which does work_and_wait() went to sleep, so
+	 * pushes to local queues know they need to wake it up.
+	 */
+	uint8_t is_waiting;
+
 	void *userdata;
 	ThreadMutex user_mutex;
 
@@ -214,6 +258,14 @@ struct TaskScheduler {
 	ThreadMutex queue_mutex;
 	ThreadCondition queue_cond;
 
+	/* Number of tasks in the global queue. Only modified with queue_mutex
+	 * locked, but read without lock to skip locking of an empty queue.
+	 */
+	volatile size_t num_queued;
+
+	/* Number of worker threads which are sleeping on queue_cond. */
+	uint32_t num_idle_threads;
+
 	volatile bool do_exit;
 
 	/* NOTE: In pthread's TLS we store the whole TaskThread structure. */
@@ -326,17 +378,118 @@ static void task_free(TaskPool *pool, Task *task, const int thread_id)
 	}
 }
 
+/* Local Queue */
+
+BLI_INLINE size_t task_local_queue_index_load(const size_t *index)
+{
+	return *(volatile const size_t *)index;
+}
+
+BLI_INLINE bool task_local_queue_is_full(const TaskLocalQueue *queue)
+{
+	/* Top could only be advanced by thieves, so in the worst case queue is
+	 * considered more full than it actually is.
+	 */
+	const size_t top = task_local_queue_index_load(&queue->top);
+	return (ptrdiff_t)(queue->bottom - top) >= LOCAL_QUEUE_SIZE;
+}
+
+/* Push task to the bottom of the queue, must only be called by the owner
+ * thread and only when queue is not full.
+ *
+ * Returns true when the queue was empty, in which case the task is the one
+ * which will be picked up by thieves next.
+ */
+BLI_INLINE bool task_local_queue_push(TaskLocalQueue *queue, Task *task)
+{
+	const size_t bottom = queue->bottom;
+	const size_t top = task_local_queue_index_load(&queue->top);
+	TaskQueueItem *item = &queue->items[bottom & LOCAL_QUEUE_MASK];
+	BLI_assert((ptrdiff_t)(bottom - top) < LOCAL_QUEUE_SIZE);
+	item->task = task;
+	item->pool = task->pool;
+	/* Atomic operation acts as a full barrier, so the item is written before
+	 * thieves can see it.
+	 */
+	atomic_add_and_fetch_z(&queue->bottom, 1);
+	return (bottom == top);
+}
+
+/* Pop newest task from the bottom of the queue, must only be called by the
+ * owner thread.
+ */
+BLI_INLINE Task *task_local_queue_pop(TaskLocalQueue *queue)
+{
+	/* Reserve the bottom-most task first, then see whether any thief got
+	 * to it already.
+	 */
+	const size_t bottom = atomic_sub_and_fetch_z(&queue->bottom, 1);
+	const size_t top = task_local_queue_index_load(&queue->top);
+	const ptrdiff_t num_tasks = (ptrdiff_t)(bottom - top);
+	Task *task = NULL;
+	if (num_tasks > 0) {
+		/* There are more tasks in the queue, thieves can not reach this one. */
+		return queue->items[bottom & LOCAL_QUEUE_MASK].task;
+	}
+	if (num_tasks == 0) {
+		/* Last task in the queue, race against thieves for it. */
+		if (atomic_cas_z(&queue->top, top, top + 1) == top) {
+			task = queue->items[bottom & LOCAL_QUEUE_MASK].task;
+		}
+	}
+	/* Queue is empty now, restore canonical state where bottom equals top. */
+	atomic_add_and_fetch_z(&queue->bottom, 1);
+	return task;
+}
+
+/* Steal oldest task from the top of the queue of another thread.
+ *
+ * When pool is given, only task which belongs to this pool is stolen.
+ */
+BLI_INLINE Task *task_local_queue_steal(TaskLocalQueue *queue, TaskPool *pool)
+{
+	/* Atomic reads act as barriers, so bottom is read after top and the item
+	 * is read after both of them.
+	 */
+	const size_t top = atomic_fetch_and_add_z(&queue->top, 0);
+	const size_t bottom = atomic_fetch_and_add_z(&queue->bottom, 0);
+	if ((ptrdiff_t)(bottom - top) <= 0) {
+		return NULL;
+	}
+	/* Item might be overwritten by the owner in the meantime, but then top
+	 * is advanced already and CAS below fails.
+	 */
+	const TaskQueueItem item = queue->items[top & LOCAL_QUEUE_MASK];
+	if (pool != NULL && item.pool != pool) {
+		return NULL;
+	}
+	if (atomic_cas_z(&queue->top, top, top + 1) != top) {
+		return NULL;
+	}
+	return item.task;
+}
+
 /* Task Scheduler */
 
 static void task_pool_num_decrease(TaskPool *pool, size_t done)
 {
+	/* Counter does not reach zero, so nobody is to be notified and pool can
+	 * not be freed from under us: avoid any locks.
+	 */
+	size_t num = pool->num;
+	while (num > done) {
+		const size_t prev_num = atomic_cas_z(&pool->num, num, num - done);
+		if (prev_num == num) {
+			return;
+		}
+		num = prev_num;
+	}
+
 	BLI_mutex_lock(&pool->num_mutex);
 
 	BLI_assert(pool->num >= done);
 
-	pool->num -= done;
-
-	if (pool->num == 0)
+	if (atomic_sub_and_fetch_z(&pool->num, done) == 0)
 		BLI_condition_notify_all(&pool->num_cond);
 
 	BLI_mutex_unlock(&pool->num_mutex);
@@ -346,86 +499,166 @@ static void task_pool_num_increase(TaskPool *pool, size_t new)
 {
 	BLI_mutex_lock(&pool->num_mutex);
 
-	pool->num += new;
+	atomic_add_and_fetch_z(&pool->num, new);
 	BLI_condition_notify_all(&pool->num_cond);
 
 	BLI_mutex_unlock(&pool->num_mutex);
 }
 
-static bool task_scheduler_thread_wait_pop(TaskScheduler *scheduler, Task **task)
+/* Push task to the local queue of the calling thread.
+ *
+ * Returns false if local queue is full and task is to be pushed elsewhere.
+ */
+static bool task_scheduler_push_local(TaskScheduler *scheduler,
+                                      TaskThreadLocalStorage *tls,
+                                      Task *task)
 {
-	bool found_task = false;
-	BLI_mutex_lock(&scheduler->queue_mutex);
+	TaskPool *pool = task->pool;
+	if (task_local_queue_is_full(&tls->local_queue)) {
+		return false;
+	}
+	/* Count the task before it becomes visible to other threads. */
+	atomic_add_and_fetch_z(&pool->num, 1);
+	const bool was_empty = task_local_queue_push(&tls->local_queue, task);
+	/* Queue of non-scheduler thread is not visible to others. */
+	if (tls == &pool->local_tls) {
+		return true;
+	}
+	/* Wake up idle thread, so it can steal the task. */
+	if (atomic_add_and_fetch_uint32(&scheduler->num_idle_threads, 0) != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		BLI_condition_notify_one(&scheduler->queue_cond);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+	/* Thread which waits for the pool could only steal the oldest task, so
+	 * only wake it up when it's the one we've just pushed.
+	 */
+	if (was_empty && atomic_fetch_and_or_uint8(&pool->is_waiting, 0)) {
+		BLI_mutex_lock(&pool->num_mutex);
+		BLI_condition_notify_all(&pool->num_cond);
+		BLI_mutex_unlock(&pool->num_mutex);
+	}
+	return true;
+}
 
-	while (!scheduler->queue.first && !scheduler->do_exit)
-		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+/* Pop task from the global queue, queue_mutex is to be locked.
+ *
+ * When pool is given, only tasks from this pool are considered.
+ */
+static Task *task_scheduler_pop_locked(TaskScheduler *scheduler, TaskPool *pool)
+{
+	for (Task *task = scheduler->queue.first; task != NULL; task = task->next) {
+		if (pool != NULL) {
+			if (task->pool != pool) {
+				continue;
+			}
+		}
+		else if (scheduler->background_thread_only && !task->pool->run_in_background) {
+			continue;
+		}
+		BLI_remlink(&scheduler->queue, task);
+		scheduler->num_queued--;
+		return task;
+	}
+	return NULL;
+}
 
-	do {
-		Task *current_task;
+static Task *task_scheduler_pop(TaskScheduler *scheduler, TaskPool *pool)
+{
+	Task *task = NULL;
+	if (scheduler->num_queued != 0) {
+		BLI_mutex_lock(&scheduler->queue_mutex);
+		task = task_scheduler_pop_locked(scheduler, pool);
+		BLI_mutex_unlock(&scheduler->queue_mutex);
+	}
+	return task;
+}
 
-		/* Assuming we can only have a void queue in 'exit' case here seems logical (we should only be here after
-		 * our worker thread has been woken up from a condition_wait(), which only happens after a new task was
-		 * added to the queue), but it is wrong.
-		 * Waiting on condition may wake up the thread even if condition is not signaled (spurious wake-ups), and some
-		 * race condition may also empty the queue **after** condition has been signaled, but **before** awoken thread
-		 * reaches this point...
-		 * See http://stackoverflow.com/questions/8594591
-		 *
-		 * So we only abort here if do_exit is set.
-		 */
-		if (scheduler->do_exit) {
-			BLI_mutex_unlock(&scheduler->queue_mutex);
-			return false;
+/* Steal a task from local queues of threads other than the given one.
+ *
+ * When pool is given, only tasks from this pool are considered.
+ */
+static Task *task_scheduler_steal(TaskScheduler *scheduler, const int thread_id, TaskPool *pool)
+{
+	const int num_queues = scheduler->num_threads + 1;
+	for (int i = 1; i < num_queues; i++) {
+		const int victim_id = (thread_id + i) % num_queues;
+		TaskLocalQueue *queue = &scheduler->task_threads[victim_id].tls.local_queue;
+		Task *task = task_local_queue_steal(queue, pool);
+		if (task != NULL) {
+			return task;
 		}
+	}
+	return NULL;
+}
 
-		for (current_task = scheduler->queue.first;
-		     current_task != NULL;
-		     current_task = current_task->next)
-		{
-			TaskPool *pool = current_task->pool;
+static bool task_scheduler_thread_wait_pop(TaskThread *thread, Task **task)
+{
+	TaskScheduler *scheduler = thread->scheduler;
+	/* Background-only thread must not pick up regular tasks from the main
+	 * thread queue.
+	 */
+	const bool use_steal = !scheduler->background_thread_only;
+	bool found_task = false;
 
-			if (scheduler->background_thread_only && !pool->run_in_background) {
-				continue;
-			}
+	/* Newest task of own queue is the most likely one to have data in cache. */
+	if ((*task = task_local_queue_pop(&thread->tls.local_queue)) != NULL) {
+		return true;
+	}
+	if ((*task = task_scheduler_pop(scheduler, NULL)) != NULL) {
+		return true;
+	}
+	if (use_steal && (*task = task_scheduler_steal(scheduler, thread->id, NULL)) != NULL) {
+		return true;
+	}
 
-			*task = current_task;
+	/* Nothing to do, go to sleep. Queues are checked once more after marking
+	 * the thread as idle, so we don't miss a wake up from a local queue push.
+	 */
+	BLI_mutex_lock(&scheduler->queue_mutex);
+	atomic_add_and_fetch_uint32(&scheduler->num_idle_threads, 1);
+
+	/* NOTE: Waiting on condition may wake up the thread even if condition is
+	 * not signaled (spurious wake-ups), and some race condition may also empty
+	 * the queue **after** condition has been signaled, but **before** awoken
+	 * thread reaches this point...
+	 * See http://stackoverflow.com/questions/8594591
+	 *
+	 * So we only abort here if do_exit is set.
+	 */
+	while (!scheduler->do_exit) {
+		if ((*task = task_scheduler_pop_locked(scheduler, NULL)) != NULL) {
 			found_task = true;
-			BLI_remlink(&scheduler->queue, *task);
 			break;
 		}
-		if (!found_task)
-			BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
-	} while (!found_task);
+		if (use_steal && (*task = task_scheduler_steal(scheduler, thread->id, NULL)) != NULL) {
+			found_task = true;
+			break;
+		}
+		BLI_condition_wait(&scheduler->queue_cond, &scheduler->queue_mutex);
+	}
 
+	atomic_sub_and_fetch_uint32(&scheduler->num_idle_threads, 1);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
-	return true;
+	return found_task;
 }
 
-BLI_INLINE void handle_local_queue(TaskThreadLocalStorage *tls,
-                                   const int thread_id)
+/* Run the task, free it and notify its pool. */
+static void task_scheduler_run_task(Task *task, const int thread_id)
 {
-	BLI_assert(!tls->do_delayed_push);
-	while (tls->num_local_queue > 0) {
-		/* We pop task from queue before handling it so handler of the task can
-		 * push next job to the local queue.
-		 */
-		tls->num_local_queue--;
-		Task *local_task = tls->local_queue[tls->num_local_queue];
-		/* TODO(sergey): Double-check work_and_wait() doesn't handle other's
-		 * pool tasks.
-		 */
-		TaskPool *local_pool = local_task->pool;
-		local_task->run(local_pool, local_task->taskdata, thread_id);
-		task_free(local_pool, local_task, thread_id);
+	TaskPool *pool = task->pool;
+	/* Tasks from local queues are not removed on cancel, skip them here. */
+	if (!pool->do_cancel) {
+		task->run(pool, task->taskdata, thread_id);
 	}
-	BLI_assert(!tls->do_delayed_push);
+	task_free(pool, task, thread_id);
+	task_pool_num_decrease(pool, 1);
 }
 
 static void *task_scheduler_thread_run(void *thread_p)
 {
 	TaskThread *thread = (TaskThread *) thread_p;
-	TaskThreadLocalStorage *tls = &thread->tls;
 	TaskScheduler *scheduler = thread->scheduler;
 	int thread_id = thread->id;
 	Task *task;
@@ -433,22 +666,10 @@ static void *task_scheduler_thread_run(void *thread_p)
 	pthread_setspecific(scheduler->tls_id_key, thread);
 
 	/* keep popping off tasks */
-	while (task_scheduler_thread_wait_pop(scheduler, &task)) {
-		TaskPool *pool = task->pool;
-
-		/* run task */
-		BLI_assert(!tls->do_delayed_push);
-		task->run(pool, task->taskdata, thread_id);
-		BLI_assert(!tls->do_delayed_push);
-
-		/* delete task */
-		task_free(pool, task, thread_id);
-
-		/* Handle all tasks from local queue. */
-		handle_local_queue(tls, thread_id);
-
-		/* notify pool task was done */
-		task_pool_num_decrease(pool, 1);
+	while (task_scheduler_thread_wait_pop(thread, &task)) {
+		BLI_assert(!thread->tls.do_delayed_push);
+		task_scheduler_run_task(task, thread_id);
+		BLI_assert(!thread->tls.do_delayed_push);
 	}
 
 	return NULL;
@@ -573,6 +794,7 @@ static void task_scheduler_push(TaskScheduler *scheduler, Task *task, TaskPriori
 		BLI_addhead(&scheduler->queue, task);
 	else
 		BLI_addtail(&scheduler->queue, task);
+	scheduler->num_queued++;
 
 	BLI_condition_notify_one(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -594,6 +816,7 @@ static void task_scheduler_push_all(TaskScheduler *scheduler,
 	for (int i = 0; i < num_tasks; i++) {
 		BLI_addhead(&scheduler->queue, tasks[i]);
 	}
+	scheduler->num_queued += num_tasks;
 
 	BLI_condition_notify_all(&scheduler->queue_cond);
 	BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -617,6 +840,7 @@ static void task_scheduler_clear(TaskScheduler *scheduler, TaskPool *pool)
 			done++;
 		}
 	}
+	scheduler->num_queued -= done;
 
 	BLI_mutex_unlock(&scheduler->queue_mutex);
 
@@ -647,6 +871,7 @@ static TaskPool *task_pool_create_ex(TaskScheduler *scheduler,
 
 	pool->scheduler = scheduler;
 	pool->num = 0;
+	pool->is_waiting = 0;
 	pool->do_cancel = false;
 	pool->do_work = false;
 	pool->is_suspended = is_suspended;
@@ -799,11 +1024,9 @@ static void task_pool_push(
 		ASSERT_THREAD_ID(pool->scheduler, thread_id);
 		TaskThreadLocalStorage *tls = get_task_tls(pool, thread_id);
 		/* Try to push to a local execution queue.
-		 * These tasks will be picked up next.
+		 * These tasks will be picked up next, or stolen by idle threads.
 		 */
-		if (tls->num_local_queue < LOCAL_QUEUE_SIZE) {
-			tls->local_queue[tls->num_local_queue] = task;
-			tls->num_local_queue++;
+		if (task_scheduler_push_local(pool->scheduler, tls, task)) {
 			return;
 		}
 		/* If we are in the delayed tasks push mode, we push tasks to a
@@ -852,6 +1075,7 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 			BLI_mutex_lock(&scheduler->queue_mutex);
 
 			BLI_movelisttolist(&scheduler->queue, &pool->suspended_queue);
+			scheduler->num_queued += pool->num_suspended;
 
 			BLI_condition_notify_all(&scheduler->queue_cond);
 			BLI_mutex_unlock(&scheduler->queue_mutex);
@@ -862,58 +1086,47 @@ void BLI_task_pool_work_and_wait(TaskPool *pool)
 
 	ASSERT_THREAD_ID(pool->scheduler, pool->thread_id);
 
-	BLI_mutex_lock(&pool->num_mutex);
-
-	while (pool->num != 0) {
-		Task *task, *work_task = NULL;
-		bool found_task = false;
-
-		BLI_mutex_unlock(&pool->num_mutex);
-
-		BLI_mutex_lock(&scheduler->queue_mutex);
-
-		/* find task from this pool. if we get a task from another pool,
-		 * we can get into deadlock */
+	while (atomic_add_and_fetch_z(&pool->num, 0) != 0) {
+		/* Own local queue only contains tasks pushed by this thread, so it's
+		 * safe to handle them. From the global queue and queues of other
+		 * threads we only take tasks of this pool: if we get a task from
+		 * another pool, we can get into deadlock.
+		 */
+		Task *task = task_local_queue_pop(&tls->local_queue);
+		if (task == NULL) {
+			task = task_scheduler_pop(scheduler, pool);
+		}
+		if (task == NULL) {
+			task = task_scheduler_steal(scheduler, pool->thread_id, pool);
+		}
 
-		for (task = scheduler->queue.first; task; task = task->next) {
-			if (task->pool == pool) {
-				work_task = task;
-				found_task = true;
-				BLI_remlink(&scheduler->queue, task);
-				break;
+		/* if no task found, wait until other tasks are done or new task could
+		 * be taken by us */
+		if (task == NULL) {
+			BLI_mutex_lock(&pool->num_mutex);
+			atomic_fetch_and_or_uint8(&pool->is_waiting, 1);
+			if (pool->num != 0) {
+				task = task_scheduler_steal(scheduler, pool->thread_id, pool);
+				if (task == NULL) {
+					BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
+				}
 			}
+			atomic_fetch_and_and_uint8(&pool->is_waiting, 0);
+			BLI_mutex_unlock(&pool->num_mutex);
 		}
 
-		BLI_mutex_unlock(&scheduler->queue_mutex);
-
-		/* if found task, do it, otherwise wait until other tasks are done */
-		if (found_task) {
-			/* run task */
+		if (task != NULL) {
 			BLI_assert(!tls->do_delayed_push);
-			work_task->run(pool, work_task->taskdata, pool->thread_id);
+			task_scheduler_run_task(task, pool->thread_id);
 			BLI_assert(!tls->do_delayed_push);
-
-			/* delete task */
-			task_free(pool, task, pool->thread_id);
-
-			/* Handle all tasks from local queue. */
-			handle_local_queue(tls, pool->thread_id);
-
-			/* notify pool task was done */
-			task_pool_num_decrease(pool, 1);
 		}
-
-		BLI_mutex_lock(&pool->num_mutex);
-		if (pool->num == 0)
-			break;
-
-		if (!found_task)
-			BLI_condition_wait(&pool->num_cond, &pool->num_mutex);
 	}
 
-	BLI_mutex_unlock(&pool->num_mutex);
-
-	handle_local_queue(tls, pool->thread_id);
+	/* Handle all remaining tasks from local queue. */
+	Task *task;
+	while ((task = task_local_queue_pop(&tls->local_queue)) != NULL) {
+		task_scheduler_run_task(task, pool->thread_id);
+	}
 }
 
 void BLI_task_pool_cancel(TaskPool *pool)
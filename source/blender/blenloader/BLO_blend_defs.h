@@ -75,6 +75,21 @@ enum {
 	ENDB = BLEND_MAKE_ID('E', 'N', 'D', 'B'),
 };
 
+/**
+ * Chunk compressed files (written with #G_FILE_COMPRESS_LZO) start with #BLEN_LZO_MAGIC,
+ * followed by a regular (uncompressed) blend file, split into chunks which are compressed independently,
+ * so they can be compressed and decompressed in parallel.
+ *
+ * Each chunk is stored as ``uint32 raw_len, uint32 data_len, data[data_len]`` (little endian),
+ * when ``data_len == raw_len`` the data is stored as-is. A chunk with ``raw_len == 0`` ends the file.
+ *
+ * \note The magic isn't a valid blend file header, so older versions refuse to load these files.
+ */
+#define BLEN_LZO_MAGIC "BLENDERzLZO1"
+#define BLEN_LZO_MAGIC_LEN 12
+#define BLEN_LZO_CHUNK_HEADER_LEN 8
+#define BLEN_LZO_CHUNK_SIZE (1 << 20)
+
 #define BLEN_THUMB_MEMSIZE_FILE(_x, _y) (sizeof(int) * (2 + (size_t)(_x) * (size_t)(_y)))
 
 #endif  /* __BLO_BLEND_DEFS_H__ */
@@ -33,6 +33,8 @@
  *  \ingroup blenloader
  */
 
+struct BArrayState;
+struct BArrayStore;
 struct Scene;
 
 typedef struct {
@@ -46,7 +48,16 @@ typedef struct {
 
 typedef struct MemFile {
 	ListBase chunks;
+	/** Size in bytes not shared with other undo steps. */
 	size_t size;
+	/**
+	 * Contents de-duplicated against all other undo steps (see #BLI_array_store),
+	 * when set \a chunks is empty.
+	 */
+	struct BArrayState *state;
+	/** Data written into \a state, only used while writing. */
+	char *stream;
+	size_t stream_len, stream_len_alloc;
 } MemFile;
 
 typedef struct MemFileUndoData {
@@ -59,6 +70,7 @@ typedef struct MemFileUndoData {
 extern void memfile_chunk_add(
         MemFile *memfile, const char *buf, unsigned int size,
         MemFileChunk **compchunk_step);
+extern void memfile_write_end(MemFile *memfile, MemFile *compare);
 
 /* exports */
 extern void BLO_memfile_free(MemFile *memfile);
@@ -67,6 +79,8 @@ extern void BLO_memfile_merge(MemFile *first, MemFile *second);
 /* utilities */
 extern struct Main *BLO_memfile_main_get(struct MemFile *memfile, struct Main *bmain, struct Scene **r_scene);
 extern bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename);
+extern void *BLO_memfile_data_get_alloc(struct MemFile *memfile, size_t *r_data_len);
+extern struct BArrayStore *BLO_memfile_arraystore_get(void);
 
 #endif  /* __BLO_UNDOFILE_H__ */
 
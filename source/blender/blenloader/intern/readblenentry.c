@@ -83,7 +83,7 @@ BlendHandle *BLO_blendhandle_from_file(const char *filepath, ReportList *reports
 {
 	BlendHandle *bh;
 
-	bh = (BlendHandle *)blo_openblenderfile(filepath, reports);
+	bh = (BlendHandle *)blo_openblenderfile_library(filepath, reports);
 
 	return bh;
 }
@@ -210,13 +210,13 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 					if (prv) {
 						memcpy(new_prv, prv, sizeof(PreviewImage));
 						if (prv->rect[0] && prv->w[0] && prv->h[0]) {
-							unsigned int *rect = NULL;
 							size_t len = new_prv->w[0] * new_prv->h[0] * sizeof(unsigned int);
 							new_prv->rect[0] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
 							BLI_assert(len == bhead->len);
-							memcpy(new_prv->rect[0], rect, len);
+							if (len == (size_t)bhead->len) {
+								blo_bhead_read_data(fd, bhead, new_prv->rect[0]);
+							}
 						}
 						else {
 							/* This should not be needed, but can happen in 'broken' .blend files,
@@ -227,13 +227,13 @@ LinkNode *BLO_blendhandle_get_previews(BlendHandle *bh, int ofblocktype, int *to
 						}
 						
 						if (prv->rect[1] && prv->w[1] && prv->h[1]) {
-							unsigned int *rect = NULL;
 							size_t len = new_prv->w[1] * new_prv->h[1] * sizeof(unsigned int);
 							new_prv->rect[1] = MEM_callocN(len, __func__);
 							bhead = blo_nextbhead(fd, bhead);
-							rect = (unsigned int *)(bhead + 1);
 							BLI_assert(len == bhead->len);
-							memcpy(new_prv->rect[1], rect, len);
+							if (len == (size_t)bhead->len) {
+								blo_bhead_read_data(fd, bhead, new_prv->rect[1]);
+							}
 						}
 						else {
 							/* This should not be needed, but can happen in 'broken' .blend files,
@@ -98,6 +98,7 @@
 #include "DNA_speaker_types.h"
 #include "DNA_sound_types.h"
 #include "DNA_space_types.h"
+#include "DNA_userdef_types.h"
 #include "DNA_vfont_types.h"
 #include "DNA_world_types.h"
 #include "DNA_movieclip_types.h"
@@ -110,6 +111,10 @@
 #include "BLI_math.h"
 #include "BLI_threads.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_hash_mm2a.h"
+
+#include "PIL_time.h"
 
 #include "BLT_translation.h"
 
@@ -217,9 +222,39 @@
 /* use GHash for BHead name-based lookups (speeds up linking) */
 #define USE_GHASH_BHEAD
 
+/* Memory map uncompressed files, so block data is read from the page cache
+ * instead of being copied into a new allocation per block.
+ * Not on Windows, where mmap_win doesn't support private (copy-on-write) mappings. */
+#ifndef WIN32
+#  define USE_MMAP_READ
+#  include <sys/mman.h>
+#endif
+
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#endif
+
+/* Only index #DATA blocks when opening seekable files (that aren't memory mapped),
+ * their data is read when it's used. Avoids reading data we may never use,
+ * especially when linking a few data-blocks from a large library.
+ *
+ * \note Not used for gzip compressed files, seeking in those is too slow. */
+#define USE_BHEAD_READ_ON_DEMAND
+
+#ifdef USE_BHEAD_READ_ON_DEMAND
+/* We may want to read the data of other block types on demand too. */
+#  define BHEAD_USE_READ_ON_DEMAND(bhead) ((bhead)->code == DATA)
+#endif
+
 /* Use GHash for restoring pointers by name */
 #define USE_GHASH_RESTORE_POINTER
 
+#define BHEADN_FROM_BHEAD(bh) ((BHeadN *)POINTER_OFFSET(bh, -offsetof(BHeadN, bhead)))
+
 /* Define this to have verbose debug prints. */
 #define USE_DEBUG_PRINT
 
@@ -237,11 +272,17 @@ typedef struct OldNew {
 	int nr;
 } OldNew;
 
+/**
+ * Entries are kept in insertion order (some callers loop over them),
+ * \a map is an open-addressing hash of indices into \a entries, for lookups by old address.
+ */
 typedef struct OldNewMap {
 	OldNew *entries;
 	int nentries, entriessize;
-	bool sorted;
 	int lasthit;
+
+	int *map;  /* -1 for empty slots */
+	int map_size_exp;  /* map has (1 << map_size_exp) slots */
 } OldNewMap;
 
 
@@ -284,31 +325,59 @@ static const char *library_parent_filepath(Library *lib)
 	return lib->parent ? lib->parent->filepath : "<direct>";
 }
 
-static OldNewMap *oldnewmap_new(void) 
+#define ONM_MAP_SIZE_EXP_MIN 11
+#define ONM_MAP_SIZE(onm) (1 << (onm)->map_size_exp)
+
+BLI_INLINE uint oldnewmap_hash(const void *ptr, const int map_size_exp)
 {
-	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
-	
-	onm->entriessize = 1024;
-	onm->entries = MEM_malloc_arrayN(onm->entriessize, sizeof(*onm->entries), "OldNewMap.entries");
-	
-	return onm;
+	/* Fibonacci hashing, old addresses are aligned and often close together,
+	 * taking the high bits spreads them over the map. */
+	const uint64_t key = (uint64_t)(uintptr_t)ptr >> 3;
+	return (uint)((key * 0x9E3779B97F4A7C15ull) >> (64 - map_size_exp));
 }
 
-static int verg_oldnewmap(const void *v1, const void *v2)
+static void oldnewmap_map_clear(OldNewMap *onm)
 {
-	const struct OldNew *x1=v1, *x2=v2;
-	
-	if (x1->old > x2->old) return 1;
-	else if (x1->old < x2->old) return -1;
-	return 0;
+	memset(onm->map, 0xff, sizeof(*onm->map) * (size_t)ONM_MAP_SIZE(onm));
 }
 
+static void oldnewmap_map_insert_index(OldNewMap *onm, const void *addr, const int index)
+{
+	const uint mask = (uint)ONM_MAP_SIZE(onm) - 1;
+	uint slot = oldnewmap_hash(addr, onm->map_size_exp);
 
-static void oldnewmap_sort(FileData *fd) 
+	while (onm->map[slot] != -1) {
+		/* Duplicate old addresses: later entries are found first. */
+		if (onm->entries[onm->map[slot]].old == addr) {
+			break;
+		}
+		slot = (slot + 1) & mask;
+	}
+	onm->map[slot] = index;
+}
+
+static void oldnewmap_map_rebuild(OldNewMap *onm)
 {
-	BLI_assert(fd->libmap->sorted == false);
-	qsort(fd->libmap->entries, fd->libmap->nentries, sizeof(OldNew), verg_oldnewmap);
-	fd->libmap->sorted = 1;
+	int i;
+
+	oldnewmap_map_clear(onm);
+	for (i = 0; i < onm->nentries; i++) {
+		oldnewmap_map_insert_index(onm, onm->entries[i].old, i);
+	}
+}
+
+static OldNewMap *oldnewmap_new(void) 
+{
+	OldNewMap *onm= MEM_callocN(sizeof(*onm), "OldNewMap");
+	
+	onm->entriessize = 1024;
+	onm->entries = MEM_malloc_arrayN(onm->entriessize, sizeof(*onm->entries), "OldNewMap.entries");
+
+	onm->map_size_exp = ONM_MAP_SIZE_EXP_MIN;
+	onm->map = MEM_malloc_arrayN(ONM_MAP_SIZE(onm), sizeof(*onm->map), "OldNewMap.map");
+	oldnewmap_map_clear(onm);
+	
+	return onm;
 }
 
 /* nr is zero for data, and ID code for libdata */
@@ -323,6 +392,16 @@ static void oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void *newaddr,
 		onm->entries = MEM_reallocN(onm->entries, sizeof(*onm->entries) * onm->entriessize);
 	}
 
+	/* keep the map at most half full */
+	if (UNLIKELY(onm->nentries * 2 >= ONM_MAP_SIZE(onm))) {
+		onm->map_size_exp++;
+		MEM_freeN(onm->map);
+		onm->map = MEM_malloc_arrayN(ONM_MAP_SIZE(onm), sizeof(*onm->map), "OldNewMap.map");
+		oldnewmap_map_rebuild(onm);
+	}
+
+	oldnewmap_map_insert_index(onm, oldaddr, onm->nentries);
+
 	entry = &onm->entries[onm->nentries++];
 	entry->old = oldaddr;
 	entry->newp = newaddr;
@@ -335,50 +414,22 @@ void blo_do_versions_oldnewmap_insert(OldNewMap *onm, const void *oldaddr, void
 }
 
 /**
- * Do a full search (no state).
- *
- * \param lasthit: Use as a reference position to avoid a full search
- * from either end of the array, giving more efficient lookups.
+ * Do a full lookup (no state), using the hash.
  *
- * \note This would seem an ideal case for hash or btree lookups.
- * However the data is written in-order, using the \a lasthit will normally avoid calling this function.
- * Creating a btree/hash structure adds overhead for the common-case to optimize the corner-case
- * (since most entries will never be retrieved).
- * So just keep full lookups as a fall-back.
+ * \note The data is written in-order, so checking the entry after \a lasthit
+ * (see #oldnewmap_lookup_and_inc) will normally avoid calling this function.
  */
-static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr, int lasthit)
+static int oldnewmap_lookup_entry_full(const OldNewMap *onm, const void *addr)
 {
-	const int nentries = onm->nentries;
-	const OldNew *entries = onm->entries;
-	int i;
+	const uint mask = (uint)ONM_MAP_SIZE(onm) - 1;
+	uint slot = oldnewmap_hash(addr, onm->map_size_exp);
+	int index;
 
-	/* search relative to lasthit where possible */
-	if (lasthit >= 0 && lasthit < nentries) {
-
-		/* search forwards */
-		i = lasthit;
-		while (++i != nentries) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-
-		/* search backwards */
-		i = lasthit + 1;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
-		}
-	}
-	else {
-		/* search backwards (full) */
-		i = nentries;
-		while (i--) {
-			if (entries[i].old == addr) {
-				return i;
-			}
+	while ((index = onm->map[slot]) != -1) {
+		if (onm->entries[index].old == addr) {
+			return index;
 		}
+		slot = (slot + 1) & mask;
 	}
 
 	return -1;
@@ -400,7 +451,7 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool inc
 		}
 	}
 	
-	i = oldnewmap_lookup_entry_full(onm, addr, onm->lasthit);
+	i = oldnewmap_lookup_entry_full(onm, addr);
 	if (i != -1) {
 		OldNew *entry = &onm->entries[i];
 		BLI_assert(entry->old == addr);
@@ -416,32 +467,19 @@ static void *oldnewmap_lookup_and_inc(OldNewMap *onm, const void *addr, bool inc
 /* for libdata, nr has ID code, no increment */
 static void *oldnewmap_liblookup(OldNewMap *onm, const void *addr, const void *lib)
 {
+	int i;
+
 	if (addr == NULL) {
 		return NULL;
 	}
 
-	/* lasthit works fine for non-libdata, linking there is done in same sequence as writing */
-	if (onm->sorted) {
-		const OldNew entry_s = {.old = addr};
-		OldNew *entry = bsearch(&entry_s, onm->entries, onm->nentries, sizeof(OldNew), verg_oldnewmap);
-		if (entry) {
-			ID *id = entry->newp;
-
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
-		}
-	}
-	else {
-		/* note, this can be a bottle neck when loading some files */
-		const int i = oldnewmap_lookup_entry_full(onm, addr, -1);
-		if (i != -1) {
-			OldNew *entry = &onm->entries[i];
-			ID *id = entry->newp;
-			BLI_assert(entry->old == addr);
-			if (id && (!lib || id->lib)) {
-				return id;
-			}
+	i = oldnewmap_lookup_entry_full(onm, addr);
+	if (i != -1) {
+		OldNew *entry = &onm->entries[i];
+		ID *id = entry->newp;
+		BLI_assert(entry->old == addr);
+		if (id && (!lib || id->lib)) {
+			return id;
 		}
 	}
 
@@ -463,6 +501,29 @@ static void oldnewmap_free_unused(OldNewMap *onm)
 
 static void oldnewmap_clear(OldNewMap *onm) 
 {
+	/* The datamap is cleared for every ID, most of them only have a few entries:
+	 * shrink back and only reset the used slots. */
+	if (onm->map_size_exp != ONM_MAP_SIZE_EXP_MIN) {
+		onm->map_size_exp = ONM_MAP_SIZE_EXP_MIN;
+		MEM_freeN(onm->map);
+		onm->map = MEM_malloc_arrayN(ONM_MAP_SIZE(onm), sizeof(*onm->map), "OldNewMap.map");
+		oldnewmap_map_clear(onm);
+	}
+	else {
+		const uint mask = (uint)ONM_MAP_SIZE(onm) - 1;
+		int i;
+
+		/* All entries are removed, so clearing the run of used slots
+		 * from the hash of each entry reaches every used slot. */
+		for (i = 0; i < onm->nentries; i++) {
+			uint slot = oldnewmap_hash(onm->entries[i].old, onm->map_size_exp);
+			while (onm->map[slot] != -1) {
+				onm->map[slot] = -1;
+				slot = (slot + 1) & mask;
+			}
+		}
+	}
+
 	onm->nentries = 0;
 	onm->lasthit = 0;
 }
@@ -470,9 +531,29 @@ static void oldnewmap_clear(OldNewMap *onm)
 static void oldnewmap_free(OldNewMap *onm) 
 {
 	MEM_freeN(onm->entries);
+	MEM_freeN(onm->map);
 	MEM_freeN(onm);
 }
 
+#undef ONM_MAP_SIZE_EXP_MIN
+#undef ONM_MAP_SIZE
+
+/***/
+
+/* Load timings, printed per phase with G_DEBUG_IO. */
+
+BLI_INLINE double read_timing_begin(void)
+{
+	return (G.debug & G_DEBUG_IO) ? PIL_check_seconds_timer() : 0.0;
+}
+
+BLI_INLINE void read_timing_end(double *r_time, const double time_begin)
+{
+	if (G.debug & G_DEBUG_IO) {
+		*r_time += PIL_check_seconds_timer() - time_begin;
+	}
+}
+
 /***/
 
 static void read_libraries(FileData *basefd, ListBase *mainlist);
@@ -802,21 +883,56 @@ static BHeadN *get_bhead(FileData *fd)
 			 * the associated data and put everything in a BHeadN (creative naming !)
 			 */
 			if (!fd->eof) {
-				new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
-				if (new_bhead) {
-					new_bhead->next = new_bhead->prev = NULL;
-					new_bhead->bhead = bhead;
-					
-					readsize = fd->read(fd, new_bhead + 1, bhead.len);
-					
-					if (readsize != bhead.len) {
+				if (fd->file_data) {
+					/* reference the data in the file buffer, no need to copy it */
+					if ((size_t)bhead.len <= fd->file_data_size - fd->file_data_seek) {
+						new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+						new_bhead->next = new_bhead->prev = NULL;
+						new_bhead->data = fd->file_data + fd->file_data_seek;
+						new_bhead->file_offset = (int64_t)fd->file_data_seek;
+						new_bhead->bhead = bhead;
+						fd->file_data_seek += (size_t)bhead.len;
+					}
+					else {
 						fd->eof = 1;
-						MEM_freeN(new_bhead);
-						new_bhead = NULL;
 					}
 				}
+#ifdef USE_BHEAD_READ_ON_DEMAND
+				else if ((fd->flags & FD_FLAGS_READ_ON_DEMAND) && BHEAD_USE_READ_ON_DEMAND(&bhead)) {
+					/* only store where the data is, skip over it */
+					const int64_t offset = lseek(fd->filedes, bhead.len, SEEK_CUR);
+					if (offset != -1) {
+						new_bhead = MEM_mallocN(sizeof(BHeadN), "new_bhead");
+						new_bhead->next = new_bhead->prev = NULL;
+						new_bhead->data = NULL;
+						new_bhead->file_offset = offset - bhead.len;
+						new_bhead->bhead = bhead;
+						fd->file_offset = offset;
+					}
+					else {
+						fd->eof = 1;
+					}
+				}
+#endif
 				else {
-					fd->eof = 1;
+					new_bhead = MEM_mallocN(sizeof(BHeadN) + bhead.len, "new_bhead");
+					if (new_bhead) {
+						new_bhead->next = new_bhead->prev = NULL;
+						new_bhead->data = new_bhead + 1;
+						new_bhead->file_offset = fd->file_offset;
+						new_bhead->bhead = bhead;
+
+						readsize = fd->read(fd, new_bhead + 1, bhead.len);
+
+						if (readsize != bhead.len) {
+							fd->eof = 1;
+							MEM_freeN(new_bhead);
+							new_bhead = NULL;
+						}
+					}
+					else {
+						fd->eof = 1;
+					}
 				}
 			}
 		}
@@ -852,9 +968,56 @@ BHead *blo_firstbhead(FileData *fd)
 	return(bhead);
 }
 
+/**
+ * \return The data following \a bhead in the file,
+ * NULL for #DATA blocks which haven't been read (see #USE_BHEAD_READ_ON_DEMAND).
+ */
+void *blo_bhead_data(BHead *bhead)
+{
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(bhead);
+	return bheadn->data;
+}
+
+/**
+ * Copy the data of \a bhead into \a buf (which must be at least ``bhead->len`` in size),
+ * reading it from the file when it's not in memory.
+ *
+ * \return Success.
+ */
+bool blo_bhead_read_data(FileData *fd, BHead *bhead, void *buf)
+{
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(bhead);
+
+	if (bheadn->data) {
+		memcpy(buf, bheadn->data, (size_t)bhead->len);
+		return true;
+	}
+
+#ifdef USE_BHEAD_READ_ON_DEMAND
+	if (fd->flags & FD_FLAGS_READ_ON_DEMAND) {
+		/* restore the offset, the file may not have been read to the end yet */
+		const int64_t offset_prev = fd->file_offset;
+		bool ok = false;
+
+		if (lseek(fd->filedes, bheadn->file_offset, SEEK_SET) == bheadn->file_offset) {
+			ok = (read(fd->filedes, buf, (unsigned int)bhead->len) == bhead->len);
+			if (lseek(fd->filedes, offset_prev, SEEK_SET) != offset_prev) {
+				fd->eof = 1;
+				ok = false;
+			}
+		}
+		return ok;
+	}
+#else
+	UNUSED_VARS(fd);
+#endif
+
+	return false;
+}
+
 BHead *blo_prevbhead(FileData *UNUSED(fd), BHead *thisblock)
 {
-	BHeadN *bheadn = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+	BHeadN *bheadn = BHEADN_FROM_BHEAD(thisblock);
 	BHeadN *prev = bheadn->prev;
 	
 	return (prev) ? &prev->bhead : NULL;
@@ -868,7 +1031,7 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 	if (thisblock) {
 		/* bhead is actually a sub part of BHeadN
 		 * We calculate the BHeadN pointer from the BHead pointer below */
-		new_bhead = (BHeadN *)POINTER_OFFSET(thisblock, -offsetof(BHeadN, bhead));
+		new_bhead = BHEADN_FROM_BHEAD(thisblock);
 		
 		/* get the next BHeadN. If it doesn't exist we read in the next one */
 		new_bhead = new_bhead->next;
@@ -889,7 +1052,14 @@ BHead *blo_nextbhead(FileData *fd, BHead *thisblock)
 /* Warning! Caller's responsibility to ensure given bhead **is** and ID one! */
 const char *bhead_id_name(const FileData *fd, const BHead *bhead)
 {
-	return (const char *)POINTER_OFFSET(bhead, sizeof(*bhead) + fd->id_name_offs);
+	const BHeadN *bheadn = BHEADN_FROM_BHEAD(bhead);
+
+	if (bheadn->data == NULL) {
+		/* Only ID's read from an index have no data, their name follows the BHeadN. */
+		return (const char *)(bheadn + 1);
+	}
+
+	return (const char *)POINTER_OFFSET(bheadn->data, fd->id_name_offs);
 }
 
 static void decode_blender_header(FileData *fd)
@@ -945,11 +1115,27 @@ static bool read_file_dna(FileData *fd, const char **r_error_message)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == DNA1) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			
-			fd->filesdna = DNA_sdna_from_data(&bhead[1], bhead->len, do_endian_swap, true, r_error_message);
+			void *data = blo_bhead_data(bhead);
+			void *data_on_demand = NULL;
+
+			if (data == NULL) {
+				data = data_on_demand = MEM_mallocN((size_t)bhead->len, __func__);
+				if (!blo_bhead_read_data(fd, bhead, data)) {
+					MEM_freeN(data_on_demand);
+					*r_error_message = "Failed to read DNA block";
+					return false;
+				}
+			}
+
+			fd->filesdna = DNA_sdna_from_data(data, bhead->len, do_endian_swap, true, r_error_message);
+
+			if (data_on_demand) {
+				MEM_freeN(data_on_demand);
+			}
+
 			if (fd->filesdna) {
 				fd->compflags = DNA_struct_get_compareflags(fd->filesdna, fd->memsdna);
-				/* used to retrieve ID names from (bhead+1) */
+				/* used to retrieve ID names from the bhead data */
 				fd->id_name_offs = DNA_elem_offset(fd->filesdna, "ID", "char", "name[]");
 
 				return true;
@@ -975,7 +1161,7 @@ static int *read_file_thumbnail(FileData *fd)
 	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
 		if (bhead->code == TEST) {
 			const bool do_endian_swap = (fd->flags & FD_FLAGS_SWITCH_ENDIAN) != 0;
-			int *data = (int *)(bhead + 1);
+			int *data = blo_bhead_data(bhead);
 
 			if (bhead->len < (2 * sizeof(int))) {
 				break;
@@ -1017,6 +1203,7 @@ static int fd_read_from_file(FileData *filedata, void *buffer, unsigned int size
 	}
 	else {
 		filedata->seek += readsize;
+		filedata->file_offset += readsize;
 	}
 	
 	return readsize;
@@ -1036,6 +1223,17 @@ static int fd_read_gzip_from_file(FileData *filedata, void *buffer, unsigned int
 	return (readsize);
 }
 
+static int fd_read_from_file_data(FileData *filedata, void *buffer, unsigned int size)
+{
+	/* don't read more bytes then there are available in the buffer */
+	const size_t readsize = MIN2((size_t)size, filedata->file_data_size - filedata->file_data_seek);
+
+	memcpy(buffer, filedata->file_data + filedata->file_data_seek, readsize);
+	filedata->file_data_seek += readsize;
+
+	return (int)readsize;
+}
+
 static int fd_read_from_memory(FileData *filedata, void *buffer, unsigned int size)
 {
 	/* don't read more bytes then there are available in the buffer */
@@ -1145,11 +1343,277 @@ static FileData *blo_decode_and_check(FileData *fd, ReportList *reports)
 	return fd;
 }
 
-/* cannot be called with relative paths anymore! */
-/* on each new library added, it now checks for the current FileData and expands relativeness */
-FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+#ifdef WITH_LZO
+
+typedef struct LZOChunkRead {
+	const char *data;
+	size_t data_len;
+	size_t raw_offset, raw_len;
+} LZOChunkRead;
+
+typedef struct LZODecompressData {
+	const LZOChunkRead *chunks;
+	char *raw;
+	bool error;
+} LZODecompressData;
+
+static void blo_lzo_decompress_cb(
+        void *__restrict userdata,
+        const int index,
+        const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	LZODecompressData *data = userdata;
+	const LZOChunkRead *chunk = &data->chunks[index];
+	char *raw = data->raw + chunk->raw_offset;
+
+	if (chunk->data_len == chunk->raw_len) {
+		memcpy(raw, chunk->data, chunk->raw_len);
+	}
+	else {
+		lzo_uint out_len = (lzo_uint)chunk->raw_len;
+		const int r = lzo1x_decompress_safe(
+		        (const lzo_bytep)chunk->data, (lzo_uint)chunk->data_len, (lzo_bytep)raw, &out_len, NULL);
+		if ((r != LZO_E_OK) || (out_len != (lzo_uint)chunk->raw_len)) {
+			data->error = true;
+		}
+	}
+}
+
+static uint32_t blo_lzo_read_uint32(const unsigned char *p)
+{
+	return ((uint32_t)p[0]) | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Parse the chunks of a chunk compressed file (see #BLEN_LZO_MAGIC).
+ *
+ * \param r_chunks: When NULL, the chunks are only counted and validated.
+ * \return The number of chunks, -1 when the file is corrupt.
+ */
+static int blo_lzo_parse_chunks(
+        const char *file_data, const size_t file_size,
+        LZOChunkRead *r_chunks, size_t *r_raw_size)
+{
+	size_t pos = BLEN_LZO_MAGIC_LEN;
+	size_t raw_size = 0;
+	int chunks_len = 0;
+
+	while (true) {
+		const unsigned char *header = (const unsigned char *)file_data + pos;
+		size_t raw_len, data_len;
+
+		if (file_size - pos < BLEN_LZO_CHUNK_HEADER_LEN) {
+			return -1;
+		}
+		raw_len = blo_lzo_read_uint32(header);
+		data_len = blo_lzo_read_uint32(header + 4);
+		pos += BLEN_LZO_CHUNK_HEADER_LEN;
+
+		if (raw_len == 0) {
+			break;
+		}
+		/* data is only ever stored compressed when that makes it smaller */
+		if ((data_len > raw_len) || (data_len > file_size - pos) || (chunks_len == INT_MAX) ||
+		    (raw_size + raw_len < raw_size))
+		{
+			return -1;
+		}
+
+		if (r_chunks) {
+			LZOChunkRead *chunk = &r_chunks[chunks_len];
+			chunk->data = file_data + pos;
+			chunk->data_len = data_len;
+			chunk->raw_offset = raw_size;
+			chunk->raw_len = raw_len;
+		}
+
+		raw_size += raw_len;
+		pos += data_len;
+		chunks_len += 1;
+	}
+
+	*r_raw_size = raw_size;
+	return chunks_len;
+}
+
+/**
+ * Read a chunk compressed file (see #BLEN_LZO_MAGIC), decompressing all chunks in parallel.
+ *
+ * \return The uncompressed file contents, NULL when the file can't be read or is corrupt.
+ */
+char *blo_lzo_decompress_file(int file, const size_t file_size, size_t *r_size)
+{
+	char *file_data, *raw = NULL;
+	size_t raw_size, pos = 0;
+	int chunks_len;
+
+	if (lseek(file, 0, SEEK_SET) != 0) {
+		return NULL;
+	}
+
+	file_data = MEM_mallocN(file_size, __func__);
+	while (pos < file_size) {
+		const int readsize = read(file, file_data + pos, (unsigned int)MIN2(file_size - pos, 1 << 30));
+		if (readsize <= 0) {
+			MEM_freeN(file_data);
+			return NULL;
+		}
+		pos += (size_t)readsize;
+	}
+
+	chunks_len = blo_lzo_parse_chunks(file_data, file_size, NULL, &raw_size);
+
+	if ((chunks_len > 0) && (raw_size >= SIZEOFBLENDERHEADER)) {
+		LZODecompressData data = {NULL};
+		LZOChunkRead *chunks = MEM_mallocN(sizeof(*chunks) * (size_t)chunks_len, __func__);
+
+		blo_lzo_parse_chunks(file_data, file_size, chunks, &raw_size);
+
+		data.chunks = chunks;
+		data.raw = raw = MEM_mallocN(raw_size, __func__);
+
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (chunks_len > 1);
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		BLI_task_parallel_range(0, chunks_len, &data, blo_lzo_decompress_cb, &settings);
+
+		MEM_freeN(chunks);
+
+		if (data.error) {
+			MEM_freeN(raw);
+			raw = NULL;
+		}
+		else {
+			*r_size = raw_size;
+		}
+	}
+
+	MEM_freeN(file_data);
+
+	return raw;
+}
+
+#endif  /* WITH_LZO */
+
+/**
+ * Open files that aren't gzip compressed:
+ * - Uncompressed files are memory mapped.
+ *   The mapping is private (copy-on-write), since block data is endian switched in place.
+ *   Saving never overwrites the file in place (it writes a temporary file and renames it),
+ *   so the mapping stays valid while the file data is in use.
+ *   When mapping isn't supported, the file is read directly (see #USE_BHEAD_READ_ON_DEMAND).
+ * - Chunk compressed files are decompressed in parallel.
+ *
+ * \param use_mmap: When false, uncompressed files are always read directly.
+ * \return NULL for gzip compressed files, then regular reading is used.
+ * \a r_error is set when the file can't be read at all.
+ */
+static FileData *blo_openblenderfile_direct(
+        const char *filepath, ReportList *reports, const bool use_mmap, bool *r_error)
+{
+	FileData *fd;
+	unsigned char magic[BLEN_LZO_MAGIC_LEN];
+	size_t size;
+	int file;
+
+	*r_error = false;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return NULL;
+	}
+
+	size = BLI_file_descriptor_size(file);
+	if ((size == (size_t)-1) || (size < sizeof(magic)) ||
+	    (read(file, magic, sizeof(magic)) != sizeof(magic)))
+	{
+		close(file);
+		return NULL;
+	}
+
+	if (memcmp(magic, BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN) == 0) {
+#ifdef WITH_LZO
+		size_t data_size;
+		char *data = blo_lzo_decompress_file(file, size, &data_size);
+		close(file);
+
+		if (data == NULL) {
+			BKE_reportf(reports, RPT_ERROR, "Failed to read blend file '%s', compressed data is corrupt", filepath);
+			*r_error = true;
+			return NULL;
+		}
+
+		fd = filedata_new();
+		fd->file_data = data;
+		fd->file_data_size = data_size;
+		fd->read = fd_read_from_file_data;
+
+		return fd;
+#else
+		close(file);
+		BKE_reportf(reports, RPT_ERROR, "Failed to read blend file '%s', built without LZO support", filepath);
+		*r_error = true;
+		return NULL;
+#endif
+	}
+
+	if (magic[0] == 0x1f && magic[1] == 0x8b) {
+		close(file);
+		return NULL;
+	}
+
+#ifdef USE_MMAP_READ
+	if (use_mmap) {
+		void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+		if (data != MAP_FAILED) {
+			fd = filedata_new();
+			fd->filedes = file;
+			fd->file_data = data;
+			fd->file_data_size = size;
+			fd->flags |= FD_FLAGS_FILE_DATA_MMAP;
+			fd->read = fd_read_from_file_data;
+
+			return fd;
+		}
+	}
+#else
+	UNUSED_VARS(use_mmap);
+#endif
+
+	if (lseek(file, 0, SEEK_SET) != 0) {
+		close(file);
+		return NULL;
+	}
+
+	fd = filedata_new();
+	fd->filedes = file;
+	fd->read = fd_read_from_file;
+#ifdef USE_BHEAD_READ_ON_DEMAND
+	fd->flags |= FD_FLAGS_READ_ON_DEMAND;
+#endif
+
+	return fd;
+}
+
+static FileData *blo_openblenderfile_ex(const char *filepath, ReportList *reports, const bool use_mmap)
 {
 	gzFile gzfile;
+
+	{
+		bool error;
+		FileData *fd = blo_openblenderfile_direct(filepath, reports, use_mmap, &error);
+		if (fd) {
+			/* needed for library_append and read_libraries */
+			BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+			return blo_decode_and_check(fd, reports);
+		}
+		else if (error) {
+			return NULL;
+		}
+	}
+
 	errno = 0;
 	gzfile = BLI_gzopen(filepath, "rb");
 	
@@ -1170,30 +1634,371 @@ FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
 	}
 }
 
+/* cannot be called with relative paths anymore! */
+/* on each new library added, it now checks for the current FileData and expands relativeness */
+FileData *blo_openblenderfile(const char *filepath, ReportList *reports)
+{
+	return blo_openblenderfile_ex(filepath, reports, true);
+}
+
+/**
+ * Same as #blo_openblenderfile, but uncompressed files aren't memory mapped,
+ * their block data is read on demand (#FD_FLAGS_READ_ON_DEMAND), as on systems without mmap.
+ */
+FileData *blo_openblenderfile_read_on_demand(const char *filepath, ReportList *reports)
+{
+	return blo_openblenderfile_ex(filepath, reports, false);
+}
+
+/* -------------------------------------------------------------------- */
+/** \name Library Index
+ *
+ * Optionally (#USER_LIBRARY_INDEX), an index is kept next to library files (``file.blend.idx``),
+ * storing all block headers, the offsets of their data in the file and the names of ID's.
+ *
+ * Listing the contents of a library and linking from it then only reads the index,
+ * block data is read on demand (see #USE_BHEAD_READ_ON_DEMAND).
+ *
+ * Only used for uncompressed files, the index is rebuilt when the file changes. Besides the size,
+ * modification time and file node (saving replaces the file), a hash of the start and the end
+ * of the file is checked, covering the file header and the first and last block headers.
+ * \{ */
+
+#define BHEAD_INDEX_MAGIC "BLENIDX2"
+#define BHEAD_INDEX_EXT ".idx"
+
+/* number of bytes at the start and the end of the file which are hashed */
+#define BHEAD_INDEX_HASH_SIZE 4096
+
+/* flags the stored block headers depend on */
+#define BHEAD_INDEX_FD_FLAGS (FD_FLAGS_SWITCH_ENDIAN | FD_FLAGS_FILE_POINTSIZE_IS_4 | FD_FLAGS_POINTSIZE_DIFFERS)
+
+typedef struct BHeadIndexHeader {
+	char magic[8];
+	/* the file this is an index of */
+	int64_t file_size, file_mtime, file_mtime_nsec, file_inode;
+	uint32_t file_hash;
+	/* block headers are stored converted, so the index is only valid for the same kind of build */
+	int pointer_size, endian;
+	int fd_flags;
+	/* number of entries, followed by a name (MAX_ID_NAME) for each ID entry */
+	int bhead_len, id_len;
+	int _pad;
+} BHeadIndexHeader;
+
+typedef struct BHeadIndexEntry {
+	BHead bhead;
+	int64_t file_offset;
+} BHeadIndexEntry;
+
+static bool blo_bhead_is_id(const BHead *bhead)
+{
+	const int code = bhead->code;
+
+	/* codes of other blocks use four characters (see #MAKE_ID), which may contain an ID code
+	 * in their two least significant bytes */
+	if (code != (code & 0xFFFF)) {
+		return false;
+	}
+	/* screens are still written with their deprecated code, linked ID's use placeholders */
+	return BKE_idcode_is_valid((short)code) || ELEM(code, ID_SCRN, ID_ID);
+}
+
+static bool blo_bhead_index_filepath(const char *filepath, char r_filepath[FILE_MAX])
+{
+	return (BLI_snprintf(r_filepath, FILE_MAX, "%s" BHEAD_INDEX_EXT, filepath) < FILE_MAX);
+}
+
+static int64_t blo_bhead_index_mtime_nsec(const BLI_stat_t *st)
+{
+	/* the second resolution of 'st_mtime' misses files saved again within the same second */
+#if defined(__APPLE__)
+	return (int64_t)st->st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+	return (int64_t)st->st_mtim.tv_nsec;
+#else
+	UNUSED_VARS(st);
+	return 0;
+#endif
+}
+
+static bool blo_bhead_index_file_hash(const char *filepath, const int64_t file_size, uint32_t *r_hash)
+{
+	unsigned char buf[BHEAD_INDEX_HASH_SIZE];
+	const size_t len = (file_size < BHEAD_INDEX_HASH_SIZE) ? (size_t)file_size : BHEAD_INDEX_HASH_SIZE;
+	BLI_HashMurmur2A mm2;
+	bool ok;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file == -1) {
+		return false;
+	}
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	ok = (read(file, buf, len) == (int64_t)len);
+	if (ok) {
+		BLI_hash_mm2a_add(&mm2, buf, len);
+		ok = ((lseek(file, file_size - (int64_t)len, SEEK_SET) != -1) &&
+		      (read(file, buf, len) == (int64_t)len));
+	}
+	if (ok) {
+		BLI_hash_mm2a_add(&mm2, buf, len);
+		*r_hash = BLI_hash_mm2a_end(&mm2);
+	}
+
+	close(file);
+
+	return ok;
+}
+
+static bool blo_bhead_index_header_init(const char *filepath, BHeadIndexHeader *r_header)
+{
+	BLI_stat_t st;
+
+	if (BLI_stat(filepath, &st) != 0) {
+		return false;
+	}
+
+	memset(r_header, 0, sizeof(*r_header));
+	memcpy(r_header->magic, BHEAD_INDEX_MAGIC, sizeof(r_header->magic));
+	r_header->file_size = (int64_t)st.st_size;
+	r_header->file_mtime = (int64_t)st.st_mtime;
+	r_header->file_mtime_nsec = blo_bhead_index_mtime_nsec(&st);
+	r_header->file_inode = (int64_t)st.st_ino;
+	r_header->pointer_size = (int)sizeof(void *);
+	r_header->endian = ENDIAN_ORDER;
+
+	return blo_bhead_index_file_hash(filepath, r_header->file_size, &r_header->file_hash);
+}
+
+/**
+ * Write the index of \a fd (which must be fully read), replacing an existing one.
+ * Failing to write the index isn't an error (the directory may not be writable for e.g.).
+ */
+static void blo_bhead_index_write(FileData *fd, const char *filepath)
+{
+	BHeadIndexHeader header;
+	BHeadIndexEntry *entries;
+	char (*names)[MAX_ID_NAME];
+	char index_filepath[FILE_MAX], index_filepath_temp[FILE_MAX];
+	BHead *bhead;
+	FILE *fp;
+	bool ok;
+
+	/* data offsets are only known for uncompressed files */
+	if (!(fd->flags & (FD_FLAGS_FILE_DATA_MMAP | FD_FLAGS_READ_ON_DEMAND))) {
+		return;
+	}
+
+	if (!blo_bhead_index_filepath(filepath, index_filepath) ||
+	    (BLI_snprintf(index_filepath_temp, sizeof(index_filepath_temp), "%s@", index_filepath) >= FILE_MAX) ||
+	    !blo_bhead_index_header_init(filepath, &header))
+	{
+		return;
+	}
+
+	header.fd_flags = fd->flags & BHEAD_INDEX_FD_FLAGS;
+	for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead)) {
+		header.bhead_len += 1;
+		header.id_len += blo_bhead_is_id(bhead) ? 1 : 0;
+	}
+
+	entries = MEM_mallocN(sizeof(*entries) * (size_t)header.bhead_len, __func__);
+	names = MEM_callocN(sizeof(*names) * (size_t)max_ii(header.id_len, 1), __func__);
+
+	{
+		BHeadIndexEntry *entry = entries;
+		char (*name)[MAX_ID_NAME] = names;
+		for (bhead = blo_firstbhead(fd); bhead; bhead = blo_nextbhead(fd, bhead), entry++) {
+			entry->bhead = *bhead;
+			entry->file_offset = BHEADN_FROM_BHEAD(bhead)->file_offset;
+			if (blo_bhead_is_id(bhead)) {
+				BLI_strncpy(*name, bhead_id_name(fd, bhead), sizeof(*name));
+				name++;
+			}
+		}
+	}
+
+	fp = BLI_fopen(index_filepath_temp, "wb");
+	if (fp) {
+		ok = ((fwrite(&header, sizeof(header), 1, fp) == 1) &&
+		      (fwrite(entries, sizeof(*entries), (size_t)header.bhead_len, fp) == (size_t)header.bhead_len) &&
+		      (fwrite(names, sizeof(*names), (size_t)header.id_len, fp) == (size_t)header.id_len));
+		ok = (fclose(fp) == 0) && ok;
+
+		if (!ok || (BLI_rename(index_filepath_temp, index_filepath) != 0)) {
+			BLI_delete(index_filepath_temp, false, false);
+		}
+	}
+
+	MEM_freeN(entries);
+	MEM_freeN(names);
+}
+
+/**
+ * \return The file data with all block headers from the index, NULL when there is no valid index.
+ */
+FileData *blo_bhead_index_read(const char *filepath, ReportList *reports)
+{
+	BHeadIndexHeader header, header_test;
+	BHeadIndexEntry *entries = NULL;
+	char (*names)[MAX_ID_NAME] = NULL;
+	char index_filepath[FILE_MAX];
+	FileData *fd = NULL;
+	FILE *fp;
+	int file;
+
+	if (!blo_bhead_index_filepath(filepath, index_filepath) ||
+	    !blo_bhead_index_header_init(filepath, &header_test))
+	{
+		return NULL;
+	}
+
+	fp = BLI_fopen(index_filepath, "rb");
+	if (fp == NULL) {
+		return NULL;
+	}
+
+	if ((fread(&header, sizeof(header), 1, fp) == 1) &&
+	    (memcmp(header.magic, header_test.magic, sizeof(header.magic)) == 0) &&
+	    (header.file_size == header_test.file_size) &&
+	    (header.file_mtime == header_test.file_mtime) &&
+	    (header.file_mtime_nsec == header_test.file_mtime_nsec) &&
+	    (header.file_inode == header_test.file_inode) &&
+	    (header.file_hash == header_test.file_hash) &&
+	    (header.pointer_size == header_test.pointer_size) &&
+	    (header.endian == header_test.endian) &&
+	    (header.bhead_len > 0) && (header.id_len >= 0) && (header.id_len <= header.bhead_len))
+	{
+		entries = MEM_mallocN(sizeof(*entries) * (size_t)header.bhead_len, __func__);
+		names = MEM_mallocN(sizeof(*names) * (size_t)max_ii(header.id_len, 1), __func__);
+		if ((fread(entries, sizeof(*entries), (size_t)header.bhead_len, fp) != (size_t)header.bhead_len) ||
+		    (fread(names, sizeof(*names), (size_t)header.id_len, fp) != (size_t)header.id_len))
+		{
+			MEM_SAFE_FREE(entries);
+		}
+	}
+	fclose(fp);
+
+	if (entries == NULL) {
+		MEM_SAFE_FREE(names);
+		return NULL;
+	}
+
+	file = BLI_open(filepath, O_BINARY | O_RDONLY, 0);
+	if (file != -1) {
+		const BHeadIndexEntry *entry = entries;
+		const char (*name)[MAX_ID_NAME] = (const char (*)[MAX_ID_NAME])names;
+		int id_len = 0;
+
+		fd = filedata_new();
+		fd->filedes = file;
+		fd->read = fd_read_from_file;
+		fd->flags |= FD_FLAGS_READ_ON_DEMAND;
+
+		for (int i = 0; i < header.bhead_len; i++, entry++) {
+			const bool is_id = blo_bhead_is_id(&entry->bhead);
+			BHeadN *new_bhead;
+
+			if (is_id && (id_len++ == header.id_len)) {
+				break;
+			}
+
+			new_bhead = MEM_mallocN(sizeof(BHeadN) + (is_id ? MAX_ID_NAME : 0), "new_bhead");
+			new_bhead->next = new_bhead->prev = NULL;
+			new_bhead->data = NULL;
+			new_bhead->file_offset = entry->file_offset;
+			new_bhead->bhead = entry->bhead;
+			if (is_id) {
+				BLI_strncpy((char *)(new_bhead + 1), *name, MAX_ID_NAME);
+				name++;
+			}
+			BLI_addtail(&fd->listbase, new_bhead);
+		}
+
+		/* all blocks are known, never read more block headers from the file */
+		fd->eof = 1;
+
+		BLI_strncpy(fd->relabase, filepath, sizeof(fd->relabase));
+
+		fd = blo_decode_and_check(fd, reports);
+
+		/* written for a file with a different header (shouldn't happen since the file size matches) */
+		if (fd && ((fd->flags & BHEAD_INDEX_FD_FLAGS) != header.fd_flags || (id_len != header.id_len))) {
+			blo_freefiledata(fd);
+			fd = NULL;
+		}
+	}
+
+	MEM_freeN(entries);
+	MEM_freeN(names);
+
+	return fd;
+}
+
+/**
+ * Same as blo_openblenderfile(), for files which data-blocks are linked from (libraries),
+ * which may use an index of the file, see #USER_LIBRARY_INDEX.
+ */
+FileData *blo_openblenderfile_library(const char *filepath, ReportList *reports)
+{
+	FileData *fd;
+	const bool use_index = (U.flag & USER_LIBRARY_INDEX) != 0;
+
+	if (use_index) {
+		fd = blo_bhead_index_read(filepath, reports);
+		if (fd) {
+			return fd;
+		}
+	}
+
+	fd = blo_openblenderfile(filepath, reports);
+
+	if (fd && use_index) {
+		blo_bhead_index_write(fd, filepath);
+	}
+
+	return fd;
+}
+
+/** \} */
+
 /**
  * Same as blo_openblenderfile(), but does not reads DNA data, only header. Use it for light access
  * (e.g. thumbnail reading).
  */
 static FileData *blo_openblenderfile_minimal(const char *filepath)
 {
+	FileData *fd;
 	gzFile gzfile;
-	errno = 0;
-	gzfile = BLI_gzopen(filepath, "rb");
+	bool error;
 
-	if (gzfile != (gzFile)Z_NULL) {
-		FileData *fd = filedata_new();
+	fd = blo_openblenderfile_direct(filepath, NULL, true, &error);
+	if (fd == NULL) {
+		if (error) {
+			return NULL;
+		}
+
+		errno = 0;
+		gzfile = BLI_gzopen(filepath, "rb");
+		if (gzfile == (gzFile)Z_NULL) {
+			return NULL;
+		}
+
+		fd = filedata_new();
 		fd->gzfiledes = gzfile;
 		fd->read = fd_read_gzip_from_file;
+	}
 
-		decode_blender_header(fd);
-
-		if (fd->flags & FD_FLAGS_FILE_OK) {
-			return fd;
-		}
+	decode_blender_header(fd);
 
-		blo_freefiledata(fd);
+	if (fd->flags & FD_FLAGS_FILE_OK) {
+		return fd;
 	}
 
+	blo_freefiledata(fd);
+
 	return NULL;
 }
 
@@ -1276,7 +2081,14 @@ FileData *blo_openblendermemfile(MemFile *memfile, ReportList *reports)
 		FileData *fd = filedata_new();
 		fd->memfile = memfile;
 		
-		fd->read = fd_read_from_memfile;
+		/* stored in an array-store, expand it so data is referenced without copying */
+		fd->file_data = BLO_memfile_data_get_alloc(memfile, &fd->file_data_size);
+		if (fd->file_data) {
+			fd->read = fd_read_from_file_data;
+		}
+		else {
+			fd->read = fd_read_from_memfile;
+		}
 		fd->flags |= FD_FLAGS_NOT_MY_BUFFER;
 		
 		return blo_decode_and_check(fd, reports);
@@ -1294,6 +2106,18 @@ void blo_freefiledata(FileData *fd)
 		if (fd->gzfiledes != NULL) {
 			gzclose(fd->gzfiledes);
 		}
+
+		if (fd->file_data != NULL) {
+#ifdef USE_MMAP_READ
+			if (fd->flags & FD_FLAGS_FILE_DATA_MMAP) {
+				munmap(fd->file_data, fd->file_data_size);
+			}
+			else
+#endif
+			{
+				MEM_freeN(fd->file_data);
+			}
+		}
 		
 		if (fd->strm.next_in) {
 			if (inflateEnd(&fd->strm) != Z_OK) {
@@ -1569,9 +2393,6 @@ static void change_idid_adr_fd(FileData *fd, const void *old, void *new)
 {
 	int i;
 	
-	/* use a binary search if we have a sorted libmap, for now it's not needed. */
-	BLI_assert(fd->libmap->sorted == false);
-
 	for (i = 0; i < fd->libmap->nentries; i++) {
 		OldNew *entry = &fd->libmap->entries[i];
 		
@@ -1886,12 +2707,10 @@ void blo_add_library_pointer_map(ListBase *old_mainlist, FileData *fd)
 /* ********** END OLD POINTERS ****************** */
 /* ********** READ FILE ****************** */
 
-static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead)
+static void switch_endian_structs(const struct SDNA *filesdna, BHead *bhead, char *data)
 {
 	int blocksize, nblocks;
-	char *data;
 	
-	data = (char *)(bhead+1);
 	blocksize = filesdna->typelens[ filesdna->structs[bhead->SDNAnr][0] ];
 	
 	nblocks = bhead->nr;
@@ -1907,20 +2726,50 @@ static void *read_struct(FileData *fd, BHead *bh, const char *blockname)
 	void *temp = NULL;
 	
 	if (bh->len) {
+		void *data = blo_bhead_data(bh);
+
+#ifdef USE_BHEAD_READ_ON_DEMAND
+		/* not read yet, read it now, without keeping it around (it's only used once) */
+		void *data_on_demand = NULL;
+		if (data == NULL) {
+			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_REMOVED) {
+				return NULL;
+			}
+			data = data_on_demand = MEM_mallocN(bh->len, blockname);
+			if (!blo_bhead_read_data(fd, bh, data)) {
+				MEM_freeN(data_on_demand);
+				return NULL;
+			}
+		}
+#endif
+
 		/* switch is based on file dna */
 		if (bh->SDNAnr && (fd->flags & FD_FLAGS_SWITCH_ENDIAN))
-			switch_endian_structs(fd->filesdna, bh);
+			switch_endian_structs(fd->filesdna, bh, data);
 		
 		if (fd->compflags[bh->SDNAnr] != SDNA_CMP_REMOVED) {
 			if (fd->compflags[bh->SDNAnr] == SDNA_CMP_NOT_EQUAL) {
-				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, (bh+1));
+				temp = DNA_struct_reconstruct(fd->memsdna, fd->filesdna, fd->compflags, bh->SDNAnr, bh->nr, data);
 			}
+#ifdef USE_BHEAD_READ_ON_DEMAND
+			else if (data_on_demand) {
+				/* SDNA_CMP_EQUAL, use the data as-is */
+				temp = data_on_demand;
+				data_on_demand = NULL;
+			}
+#endif
 			else {
 				/* SDNA_CMP_EQUAL */
 				temp = MEM_mallocN(bh->len, blockname);
-				memcpy(temp, (bh+1), bh->len);
+				memcpy(temp, data, bh->len);
 			}
 		}
+
+#ifdef USE_BHEAD_READ_ON_DEMAND
+		if (data_on_demand) {
+			MEM_freeN(data_on_demand);
+		}
+#endif
 	}
 
 	return temp;
@@ -5664,6 +6513,7 @@ static void direct_link_object(FileData *fd, Object *ob)
 	ob->bb = NULL;
 	ob->derivedDeform = NULL;
 	ob->derivedFinal = NULL;
+	ob->deform_normals_cache = NULL;
 	BLI_listbase_clear(&ob->gpulamp);
 	link_list(fd, &ob->pc_ids);
 
@@ -8164,6 +9014,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	ListBase *lb;
 	const char *allocname;
 	bool wrong_id = false;
+	double time_begin;
 
 	/* In undo case, most libs and linked data should be kept as is from previous state (see BLO_read_from_memfile).
 	 * However, some needed by the snapshot being read may have been removed in previous one, and would go missing.
@@ -8219,6 +9070,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	}
 
 	/* read libblock */
+	time_begin = read_timing_begin();
 	id = read_struct(fd, bhead, "lib block");
 
 	if (id) {
@@ -8239,8 +9091,10 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 
 	if (r_id)
 		*r_id = id;
-	if (!id)
+	if (!id) {
+		read_timing_end(&fd->time_read, time_begin);
 		return blo_nextbhead(fd, bhead);
+	}
 	
 	id->lib = main->curlib;
 	id->us = ID_FAKE_USERS(id);
@@ -8253,6 +9107,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 		/* That way, we know which datablock needs do_versions (required currently for linking). */
 		id->tag = tag | LIB_TAG_NEED_LINK | LIB_TAG_NEW;
 
+		read_timing_end(&fd->time_read, time_begin);
 		return blo_nextbhead(fd, bhead);
 	}
 
@@ -8261,8 +9116,10 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	
 	/* read all data into fd->datamap */
 	bhead = read_data_into_oldnewmap(fd, bhead, allocname);
+	read_timing_end(&fd->time_read, time_begin);
 	
 	/* init pointers direct data */
+	time_begin = read_timing_begin();
 	direct_link_id(fd, id);
 
 	/* That way, we know which datablock needs do_versions (required currently for linking). */
@@ -8376,6 +9233,7 @@ static BHead *read_libblock(FileData *fd, Main *main, BHead *bhead, const short
 	
 	oldnewmap_free_unused(fd->datamap);
 	oldnewmap_clear(fd->datamap);
+	read_timing_end(&fd->time_direct_link, time_begin);
 	
 	if (wrong_id) {
 		BKE_libblock_free(main, id);
@@ -8527,8 +9385,6 @@ static void do_versions_after_linking(Main *main)
 
 static void lib_link_all(FileData *fd, Main *main)
 {
-	oldnewmap_sort(fd);
-	
 	/* No load UI for undo memfiles */
 	if (fd->memfile == NULL) {
 		lib_link_windowmanager(fd, main);
@@ -8650,6 +9506,8 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	BHead *bhead = blo_firstbhead(fd);
 	BlendFileData *bfd;
 	ListBase mainlist = {NULL, NULL};
+	const double time_start = read_timing_begin();
+	double time_begin, time_versioning = 0.0, time_libraries = 0.0, time_lib_link = 0.0;
 	
 	bfd = MEM_callocN(sizeof(BlendFileData), "blendfiledata");
 	bfd->main = BKE_main_new();
@@ -8735,18 +9593,25 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	
 	/* do before read_libraries, but skip undo case */
 	if (fd->memfile == NULL) {
+		time_begin = read_timing_begin();
 		do_versions(fd, NULL, bfd->main);
 		do_versions_userdef(fd, bfd);
+		read_timing_end(&time_versioning, time_begin);
 	}
 	
+	time_begin = read_timing_begin();
 	read_libraries(fd, &mainlist);
+	read_timing_end(&time_libraries, time_begin);
 	
 	blo_join_main(&mainlist);
 	
+	time_begin = read_timing_begin();
 	lib_link_all(fd, bfd->main);
+	read_timing_end(&time_lib_link, time_begin);
 
 	/* Skip in undo case. */
 	if (fd->memfile == NULL) {
+		time_begin = read_timing_begin();
 		/* Yep, second splitting... but this is a very cheap operation, so no big deal. */
 		blo_split_main(&mainlist, bfd->main);
 		for (Main *mainvar = mainlist.first; mainvar; mainvar = mainvar->next) {
@@ -8754,6 +9619,7 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 			do_versions_after_linking(mainvar);
 		}
 		blo_join_main(&mainlist);
+		read_timing_end(&time_versioning, time_begin);
 	}
 
 	BKE_main_id_tag_all(bfd->main, LIB_TAG_NEW, false);
@@ -8765,6 +9631,17 @@ BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath)
 	
 	fd->mainlist = NULL;  /* Safety, this is local variable, shall not be used afterward. */
 
+	/* Undo steps would flood the output. */
+	if ((G.debug & G_DEBUG_IO) && (fd->memfile == NULL)) {
+		printf("Load timings: \"%s\"\n", filepath[0] ? filepath : "<memory>");
+		printf("  read:        %.4f sec\n", fd->time_read);
+		printf("  direct_link: %.4f sec\n", fd->time_direct_link);
+		printf("  versioning:  %.4f sec\n", time_versioning);
+		printf("  libraries:   %.4f sec\n", time_libraries);
+		printf("  lib_link:    %.4f sec\n", time_lib_link);
+		printf("  total:       %.4f sec\n", PIL_check_seconds_timer() - time_start);
+	}
+
 	return bfd;
 }
 
@@ -10524,7 +11401,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 						        mainptr->curlib->filepath,
 						        mainptr->curlib->name,
 						        library_parent_filepath(mainptr->curlib));
-						fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+						fd = blo_openblenderfile_library(mainptr->curlib->filepath, basefd->reports);
 					}
 					/* allow typing in a new lib path */
 					if (G.debug_value == -666) {
@@ -10541,7 +11418,7 @@ static void read_libraries(FileData *basefd, ListBase *mainlist)
 								BLI_strncpy(mainptr->curlib->filepath, newlib_path, sizeof(mainptr->curlib->filepath));
 								BLI_cleanup_path(G.main->name, mainptr->curlib->filepath);
 								
-								fd = blo_openblenderfile(mainptr->curlib->filepath, basefd->reports);
+								fd = blo_openblenderfile_library(mainptr->curlib->filepath, basefd->reports);
 
 								if (fd) {
 									fd->mainlist = mainlist;
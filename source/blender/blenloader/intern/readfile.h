@@ -61,6 +61,12 @@ typedef struct FileData {
 	// variables needed for reading from file
 	int filedes;
 	gzFile gzfiledes;
+	int64_t file_offset;  /* only for uncompressed files, read with #filedes */
+
+	// variables needed for reading from the whole file in memory,
+	// memory mapped (uncompressed files) or decompressed (chunk compressed files, see #BLEN_LZO_MAGIC)
+	char *file_data;
+	size_t file_data_size, file_data_seek;
 
 	// now only in use for library appending
 	char relabase[FILE_MAX];
@@ -100,6 +106,10 @@ typedef struct FileData {
 	ListBase *mainlist;
 	ListBase *old_mainlist;  /* Used for undo. */
 
+	/* Time spent reading and direct-linking data-blocks, in seconds.
+	 * Only accumulated with G_DEBUG_IO, see blo_read_file_internal. */
+	double time_read, time_direct_link;
+
 	/* ick ick, used to return
 	 * data through streamglue.
 	 */
@@ -109,6 +119,13 @@ typedef struct FileData {
 
 typedef struct BHeadN {
 	struct BHeadN *next, *prev;
+	/* The data of the block, follows the header unless the whole file is in memory
+	 * (see FileData.file_data), in which case it points into that buffer.
+	 * NULL when the data is read on demand (see FD_FLAGS_READ_ON_DEMAND). */
+	void *data;
+	/* Offset of the data in the file (only valid for uncompressed files),
+	 * used when reading on demand and for the index, see #blo_openblenderfile_library. */
+	int64_t file_offset;
 	struct BHead bhead;
 } BHeadN;
 
@@ -120,6 +137,8 @@ enum {
 	FD_FLAGS_FILE_OK               = 1 << 3,
 	FD_FLAGS_NOT_MY_BUFFER         = 1 << 4,
 	FD_FLAGS_NOT_MY_LIBMAP         = 1 << 5,  /* XXX Unused in practice (checked once but never set). */
+	FD_FLAGS_FILE_DATA_MMAP        = 1 << 6,  /* FileData.file_data is memory mapped (otherwise allocated). */
+	FD_FLAGS_READ_ON_DEMAND        = 1 << 7,  /* Data of #DATA blocks is read when used (seekable files only). */
 };
 
 #define SIZEOFBLENDERHEADER 12
@@ -132,6 +151,12 @@ void blo_split_main(ListBase *mainlist, struct Main *main);
 BlendFileData *blo_read_file_internal(FileData *fd, const char *filepath);
 
 FileData *blo_openblenderfile(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile_read_on_demand(const char *filepath, struct ReportList *reports);
+FileData *blo_openblenderfile_library(const char *filepath, struct ReportList *reports);
+FileData *blo_bhead_index_read(const char *filepath, struct ReportList *reports);
+#ifdef WITH_LZO
+char *blo_lzo_decompress_file(int file, const size_t file_size, size_t *r_size);
+#endif
 FileData *blo_openblendermemory(const void *buffer, int buffersize, struct ReportList *reports);
 FileData *blo_openblendermemfile(struct MemFile *memfile, struct ReportList *reports);
 
@@ -151,6 +176,8 @@ void blo_freefiledata(FileData *fd);
 BHead *blo_firstbhead(FileData *fd);
 BHead *blo_nextbhead(FileData *fd, BHead *thisblock);
 BHead *blo_prevbhead(FileData *fd, BHead *thisblock);
+void *blo_bhead_data(BHead *bhead);
+bool blo_bhead_read_data(FileData *fd, BHead *bhead, void *buf);
 
 const char *bhead_id_name(const FileData *fd, const BHead *bhead);
 
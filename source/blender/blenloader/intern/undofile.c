@@ -55,11 +55,72 @@
 
 #include "BKE_main.h"
 
+/**
+ * Store undo steps in a #BArrayStore shared by all memfiles,
+ * so data is de-duplicated against every other step (not only the previous one at the same offset),
+ * the memory used by an undo step is then close to the size of the data that changed.
+ */
+#define USE_MEMFILE_ARRAY_STORE
+
+#ifdef USE_MEMFILE_ARRAY_STORE
+#  include "BLI_array_store.h"
+   /* Bytes per de-duplicated chunk. */
+#  define MEMFILE_ARRAY_CHUNK_SIZE 4096
+   /* Initial size of the write stream. */
+#  define MEMFILE_STREAM_SIZE_MIN (1 << 20)
+#endif
+
 /* keep last */
 #include "BLI_strict_flags.h"
 
 /* **************** support for memory-write, for undo buffers *************** */
 
+#ifdef USE_MEMFILE_ARRAY_STORE
+
+/** \name Array Store
+ * \{ */
+
+static struct {
+	BArrayStore *bs;
+	/* number of memfile states in 'bs' */
+	int users;
+} mf_arraystore = {NULL};
+
+static BArrayStore *memfile_arraystore_ensure(void)
+{
+	if (mf_arraystore.bs == NULL) {
+		mf_arraystore.bs = BLI_array_store_create(1, MEMFILE_ARRAY_CHUNK_SIZE);
+	}
+	mf_arraystore.users += 1;
+	return mf_arraystore.bs;
+}
+
+static void memfile_arraystore_release(void)
+{
+	BLI_assert(mf_arraystore.users > 0);
+	mf_arraystore.users -= 1;
+	if (mf_arraystore.users == 0) {
+		BLI_array_store_destroy(mf_arraystore.bs);
+		mf_arraystore.bs = NULL;
+	}
+}
+
+/** \} */
+
+#endif  /* USE_MEMFILE_ARRAY_STORE */
+
+/**
+ * \return The store shared by all memfile undo steps, NULL when no steps use it.
+ */
+struct BArrayStore *BLO_memfile_arraystore_get(void)
+{
+#ifdef USE_MEMFILE_ARRAY_STORE
+	return mf_arraystore.bs;
+#else
+	return NULL;
+#endif
+}
+
 /* not memfile itself */
 void BLO_memfile_free(MemFile *memfile)
 {
@@ -71,11 +132,26 @@ void BLO_memfile_free(MemFile *memfile)
 		}
 		MEM_freeN(chunk);
 	}
+
+#ifdef USE_MEMFILE_ARRAY_STORE
+	if (memfile->state) {
+		BLI_array_store_state_remove(mf_arraystore.bs, memfile->state);
+		memfile->state = NULL;
+		memfile_arraystore_release();
+	}
+	if (memfile->stream) {
+		MEM_freeN(memfile->stream);
+		memfile->stream = NULL;
+		memfile->stream_len = memfile->stream_len_alloc = 0;
+	}
+#endif
+
 	memfile->size = 0;
 }
 
 /* to keep list of memfiles consistent, 'first' is always first in list */
-/* result is that 'first' is being freed */
+/* result is that 'first' is being freed,
+ * states in the array store are reference counted, so they don't need merging. */
 void BLO_memfile_merge(MemFile *first, MemFile *second)
 {
 	MemFileChunk *fc, *sc;
@@ -100,6 +176,19 @@ void memfile_chunk_add(
         MemFile *memfile, const char *buf, unsigned int size,
         MemFileChunk **compchunk_step)
 {
+#ifdef USE_MEMFILE_ARRAY_STORE
+	/* Written into a single stream, de-duplicated in #memfile_write_end. */
+	if (memfile->stream_len + size > memfile->stream_len_alloc) {
+		memfile->stream_len_alloc = MAX3(
+		        memfile->stream_len_alloc * 2, memfile->stream_len + size, (size_t)MEMFILE_STREAM_SIZE_MIN);
+		memfile->stream = memfile->stream ?
+		        MEM_reallocN(memfile->stream, memfile->stream_len_alloc) :
+		        MEM_mallocN(memfile->stream_len_alloc, "MemFile stream");
+	}
+	memcpy(memfile->stream + memfile->stream_len, buf, size);
+	memfile->stream_len += size;
+	UNUSED_VARS(compchunk_step);
+#else
 	MemFileChunk *curchunk = MEM_mallocN(sizeof(MemFileChunk), "MemFileChunk");
 	curchunk->size = size;
 	curchunk->buf = NULL;
@@ -125,6 +214,48 @@ void memfile_chunk_add(
 		curchunk->buf = buf_new;
 		memfile->size += size;
 	}
+#endif  /* USE_MEMFILE_ARRAY_STORE */
+}
+
+/**
+ * Finish writing \a memfile, \a compare is the previous undo step (can be NULL).
+ */
+void memfile_write_end(MemFile *memfile, MemFile *compare)
+{
+#ifdef USE_MEMFILE_ARRAY_STORE
+	if (memfile->stream) {
+		BArrayStore *bs = memfile_arraystore_ensure();
+		const size_t size_compacted_prev = BLI_array_store_calc_size_compacted_get(bs);
+
+		memfile->state = BLI_array_store_state_add(
+		        bs, memfile->stream, memfile->stream_len,
+		        (compare && compare->state) ? compare->state : NULL);
+		memfile->size = BLI_array_store_calc_size_compacted_get(bs) - size_compacted_prev;
+
+		MEM_freeN(memfile->stream);
+		memfile->stream = NULL;
+		memfile->stream_len = memfile->stream_len_alloc = 0;
+	}
+#else
+	UNUSED_VARS(memfile, compare);
+#endif
+}
+
+/**
+ * \return The contents of \a memfile in a single allocation,
+ * or NULL when it's stored as a list of chunks.
+ */
+void *BLO_memfile_data_get_alloc(MemFile *memfile, size_t *r_data_len)
+{
+#ifdef USE_MEMFILE_ARRAY_STORE
+	if (memfile->state) {
+		return BLI_array_store_state_data_get_alloc(memfile->state, r_data_len);
+	}
+#else
+	UNUSED_VARS(memfile);
+#endif
+	*r_data_len = 0;
+	return NULL;
 }
 
 struct Main *BLO_memfile_main_get(struct MemFile *memfile, struct Main *oldmain, struct Scene **r_scene)
@@ -177,15 +308,28 @@ bool BLO_memfile_write_file(struct MemFile *memfile, const char *filename)
 		return false;
 	}
 
-	for (chunk = memfile->chunks.first; chunk; chunk = chunk->next) {
+	bool ok = true;
+	size_t data_len;
+	char *data = BLO_memfile_data_get_alloc(memfile, &data_len);
+	if (data) {
+		/* write in pieces, large writes may be truncated */
+		const size_t write_len_max = (1 << 30);
+		for (size_t pos = 0; pos < data_len && ok; pos += write_len_max) {
+			const size_t len = MIN2(data_len - pos, write_len_max);
+			ok = ((size_t)write(file, data + pos, (uint)len) == len);
+		}
+		MEM_freeN(data);
+	}
+
+	for (chunk = memfile->chunks.first; chunk && ok; chunk = chunk->next) {
 		if ((size_t)write(file, chunk->buf, chunk->size) != chunk->size) {
-			break;
+			ok = false;
 		}
 	}
 
 	close(file);
 
-	if (chunk) {
+	if (!ok) {
 		fprintf(stderr, "Unable to save '%s': %s\n",
 		        filename, errno ? strerror(errno) : "Unknown error writing file");
 		return false;
@@ -154,6 +154,7 @@
 #include "BLI_blenlib.h"
 #include "BLI_linklist.h"
 #include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_action.h"
 #include "BKE_blender_version.h"
@@ -191,6 +192,15 @@
 
 #include <errno.h>
 
+#ifdef WITH_LZO
+#  ifdef WITH_SYSTEM_LZO
+#    include <lzo/lzo1x.h>
+#  else
+#    include "minilzo.h"
+#  endif
+#  define LZO_OUT_LEN(size)     ((size) + (size) / 16 + 64 + 3)
+#endif
+
 /* ********* my write, buffered writing with minimum size chunks ************ */
 
 /* Use optimal allocation since blocks of this size are kept in memory for undo. */
@@ -207,9 +217,15 @@
 typedef enum {
 	WW_WRAP_NONE = 1,
 	WW_WRAP_ZLIB,
+#ifdef WITH_LZO
+	WW_WRAP_LZO,
+#endif
 } eWriteWrapType;
 
 typedef struct WriteWrap WriteWrap;
+#ifdef WITH_LZO
+typedef struct WriteWrapLZO WriteWrapLZO;
+#endif
 struct WriteWrap {
 	/* callbacks */
 	bool   (*open)(WriteWrap *ww, const char *filepath);
@@ -220,6 +236,9 @@ struct WriteWrap {
 	union {
 		int file_handle;
 		gzFile gz_handle;
+#ifdef WITH_LZO
+		WriteWrapLZO *lzo_handle;
+#endif
 	} _user_data;
 };
 
@@ -279,6 +298,186 @@ static size_t ww_write_zlib(WriteWrap *ww, const char *buf, size_t buf_len)
 }
 #undef FILE_HANDLE
 
+/* lzo (chunked) */
+#ifdef WITH_LZO
+
+/**
+ * Data is split into #BLEN_LZO_CHUNK_SIZE chunks, each full chunk is compressed by a task
+ * while the following chunks are being filled, once all chunks of a batch are in use
+ * they're written in order (see #BLEN_LZO_MAGIC for the file layout).
+ */
+typedef struct WriteWrapLZOChunk {
+	char *in;
+	char *out;
+	size_t in_len;
+	lzo_uint out_len;
+	/* when false, the chunk is written uncompressed */
+	bool is_compressed;
+	lzo_align_t *wrkmem;
+} WriteWrapLZOChunk;
+
+struct WriteWrapLZO {
+	int file_handle;
+	TaskPool *task_pool;
+	WriteWrapLZOChunk *chunks;
+	/* number of chunks in the batch, and the chunk currently being filled */
+	int chunks_len, chunk_active;
+	bool error;
+};
+
+#define FILE_HANDLE(ww) \
+	(ww)->_user_data.lzo_handle
+
+static void ww_lzo_compress_task(TaskPool *__restrict UNUSED(pool), void *taskdata, int UNUSED(threadid))
+{
+	WriteWrapLZOChunk *chunk = taskdata;
+	int r;
+
+	chunk->out_len = LZO_OUT_LEN(chunk->in_len);
+	r = lzo1x_1_compress(
+	        (const lzo_bytep)chunk->in, (lzo_uint)chunk->in_len,
+	        (lzo_bytep)chunk->out, &chunk->out_len, chunk->wrkmem);
+
+	chunk->is_compressed = ((r == LZO_E_OK) && (chunk->out_len < chunk->in_len));
+}
+
+static bool ww_lzo_write_chunk_header(WriteWrapLZO *wwl, size_t raw_len, size_t data_len)
+{
+	const uint32_t values[2] = {(uint32_t)raw_len, (uint32_t)data_len};
+	unsigned char header[BLEN_LZO_CHUNK_HEADER_LEN];
+
+	for (int i = 0; i < 2; i++) {
+		header[i * 4 + 0] = (unsigned char)(values[i]);
+		header[i * 4 + 1] = (unsigned char)(values[i] >> 8);
+		header[i * 4 + 2] = (unsigned char)(values[i] >> 16);
+		header[i * 4 + 3] = (unsigned char)(values[i] >> 24);
+	}
+
+	return ((size_t)write(wwl->file_handle, header, sizeof(header)) == sizeof(header));
+}
+
+/**
+ * Wait for all pending chunks to be compressed, then write them in order.
+ */
+static void ww_lzo_flush(WriteWrapLZO *wwl)
+{
+	int chunks_filled = wwl->chunk_active;
+
+	BLI_task_pool_work_and_wait(wwl->task_pool);
+
+	/* the last chunk may be partially filled (only when closing), compress it here */
+	if (chunks_filled < wwl->chunks_len && wwl->chunks[chunks_filled].in_len != 0) {
+		ww_lzo_compress_task(NULL, &wwl->chunks[chunks_filled], 0);
+		chunks_filled += 1;
+	}
+
+	for (int i = 0; i < chunks_filled; i++) {
+		WriteWrapLZOChunk *chunk = &wwl->chunks[i];
+		const char *data = chunk->is_compressed ? chunk->out : chunk->in;
+		const size_t data_len = chunk->is_compressed ? (size_t)chunk->out_len : chunk->in_len;
+
+		if (wwl->error == false) {
+			if (!ww_lzo_write_chunk_header(wwl, chunk->in_len, data_len) ||
+			    ((size_t)write(wwl->file_handle, data, data_len) != data_len))
+			{
+				wwl->error = true;
+			}
+		}
+		chunk->in_len = 0;
+	}
+
+	wwl->chunk_active = 0;
+}
+
+static bool ww_open_lzo(WriteWrap *ww, const char *filepath)
+{
+	WriteWrapLZO *wwl;
+	int file;
+
+	file = BLI_open(filepath, O_BINARY + O_WRONLY + O_CREAT + O_TRUNC, 0666);
+
+	if (file == -1) {
+		return false;
+	}
+
+	if ((size_t)write(file, BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN) != BLEN_LZO_MAGIC_LEN) {
+		close(file);
+		return false;
+	}
+
+	TaskScheduler *scheduler = BLI_task_scheduler_get();
+
+	wwl = MEM_callocN(sizeof(*wwl), __func__);
+	wwl->file_handle = file;
+	wwl->task_pool = BLI_task_pool_create(scheduler, NULL);
+	/* enough chunks to keep all threads busy while the next ones are being filled */
+	wwl->chunks_len = BLI_task_scheduler_num_threads(scheduler) * 2;
+	wwl->chunks = MEM_callocN(sizeof(*wwl->chunks) * (size_t)wwl->chunks_len, __func__);
+
+	for (int i = 0; i < wwl->chunks_len; i++) {
+		WriteWrapLZOChunk *chunk = &wwl->chunks[i];
+		chunk->in = MEM_mallocN(BLEN_LZO_CHUNK_SIZE, __func__);
+		chunk->out = MEM_mallocN(LZO_OUT_LEN(BLEN_LZO_CHUNK_SIZE), __func__);
+		chunk->wrkmem = MEM_mallocN(LZO1X_MEM_COMPRESS, __func__);
+	}
+
+	FILE_HANDLE(ww) = wwl;
+	return true;
+}
+static bool ww_close_lzo(WriteWrap *ww)
+{
+	WriteWrapLZO *wwl = FILE_HANDLE(ww);
+	bool ok;
+
+	ww_lzo_flush(wwl);
+
+	if (wwl->error == false) {
+		if (!ww_lzo_write_chunk_header(wwl, 0, 0)) {
+			wwl->error = true;
+		}
+	}
+	ok = (wwl->error == false) && (close(wwl->file_handle) != -1);
+
+	BLI_task_pool_free(wwl->task_pool);
+	for (int i = 0; i < wwl->chunks_len; i++) {
+		WriteWrapLZOChunk *chunk = &wwl->chunks[i];
+		MEM_freeN(chunk->in);
+		MEM_freeN(chunk->out);
+		MEM_freeN(chunk->wrkmem);
+	}
+	MEM_freeN(wwl->chunks);
+	MEM_freeN(wwl);
+
+	return ok;
+}
+static size_t ww_write_lzo(WriteWrap *ww, const char *buf, size_t buf_len)
+{
+	WriteWrapLZO *wwl = FILE_HANDLE(ww);
+	size_t written = 0;
+
+	while (written < buf_len) {
+		WriteWrapLZOChunk *chunk = &wwl->chunks[wwl->chunk_active];
+		const size_t len = MIN2(buf_len - written, BLEN_LZO_CHUNK_SIZE - chunk->in_len);
+
+		memcpy(chunk->in + chunk->in_len, buf + written, len);
+		chunk->in_len += len;
+		written += len;
+
+		if (chunk->in_len == BLEN_LZO_CHUNK_SIZE) {
+			BLI_task_pool_push(wwl->task_pool, ww_lzo_compress_task, chunk, false, TASK_PRIORITY_HIGH);
+			wwl->chunk_active += 1;
+			if (wwl->chunk_active == wwl->chunks_len) {
+				ww_lzo_flush(wwl);
+			}
+		}
+	}
+
+	return wwl->error ? 0 : buf_len;
+}
+#undef FILE_HANDLE
+
+#endif  /* WITH_LZO */
+
 /* --- end compression types --- */
 
 static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
@@ -293,6 +492,15 @@ static void ww_handle_init(eWriteWrapType ww_type, WriteWrap *r_ww)
 			r_ww->write = ww_write_zlib;
 			break;
 		}
+#ifdef WITH_LZO
+		case WW_WRAP_LZO:
+		{
+			r_ww->open  = ww_open_lzo;
+			r_ww->close = ww_close_lzo;
+			r_ww->write = ww_write_lzo;
+			break;
+		}
+#endif
 		default:
 		{
 			r_ww->open  = ww_open_none;
@@ -4104,7 +4312,11 @@ bool BLO_write_file(
 	BLI_snprintf(tempname, sizeof(tempname), "%s@", filepath);
 
 	if (write_flags & G_FILE_COMPRESS) {
+#ifdef WITH_LZO
+		ww_type = (write_flags & G_FILE_COMPRESS_LZO) ? WW_WRAP_LZO : WW_WRAP_ZLIB;
+#else
 		ww_type = WW_WRAP_ZLIB;
+#endif
 	}
 	else {
 		ww_type = WW_WRAP_NONE;
@@ -4153,9 +4365,12 @@ bool BLO_write_file(
 	}
 
 	/* actual file writing */
-	const bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
+	bool err = write_file_handle(mainvar, &ww, NULL, NULL, write_flags, thumb);
 
-	ww.close(&ww);
+	/* compressed data may only be written out on closing */
+	if (ww.close(&ww) == false) {
+		err = true;
+	}
 
 	if (UNLIKELY(path_list_backup)) {
 		BKE_bpath_list_restore(mainvar, path_list_flag, path_list_backup);
@@ -4201,6 +4416,8 @@ bool BLO_write_file_mem(Main *mainvar, MemFile *compare, MemFile *current, int w
 
 	const bool err = write_file_handle(mainvar, NULL, compare, current, write_flags, NULL);
 
+	memfile_write_end(current, compare);
+
 	return (err == 0);
 }
 
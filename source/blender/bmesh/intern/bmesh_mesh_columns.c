@@ -0,0 +1,222 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/bmesh/intern/bmesh_mesh_columns.c
+ *  \ingroup bmesh
+ *
+ * Columnar storage of BMesh custom-data.
+ *
+ * BMesh keeps all custom-data layers of an element interleaved in a single block,
+ * which is good for topology editing but means operations working on a single layer
+ * (vertex groups, UV's, shape keys...) stride over unrelated data.
+ *
+ * This gathers layers into contiguous arrays indexed by element index,
+ * which can be written back into the blocks once the operation is done.
+ *
+ * Columns are plain copies of the block data, data owned by the layer
+ * (deform-vert weights, multi-res displacements) is shared with the blocks.
+ * Topology and custom-data layout must not change while columns are in use.
+ */
+
+#include <string.h>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+
+#include "BKE_customdata.h"
+
+#include "bmesh.h"
+
+#include "bmesh_mesh_columns.h"
+
+typedef struct BMDataColumn {
+	int type;
+	/* Offset of the layer in the element blocks. */
+	int offset;
+	int size;
+	void *data;
+} BMDataColumn;
+
+struct BMDataColumns {
+	char htype;
+	int totelem;
+	/* Blocks in element index order. */
+	void **blocks;
+	BMDataColumn *layers;
+	int totlayer;
+};
+
+static CustomData *bm_data_columns_customdata(BMesh *bm, const char htype)
+{
+	switch (htype) {
+		case BM_VERT: return &bm->vdata;
+		case BM_EDGE: return &bm->edata;
+		case BM_LOOP: return &bm->ldata;
+		case BM_FACE: return &bm->pdata;
+	}
+	BLI_assert(0);
+	return NULL;
+}
+
+static int bm_data_columns_blocks_fill(BMesh *bm, const char htype, void **blocks)
+{
+	BMIter iter;
+	int i = 0;
+
+	if (htype == BM_LOOP) {
+		BMFace *f;
+		BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+			BMLoop *l_iter, *l_first;
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				blocks[i++] = l_iter->head.data;
+			} while ((l_iter = l_iter->next) != l_first);
+		}
+	}
+	else {
+		BMElem *ele;
+		const char itype = (htype == BM_VERT) ? BM_VERTS_OF_MESH :
+		                   (htype == BM_EDGE) ? BM_EDGES_OF_MESH : BM_FACES_OF_MESH;
+		BM_ITER_MESH (ele, &iter, bm, itype) {
+			blocks[i++] = ele->head.data;
+		}
+	}
+	return i;
+}
+
+/**
+ * Gather layers matching \a cd_mask of a single element type into columns.
+ *
+ * \param htype: One of #BM_VERT, #BM_EDGE, #BM_LOOP, #BM_FACE.
+ * \note Element indices are ensured, so they can be used to look up the columns.
+ */
+BMDataColumns *BM_data_columns_create(BMesh *bm, const char htype, const uint64_t cd_mask)
+{
+	const CustomData *data = bm_data_columns_customdata(bm, htype);
+	BMDataColumns *columns = MEM_callocN(sizeof(*columns), __func__);
+	int i, layer_index;
+
+	BM_mesh_elem_index_ensure(bm, htype);
+
+	columns->htype = htype;
+	columns->totelem = (htype == BM_VERT) ? bm->totvert :
+	                   (htype == BM_EDGE) ? bm->totedge :
+	                   (htype == BM_LOOP) ? bm->totloop : bm->totface;
+
+	for (layer_index = 0; layer_index < data->totlayer; layer_index++) {
+		if (cd_mask & CD_TYPE_AS_MASK(data->layers[layer_index].type)) {
+			columns->totlayer++;
+		}
+	}
+
+	if (columns->totlayer == 0 || columns->totelem == 0) {
+		return columns;
+	}
+
+	columns->blocks = MEM_mallocN(sizeof(*columns->blocks) * columns->totelem, __func__);
+	{
+		const int totelem = bm_data_columns_blocks_fill(bm, htype, columns->blocks);
+		BLI_assert(totelem == columns->totelem);
+		UNUSED_VARS_NDEBUG(totelem);
+	}
+
+	columns->layers = MEM_mallocN(sizeof(*columns->layers) * columns->totlayer, __func__);
+	i = 0;
+	for (layer_index = 0; layer_index < data->totlayer; layer_index++) {
+		const CustomDataLayer *layer = &data->layers[layer_index];
+		if ((cd_mask & CD_TYPE_AS_MASK(layer->type)) == 0) {
+			continue;
+		}
+		BMDataColumn *column = &columns->layers[i++];
+		column->type = layer->type;
+		column->offset = layer->offset;
+		column->size = CustomData_sizeof(layer->type);
+		column->data = MEM_mallocN((size_t)column->size * columns->totelem, __func__);
+
+		char *dst = column->data;
+		for (int elem_index = 0; elem_index < columns->totelem; elem_index++, dst += column->size) {
+			memcpy(dst, POINTER_OFFSET(columns->blocks[elem_index], column->offset), column->size);
+		}
+	}
+
+	return columns;
+}
+
+/**
+ * Write columns back into the element blocks.
+ */
+void BM_data_columns_flush(BMesh *bm, const BMDataColumns *columns)
+{
+	BLI_assert(columns->totlayer == 0 ||
+	           columns->totelem == ((columns->htype == BM_VERT) ? bm->totvert :
+	                                (columns->htype == BM_EDGE) ? bm->totedge :
+	                                (columns->htype == BM_LOOP) ? bm->totloop : bm->totface));
+	UNUSED_VARS_NDEBUG(bm);
+
+	for (int i = 0; i < columns->totlayer; i++) {
+		const BMDataColumn *column = &columns->layers[i];
+		const char *src = column->data;
+		for (int elem_index = 0; elem_index < columns->totelem; elem_index++, src += column->size) {
+			memcpy(POINTER_OFFSET(columns->blocks[elem_index], column->offset), src, column->size);
+		}
+	}
+}
+
+void BM_data_columns_free(BMDataColumns *columns)
+{
+	for (int i = 0; i < columns->totlayer; i++) {
+		MEM_freeN(columns->layers[i].data);
+	}
+	MEM_SAFE_FREE(columns->layers);
+	MEM_SAFE_FREE(columns->blocks);
+	MEM_freeN(columns);
+}
+
+/**
+ * \return The number of elements in every column.
+ */
+int BM_data_columns_len(const BMDataColumns *columns)
+{
+	return columns->totelem;
+}
+
+/**
+ * \return The column of the nth layer of \a type, NULL when there is no such layer
+ * (or it was not included in the mask).
+ */
+void *BM_data_columns_layer_get_n(const BMDataColumns *columns, const int type, const int n)
+{
+	int layer_n = 0;
+	for (int i = 0; i < columns->totlayer; i++) {
+		if (columns->layers[i].type == type) {
+			if (layer_n == n) {
+				return columns->layers[i].data;
+			}
+			layer_n++;
+		}
+	}
+	return NULL;
+}
+
+void *BM_data_columns_layer_get(const BMDataColumns *columns, const int type)
+{
+	return BM_data_columns_layer_get_n(columns, type, 0);
+}
@@ -0,0 +1,39 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+#ifndef __BMESH_MESH_COLUMNS_H__
+#define __BMESH_MESH_COLUMNS_H__
+
+/** \file blender/bmesh/intern/bmesh_mesh_columns.h
+ *  \ingroup bmesh
+ */
+
+typedef struct BMDataColumns BMDataColumns;
+
+BMDataColumns *BM_data_columns_create(BMesh *bm, const char htype, const uint64_t cd_mask)
+ATTR_NONNULL() ATTR_WARN_UNUSED_RESULT;
+void BM_data_columns_flush(BMesh *bm, const BMDataColumns *columns) ATTR_NONNULL();
+void BM_data_columns_free(BMDataColumns *columns) ATTR_NONNULL();
+
+int   BM_data_columns_len(const BMDataColumns *columns) ATTR_NONNULL();
+void *BM_data_columns_layer_get_n(const BMDataColumns *columns, const int type, const int n) ATTR_NONNULL();
+void *BM_data_columns_layer_get(const BMDataColumns *columns, const int type) ATTR_NONNULL();
+
+#endif /* __BMESH_MESH_COLUMNS_H__ */
@@ -86,6 +86,7 @@
 #include "BLI_listbase.h"
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_mesh.h"
 #include "BKE_customdata.h"
@@ -98,6 +99,8 @@
 #include "bmesh.h"
 #include "intern/bmesh_private.h" /* for element checking */
 
+#include "atomic_ops.h"
+
 /**
  * Currently this is only used for Python scripts
  * which may fail to keep matching UV/TexFace layers.
@@ -217,6 +220,469 @@ static BMFace *bm_face_create_from_mpoly(
 }
 
 
+/* -------------------------------------------------------------------- */
+/** \name Bulk Mesh -> BMesh
+ *
+ * Used when converting into a new BMesh: all elements are allocated up front, in order
+ * (so iterating the pools matches element indices), then initialized and linked in parallel.
+ *
+ * Disk and radial cycles are built from vertex-edge and edge-loop adjacency,
+ * giving the same element order as adding elements one at a time
+ * (#BM_edge_create appends to the end of the disk cycle, #BM_face_create uses the last loop for #BMEdge.l).
+ * \{ */
+
+#define BM_CONV_CHUNK_SIZE 1024
+
+typedef struct BMFromMeshBulkData {
+	BMesh *bm;
+	const Mesh *me;
+
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+	/* Indexed by mesh loop, NULL for loops not used by any face. */
+	BMLoop **ltable;
+	/* Index of the first BMesh loop of every face. */
+	int *face_loop_index;
+
+	/* Edges of every vertex, in edge order. */
+	int *vert_edges_offset, *vert_edges;
+	/* Mesh loops of every edge, in face order. */
+	int *edge_loops_offset, *edge_loops;
+
+	const float (*keyco)[3];
+	const float (**shape_key_table)[3];
+	int tot_shape_keys;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+	int cd_shape_key_offset;
+	int cd_shape_keyindex_offset;
+
+	bool calc_face_normal;
+} BMFromMeshBulkData;
+
+static void bm_conv_parallel_chunks(const int totelem, void *userdata, TaskParallelRangeFunc func)
+{
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = (totelem >= BM_OMP_LIMIT);
+	BLI_task_parallel_range(0, (totelem + BM_CONV_CHUNK_SIZE - 1) / BM_CONV_CHUNK_SIZE, userdata, func, &settings);
+}
+
+BLI_INLINE void bm_conv_chunk_range(const int chunk, const int totelem, int *r_start, int *r_end)
+{
+	*r_start = chunk * BM_CONV_CHUNK_SIZE;
+	*r_end = min_ii(*r_start + BM_CONV_CHUNK_SIZE, totelem);
+}
+
+static bool bm_mesh_bm_from_me_bulk_supported(const Mesh *me)
+{
+#ifdef USE_BMESH_HOLES
+	UNUSED_VARS(me);
+	return false;
+#else
+	/* Faces without loops are skipped by the regular conversion. */
+	for (int i = 0; i < me->totpoly; i++) {
+		if (me->mpoly[i].totloop == 0) {
+			return false;
+		}
+	}
+	return true;
+#endif
+}
+
+/**
+ * Turn per-element counts in \a offset (\a len + 1 items) into the end of every element's range.
+ * Filling the ranges in reverse with `--offset[i]` then leaves \a offset pointing to their start
+ * with the elements in ascending order.
+ */
+static void bm_conv_adjacency_offsets_accumulate(int *offset, const int len)
+{
+	for (int i = 1; i <= len; i++) {
+		offset[i] += offset[i - 1];
+	}
+}
+
+static void bm_from_me_bulk_edges_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	const Mesh *me = data->me;
+	void **blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+
+	bm_conv_chunk_range(chunk, me->totedge, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		const MEdge *medge = &me->medge[i];
+		BMEdge *e = data->etable[i];
+
+		e->head.htype = BM_EDGE;
+		e->head.hflag = BM_edge_flag_from_mflag(medge->flag & ~SELECT);
+		e->head.api_flag = 0;
+		BM_elem_index_set(e, i); /* set_ok */
+
+		e->v1 = data->vtable[medge->v1];
+		e->v2 = data->vtable[medge->v2];
+		/* Disk links are set from the vertices. */
+
+		/* Radial cycle. */
+		const int *loops = &data->edge_loops[data->edge_loops_offset[i]];
+		const int loops_len = data->edge_loops_offset[i + 1] - data->edge_loops_offset[i];
+		for (int j = 0; j < loops_len; j++) {
+			BMLoop *l = data->ltable[loops[j]];
+			l->radial_next = data->ltable[loops[(j + 1) % loops_len]];
+			l->radial_prev = data->ltable[loops[(j + loops_len - 1) % loops_len]];
+		}
+		e->l = loops_len ? data->ltable[loops[loops_len - 1]] : NULL;
+
+		blocks[i - start] = &e->head.data;
+	}
+
+	CustomData_to_bmesh_blocks(&me->edata, &data->bm->edata, start, blocks, end - start, true);
+
+	if (data->cd_edge_bweight_offset != -1 || data->cd_edge_crease_offset != -1) {
+		for (int i = start; i < end; i++) {
+			const MEdge *medge = &me->medge[i];
+			BMEdge *e = data->etable[i];
+			if (data->cd_edge_bweight_offset != -1) {
+				BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+			}
+			if (data->cd_edge_crease_offset != -1) {
+				BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset, (float)medge->crease / 255.0f);
+			}
+		}
+	}
+}
+
+static void bm_from_me_bulk_verts_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	const Mesh *me = data->me;
+	void **blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+
+	bm_conv_chunk_range(chunk, me->totvert, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		const MVert *mvert = &me->mvert[i];
+		BMVert *v = data->vtable[i];
+
+		v->head.htype = BM_VERT;
+		v->head.hflag = BM_vert_flag_from_mflag(mvert->flag & ~SELECT);
+		v->head.api_flag = 0;
+		BM_elem_index_set(v, i); /* set_ok */
+
+		copy_v3_v3(v->co, data->keyco ? data->keyco[i] : mvert->co);
+		normal_short_to_float_v3(v->no, mvert->no);
+
+		/* Disk cycle. */
+		const int *edges = &data->vert_edges[data->vert_edges_offset[i]];
+		const int edges_len = data->vert_edges_offset[i + 1] - data->vert_edges_offset[i];
+		for (int j = 0; j < edges_len; j++) {
+			BMDiskLink *dl = bmesh_disk_edge_link_from_vert(data->etable[edges[j]], v);
+			dl->next = data->etable[edges[(j + 1) % edges_len]];
+			dl->prev = data->etable[edges[(j + edges_len - 1) % edges_len]];
+		}
+		v->e = edges_len ? data->etable[edges[0]] : NULL;
+
+		blocks[i - start] = &v->head.data;
+	}
+
+	CustomData_to_bmesh_blocks(&me->vdata, &data->bm->vdata, start, blocks, end - start, true);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		for (int i = start; i < end; i++) {
+			BM_ELEM_CD_SET_FLOAT(data->vtable[i], data->cd_vert_bweight_offset, (float)me->mvert[i].bweight / 255.0f);
+		}
+	}
+
+	/* set shape key original index */
+	if (data->cd_shape_keyindex_offset != -1) {
+		for (int i = start; i < end; i++) {
+			BM_ELEM_CD_SET_INT(data->vtable[i], data->cd_shape_keyindex_offset, i);
+		}
+	}
+
+	/* set shapekey data, a key at a time */
+	for (int j = 0; j < data->tot_shape_keys; j++) {
+		const int cd_shape_key_offset_j = data->cd_shape_key_offset + j * (int)sizeof(float[3]);
+		for (int i = start; i < end; i++) {
+			copy_v3_v3(BM_ELEM_CD_GET_VOID_P(data->vtable[i], cd_shape_key_offset_j), data->shape_key_table[j][i]);
+		}
+	}
+}
+
+static void bm_from_me_bulk_faces_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	const Mesh *me = data->me;
+	void **blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+	int totfacesel = 0;
+
+	bm_conv_chunk_range(chunk, me->totpoly, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		const MPoly *mp = &me->mpoly[i];
+		BMFace *f = data->ftable[i];
+
+		f->head.htype = BM_FACE;
+		f->head.hflag = BM_face_flag_from_mflag(mp->flag & ~ME_FACE_SEL);
+		f->head.api_flag = 0;
+		BM_elem_index_set(f, i); /* set_ok */
+
+		/* Selection of the verts and edges of the face is handled after all faces are done. */
+		if ((mp->flag & ME_FACE_SEL) && !BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+			BM_elem_flag_enable(f, BM_ELEM_SELECT);
+			totfacesel++;
+		}
+
+		f->mat_nr = mp->mat_nr;
+		f->len = mp->totloop;
+		f->l_first = data->ltable[mp->loopstart];
+
+		for (int j = 0; j < mp->totloop; j++) {
+			const MLoop *ml = &me->mloop[mp->loopstart + j];
+			BMLoop *l = data->ltable[mp->loopstart + j];
+
+			l->head.htype = BM_LOOP;
+			l->head.hflag = 0;
+			l->head.api_flag = 0;
+			BM_elem_index_set(l, data->face_loop_index[i] + j); /* set_ok */
+
+			l->v = data->vtable[ml->v];
+			l->e = data->etable[ml->e];
+			l->f = f;
+			l->next = data->ltable[mp->loopstart + (j + 1) % mp->totloop];
+			l->prev = data->ltable[mp->loopstart + (j + mp->totloop - 1) % mp->totloop];
+			/* Radial links are set from the edges. */
+		}
+
+		if (data->calc_face_normal) {
+			BM_face_normal_update(f);
+		}
+		else {
+			zero_v3(f->no);
+		}
+
+		blocks[i - start] = &f->head.data;
+	}
+
+	CustomData_to_bmesh_blocks(&me->pdata, &data->bm->pdata, start, blocks, end - start, true);
+
+	if (totfacesel) {
+		atomic_add_and_fetch_int32(&data->bm->totfacesel, totfacesel);
+	}
+}
+
+static void bm_from_me_bulk_loops_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	void **blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+
+	bm_conv_chunk_range(chunk, data->me->totloop, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		blocks[i - start] = data->ltable[i] ? &data->ltable[i]->head.data : NULL;
+	}
+
+	CustomData_to_bmesh_blocks(&data->me->ldata, &data->bm->ldata, start, blocks, end - start, true);
+}
+
+/* Same rules as #BM_face_select_set and #BM_edge_select_set, hidden elements are never selected. */
+static void bm_from_me_bulk_edges_select_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	int start, end;
+	int totedgesel = 0;
+
+	bm_conv_chunk_range(chunk, data->me->totedge, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		BMEdge *e = data->etable[i];
+		if (BM_elem_flag_test(e, BM_ELEM_HIDDEN)) {
+			continue;
+		}
+		bool select = (data->me->medge[i].flag & SELECT) != 0;
+		if (!select && e->l) {
+			BMLoop *l_iter = e->l;
+			do {
+				if (BM_elem_flag_test(l_iter->f, BM_ELEM_SELECT)) {
+					select = true;
+					break;
+				}
+			} while ((l_iter = l_iter->radial_next) != e->l);
+		}
+		if (select) {
+			BM_elem_flag_enable(e, BM_ELEM_SELECT);
+			totedgesel++;
+		}
+	}
+
+	if (totedgesel) {
+		atomic_add_and_fetch_int32(&data->bm->totedgesel, totedgesel);
+	}
+}
+
+static void bm_from_me_bulk_verts_select_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMFromMeshBulkData *data = userdata;
+	int start, end;
+	int totvertsel = 0;
+
+	bm_conv_chunk_range(chunk, data->me->totvert, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		BMVert *v = data->vtable[i];
+		if (BM_elem_flag_test(v, BM_ELEM_HIDDEN)) {
+			continue;
+		}
+		bool select = (data->me->mvert[i].flag & SELECT) != 0;
+		if (!select && v->e) {
+			BMEdge *e_iter = v->e;
+			do {
+				if (BM_elem_flag_test(e_iter, BM_ELEM_SELECT)) {
+					select = true;
+				}
+				else if (e_iter->l) {
+					/* Faces select their verts even when the edge is hidden. */
+					BMLoop *l_iter = e_iter->l;
+					do {
+						if (BM_elem_flag_test(l_iter->f, BM_ELEM_SELECT)) {
+							select = true;
+							break;
+						}
+					} while ((l_iter = l_iter->radial_next) != e_iter->l);
+				}
+			} while (!select && (e_iter = BM_DISK_EDGE_NEXT(e_iter, v)) != v->e);
+		}
+		if (select) {
+			BM_elem_flag_enable(v, BM_ELEM_SELECT);
+			totvertsel++;
+		}
+	}
+
+	if (totvertsel) {
+		atomic_add_and_fetch_int32(&data->bm->totvertsel, totvertsel);
+	}
+}
+
+/**
+ * Create all elements of \a me in an empty \a bm, filling the element tables.
+ */
+static void bm_mesh_bm_from_me_bulk(BMesh *bm, const Mesh *me, BMFromMeshBulkData *data)
+{
+	const bool use_toolflags = bm->use_toolflags;
+	int i, j, totloop;
+
+	BLI_assert(bm->totvert == 0 && bm->totedge == 0 && bm->totface == 0);
+
+	data->bm = bm;
+	data->me = me;
+	data->ltable = MEM_callocN(sizeof(*data->ltable) * me->totloop, __func__);
+	data->face_loop_index = MEM_mallocN(sizeof(*data->face_loop_index) * me->totpoly, __func__);
+
+	/* Allocate elements (and their custom-data blocks), the pools are not thread safe. */
+	for (i = 0; i < me->totvert; i++) {
+		BMVert *v = data->vtable[i] = BLI_mempool_alloc(bm->vpool);
+		v->head.data = bm->vdata.totsize ? BLI_mempool_alloc(bm->vdata.pool) : NULL;
+		if (use_toolflags) {
+			((BMVert_OFlag *)v)->oflags = bm->vtoolflagpool ? BLI_mempool_calloc(bm->vtoolflagpool) : NULL;
+		}
+	}
+	for (i = 0; i < me->totedge; i++) {
+		BMEdge *e = data->etable[i] = BLI_mempool_alloc(bm->epool);
+		e->head.data = bm->edata.totsize ? BLI_mempool_alloc(bm->edata.pool) : NULL;
+		if (use_toolflags) {
+			((BMEdge_OFlag *)e)->oflags = bm->etoolflagpool ? BLI_mempool_calloc(bm->etoolflagpool) : NULL;
+		}
+	}
+	for (i = 0, totloop = 0; i < me->totpoly; i++) {
+		const MPoly *mp = &me->mpoly[i];
+		BMFace *f = data->ftable[i] = BLI_mempool_alloc(bm->fpool);
+		f->head.data = bm->pdata.totsize ? BLI_mempool_alloc(bm->pdata.pool) : NULL;
+		if (use_toolflags) {
+			((BMFace_OFlag *)f)->oflags = bm->ftoolflagpool ? BLI_mempool_calloc(bm->ftoolflagpool) : NULL;
+		}
+		data->face_loop_index[i] = totloop;
+		for (j = 0; j < mp->totloop; j++) {
+			BMLoop *l = data->ltable[mp->loopstart + j] = BLI_mempool_alloc(bm->lpool);
+			l->head.data = bm->ldata.totsize ? BLI_mempool_alloc(bm->ldata.pool) : NULL;
+		}
+		totloop += mp->totloop;
+	}
+
+	bm->totvert = me->totvert;
+	bm->totedge = me->totedge;
+	bm->totface = me->totpoly;
+	bm->totloop = totloop;
+
+	/* Vertex -> edge adjacency. */
+	data->vert_edges_offset = MEM_callocN(sizeof(int) * (me->totvert + 1), __func__);
+	data->vert_edges = MEM_mallocN(sizeof(int) * me->totedge * 2, __func__);
+	for (i = 0; i < me->totedge; i++) {
+		data->vert_edges_offset[me->medge[i].v1]++;
+		data->vert_edges_offset[me->medge[i].v2]++;
+	}
+	bm_conv_adjacency_offsets_accumulate(data->vert_edges_offset, me->totvert);
+	for (i = me->totedge - 1; i >= 0; i--) {
+		data->vert_edges[--data->vert_edges_offset[me->medge[i].v2]] = i;
+		data->vert_edges[--data->vert_edges_offset[me->medge[i].v1]] = i;
+	}
+
+	/* Edge -> loop adjacency. */
+	data->edge_loops_offset = MEM_callocN(sizeof(int) * (me->totedge + 1), __func__);
+	data->edge_loops = MEM_mallocN(sizeof(int) * totloop, __func__);
+	for (i = 0; i < me->totpoly; i++) {
+		const MPoly *mp = &me->mpoly[i];
+		for (j = 0; j < mp->totloop; j++) {
+			data->edge_loops_offset[me->mloop[mp->loopstart + j].e]++;
+		}
+	}
+	bm_conv_adjacency_offsets_accumulate(data->edge_loops_offset, me->totedge);
+	for (i = me->totpoly - 1; i >= 0; i--) {
+		const MPoly *mp = &me->mpoly[i];
+		for (j = mp->totloop - 1; j >= 0; j--) {
+			data->edge_loops[--data->edge_loops_offset[me->mloop[mp->loopstart + j].e]] = mp->loopstart + j;
+		}
+	}
+
+	/* Edges before verts (disk links need edge verts), verts before faces (face normals). */
+	bm_conv_parallel_chunks(me->totedge, data, bm_from_me_bulk_edges_cb);
+	bm_conv_parallel_chunks(me->totvert, data, bm_from_me_bulk_verts_cb);
+	bm_conv_parallel_chunks(me->totpoly, data, bm_from_me_bulk_faces_cb);
+	bm_conv_parallel_chunks(me->totloop, data, bm_from_me_bulk_loops_cb);
+
+	bm_conv_parallel_chunks(me->totedge, data, bm_from_me_bulk_edges_select_cb);
+	bm_conv_parallel_chunks(me->totvert, data, bm_from_me_bulk_verts_select_cb);
+
+	if (me->act_face >= 0 && me->act_face < me->totpoly) {
+		bm->act_face = data->ftable[me->act_face];
+	}
+
+	/* added in order, clear dirty flag */
+	bm->elem_index_dirty &= ~BM_ALL;
+	bm->elem_table_dirty |= BM_VERT | BM_EDGE | BM_FACE;
+
+	MEM_freeN(data->ltable);
+	MEM_freeN(data->face_loop_index);
+	MEM_freeN(data->vert_edges_offset);
+	MEM_freeN(data->vert_edges);
+	MEM_freeN(data->edge_loops_offset);
+	MEM_freeN(data->edge_loops);
+}
+
+/** \} */
+
 /**
  * \brief Mesh -> BMesh
  * \param bm: The mesh to write into, while this is typically a newly created BMesh,
@@ -348,124 +814,174 @@ void BM_mesh_bm_from_me(
 	          CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX) : -1;
 
 	vtable = MEM_mallocN(sizeof(BMVert **) * me->totvert, __func__);
+	etable = MEM_mallocN(sizeof(BMEdge **) * me->totedge, __func__);
 
-	for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
-		v = vtable[i] = BM_vert_create(bm, keyco ? keyco[i] : mvert->co, NULL, BM_CREATE_SKIP_CD);
-		BM_elem_index_set(v, i); /* set_ok */
+	if (is_new && bm_mesh_bm_from_me_bulk_supported(me)) {
+		BMFromMeshBulkData data = {NULL};
 
-		/* transfer flag */
-		v->head.hflag = BM_vert_flag_from_mflag(mvert->flag & ~SELECT);
+		ftable = MEM_mallocN(sizeof(BMFace **) * me->totpoly, __func__);
 
-		/* this is necessary for selection counts to work properly */
-		if (mvert->flag & SELECT) {
-			BM_vert_select_set(bm, v, true);
-		}
+		data.vtable = vtable;
+		data.etable = etable;
+		data.ftable = ftable;
+		data.keyco = (const float (*)[3])keyco;
+		data.shape_key_table = shape_key_table;
+		data.tot_shape_keys = tot_shape_keys;
+		data.cd_vert_bweight_offset = cd_vert_bweight_offset;
+		data.cd_edge_bweight_offset = cd_edge_bweight_offset;
+		data.cd_edge_crease_offset = cd_edge_crease_offset;
+		data.cd_shape_key_offset = cd_shape_key_offset;
+		data.cd_shape_keyindex_offset = cd_shape_keyindex_offset;
+		data.calc_face_normal = params->calc_face_normal;
+
+		bm_mesh_bm_from_me_bulk(bm, me, &data);
+	}
+	else {
+		/* Custom-data is copied a whole layer at a time, once all elements of a type exist. */
+		void ***blocks = MEM_mallocN(sizeof(*blocks) * max_ii(max_ii(me->totvert, me->totedge), me->totloop), __func__);
+		/* NULL for skipped faces (and their loops). */
+		void ***fblocks = MEM_callocN(sizeof(*fblocks) * me->totpoly, __func__);
 
-		normal_short_to_float_v3(v->no, mvert->no);
+		for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
+			v = vtable[i] = BM_vert_create(bm, keyco ? keyco[i] : mvert->co, NULL, BM_CREATE_SKIP_CD);
+			BM_elem_index_set(v, i); /* set_ok */
+
+			/* transfer flag */
+			v->head.hflag = BM_vert_flag_from_mflag(mvert->flag & ~SELECT);
+
+			/* this is necessary for selection counts to work properly */
+			if (mvert->flag & SELECT) {
+				BM_vert_select_set(bm, v, true);
+			}
+
+			normal_short_to_float_v3(v->no, mvert->no);
+
+			blocks[i] = &v->head.data;
+		}
 
 		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
+		CustomData_to_bmesh_blocks(&me->vdata, &bm->vdata, 0, blocks, me->totvert, true);
 
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+		if (cd_vert_bweight_offset != -1) {
+			for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
+				BM_ELEM_CD_SET_FLOAT(vtable[i], cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+			}
+		}
 
 		/* set shape key original index */
-		if (cd_shape_keyindex_offset != -1) BM_ELEM_CD_SET_INT(v, cd_shape_keyindex_offset, i);
+		if (cd_shape_keyindex_offset != -1) {
+			for (i = 0; i < me->totvert; i++) {
+				BM_ELEM_CD_SET_INT(vtable[i], cd_shape_keyindex_offset, i);
+			}
+		}
 
-		/* set shapekey data */
-		if (tot_shape_keys) {
-			float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, cd_shape_key_offset);
-			for (int j = 0; j < tot_shape_keys; j++, co_dst++) {
-				copy_v3_v3(*co_dst, shape_key_table[j][i]);
+		/* set shapekey data, a key at a time */
+		for (int j = 0; j < tot_shape_keys; j++) {
+			const int cd_shape_key_offset_j = cd_shape_key_offset + j * (int)sizeof(float[3]);
+			for (i = 0; i < me->totvert; i++) {
+				copy_v3_v3(BM_ELEM_CD_GET_VOID_P(vtable[i], cd_shape_key_offset_j), shape_key_table[j][i]);
 			}
 		}
-	}
-	if (is_new) {
-		bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
-	}
+		if (is_new) {
+			bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
+		}
 
-	etable = MEM_mallocN(sizeof(BMEdge **) * me->totedge, __func__);
+		medge = me->medge;
+		for (i = 0; i < me->totedge; i++, medge++) {
+			e = etable[i] = BM_edge_create(bm, vtable[medge->v1], vtable[medge->v2], NULL, BM_CREATE_SKIP_CD);
+			BM_elem_index_set(e, i); /* set_ok */
 
-	medge = me->medge;
-	for (i = 0; i < me->totedge; i++, medge++) {
-		e = etable[i] = BM_edge_create(bm, vtable[medge->v1], vtable[medge->v2], NULL, BM_CREATE_SKIP_CD);
-		BM_elem_index_set(e, i); /* set_ok */
+			/* transfer flags */
+			e->head.hflag = BM_edge_flag_from_mflag(medge->flag & ~SELECT);
 
-		/* transfer flags */
-		e->head.hflag = BM_edge_flag_from_mflag(medge->flag & ~SELECT);
+			/* this is necessary for selection counts to work properly */
+			if (medge->flag & SELECT) {
+				BM_edge_select_set(bm, e, true);
+			}
 
-		/* this is necessary for selection counts to work properly */
-		if (medge->flag & SELECT) {
-			BM_edge_select_set(bm, e, true);
+			blocks[i] = &e->head.data;
 		}
 
 		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
+		CustomData_to_bmesh_blocks(&me->edata, &bm->edata, 0, blocks, me->totedge, true);
 
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
+		if (cd_edge_bweight_offset != -1 || cd_edge_crease_offset != -1) {
+			for (i = 0, medge = me->medge; i < me->totedge; i++, medge++) {
+				e = etable[i];
+				if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+				if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
+			}
+		}
+		if (is_new) {
+			bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
+		}
 
-	}
-	if (is_new) {
-		bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
-	}
+		/* only needed for selection. */
+		if (me->mselect && me->totselect != 0) {
+			ftable = MEM_mallocN(sizeof(BMFace **) * me->totpoly, __func__);
+		}
 
-	/* only needed for selection. */
-	if (me->mselect && me->totselect != 0) {
-		ftable = MEM_mallocN(sizeof(BMFace **) * me->totpoly, __func__);
-	}
+		memset(blocks, 0, sizeof(*blocks) * me->totloop);
 
-	mloop = me->mloop;
-	mp = me->mpoly;
-	for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
-		BMLoop *l_iter;
-		BMLoop *l_first;
+		mloop = me->mloop;
+		mp = me->mpoly;
+		for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
+			BMLoop *l_iter;
+			BMLoop *l_first;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
-		if (ftable != NULL) {
-			ftable[i] = f;
-		}
+			f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
+			                              bm, vtable, etable);
+			if (ftable != NULL) {
+				ftable[i] = f;
+			}
 
-		if (UNLIKELY(f == NULL)) {
-			printf("%s: Warning! Bad face in mesh"
-			       " \"%s\" at index %d!, skipping\n",
-			       __func__, me->id.name + 2, i);
-			continue;
-		}
+			if (UNLIKELY(f == NULL)) {
+				printf("%s: Warning! Bad face in mesh"
+				       " \"%s\" at index %d!, skipping\n",
+				       __func__, me->id.name + 2, i);
+				continue;
+			}
 
-		/* don't use 'i' since we may have skipped the face */
-		BM_elem_index_set(f, bm->totface - 1); /* set_ok */
+			/* don't use 'i' since we may have skipped the face */
+			BM_elem_index_set(f, bm->totface - 1); /* set_ok */
 
-		/* transfer flag */
-		f->head.hflag = BM_face_flag_from_mflag(mp->flag & ~ME_FACE_SEL);
+			/* transfer flag */
+			f->head.hflag = BM_face_flag_from_mflag(mp->flag & ~ME_FACE_SEL);
 
-		/* this is necessary for selection counts to work properly */
-		if (mp->flag & ME_FACE_SEL) {
-			BM_face_select_set(bm, f, true);
-		}
+			/* this is necessary for selection counts to work properly */
+			if (mp->flag & ME_FACE_SEL) {
+				BM_face_select_set(bm, f, true);
+			}
 
-		f->mat_nr = mp->mat_nr;
-		if (i == me->act_face) bm->act_face = f;
+			f->mat_nr = mp->mat_nr;
+			if (i == me->act_face) bm->act_face = f;
 
-		int j = mp->loopstart;
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			/* don't use 'j' since we may have skipped some faces, hence some loops. */
-			BM_elem_index_set(l_iter, totloops++); /* set_ok */
+			int j = mp->loopstart;
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				/* don't use 'j' since we may have skipped some faces, hence some loops. */
+				BM_elem_index_set(l_iter, totloops++); /* set_ok */
 
-			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
-		} while ((l_iter = l_iter->next) != l_first);
+				/* Save block of correspsonding MLoop */
+				blocks[j++] = &l_iter->head.data;
+			} while ((l_iter = l_iter->next) != l_first);
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
+			fblocks[i] = &f->head.data;
 
-		if (params->calc_face_normal) {
-			BM_face_normal_update(f);
+			if (params->calc_face_normal) {
+				BM_face_normal_update(f);
+			}
 		}
-	}
-	if (is_new) {
-		bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
+		if (is_new) {
+			bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
+		}
+
+		/* Copy Custom Data */
+		CustomData_to_bmesh_blocks(&me->ldata, &bm->ldata, 0, blocks, me->totloop, true);
+		CustomData_to_bmesh_blocks(&me->pdata, &bm->pdata, 0, fblocks, me->totpoly, true);
+
+		MEM_freeN(blocks);
+		MEM_freeN(fblocks);
 	}
 
 	/* -------------------------------------------------------------------- */
@@ -590,6 +1106,142 @@ BLI_INLINE void bmesh_quick_edgedraw_flag(MEdge *med, BMEdge *e)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Parallel BMesh -> Mesh
+ *
+ * Elements are looked up from the element tables, so chunks of every element type
+ * (and their custom-data) can be written independently.
+ * \{ */
+
+typedef struct BMToMeshData {
+	BMesh *bm;
+	Mesh *me;
+
+	/* Face and loop custom-data blocks, in mesh order. */
+	void **fblocks;
+	void **lblocks;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+} BMToMeshData;
+
+static void bm_to_me_verts_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMToMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	void *blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+
+	bm_conv_chunk_range(chunk, bm->totvert, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		BMVert *v = bm->vtable[i];
+		MVert *mvert = &data->me->mvert[i];
+
+		copy_v3_v3(mvert->co, v->co);
+		normal_float_to_short_v3(mvert->no, v->no);
+
+		mvert->flag = BM_vert_flag_to_mflag(v);
+
+		blocks[i - start] = v->head.data;
+
+		if (data->cd_vert_bweight_offset != -1) {
+			mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, data->cd_vert_bweight_offset);
+		}
+
+		BM_CHECK_ELEMENT(v);
+	}
+
+	CustomData_from_bmesh_blocks(&bm->vdata, &data->me->vdata, blocks, start, end - start);
+}
+
+static void bm_to_me_edges_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMToMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	void *blocks[BM_CONV_CHUNK_SIZE];
+	int start, end;
+
+	bm_conv_chunk_range(chunk, bm->totedge, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		BMEdge *e = bm->etable[i];
+		MEdge *med = &data->me->medge[i];
+
+		med->v1 = BM_elem_index_get(e->v1);
+		med->v2 = BM_elem_index_get(e->v2);
+
+		med->flag = BM_edge_flag_to_mflag(e);
+
+		blocks[i - start] = e->head.data;
+
+		bmesh_quick_edgedraw_flag(med, e);
+
+		if (data->cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_crease_offset);
+		if (data->cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_bweight_offset);
+
+		BM_CHECK_ELEMENT(e);
+	}
+
+	CustomData_from_bmesh_blocks(&bm->edata, &data->me->edata, blocks, start, end - start);
+}
+
+static void bm_to_me_faces_cb(
+        void *__restrict userdata, const int chunk, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMToMeshData *data = userdata;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	int start, end;
+
+	bm_conv_chunk_range(chunk, bm->totface, &start, &end);
+
+	for (int i = start; i < end; i++) {
+		BMFace *f = bm->ftable[i];
+		MPoly *mpoly = &me->mpoly[i];
+		BMLoop *l_iter, *l_first;
+		/* 'loopstart' is set beforehand. */
+		int j = mpoly->loopstart;
+
+		mpoly->totloop = f->len;
+		mpoly->mat_nr = f->mat_nr;
+		mpoly->flag = BM_face_flag_to_mflag(f);
+
+		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+		do {
+			MLoop *mloop = &me->mloop[j];
+			mloop->e = BM_elem_index_get(l_iter->e);
+			mloop->v = BM_elem_index_get(l_iter->v);
+
+			data->lblocks[j] = l_iter->head.data;
+
+			j++;
+			BM_CHECK_ELEMENT(l_iter);
+			BM_CHECK_ELEMENT(l_iter->e);
+			BM_CHECK_ELEMENT(l_iter->v);
+		} while ((l_iter = l_iter->next) != l_first);
+
+		data->fblocks[i] = f->head.data;
+
+		BM_CHECK_ELEMENT(f);
+	}
+
+	CustomData_from_bmesh_blocks(&bm->pdata, &me->pdata, &data->fblocks[start], start, end - start);
+
+	/* Loops of this chunk are contiguous. */
+	if (start < end) {
+		const int loop_start = me->mpoly[start].loopstart;
+		const int loop_end = me->mpoly[end - 1].loopstart + me->mpoly[end - 1].totloop;
+		CustomData_from_bmesh_blocks(
+		        &bm->ldata, &me->ldata, &data->lblocks[loop_start], loop_start, loop_end - loop_start);
+	}
+}
+
+/** \} */
+
 void BM_mesh_bm_to_me(
         BMesh *bm, Mesh *me,
         const struct BMeshToMeshParams *params)
@@ -597,10 +1249,8 @@ void BM_mesh_bm_to_me(
 	MLoop *mloop;
 	MPoly *mpoly;
 	MVert *mvert, *oldverts;
-	MEdge *med, *medge;
-	BMVert *v, *eve;
-	BMEdge *e;
-	BMFace *f;
+	MEdge *medge;
+	BMVert *eve;
 	BMIter iter;
 	int i, j, ototvert;
 
@@ -671,83 +1321,36 @@ void BM_mesh_bm_to_me(
 	/* this is called again, 'dotess' arg is used there */
 	BKE_mesh_update_customdata_pointers(me, 0);
 
-	i = 0;
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-		copy_v3_v3(mvert->co, v->co);
-		normal_float_to_short_v3(mvert->no, v->no);
-
-		mvert->flag = BM_vert_flag_to_mflag(v);
-
-		BM_elem_index_set(v, i); /* set_inline */
-
-		/* copy over customdat */
-		CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
-
-		if (cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, cd_vert_bweight_offset);
+	/* Custom-data is copied a whole layer at a time, a chunk of elements at a time. */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
 
-		i++;
-		mvert++;
-
-		BM_CHECK_ELEMENT(v);
+	for (i = 0, j = 0; i < bm->totface; i++) {
+		me->mpoly[i].loopstart = j;
+		j += bm->ftable[i]->len;
 	}
-	bm->elem_index_dirty &= ~BM_VERT;
-
-	med = medge;
-	i = 0;
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		med->v1 = BM_elem_index_get(e->v1);
-		med->v2 = BM_elem_index_get(e->v2);
-
-		med->flag = BM_edge_flag_to_mflag(e);
 
-		BM_elem_index_set(e, i); /* set_inline */
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
-
-		bmesh_quick_edgedraw_flag(med, e);
-
-		if (cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_crease_offset);
-		if (cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_bweight_offset);
-
-		i++;
-		med++;
-		BM_CHECK_ELEMENT(e);
+	{
+		BMToMeshData data = {
+			.bm = bm,
+			.me = me,
+			.fblocks = MEM_mallocN(sizeof(void *) * bm->totface, __func__),
+			.lblocks = MEM_mallocN(sizeof(void *) * bm->totloop, __func__),
+			.cd_vert_bweight_offset = cd_vert_bweight_offset,
+			.cd_edge_bweight_offset = cd_edge_bweight_offset,
+			.cd_edge_crease_offset = cd_edge_crease_offset,
+		};
+
+		bm_conv_parallel_chunks(bm->totvert, &data, bm_to_me_verts_cb);
+		bm_conv_parallel_chunks(bm->totedge, &data, bm_to_me_edges_cb);
+		bm_conv_parallel_chunks(bm->totface, &data, bm_to_me_faces_cb);
+
+		MEM_freeN(data.fblocks);
+		MEM_freeN(data.lblocks);
 	}
-	bm->elem_index_dirty &= ~BM_EDGE;
-
-	i = 0;
-	j = 0;
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_iter, *l_first;
-		mpoly->loopstart = j;
-		mpoly->totloop = f->len;
-		mpoly->mat_nr = f->mat_nr;
-		mpoly->flag = BM_face_flag_to_mflag(f);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			mloop->e = BM_elem_index_get(l_iter->e);
-			mloop->v = BM_elem_index_get(l_iter->v);
-
-			/* copy over customdata */
-			CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
-
-			j++;
-			mloop++;
-			BM_CHECK_ELEMENT(l_iter);
-			BM_CHECK_ELEMENT(l_iter->e);
-			BM_CHECK_ELEMENT(l_iter->v);
-		} while ((l_iter = l_iter->next) != l_first);
-
-		if (f == bm->act_face) me->act_face = i;
 
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
-
-		i++;
-		mpoly++;
-		BM_CHECK_ELEMENT(f);
+	if (bm->act_face) {
+		me->act_face = BM_elem_index_get(bm->act_face);
 	}
 
 	/* patch hook indices and vertex parents */
@@ -839,7 +1442,12 @@ void BM_mesh_bm_to_me(
 	/* see comment below, this logic is in twice */
 
 	if (me->key) {
-		const int cd_shape_keyindex_offset = CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX);
+		/* shape keys are written one key at a time, gather their layers into columns
+		 * instead of striding over the vertex blocks for every key */
+		BMDataColumns *shape_columns = BM_data_columns_create(
+		        bm, BM_VERT, CD_MASK_SHAPEKEY | CD_MASK_SHAPE_KEYINDEX);
+		const int *keyindex = BM_data_columns_layer_get(shape_columns, CD_SHAPE_KEYINDEX);
+		bool shape_columns_changed = false;
 
 		KeyBlock *currkey;
 		KeyBlock *actkey = BLI_findlink(&me->key->block, bm->shapenr - 1);
@@ -877,13 +1485,13 @@ void BM_mesh_bm_to_me(
 			const bool act_is_basis = BKE_keyblock_is_basis(me->key, bm->shapenr - 1);
 
 			/* active key is a base */
-			if (act_is_basis && (cd_shape_keyindex_offset != -1)) {
+			if (act_is_basis && (keyindex != NULL)) {
 				float (*fp)[3] = actkey->data;
 
 				ofs = MEM_callocN(sizeof(float) * 3 * bm->totvert,  "currkey->data");
 				mvert = me->mvert;
-				BM_ITER_MESH_INDEX (eve, &iter, bm, BM_VERTS_OF_MESH, i) {
-					const int keyi = BM_ELEM_CD_GET_INT(eve, cd_shape_keyindex_offset);
+				for (i = 0; i < bm->totvert; i++) {
+					const int keyi = keyindex[i];
 
 					if (keyi != ORIGINDEX_NONE) {
 						sub_v3_v3v3(ofs[i], mvert->co, fp[keyi]);
@@ -904,28 +1512,28 @@ void BM_mesh_bm_to_me(
 
 		for (currkey = me->key->block.first; currkey; currkey = currkey->next) {
 			const bool apply_offset = (ofs && (currkey != actkey) && (bm->shapenr - 1 == currkey->relative));
-			int cd_shape_offset;
 			int keyi;
 			float (*ofs_pt)[3] = ofs;
 			float *newkey, (*oldkey)[3], *fp;
+			float (*shape)[3];
 
 			j = bm_to_mesh_shape_layer_index_from_kb(bm, currkey);
-			cd_shape_offset = CustomData_get_n_offset(&bm->vdata, CD_SHAPEKEY, j);
+			shape = (j != -1) ? BM_data_columns_layer_get_n(shape_columns, CD_SHAPEKEY, j) : NULL;
 
 
 			fp = newkey = MEM_callocN(me->key->elemsize * bm->totvert,  "currkey->data");
 			oldkey = currkey->data;
 
 			mvert = me->mvert;
-			BM_ITER_MESH (eve, &iter, bm, BM_VERTS_OF_MESH) {
+			BM_ITER_MESH_INDEX (eve, &iter, bm, BM_VERTS_OF_MESH, i) {
 
 				if (currkey == actkey) {
 					copy_v3_v3(fp, eve->co);
 
 					if (actkey != me->key->refkey) { /* important see bug [#30771] */
-						if (cd_shape_keyindex_offset != -1) {
+						if (keyindex != NULL) {
 							if (oldverts) {
-								keyi = BM_ELEM_CD_GET_INT(eve, cd_shape_keyindex_offset);
+								keyi = keyindex[i];
 								if (keyi != ORIGINDEX_NONE && keyi < currkey->totelem) { /* valid old vertex */
 									copy_v3_v3(mvert->co, oldverts[keyi].co);
 								}
@@ -933,13 +1541,13 @@ void BM_mesh_bm_to_me(
 						}
 					}
 				}
-				else if (j != -1) {
+				else if (shape != NULL) {
 					/* in most cases this runs */
-					copy_v3_v3(fp, BM_ELEM_CD_GET_VOID_P(eve, cd_shape_offset));
+					copy_v3_v3(fp, shape[i]);
 				}
 				else if ((oldkey != NULL) &&
-				         (cd_shape_keyindex_offset != -1) &&
-				         ((keyi = BM_ELEM_CD_GET_INT(eve, cd_shape_keyindex_offset)) != ORIGINDEX_NONE) &&
+				         (keyindex != NULL) &&
+				         ((keyi = keyindex[i]) != ORIGINDEX_NONE) &&
 				         (keyi < currkey->totelem))
 				{
 					/* old method of reconstructing keys via vertice's original key indices,
@@ -958,7 +1566,10 @@ void BM_mesh_bm_to_me(
 					/* Apply back new coordinates of offsetted shapekeys into BMesh.
 					 * Otherwise, in case we call again BM_mesh_bm_to_me on same BMesh, we'll apply diff from previous
 					 * call to BM_mesh_bm_to_me, to shapekey values from *original creation of the BMesh*. See T50524. */
-					copy_v3_v3(BM_ELEM_CD_GET_VOID_P(eve, cd_shape_offset), fp);
+					if (shape != NULL) {
+						copy_v3_v3(shape[i], fp);
+						shape_columns_changed = true;
+					}
 				}
 
 				fp += 3;
@@ -973,6 +1584,11 @@ void BM_mesh_bm_to_me(
 		}
 
 		if (ofs) MEM_freeN(ofs);
+
+		if (shape_columns_changed) {
+			BM_data_columns_flush(bm, shape_columns);
+		}
+		BM_data_columns_free(shape_columns);
 	}
 
 	if (oldverts) MEM_freeN(oldverts);
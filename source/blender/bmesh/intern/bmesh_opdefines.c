@@ -116,7 +116,8 @@ static BMOpDefine bmo_smooth_vert_def = {
 	},
 	{{{'\0'}}},  /* no output */
 	bmo_smooth_vert_exec,
-	(BMO_OPTYPE_FLAG_NORMALS_CALC),
+	(BMO_OPTYPE_FLAG_NORMALS_CALC |
+	 BMO_OPTYPE_FLAG_THREADED),
 };
 
 /*
@@ -156,7 +157,8 @@ static BMOpDefine bmo_recalc_face_normals_def = {
 	{{{'\0'}}},  /* no output */
 	bmo_recalc_face_normals_exec,
 	(BMO_OPTYPE_FLAG_UNTAN_MULTIRES |
-	 BMO_OPTYPE_FLAG_NORMALS_CALC),
+	 BMO_OPTYPE_FLAG_NORMALS_CALC |
+	 BMO_OPTYPE_FLAG_THREADED),
 };
 
 /*
@@ -1177,7 +1179,8 @@ static BMOpDefine bmo_triangulate_def = {
 	bmo_triangulate_exec,
 	(BMO_OPTYPE_FLAG_UNTAN_MULTIRES |
 	 BMO_OPTYPE_FLAG_NORMALS_CALC |
-	 BMO_OPTYPE_FLAG_SELECT_FLUSH),
+	 BMO_OPTYPE_FLAG_SELECT_FLUSH |
+	 BMO_OPTYPE_FLAG_THREADED),
 };
 
 /*
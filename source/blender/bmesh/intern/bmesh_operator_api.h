@@ -244,6 +244,7 @@ typedef enum {
 	BMO_OPTYPE_FLAG_NORMALS_CALC        = (1 << 1),
 	BMO_OPTYPE_FLAG_SELECT_FLUSH        = (1 << 2),
 	BMO_OPTYPE_FLAG_SELECT_VALIDATE     = (1 << 3),
+	BMO_OPTYPE_FLAG_THREADED            = (1 << 4),  /* per-element work may run in parallel, see #BMO_op_use_threading */
 } BMOpTypeFlag;
 
 typedef struct BMOperator {
@@ -294,6 +295,10 @@ void BMO_op_exec(BMesh *bm, BMOperator *op);
  * after it finishes executing in BMO_op_exec).*/
 void BMO_op_finish(BMesh *bm, BMOperator *op);
 
+/* check if the operator may use threads for \a totelem elements,
+ * only operators defined with BMO_OPTYPE_FLAG_THREADED do. */
+bool BMO_op_use_threading(const BMOperator *op, const int totelem);
+
 /* count the number of elements with the specified flag enabled.
  * type can be a bitmask of BM_FACE, BM_EDGE, or BM_FACE. */
 int BMO_mesh_enabled_flag_count(BMesh *bm, const char htype, const short oflag);
@@ -480,6 +485,13 @@ void *BMO_slot_buffer_get_single(BMOpSlot *slot);
 int BMO_slot_buffer_count(BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_name);
 int BMO_slot_map_count(BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_name);
 
+/* calls \a func for every element of a slot array, in parallel when #BMO_op_use_threading allows it.
+ * \a func must only modify the element passed to it (and data owned by it, such as tool flags). */
+typedef void (*BMOSlotBufferParallelFunc)(void *__restrict userdata, BMElemF *ele, const int index);
+void BMO_slot_buffer_parallel(
+        BMOperator *op, BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_name,
+        BMOSlotBufferParallelFunc func, void *userdata);
+
 void BMO_slot_map_insert(
         BMOperator *op, BMOpSlot *slot,
         const void *element, const void *data);
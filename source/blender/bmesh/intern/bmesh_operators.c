@@ -34,6 +34,7 @@
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -224,6 +225,11 @@ void BMO_op_exec(BMesh *bm, BMOperator *op)
 	BMO_pop(bm);
 }
 
+bool BMO_op_use_threading(const BMOperator *op, const int totelem)
+{
+	return (op->type_flag & BMO_OPTYPE_FLAG_THREADED) && (totelem >= BM_OMP_LIMIT);
+}
+
 /**
  * \brief BMESH OPSTACK FINISH OP
  *
@@ -669,6 +675,42 @@ int BMO_slot_buffer_count(BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot
 	return slot->len;
 }
 
+typedef struct BMOSlotBufferParallelData {
+	BMElemF **buf;
+	BMOSlotBufferParallelFunc func;
+	void *userdata;
+} BMOSlotBufferParallelData;
+
+static void bmo_slot_buffer_parallel_cb(
+        void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BMOSlotBufferParallelData *data = userdata;
+	data->func(data->userdata, data->buf[iter], iter);
+}
+
+void BMO_slot_buffer_parallel(
+        BMOperator *op, BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_name,
+        BMOSlotBufferParallelFunc func, void *userdata)
+{
+	BMOpSlot *slot = BMO_slot_get(slot_args, slot_name);
+	BLI_assert(slot->slot_type == BMO_OP_SLOT_ELEMENT_BUF);
+
+	if (slot->slot_type != BMO_OP_SLOT_ELEMENT_BUF || slot->len == 0)
+		return;
+
+	BMOSlotBufferParallelData data = {
+		.buf = (BMElemF **)slot->data.buf,
+		.func = func,
+		.userdata = userdata,
+	};
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.use_threading = BMO_op_use_threading(op, slot->len);
+	settings.min_iter_per_thread = 1024;
+	BLI_task_parallel_range(0, slot->len, &data, bmo_slot_buffer_parallel_cb, &settings);
+}
+
 int BMO_slot_map_count(BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_name)
 {
 	BMOpSlot *slot = BMO_slot_get(slot_args, slot_name);
@@ -900,6 +900,131 @@ bool BM_face_point_inside_test(const BMFace *f, const float co[3])
 	return isect_point_poly_v2(co_2d, projverts, f->len, false);
 }
 
+/**
+ * Calculate the triangles #BM_face_triangulate creates, without modifying the mesh.
+ *
+ * Only reads \a f, so faces can be calculated in parallel
+ * (each thread using its own \a pf_arena and \a pf_heap).
+ *
+ * \param r_looptris: Array of (f->len - 2) triangles, using the loops of \a f.
+ */
+void BM_face_triangulate_calc_looptris(
+        BMFace *f, BMLoop *(*r_looptris)[3],
+        const int quad_method,
+        const int ngon_method,
+        /* use for ngons only! */
+        MemArena *pf_arena,
+
+        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
+        struct Heap *pf_heap)
+{
+	const bool use_beauty = (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY);
+	const int totfilltri = f->len - 2;
+	BMLoop *l_first;
+
+	BLI_assert(BM_face_is_normal_valid(f));
+	BLI_assert(f->len > 3);
+
+	if (f->len == 4) {
+		/* even though we're not using BLI_polyfill, fill in the triangles
+		 * so we can share code to handle face creation afterwards. */
+		BMLoop *l_v1, *l_v2;
+
+		l_first = BM_FACE_FIRST_LOOP(f);
+
+		switch (quad_method) {
+			case MOD_TRIANGULATE_QUAD_FIXED:
+			{
+				l_v1 = l_first;
+				l_v2 = l_first->next->next;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_ALTERNATE:
+			{
+				l_v1 = l_first->next;
+				l_v2 = l_first->prev;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_SHORTEDGE:
+			case MOD_TRIANGULATE_QUAD_BEAUTY:
+			default:
+			{
+				BMLoop *l_v3, *l_v4;
+				bool split_24;
+
+				l_v1 = l_first->next;
+				l_v2 = l_first->next->next;
+				l_v3 = l_first->prev;
+				l_v4 = l_first;
+
+				if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
+					float d1, d2;
+					d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
+					d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
+					split_24 = ((d2 - d1) > 0.0f);
+				}
+				else {
+					/* first check if the quad is concave on either diagonal */
+					const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
+					if (UNLIKELY(flip_flag & (1 << 0))) {
+						split_24 = true;
+					}
+					else if (UNLIKELY(flip_flag & (1 << 1))) {
+						split_24 = false;
+					}
+					else {
+						split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
+					}
+				}
+
+				/* named confusingly, l_v1 is in fact the second vertex */
+				if (split_24) {
+					l_v1 = l_v4;
+					//l_v2 = l_v2;
+				}
+				else {
+					//l_v1 = l_v1;
+					l_v2 = l_v3;
+				}
+				break;
+			}
+		}
+
+		ARRAY_SET_ITEMS(r_looptris[0], l_v1, l_v1->next, l_v2);
+		ARRAY_SET_ITEMS(r_looptris[1], l_v1, l_v2, l_v2->next);
+	}
+	else {
+		BMLoop **loops = BLI_array_alloca(loops, f->len);
+		uint (*tris)[3] = BLI_array_alloca(tris, f->len);
+		BMLoop *l_iter;
+		float axis_mat[3][3];
+		float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
+		int i;
+
+		axis_dominant_v3_to_m3_negate(axis_mat, f->no);
+
+		for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
+			loops[i] = l_iter;
+			mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
+		}
+
+		BLI_polyfill_calc_arena(projverts, f->len, 1, tris,
+		                        pf_arena);
+
+		if (use_beauty) {
+			BLI_polyfill_beautify(
+			        projverts, f->len, tris,
+			        pf_arena, pf_heap);
+		}
+
+		for (i = 0; i < totfilltri; i++) {
+			ARRAY_SET_ITEMS(r_looptris[i], loops[tris[i][0]], loops[tris[i][1]], loops[tris[i][2]]);
+		}
+
+		BLI_memarena_clear(pf_arena);
+	}
+}
+
 /**
  * \brief BMESH TRIANGULATE FACE
  *
@@ -938,137 +1063,55 @@ void BM_face_triangulate(
 
         /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
         struct Heap *pf_heap)
+{
+	BMLoop *(*looptris)[3] = BLI_array_alloca(looptris, f->len - 2);
+
+	BM_face_triangulate_calc_looptris(f, looptris, quad_method, ngon_method, pf_arena, pf_heap);
+	BM_face_triangulate_from_looptris(
+	        bm, f, looptris,
+	        r_faces_new, r_faces_new_tot,
+	        r_edges_new, r_edges_new_tot,
+	        r_faces_double, use_tag);
+}
+
+/**
+ * Create the triangles calculated by #BM_face_triangulate_calc_looptris,
+ * see #BM_face_triangulate for a description of the arguments.
+ */
+void BM_face_triangulate_from_looptris(
+        BMesh *bm, BMFace *f, BMLoop *(*looptris)[3],
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        LinkNode **r_faces_double,
+        const bool use_tag)
 {
 	const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
-	const bool use_beauty = (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY);
 	BMLoop *l_first, *l_new;
 	BMFace *f_new;
 	int nf_i = 0;
 	int ne_i = 0;
 
-	BLI_assert(BM_face_is_normal_valid(f));
-
 	/* ensure both are valid or NULL */
 	BLI_assert((r_faces_new == NULL) == (r_faces_new_tot == NULL));
 
 	BLI_assert(f->len > 3);
 
 	{
-		BMLoop **loops = BLI_array_alloca(loops, f->len);
-		uint (*tris)[3] = BLI_array_alloca(tris, f->len);
 		const int totfilltri = f->len - 2;
 		const int last_tri = f->len - 3;
 		int i;
 		/* for mdisps */
 		float f_center[3];
 
-		if (f->len == 4) {
-			/* even though we're not using BLI_polyfill, fill in 'tris' and 'loops'
-			 * so we can share code to handle face creation afterwards. */
-			BMLoop *l_v1, *l_v2;
-
-			l_first = BM_FACE_FIRST_LOOP(f);
-
-			switch (quad_method) {
-				case MOD_TRIANGULATE_QUAD_FIXED:
-				{
-					l_v1 = l_first;
-					l_v2 = l_first->next->next;
-					break;
-				}
-				case MOD_TRIANGULATE_QUAD_ALTERNATE:
-				{
-					l_v1 = l_first->next;
-					l_v2 = l_first->prev;
-					break;
-				}
-				case MOD_TRIANGULATE_QUAD_SHORTEDGE:
-				case MOD_TRIANGULATE_QUAD_BEAUTY:
-				default:
-				{
-					BMLoop *l_v3, *l_v4;
-					bool split_24;
-
-					l_v1 = l_first->next;
-					l_v2 = l_first->next->next;
-					l_v3 = l_first->prev;
-					l_v4 = l_first;
-
-					if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
-						float d1, d2;
-						d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
-						d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
-						split_24 = ((d2 - d1) > 0.0f);
-					}
-					else {
-						/* first check if the quad is concave on either diagonal */
-						const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
-						if (UNLIKELY(flip_flag & (1 << 0))) {
-							split_24 = true;
-						}
-						else if (UNLIKELY(flip_flag & (1 << 1))) {
-							split_24 = false;
-						}
-						else {
-							split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
-						}
-					}
-
-					/* named confusingly, l_v1 is in fact the second vertex */
-					if (split_24) {
-						l_v1 = l_v4;
-						//l_v2 = l_v2;
-					}
-					else {
-						//l_v1 = l_v1;
-						l_v2 = l_v3;
-					}
-					break;
-				}
-			}
-
-			loops[0] = l_v1;
-			loops[1] = l_v1->next;
-			loops[2] = l_v2;
-			loops[3] = l_v2->next;
-
-			ARRAY_SET_ITEMS(tris[0], 0, 1, 2);
-			ARRAY_SET_ITEMS(tris[1], 0, 2, 3);
-		}
-		else {
-			BMLoop *l_iter;
-			float axis_mat[3][3];
-			float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
-
-			axis_dominant_v3_to_m3_negate(axis_mat, f->no);
-
-			for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
-				loops[i] = l_iter;
-				mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
-			}
-
-			BLI_polyfill_calc_arena(projverts, f->len, 1, tris,
-			                        pf_arena);
-
-			if (use_beauty) {
-				BLI_polyfill_beautify(
-				        projverts, f->len, tris,
-				        pf_arena, pf_heap);
-			}
-
-			BLI_memarena_clear(pf_arena);
-		}
-
 		if (cd_loop_mdisp_offset != -1) {
 			BM_face_calc_center_mean(f, f_center);
 		}
 
 		/* loop over calculated triangles and create new geometry */
 		for (i = 0; i < totfilltri; i++) {
-			BMLoop *l_tri[3] = {
-			    loops[tris[i][0]],
-			    loops[tris[i][1]],
-			    loops[tris[i][2]]};
+			BMLoop **l_tri = looptris[i];
 
 			BMVert *v_tri[3] = {
 			    l_tri[0]->v,
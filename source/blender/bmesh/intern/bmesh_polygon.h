@@ -86,6 +86,21 @@ void  BM_face_triangulate(
         struct MemArena *pf_arena,
         struct Heap *pf_heap
         ) ATTR_NONNULL(1, 2);
+void  BM_face_triangulate_calc_looptris(
+        BMFace *f, BMLoop *(*r_looptris)[3],
+        const int quad_method, const int ngon_method,
+        struct MemArena *pf_arena,
+        struct Heap *pf_heap
+        ) ATTR_NONNULL(1, 2);
+void  BM_face_triangulate_from_looptris(
+        BMesh *bm, BMFace *f, BMLoop *(*looptris)[3],
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        struct LinkNode **r_faces_double,
+        const bool use_tag
+        ) ATTR_NONNULL(1, 2, 3);
 
 void  BM_face_splits_check_legal(BMesh *bm, BMFace *f, BMLoop *(*loops)[2], int len) ATTR_NONNULL();
 void  BM_face_splits_check_optimal(BMFace *f, BMLoop *(*loops)[2], int len) ATTR_NONNULL();
@@ -30,6 +30,7 @@
 
 #include "BLI_math.h"
 #include "BLI_linklist_stack.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 
@@ -188,18 +189,19 @@ static int recalc_face_normals_find_index(BMesh *bm, BMFace **faces, const int f
 }
 
 /**
- * Given an array of faces, recalculate their normals.
+ * Given an array of faces, calculate which need to be flipped (tagged with #FACE_FLIP).
  * this functions assumes all faces in the array are connected by edges.
  *
+ * Only flags of the faces in the array are modified,
+ * so arrays of faces which aren't connected by manifold edges can be calculated in parallel.
+ *
  * \param bm
  * \param faces  Array of connected faces.
  * \param faces_len  Length of \a faces
- * \param oflag  Flag to check before doing the actual face flipping.
  */
-static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int faces_len, const short oflag)
+static void bmo_recalc_face_normals_array_calc(BMesh *bm, BMFace **faces, const int faces_len)
 {
-	int i, f_start_index;
-	const short oflag_flip = oflag | FACE_FLIP;
+	int f_start_index;
 	bool is_flip;
 
 	BMFace *f;
@@ -240,13 +242,28 @@ static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int f
 	}
 
 	BLI_LINKSTACK_FREE(fstack);
+}
 
-	/* apply flipping to oflag'd faces */
-	for (i = 0; i < faces_len; i++) {
-		if (BMO_face_flag_test(bm, faces[i], oflag_flip) == oflag_flip) {
-			BM_face_normal_flip(bm, faces[i]);
+typedef struct RecalcFaceNormalsData {
+	BMesh *bm;
+	/* Faces ordered by group. */
+	BMFace **faces;
+	int (*group_index)[2];
+} RecalcFaceNormalsData;
+
+static void bmo_recalc_face_normals_group_cb(
+        void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	RecalcFaceNormalsData *data = userdata;
+	BMFace **faces_grp = &data->faces[data->group_index[iter][0]];
+	const int fg_len = data->group_index[iter][1];
+	int j;
+
+	for (j = 0; j < fg_len; j++) {
+		if (BMO_face_flag_test(data->bm, faces_grp[j], FACE_FLAG)) {
+			bmo_recalc_face_normals_array_calc(data->bm, faces_grp, fg_len);
+			break;
 		}
-		BMO_face_flag_disable(bm, faces[i], FACE_TEMP);
 	}
 }
 
@@ -261,7 +278,8 @@ static void bmo_recalc_face_normals_array(BMesh *bm, BMFace **faces, const int f
 void bmo_recalc_face_normals_exec(BMesh *bm, BMOperator *op)
 {
 	int *groups_array = MEM_mallocN(sizeof(*groups_array) * bm->totface, __func__);
-	BMFace **faces_grp = MEM_mallocN(sizeof(*faces_grp) * bm->totface, __func__);
+	BMFace **faces = MEM_mallocN(sizeof(*faces) * bm->totface, __func__);
+	const short oflag_flip = FACE_FLAG | FACE_FLIP;
 
 	int (*group_index)[2];
 	const int group_tot = BM_mesh_calc_face_groups(
@@ -274,26 +292,34 @@ void bmo_recalc_face_normals_exec(BMesh *bm, BMOperator *op)
 
 	BM_mesh_elem_table_ensure(bm, BM_FACE);
 
-	for (i = 0; i < group_tot; i++) {
-		const int fg_sta = group_index[i][0];
-		const int fg_len = group_index[i][1];
-		int j;
-		bool is_calc = false;
-
-		for (j = 0; j < fg_len; j++) {
-			faces_grp[j] = BM_face_at_index(bm, groups_array[fg_sta + j]);
+	for (i = 0; i < bm->totface; i++) {
+		faces[i] = BM_face_at_index(bm, groups_array[i]);
+	}
 
-			if (is_calc == false) {
-				is_calc = BMO_face_flag_test_bool(bm, faces_grp[j], FACE_FLAG);
-			}
-		}
+	/* groups are only connected by manifold edges,
+	 * so each can be calculated on its own, flipping modifies neighbors and happens after. */
+	{
+		RecalcFaceNormalsData data = {
+			.bm = bm,
+			.faces = faces,
+			.group_index = group_index,
+		};
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = BMO_op_use_threading(op, bm->totface);
+		settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+		BLI_task_parallel_range(0, group_tot, &data, bmo_recalc_face_normals_group_cb, &settings);
+	}
 
-		if (is_calc) {
-			bmo_recalc_face_normals_array(bm, faces_grp, fg_len, FACE_FLAG);
+	/* apply flipping to oflag'd faces */
+	for (i = 0; i < bm->totface; i++) {
+		if (BMO_face_flag_test(bm, faces[i], oflag_flip) == oflag_flip) {
+			BM_face_normal_flip(bm, faces[i]);
 		}
+		BMO_face_flag_disable(bm, faces[i], FACE_TEMP);
 	}
 
-	MEM_freeN(faces_grp);
+	MEM_freeN(faces);
 
 	MEM_freeN(groups_array);
 	MEM_freeN(group_index);
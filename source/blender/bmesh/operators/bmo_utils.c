@@ -363,71 +363,77 @@ void bmo_region_extend_exec(BMesh *bm, BMOperator *op)
 	BMO_slot_buffer_from_enabled_flag(bm, op, op->slots_out, "geom.out", BM_ALL_NOLOOP, SEL_FLAG);
 }
 
-void bmo_smooth_vert_exec(BMesh *UNUSED(bm), BMOperator *op)
+typedef struct SmoothVertData {
+	float (*cos)[3];
+	float fac, clip_dist;
+	bool clip[3];
+	bool axis[3];
+} SmoothVertData;
+
+static void bmo_smooth_vert_calc_cb(void *__restrict userdata, BMElemF *ele, const int index)
 {
-	BMOIter siter;
+	const SmoothVertData *data = userdata;
+	BMVert *v = (BMVert *)ele;
 	BMIter iter;
-	BMVert *v;
 	BMEdge *e;
-	float (*cos)[3] = MEM_mallocN(sizeof(*cos) * BMO_slot_buffer_count(op->slots_in, "verts"), __func__);
-	float *co, *co2, clip_dist = BMO_slot_float_get(op->slots_in, "clip_dist");
-	const float fac = BMO_slot_float_get(op->slots_in, "factor");
-	int i, j, clipx, clipy, clipz;
-	int xaxis, yaxis, zaxis;
-
-	clipx = BMO_slot_bool_get(op->slots_in, "mirror_clip_x");
-	clipy = BMO_slot_bool_get(op->slots_in, "mirror_clip_y");
-	clipz = BMO_slot_bool_get(op->slots_in, "mirror_clip_z");
-
-	xaxis = BMO_slot_bool_get(op->slots_in, "use_axis_x");
-	yaxis = BMO_slot_bool_get(op->slots_in, "use_axis_y");
-	zaxis = BMO_slot_bool_get(op->slots_in, "use_axis_z");
-
-	i = 0;
-	BMO_ITER (v, &siter, op->slots_in, "verts", BM_VERT) {
-
-		co = cos[i];
-		zero_v3(co);
-
-		j = 0;
-		BM_ITER_ELEM (e, &iter, v, BM_EDGES_OF_VERT) {
-			co2 = BM_edge_other_vert(e, v)->co;
-			add_v3_v3v3(co, co, co2);
-			j += 1;
-		}
+	float *co = data->cos[index];
+	int i, j;
 
-		if (!j) {
-			copy_v3_v3(co, v->co);
-			i++;
-			continue;
-		}
+	zero_v3(co);
 
-		mul_v3_fl(co, 1.0f / (float)j);
-		interp_v3_v3v3(co, v->co, co, fac);
+	j = 0;
+	BM_ITER_ELEM (e, &iter, v, BM_EDGES_OF_VERT) {
+		add_v3_v3(co, BM_edge_other_vert(e, v)->co);
+		j += 1;
+	}
+
+	if (!j) {
+		copy_v3_v3(co, v->co);
+		return;
+	}
 
-		if (clipx && fabsf(v->co[0]) <= clip_dist)
-			co[0] = 0.0f;
-		if (clipy && fabsf(v->co[1]) <= clip_dist)
-			co[1] = 0.0f;
-		if (clipz && fabsf(v->co[2]) <= clip_dist)
-			co[2] = 0.0f;
+	mul_v3_fl(co, 1.0f / (float)j);
+	interp_v3_v3v3(co, v->co, co, data->fac);
 
-		i++;
+	for (i = 0; i < 3; i++) {
+		if (data->clip[i] && fabsf(v->co[i]) <= data->clip_dist)
+			co[i] = 0.0f;
 	}
+}
 
-	i = 0;
-	BMO_ITER (v, &siter, op->slots_in, "verts", BM_VERT) {
-		if (xaxis)
-			v->co[0] = cos[i][0];
-		if (yaxis)
-			v->co[1] = cos[i][1];
-		if (zaxis)
-			v->co[2] = cos[i][2];
+static void bmo_smooth_vert_apply_cb(void *__restrict userdata, BMElemF *ele, const int index)
+{
+	const SmoothVertData *data = userdata;
+	BMVert *v = (BMVert *)ele;
+	int i;
 
-		i++;
+	for (i = 0; i < 3; i++) {
+		if (data->axis[i])
+			v->co[i] = data->cos[index][i];
 	}
+}
+
+void bmo_smooth_vert_exec(BMesh *UNUSED(bm), BMOperator *op)
+{
+	SmoothVertData data;
+
+	data.cos = MEM_mallocN(sizeof(*data.cos) * BMO_slot_buffer_count(op->slots_in, "verts"), __func__);
+	data.fac = BMO_slot_float_get(op->slots_in, "factor");
+	data.clip_dist = BMO_slot_float_get(op->slots_in, "clip_dist");
+
+	data.clip[0] = BMO_slot_bool_get(op->slots_in, "mirror_clip_x");
+	data.clip[1] = BMO_slot_bool_get(op->slots_in, "mirror_clip_y");
+	data.clip[2] = BMO_slot_bool_get(op->slots_in, "mirror_clip_z");
+
+	data.axis[0] = BMO_slot_bool_get(op->slots_in, "use_axis_x");
+	data.axis[1] = BMO_slot_bool_get(op->slots_in, "use_axis_y");
+	data.axis[2] = BMO_slot_bool_get(op->slots_in, "use_axis_z");
+
+	/* all new locations are calculated before any vertex moves */
+	BMO_slot_buffer_parallel(op, op->slots_in, "verts", bmo_smooth_vert_calc_cb, &data);
+	BMO_slot_buffer_parallel(op, op->slots_in, "verts", bmo_smooth_vert_apply_cb, &data);
 
-	MEM_freeN(cos);
+	MEM_freeN(data.cos);
 }
 
 /**************************************************************************** *
@@ -38,6 +38,7 @@
 #include "BLI_math.h"
 #include "BLI_heap.h"
 #include "BLI_polyfill_2d_beautify.h"
+#include "BLI_task.h"
 
 #include "MEM_guardedalloc.h"
 
@@ -354,6 +355,19 @@ static void bm_edge_update_beauty_cost(
 /* -------------------------------------------------------------------- */
 /* Beautify Fill */
 
+typedef struct BeautifyCostData {
+	BMEdge **edge_array;
+	float *edge_cost;
+	short flag, method;
+} BeautifyCostData;
+
+static void bm_edge_calc_rotate_beauty_cb(
+        void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	BeautifyCostData *data = userdata;
+	data->edge_cost[iter] = bm_edge_calc_rotate_beauty(data->edge_array[iter], data->flag, data->method);
+}
+
 /**
  * \note This function sets the edge indices to invalid values.
  */
@@ -364,6 +378,7 @@ void BM_mesh_beautify_fill(
 {
 	Heap *eheap;             /* edge heap */
 	HeapNode **eheap_table;  /* edge index aligned table pointing to the eheap */
+	float *edge_cost;
 
 	GSet       **edge_state_arr  = MEM_callocN((size_t)edge_array_len * sizeof(GSet *), __func__);
 	BLI_mempool *edge_state_pool = BLI_mempool_create(sizeof(EdRotState), 0, 512, BLI_MEMPOOL_NOP);
@@ -376,10 +391,26 @@ void BM_mesh_beautify_fill(
 	eheap = BLI_heap_new_ex((uint)edge_array_len);
 	eheap_table = MEM_mallocN(sizeof(HeapNode *) * (size_t)edge_array_len, __func__);
 
+	/* calculate the initial costs in parallel, only the heap is built serially */
+	{
+		BeautifyCostData data = {
+			.edge_array = edge_array,
+			.edge_cost = MEM_mallocN(sizeof(float) * (size_t)edge_array_len, __func__),
+			.flag = flag,
+			.method = method,
+		};
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = (edge_array_len >= BM_OMP_LIMIT);
+		settings.min_iter_per_thread = 1024;
+		BLI_task_parallel_range(0, edge_array_len, &data, bm_edge_calc_rotate_beauty_cb, &settings);
+		edge_cost = data.edge_cost;
+	}
+
 	/* build heap */
 	for (i = 0; i < edge_array_len; i++) {
 		BMEdge *e = edge_array[i];
-		const float cost = bm_edge_calc_rotate_beauty(e, flag, method);
+		const float cost = edge_cost[i];
 		if (cost < 0.0f) {
 			eheap_table[i] = BLI_heap_insert(eheap, cost, e);
 		}
@@ -391,6 +422,8 @@ void BM_mesh_beautify_fill(
 	}
 	bm->elem_index_dirty |= BM_EDGE;
 
+	MEM_freeN(edge_cost);
+
 	while (BLI_heap_is_empty(eheap) == false) {
 		BMEdge *e = BLI_heap_pop_min(eheap);
 		i = BM_elem_index_get(e);
@@ -36,6 +36,7 @@
 #include "BLI_memarena.h"
 #include "BLI_heap.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 
 /* only for defines */
 #include "BLI_polyfill_2d.h"
@@ -46,31 +47,24 @@
 #include "bmesh_triangulate.h"  /* own include */
 
 /**
- * a version of #BM_face_triangulate that maps to #BMOpSlot
+ * a version of #BM_face_triangulate_from_looptris that maps to #BMOpSlot
  */
 static void bm_face_triangulate_mapping(
-        BMesh *bm, BMFace *face,
-        const int quad_method, const int ngon_method,
+        BMesh *bm, BMFace *face, BMLoop *(*looptris)[3],
         const bool use_tag,
-        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out,
-
-        MemArena *pf_arena,
-        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
-        struct Heap *pf_heap)
+        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
 {
 	int faces_array_tot = face->len - 3;
 	BMFace  **faces_array = BLI_array_alloca(faces_array, faces_array_tot);
 	LinkNode *faces_double = NULL;
 	BLI_assert(face->len > 3);
 
-	BM_face_triangulate(
-	        bm, face,
+	BM_face_triangulate_from_looptris(
+	        bm, face, looptris,
 	        faces_array, &faces_array_tot,
 	        NULL, NULL,
 	        &faces_double,
-	        quad_method, ngon_method, use_tag,
-	        pf_arena,
-	        pf_heap);
+	        use_tag);
 
 	if (faces_array_tot) {
 		int i;
@@ -88,54 +82,117 @@ static void bm_face_triangulate_mapping(
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* Calculate triangles in parallel, the mesh is only modified afterwards. */
+
+typedef struct TriangulateCalcData {
+	BMFace **faces;
+	/* First triangle of each face in 'looptris'. */
+	int *faces_looptri_index;
+	BMLoop *(*looptris)[3];
+	int quad_method, ngon_method;
+} TriangulateCalcData;
+
+typedef struct TriangulateCalcChunk {
+	MemArena *pf_arena;
+	/* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
+	Heap *pf_heap;
+} TriangulateCalcChunk;
+
+static void bm_mesh_triangulate_calc_cb(
+        void *__restrict userdata, const int iter, const ParallelRangeTLS *__restrict tls)
+{
+	TriangulateCalcData *data = userdata;
+	TriangulateCalcChunk *chunk = tls->userdata_chunk;
+	BMFace *face = data->faces[iter];
+
+	/* only ngons use polyfill, allocate on demand */
+	if (face->len > 4 && chunk->pf_arena == NULL) {
+		chunk->pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+		if (data->ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
+			chunk->pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+		}
+	}
+
+	BM_face_triangulate_calc_looptris(
+	        face, &data->looptris[data->faces_looptri_index[iter]],
+	        data->quad_method, data->ngon_method,
+	        chunk->pf_arena, chunk->pf_heap);
+}
+
+static void bm_mesh_triangulate_calc_finalize(void *__restrict UNUSED(userdata), void *__restrict userdata_chunk)
+{
+	TriangulateCalcChunk *chunk = userdata_chunk;
+	if (chunk->pf_arena) {
+		BLI_memarena_free(chunk->pf_arena);
+	}
+	if (chunk->pf_heap) {
+		BLI_heap_free(chunk->pf_heap, NULL);
+	}
+}
 
+/**
+ * \param op: When set, the operator decides if threads may be used, see #BMO_op_use_threading.
+ */
 void BM_mesh_triangulate(
         BMesh *bm, const int quad_method, const int ngon_method, const bool tag_only,
         BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
 {
 	BMIter iter;
 	BMFace *face;
-	MemArena *pf_arena;
-	Heap *pf_heap;
+	TriangulateCalcData data;
+	TriangulateCalcChunk chunk = {NULL};
+	int faces_len = 0, looptris_len = 0;
+	int i;
+
+	data.faces = MEM_mallocN(sizeof(*data.faces) * (size_t)bm->totface, __func__);
+	data.faces_looptri_index = MEM_mallocN(sizeof(*data.faces_looptri_index) * (size_t)bm->totface, __func__);
+	data.quad_method = quad_method;
+	data.ngon_method = ngon_method;
+
+	BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
+		if (face->len > 3) {
+			if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
+				data.faces[faces_len] = face;
+				data.faces_looptri_index[faces_len] = looptris_len;
+				looptris_len += face->len - 2;
+				faces_len++;
+			}
+		}
+	}
 
-	pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+	data.looptris = MEM_mallocN(sizeof(*data.looptris) * (size_t)looptris_len, __func__);
 
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
-	}
-	else {
-		pf_heap = NULL;
+	{
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.use_threading = op ? BMO_op_use_threading(op, faces_len) : (faces_len >= BM_OMP_LIMIT);
+		settings.userdata_chunk = &chunk;
+		settings.userdata_chunk_size = sizeof(chunk);
+		settings.func_finalize = bm_mesh_triangulate_calc_finalize;
+		BLI_task_parallel_range(0, faces_len, &data, bm_mesh_triangulate_calc_cb, &settings);
 	}
 
+	/* creating faces isn't thread safe, triangles of other faces remain valid while adding these */
 	if (slot_facemap_out) {
 		/* same as below but call: bm_face_triangulate_mapping() */
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					bm_face_triangulate_mapping(
-					        bm, face,
-					        quad_method, ngon_method, tag_only,
-					        op, slot_facemap_out, slot_facemap_double_out,
-					        pf_arena, pf_heap);
-				}
-			}
+		for (i = 0; i < faces_len; i++) {
+			bm_face_triangulate_mapping(
+			        bm, data.faces[i], &data.looptris[data.faces_looptri_index[i]],
+			        tag_only,
+			        op, slot_facemap_out, slot_facemap_double_out);
 		}
 	}
 	else {
 		LinkNode *faces_double = NULL;
 
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					BM_face_triangulate(
-					        bm, face,
-					        NULL, NULL,
-					        NULL, NULL,
-					        &faces_double,
-					        quad_method, ngon_method, tag_only,
-					        pf_arena, pf_heap);
-				}
-			}
+		for (i = 0; i < faces_len; i++) {
+			BM_face_triangulate_from_looptris(
+			        bm, data.faces[i], &data.looptris[data.faces_looptri_index[i]],
+			        NULL, NULL,
+			        NULL, NULL,
+			        &faces_double,
+			        tag_only);
 		}
 
 		while (faces_double) {
@@ -146,9 +203,7 @@ void BM_mesh_triangulate(
 		}
 	}
 
-	BLI_memarena_free(pf_arena);
-
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		BLI_heap_free(pf_heap, NULL);
-	}
+	MEM_freeN(data.faces);
+	MEM_freeN(data.faces_looptri_index);
+	MEM_freeN(data.looptris);
 }
@@ -44,6 +44,7 @@ struct Main;
 struct Scene;
 struct Group;
 struct EffectorWeights;
+struct ID;
 struct ModifierData;
 struct Object;
 
@@ -66,6 +67,16 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update.
+ *
+ * Only nodes and relations built for this ID are re-created on the next
+ * relations update, when possible. Use for changes which do not add or remove
+ * IDs, such as modifiers, constraints or drivers being added.
+ */
+void DEG_graph_id_tag_relations_update(struct Depsgraph *graph,
+                                       struct ID *id);
+void DEG_id_tag_relations_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -60,6 +60,16 @@ void DEG_debug_stats_gnuplot(const struct Depsgraph *graph,
                              const char *label,
                              const char *output_filename);
 
+/* ************************************************ */
+/* Evaluation Profiling */
+
+/* Record every operation evaluated from now on. When profiling ends (at the
+ * latest on exit) the operations are written to filepath in the Chrome trace
+ * event format, and a summary of the slowest operations is printed.
+ */
+void DEG_debug_profile_begin(const char *filepath);
+void DEG_debug_profile_end(void);
+
 /* ************************************************ */
 
 /* Compare two dependency graphs. */
@@ -71,6 +81,13 @@ bool DEG_debug_scene_relations_validate(struct Main *bmain,
                                         struct Scene *scene);
 
 
+/* Check that nodes and relations of the graph match those of a graph built
+ * from scratch, used to validate incremental relations update.
+ */
+bool DEG_debug_graph_relations_validate(struct Depsgraph *graph,
+                                        struct Main *bmain,
+                                        struct Scene *scene);
+
 /* Perform consistency check on the graph. */
 bool DEG_debug_consistency_check(struct Depsgraph *graph);
 
@@ -40,6 +40,7 @@
 
 #include "intern/depsgraph.h"
 #include "intern/depsgraph_types.h"
+#include "intern/eval/deg_eval_compiled.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_id.h"
@@ -72,6 +73,11 @@ void deg_graph_build_flush_layers(Depsgraph *graph)
 {
 	BLI_Stack *stack = BLI_stack_new(sizeof(OperationDepsNode *),
 	                                 "DEG flush layers stack");
+	/* Nodes in order they are visited, every node comes after all of its
+	 * children.
+	 */
+	Depsgraph::OperationNodes visit_order;
+	visit_order.reserve(graph->operations.size());
 	foreach (OperationDepsNode *node, graph->operations) {
 		IDDepsNode *id_node = node->owner->owner;
 		node->done = 0;
@@ -93,6 +99,7 @@ void deg_graph_build_flush_layers(Depsgraph *graph)
 	while (!BLI_stack_is_empty(stack)) {
 		OperationDepsNode *node;
 		BLI_stack_pop(stack, &node);
+		visit_order.push_back(node);
 		/* Flush layers to parents. */
 		foreach (DepsRelation *rel, node->inlinks) {
 			if (rel->from->type == DEG_NODE_TYPE_OPERATION) {
@@ -116,6 +123,21 @@ void deg_graph_build_flush_layers(Depsgraph *graph)
 		}
 	}
 	BLI_stack_free(stack);
+	/* Keep operations sorted topologically, so evaluation can propagate
+	 * values from children to parents in a single pass.
+	 */
+	if (visit_order.size() != graph->operations.size()) {
+		/* Should not happen, but don't lose operations which are part of
+		 * cycles which were not solved for some reason.
+		 */
+		foreach (OperationDepsNode *node, graph->operations) {
+			if (node->done == 0) {
+				visit_order.push_back(node);
+			}
+		}
+	}
+	std::reverse(visit_order.begin(), visit_order.end());
+	graph->operations.swap(visit_order);
 }
 
 void deg_graph_build_finalize(Depsgraph *graph)
@@ -127,6 +149,8 @@ void deg_graph_build_finalize(Depsgraph *graph)
 	 * every frame change.
 	 */
 	foreach (IDDepsNode *id_node, graph->id_nodes) {
+		/* Remember layers set by builder, for incremental relations update. */
+		id_node->layers_base = id_node->layers;
 		if (id_node->layers == 0) {
 			ID *id = id_node->id;
 			if (GS(id->name) == ID_OB) {
@@ -167,6 +191,8 @@ void deg_graph_build_finalize(Depsgraph *graph)
 		}
 		id_node->finalize_build();
 	}
+	/* STEP 4: Flat representation of the graph for evaluation. */
+	deg_graph_compile(graph);
 }
 
 }  // namespace DEG
@@ -0,0 +1,355 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_incremental.cc
+ *  \ingroup depsgraph
+ *
+ * Incremental update of the graph relations.
+ *
+ * Every ID node and relation remembers the object it was built for (its build
+ * owner, see IDDepsNode::build_owner). When relations of some objects are
+ * tagged for update, all the nodes of those objects are removed from the graph
+ * and built again. Relations which other objects had to the removed nodes are
+ * re-built as well, by running relations builder for those objects only.
+ *
+ * Anything which is built on the scene level (rigid body, compositor, scene
+ * animation...) has no build owner, if such nodes or relations are affected
+ * graph is to be re-built from scratch.
+ */
+
+#include "intern/builder/deg_builder_incremental.h"
+
+#include <cstdio>
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
+extern "C" {
+#include "DNA_ID.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_global.h"
+#include "BKE_scene.h"
+} /* extern "C" */
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+struct IncrementalBuildState {
+	IncrementalBuildState(Depsgraph *graph)
+	        : graph(graph)
+	{
+		node_owners = BLI_gset_ptr_new("Depsgraph node owners");
+		relation_owners = BLI_gset_ptr_new("Depsgraph relation owners");
+		removed_id_nodes = BLI_gset_ptr_new("Depsgraph removed id nodes");
+		required_ids = BLI_gset_ptr_new("Depsgraph required ids");
+	}
+
+	~IncrementalBuildState()
+	{
+		BLI_gset_free(node_owners, NULL);
+		BLI_gset_free(relation_owners, NULL);
+		BLI_gset_free(removed_id_nodes, NULL);
+		BLI_gset_free(required_ids, NULL);
+	}
+
+	Depsgraph *graph;
+	/* Objects which nodes and relations are built again. */
+	GSet *node_owners;
+	/* Build owners which relations are built again, includes node owners. */
+	GSet *relation_owners;
+	/* ID nodes which are removed from the graph. */
+	GSet *removed_id_nodes;
+	/* IDs of removed nodes which are used by relations of other build owners,
+	 * those must be re-created by the node builder.
+	 */
+	GSet *required_ids;
+};
+
+template <typename T>
+void remove_from_vector(vector<T> *vector, const T& value)
+{
+	vector->erase(std::remove(vector->begin(), vector->end(), value),
+	              vector->end());
+}
+
+bool incremental_build_fail(const char *reason)
+{
+	if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+		printf("Depsgraph relations can not be updated incrementally: %s.\n",
+		       reason);
+	}
+	return false;
+}
+
+BLI_INLINE bool is_node_removed(const IncrementalBuildState *state,
+                                const DepsNode *node)
+{
+	if (node->type != DEG_NODE_TYPE_OPERATION) {
+		/* Time source is never removed. */
+		return false;
+	}
+	const OperationDepsNode *op_node = (const OperationDepsNode *)node;
+	return BLI_gset_haskey(state->removed_id_nodes, op_node->owner->owner);
+}
+
+BLI_INLINE bool is_relation_removed(const IncrementalBuildState *state,
+                                    const DepsRelation *rel)
+{
+	return (rel->build_owner != NULL) &&
+	       BLI_gset_haskey(state->relation_owners, rel->build_owner);
+}
+
+bool collect_node_owners(IncrementalBuildState *state, Scene *scene)
+{
+	Depsgraph *graph = state->graph;
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		if (GS(id->name) != ID_OB) {
+			return incremental_build_fail("non-object ID is tagged");
+		}
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL || id_node->build_owner != id) {
+			return incremental_build_fail("tagged object is not in the graph");
+		}
+		/* Node builder re-builds objects from scene bases only. */
+		if (BKE_scene_base_find(scene, (Object *)id) == NULL) {
+			return incremental_build_fail("tagged object is not in the scene");
+		}
+		BLI_gset_add(state->node_owners, id);
+		BLI_gset_add(state->relation_owners, id);
+	}
+	GSET_FOREACH_END();
+	return true;
+}
+
+bool collect_external_relation(IncrementalBuildState *state,
+                               IDDepsNode *id_node,
+                               DepsRelation *rel)
+{
+	if (rel->build_owner == NULL) {
+		return incremental_build_fail("scene relation is affected");
+	}
+	if (!BLI_gset_haskey(state->node_owners, rel->build_owner)) {
+		/* Relations of this owner are re-built, and it will need the node to
+		 * exist again.
+		 */
+		BLI_gset_add(state->relation_owners, rel->build_owner);
+		BLI_gset_add(state->required_ids, id_node->id);
+	}
+	return true;
+}
+
+bool collect_removed_nodes(IncrementalBuildState *state)
+{
+	Depsgraph *graph = state->graph;
+	foreach (IDDepsNode *id_node, graph->id_nodes) {
+		if (id_node->build_owner != NULL &&
+		    BLI_gset_haskey(state->node_owners, id_node->build_owner))
+		{
+			BLI_gset_insert(state->removed_id_nodes, id_node);
+		}
+	}
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, state->removed_id_nodes)
+	{
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				foreach (DepsRelation *rel, op_node->inlinks) {
+					if (!is_node_removed(state, rel->from) &&
+					    !collect_external_relation(state, id_node, rel))
+					{
+						return false;
+					}
+				}
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					if (!is_node_removed(state, rel->to) &&
+					    !collect_external_relation(state, id_node, rel))
+					{
+						return false;
+					}
+				}
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	GSET_FOREACH_END();
+	return true;
+}
+
+void remove_nodes(IncrementalBuildState *state)
+{
+	Depsgraph *graph = state->graph;
+	/* Operations and their update tags. */
+	Depsgraph::OperationNodes operations;
+	operations.reserve(graph->operations.size());
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (is_node_removed(state, op_node)) {
+			BLI_gset_remove(graph->entry_tags, op_node, NULL);
+		}
+		else {
+			operations.push_back(op_node);
+		}
+	}
+	graph->operations.swap(operations);
+	/* Relations to the rest of the graph. Relations between removed nodes are
+	 * freed together with the nodes.
+	 */
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, state->removed_id_nodes)
+	{
+		GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+		{
+			foreach (OperationDepsNode *op_node, comp_node->operations) {
+				DepsNode::Relations inlinks;
+				foreach (DepsRelation *rel, op_node->inlinks) {
+					if (is_node_removed(state, rel->from)) {
+						inlinks.push_back(rel);
+					}
+					else {
+						remove_from_vector(&rel->from->outlinks, rel);
+						OBJECT_GUARDED_DELETE(rel, DepsRelation);
+					}
+				}
+				op_node->inlinks.swap(inlinks);
+				foreach (DepsRelation *rel, op_node->outlinks) {
+					if (!is_node_removed(state, rel->to)) {
+						remove_from_vector(&rel->to->inlinks, rel);
+						OBJECT_GUARDED_DELETE(rel, DepsRelation);
+					}
+				}
+				op_node->outlinks.clear();
+			}
+		}
+		GHASH_FOREACH_END();
+	}
+	GSET_FOREACH_END();
+	/* ID nodes themselves. */
+	Depsgraph::IDDepsNodes id_nodes;
+	id_nodes.reserve(graph->id_nodes.size());
+	foreach (IDDepsNode *id_node, graph->id_nodes) {
+		if (BLI_gset_haskey(state->removed_id_nodes, id_node)) {
+			BLI_ghash_remove(graph->id_hash, id_node->id, NULL, NULL);
+			OBJECT_GUARDED_DELETE(id_node, IDDepsNode);
+		}
+		else {
+			id_nodes.push_back(id_node);
+		}
+	}
+	graph->id_nodes.swap(id_nodes);
+}
+
+void remove_relations(IncrementalBuildState *state)
+{
+	foreach (OperationDepsNode *op_node, state->graph->operations) {
+		DepsNode::Relations inlinks;
+		foreach (DepsRelation *rel, op_node->inlinks) {
+			if (is_relation_removed(state, rel)) {
+				remove_from_vector(&rel->from->outlinks, rel);
+				OBJECT_GUARDED_DELETE(rel, DepsRelation);
+			}
+			else {
+				inlinks.push_back(rel);
+			}
+		}
+		op_node->inlinks.swap(inlinks);
+	}
+}
+
+bool check_required_ids(IncrementalBuildState *state)
+{
+	GSET_FOREACH_BEGIN(ID *, id, state->required_ids)
+	{
+		if (state->graph->find_id_node(id) == NULL) {
+			return incremental_build_fail("shared ID is no longer built");
+		}
+	}
+	GSET_FOREACH_END();
+	return true;
+}
+
+}  // namespace
+
+bool deg_graph_build_incremental(Main *bmain, Depsgraph *graph, Scene *scene)
+{
+	if (scene->set != NULL) {
+		return incremental_build_fail("scene has a background set");
+	}
+	if (scene->rigidbody_world != NULL) {
+		/* Rigid body adds operations to the objects on the scene level. */
+		return incremental_build_fail("scene has rigid body world");
+	}
+	if (G.debug_value == 799) {
+		return incremental_build_fail("transitive reduction is enabled");
+	}
+	IncrementalBuildState state(graph);
+	/* 1) Find out what is to be re-built, graph is not modified yet. */
+	if (!collect_node_owners(&state, scene) ||
+	    !collect_removed_nodes(&state))
+	{
+		return false;
+	}
+	/* 2) Remove nodes of tagged objects and all relations which are to be
+	 *    built again.
+	 */
+	remove_nodes(&state);
+	remove_relations(&state);
+	/* 3) Build nodes which were removed. */
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	node_builder.begin_build_incremental();
+	node_builder.build_scene_incremental(scene);
+	if (!check_required_ids(&state)) {
+		return false;
+	}
+	/* 4) Build relations of all affected owners. */
+	DepsgraphRelationBuilder relation_builder(bmain, graph);
+	relation_builder.begin_build_incremental(state.relation_owners);
+	relation_builder.build_scene_incremental(scene, state.relation_owners);
+	/* 5) Detect cycles in the whole graph again, relations which were breaking
+	 *    cycles might be gone now.
+	 */
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		foreach (DepsRelation *rel, op_node->inlinks) {
+			rel->flag &= ~DEPSREL_FLAG_CYCLIC;
+		}
+	}
+	deg_graph_detect_cycles(graph);
+	/* 6) Flush visibility layer and re-schedule nodes for update. */
+	deg_graph_build_finalize(graph);
+	return true;
+}
+
+}  // namespace DEG
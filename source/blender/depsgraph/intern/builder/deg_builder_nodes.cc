@@ -122,7 +122,8 @@ namespace DEG {
 DepsgraphNodeBuilder::DepsgraphNodeBuilder(Main *bmain, Depsgraph *graph)
     : bmain_(bmain),
       graph_(graph),
-      scene_(NULL)
+      scene_(NULL),
+      build_owner_(NULL)
 {
 }
 
@@ -132,7 +133,12 @@ DepsgraphNodeBuilder::~DepsgraphNodeBuilder()
 
 IDDepsNode *DepsgraphNodeBuilder::add_id_node(ID *id)
 {
-	return graph_->add_id_node(id, id->name);
+	IDDepsNode *id_node = graph_->find_id_node(id);
+	if (id_node == NULL) {
+		id_node = graph_->add_id_node(id, id->name);
+		id_node->build_owner = build_owner_;
+	}
+	return id_node;
 }
 
 TimeSourceDepsNode *DepsgraphNodeBuilder::add_time_source()
@@ -264,6 +270,27 @@ OperationDepsNode *DepsgraphNodeBuilder::find_operation_node(
 void DepsgraphNodeBuilder::begin_build() {
 }
 
+void DepsgraphNodeBuilder::begin_build_incremental()
+{
+	/* Everything what is still in the graph is considered to be up to date,
+	 * only IDs which nodes were removed are built again.
+	 */
+	foreach (IDDepsNode *id_node, graph_->id_nodes) {
+		built_map_.tagBuild(id_node->id);
+		/* Node builder will add layers of bases back. */
+		id_node->layers = id_node->layers_base;
+	}
+}
+
+void DepsgraphNodeBuilder::build_scene_incremental(Scene *scene)
+{
+	scene_ = scene;
+	LISTBASE_FOREACH (Base *, base, &scene->base) {
+		Object *object = base->object;
+		build_object(base, object);
+	}
+}
+
 void DepsgraphNodeBuilder::build_id(ID* id) {
 	if (id == NULL) {
 		return;
@@ -339,6 +366,9 @@ void DepsgraphNodeBuilder::build_object(Base *base, Object *object)
 	if (has_object) {
 		return;
 	}
+	ID *build_owner_prev = build_owner_;
+	build_owner_ = &object->id;
+	id_node->build_owner = build_owner_;
 	object->customdata_mask = 0;
 	/* Transform. */
 	build_object_transform(object);
@@ -389,6 +419,7 @@ void DepsgraphNodeBuilder::build_object(Base *base, Object *object)
 	if (object->dup_group != NULL) {
 		build_group(base, object->dup_group);
 	}
+	build_owner_ = build_owner_prev;
 }
 
 void DepsgraphNodeBuilder::build_object_data(Object *object)
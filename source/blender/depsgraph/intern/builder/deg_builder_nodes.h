@@ -72,6 +72,10 @@ struct DepsgraphNodeBuilder {
 	~DepsgraphNodeBuilder();
 
 	void begin_build();
+	/* Continue building on top of existing graph: IDs which already have
+	 * nodes are not built again.
+	 */
+	void begin_build_incremental();
 
 	IDDepsNode *add_id_node(ID *id);
 	TimeSourceDepsNode *add_time_source();
@@ -128,6 +132,7 @@ struct DepsgraphNodeBuilder {
 
 	void build_id(ID* id);
 	void build_scene(Scene *scene);
+	void build_scene_incremental(Scene *scene);
 	void build_group(Base *base, Group *group);
 	void build_object(Base *base, Object *object);
 	void build_object_data(Object *object);
@@ -186,6 +191,8 @@ protected:
 
 	/* State which demotes currently built entities. */
 	Scene *scene_;
+	/* Object which is currently being built, NULL for scene level entities. */
+	ID *build_owner_;
 
 	BuilderMap built_map_;
 };
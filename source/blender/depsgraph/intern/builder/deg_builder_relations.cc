@@ -39,6 +39,7 @@
 #include "MEM_guardedalloc.h"
 
 #include "BLI_utildefines.h"
+#include "BLI_ghash.h"
 #include "BLI_blenlib.h"
 
 extern "C" {
@@ -174,7 +175,8 @@ DepsgraphRelationBuilder::DepsgraphRelationBuilder(Main *bmain,
                                                    Depsgraph *graph)
     : bmain_(bmain),
       graph_(graph),
-      scene_(NULL)
+      scene_(NULL),
+      build_owner_(NULL)
 {
 }
 
@@ -247,7 +249,12 @@ DepsRelation *DepsgraphRelationBuilder::add_time_relation(
         bool check_unique)
 {
 	if (timesrc && node_to) {
-		return graph_->add_new_relation(timesrc, node_to, description, check_unique);
+		DepsRelation *rel = graph_->add_new_relation(timesrc,
+		                                             node_to,
+		                                             description,
+		                                             check_unique);
+		tag_relation_build_owner(rel);
+		return rel;
 	}
 	else {
 		DEG_DEBUG_PRINTF(BUILD, "add_time_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -265,10 +272,12 @@ DepsRelation *DepsgraphRelationBuilder::add_operation_relation(
         bool check_unique)
 {
 	if (node_from && node_to) {
-		return graph_->add_new_relation(node_from,
-		                                node_to,
-		                                description,
-		                                check_unique);
+		DepsRelation *rel = graph_->add_new_relation(node_from,
+		                                             node_to,
+		                                             description,
+		                                             check_unique);
+		tag_relation_build_owner(rel);
+		return rel;
 	}
 	else {
 		DEG_DEBUG_PRINTF(BUILD, "add_operation_relation(%p = %s, %p = %s, %s) Failed\n",
@@ -381,6 +390,63 @@ void DepsgraphRelationBuilder::begin_build()
 {
 }
 
+void DepsgraphRelationBuilder::begin_build_incremental(GSet *build_owners)
+{
+	/* Only IDs which were built by the given owners will have relations
+	 * built again, all the rest relations are kept in the graph.
+	 */
+	foreach (IDDepsNode *id_node, graph_->id_nodes) {
+		if (!BLI_gset_haskey(build_owners, id_node->build_owner)) {
+			built_map_.tagBuild(id_node->id);
+		}
+	}
+}
+
+void DepsgraphRelationBuilder::build_scene_incremental(Scene *scene,
+                                                       GSet *build_owners)
+{
+	scene_ = scene;
+	/* Follow order of bases, same as full build does. */
+	LISTBASE_FOREACH (Base *, base, &scene->base) {
+		Object *object = base->object;
+		if (BLI_gset_haskey(build_owners, &object->id)) {
+			build_object(object);
+		}
+	}
+	/* Objects which are not directly in the scene (parents, proxies). */
+	GSET_FOREACH_BEGIN(ID *, id, build_owners)
+	{
+		BLI_assert(GS(id->name) == ID_OB);
+		build_object((Object *)id);
+	}
+	GSET_FOREACH_END();
+	build_customdata_masks();
+}
+
+void DepsgraphRelationBuilder::build_customdata_masks()
+{
+	for (Depsgraph::OperationNodes::const_iterator it_op = graph_->operations.begin();
+	     it_op != graph_->operations.end();
+	     ++it_op)
+	{
+		OperationDepsNode *node = *it_op;
+		IDDepsNode *id_node = node->owner->owner;
+		ID *id = id_node->id;
+		if (GS(id->name) == ID_OB) {
+			Object *object = (Object *)id;
+			object->customdata_mask |= node->customdata_mask;
+		}
+	}
+}
+
+void DepsgraphRelationBuilder::tag_relation_build_owner(DepsRelation *rel)
+{
+	/* Relation might have been added already, by another build owner. */
+	if (rel != NULL && rel->build_owner == NULL) {
+		rel->build_owner = build_owner_;
+	}
+}
+
 void DepsgraphRelationBuilder::build_group(Object *object, Group *group)
 {
 	const bool group_done = built_map_.checkIsBuiltAndTag(group);
@@ -403,6 +469,8 @@ void DepsgraphRelationBuilder::build_object(Object *object)
 	if (built_map_.checkIsBuiltAndTag(object)) {
 		return;
 	}
+	ID *build_owner_prev = build_owner_;
+	build_owner_ = &object->id;
 	/* Object Transforms */
 	eDepsOperation_Code base_op = (object->parent) ? DEG_OPCODE_TRANSFORM_PARENT
 	                                               : DEG_OPCODE_TRANSFORM_LOCAL;
@@ -500,6 +568,7 @@ void DepsgraphRelationBuilder::build_object(Object *object)
 	if (object->dup_group != NULL) {
 		build_group(object, object->dup_group);
 	}
+	build_owner_ = build_owner_prev;
 }
 
 void DepsgraphRelationBuilder::build_object_data(Object *object)
@@ -930,9 +999,9 @@ void DepsgraphRelationBuilder::build_animdata_curves_targets(
 			add_relation(adt_key, pose_init_key, "Animation -> Prop", true);
 			continue;
 		}
-		graph_->add_new_relation(operation_from, operation_to,
-		                         "Animation -> Prop",
-		                         true);
+		add_operation_relation(operation_from, operation_to,
+		                       "Animation -> Prop",
+		                       true);
 	}
 }
 
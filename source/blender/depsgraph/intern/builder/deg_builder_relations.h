@@ -53,6 +53,7 @@ struct bGPdata;
 struct CacheFile;
 struct ListBase;
 struct GHash;
+struct GSet;
 struct ID;
 struct FCurve;
 struct Group;
@@ -172,6 +173,10 @@ struct DepsgraphRelationBuilder
 	DepsgraphRelationBuilder(Main *bmain, Depsgraph *graph);
 
 	void begin_build();
+	/* Continue building on top of existing graph, relations are only built
+	 * for IDs which were built by any of the given build owners.
+	 */
+	void begin_build_incremental(GSet *build_owners);
 
 	template <typename KeyFrom, typename KeyTo>
 	DepsRelation *add_relation(const KeyFrom& key_from,
@@ -192,6 +197,8 @@ struct DepsgraphRelationBuilder
 	                                       bool check_unique = false);
 
 	void build_scene(Scene *scene);
+	void build_scene_incremental(Scene *scene, GSet *build_owners);
+	void build_customdata_masks();
 	void build_group(Object *object, Group *group);
 	void build_object(Object *object);
 	void build_object_data(Object *object);
@@ -283,6 +290,7 @@ protected:
 	                                     OperationDepsNode *node_to,
 	                                     const char *description,
 	                                     bool check_unique = false);
+	void tag_relation_build_owner(DepsRelation *rel);
 
 	template <typename KeyType>
 	DepsNodeHandle create_node_handle(const KeyType& key,
@@ -334,6 +342,8 @@ private:
 
 	/* State which demotes currently built entities. */
 	Scene *scene_;
+	/* Object which is currently being built, NULL for scene level entities. */
+	ID *build_owner_;
 
 	BuilderMap built_map_;
 };
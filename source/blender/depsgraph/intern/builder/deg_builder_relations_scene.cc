@@ -108,18 +108,8 @@ void DepsgraphRelationBuilder::build_scene(Scene *scene)
 	LISTBASE_FOREACH (MovieClip *, clip, &bmain_->movieclip) {
 		build_movieclip(clip);
 	}
-	for (Depsgraph::OperationNodes::const_iterator it_op = graph_->operations.begin();
-	     it_op != graph_->operations.end();
-	     ++it_op)
-	{
-		OperationDepsNode *node = *it_op;
-		IDDepsNode *id_node = node->owner->owner;
-		ID *id = id_node->id;
-		if (GS(id->name) == ID_OB) {
-			Object *object = (Object *)id;
-			object->customdata_mask |= node->customdata_mask;
-		}
-	}
+	/* Customdata masks requested by relations. */
+	build_customdata_masks();
 }
 
 }  // namespace DEG
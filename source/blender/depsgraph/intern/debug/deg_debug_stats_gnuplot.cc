@@ -38,6 +38,7 @@
 
 #include "intern/depsgraph.h"
 #include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
 
 #include "util/deg_util_foreach.h"
 
@@ -62,6 +63,22 @@ struct StatsEntry {
 	double time;
 };
 
+/* Path lengths, indexed by operation index in the compiled graph. */
+typedef vector<double> PathLengths;
+
+struct CriticalPath {
+	/* Operations on the path predicted by the scheduler. */
+	vector<int> operations;
+	/* Length of the path as predicted before the evaluation. */
+	double predicted_length;
+	/* Time actually spent on the operations of the predicted path. */
+	double predicted_path_time;
+	/* Length of the longest path of the evaluation, using actual timing. */
+	double actual_length;
+	/* Whether actual longest path is the same as the predicted one. */
+	bool is_prediction_exact;
+};
+
 /* TODO(sergey): De-duplicate with graphviz relation debugger. */
 static void deg_debug_fprintf(const DebugContext &ctx,
                               const char *fmt,
@@ -116,10 +133,130 @@ void write_stats_data(const DebugContext& ctx)
 	deg_debug_fprintf(ctx, "EOD" NL);
 }
 
+/* Child on the longest path, -1 if the operation is the end of the path. */
+int get_critical_child(const CompiledGraph *compiled,
+                       const PathLengths& lengths,
+                       const int index)
+{
+	int critical_child = -1;
+	double critical_length = 0.0;
+	const int children_end = compiled->children_offset[index + 1];
+	for (int c = compiled->children_offset[index]; c < children_end; ++c) {
+		if ((compiled->children_flag[c] & DEPSREL_FLAG_CYCLIC) != 0) {
+			continue;
+		}
+		const int child = compiled->children[c];
+		if (lengths[child] > critical_length) {
+			critical_child = child;
+			critical_length = lengths[child];
+		}
+	}
+	return critical_child;
+}
+
+int get_critical_root(const PathLengths& lengths)
+{
+	int critical_root = -1;
+	double critical_length = 0.0;
+	const int num_operations = lengths.size();
+	for (int i = 0; i < num_operations; ++i) {
+		if (lengths[i] > critical_length) {
+			critical_root = i;
+			critical_length = lengths[i];
+		}
+	}
+	return critical_root;
+}
+
+void calculate_critical_path(const DebugContext& ctx, CriticalPath *path)
+{
+	const CompiledGraph *compiled = &ctx.graph->compiled;
+	const int num_operations = compiled->num_operations();
+	/* Priorities calculated before evaluation are the predicted lengths. */
+	const PathLengths& predicted_lengths = compiled->priority;
+	/* Actual lengths, operations are sorted topologically. Only operations
+	 * which were evaluated the last time have valid timing.
+	 */
+	PathLengths actual_lengths(num_operations, 0.0);
+	for (int i = num_operations - 1; i >= 0; --i) {
+		if (!compiled->scheduled[i]) {
+			continue;
+		}
+		const int child = get_critical_child(compiled, actual_lengths, i);
+		actual_lengths[i] = compiled->operations[i]->stats.current_time +
+		                    ((child != -1) ? actual_lengths[child] : 0.0);
+	}
+	/* Follow the predicted path. */
+	path->operations.clear();
+	path->predicted_length = 0.0;
+	path->predicted_path_time = 0.0;
+	path->actual_length = 0.0;
+	int index = get_critical_root(predicted_lengths);
+	int actual_index = get_critical_root(actual_lengths);
+	if (index != -1) {
+		path->predicted_length = predicted_lengths[index];
+	}
+	if (actual_index != -1) {
+		path->actual_length = actual_lengths[actual_index];
+	}
+	path->is_prediction_exact = true;
+	while (index != -1) {
+		path->operations.push_back(index);
+		if (compiled->scheduled[index]) {
+			path->predicted_path_time +=
+			        compiled->operations[index]->stats.current_time;
+		}
+		if (index != actual_index) {
+			path->is_prediction_exact = false;
+		}
+		index = get_critical_child(compiled, predicted_lengths, index);
+		if (actual_index != -1) {
+			actual_index = get_critical_child(compiled,
+			                                  actual_lengths,
+			                                  actual_index);
+		}
+	}
+	if (actual_index != -1) {
+		path->is_prediction_exact = false;
+	}
+}
+
+void write_critical_path_data(const DebugContext& ctx,
+                              const CriticalPath& path)
+{
+	deg_debug_fprintf(ctx, "$critical_path << EOD" NL);
+	/* Same limit as for the per-ID statistics. */
+	const int path_length = path.operations.size();
+	const int num_operations = min_ii(path_length, 32);
+	const CompiledGraph *compiled = &ctx.graph->compiled;
+	for (int i = 0; i < num_operations; ++i) {
+		const int index = path.operations[i];
+		const OperationDepsNode *node = compiled->operations[index];
+		/* Child on the path is the one with the highest priority, so the
+		 * difference is the predicted cost of the operation itself.
+		 */
+		const double predicted_time = (i + 1 < path_length)
+		        ? (compiled->priority[index] -
+		           compiled->priority[path.operations[i + 1]])
+		        : compiled->priority[index];
+		const double actual_time = compiled->scheduled[index]
+		        ? node->stats.current_time
+		        : 0.0;
+		deg_debug_fprintf(ctx, "\"%s\",%f,%f" NL,
+		                  node->full_identifier().c_str(),
+		                  predicted_time,
+		                  actual_time);
+	}
+	deg_debug_fprintf(ctx, "EOD" NL);
+}
+
 void deg_debug_stats_gnuplot(const DebugContext& ctx)
 {
+	CriticalPath critical_path;
+	calculate_critical_path(ctx, &critical_path);
 	// Data itself.
 	write_stats_data(ctx);
+	write_critical_path_data(ctx, critical_path);
 	// Optional label.
 	if (ctx.label && ctx.label[0]) {
 		deg_debug_fprintf(ctx, "set title \"%s\"" NL, ctx.label);
@@ -131,10 +268,25 @@ void deg_debug_stats_gnuplot(const DebugContext& ctx)
 	deg_debug_fprintf(ctx, "set grid" NL);
 	deg_debug_fprintf(ctx, "set datafile separator ','" NL);
 	deg_debug_fprintf(ctx, "set style fill solid" NL);
+	deg_debug_fprintf(ctx, "set multiplot layout 1,2" NL);
 	deg_debug_fprintf(ctx, "plot \"$data\" using " \
 	                       "($2*0.5):0:($2*0.5):(0.2):yticlabels(1) "
 	                       "with boxxyerrorbars t '' lt rgb \"#406090\"" NL);
-
+	// Predicted critical path, timing of every operation on it.
+	deg_debug_fprintf(ctx,
+	                  "set title \"Critical path: predicted %f, "
+	                  "actual %f on predicted path, %f longest%s\"" NL,
+	                  critical_path.predicted_length,
+	                  critical_path.predicted_path_time,
+	                  critical_path.actual_length,
+	                  critical_path.is_prediction_exact ? "" : " (mispredicted)");
+	deg_debug_fprintf(ctx, "set style data histograms" NL);
+	deg_debug_fprintf(ctx, "set style histogram clustered" NL);
+	deg_debug_fprintf(ctx, "set xtics rotate by -45" NL);
+	deg_debug_fprintf(ctx, "plot \"$critical_path\" using 2:xtic(1) "
+	                       "t 'Predicted' lt rgb \"#406090\", "
+	                       "'' using 3 t 'Actual' lt rgb \"#90a040\"" NL);
+	deg_debug_fprintf(ctx, "unset multiplot" NL);
 }
 
 }  // namespace
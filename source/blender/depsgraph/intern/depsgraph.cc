@@ -89,6 +89,7 @@ Depsgraph::Depsgraph()
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -96,6 +97,7 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
@@ -393,7 +395,8 @@ DepsRelation::DepsRelation(DepsNode *from,
   : from(from),
     to(to),
     name(description),
-    flag(0)
+    flag(0),
+    build_owner(NULL)
 {
 	/* Hook it up to the nodes which use it.
 	 *
@@ -444,6 +447,7 @@ void Depsgraph::add_entry_tag(OperationDepsNode *node)
 
 void Depsgraph::clear_all_nodes()
 {
+	compiled.clear();
 	clear_id_nodes();
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
@@ -39,6 +39,7 @@
 #include "BLI_threads.h"  /* for SpinLock */
 
 #include "intern/depsgraph_types.h"
+#include "intern/eval/deg_eval_compiled.h"
 
 struct ID;
 struct GHash;
@@ -78,6 +79,11 @@ struct DepsRelation {
 
 	int flag;                     /* (eDepsRelation_Flag) */
 
+	/* Object (or scene) which was being built when relation was added,
+	 * see IDDepsNode::build_owner.
+	 */
+	ID *build_owner;
+
 	DepsRelation(DepsNode *from,
 	             DepsNode *to,
 	             const char *description);
@@ -161,6 +167,11 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations needs to be updated, when the whole graph is not
+	 * tagged for update. Only nodes and relations of those are re-built.
+	 */
+	GSet *id_relations_tags;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -169,9 +180,16 @@ struct Depsgraph {
 	/* Convenience Data ................... */
 
 	/* XXX: should be collected after building (if actually needed?) */
-	/* All operation nodes, sorted in order of single-thread traversal order. */
+	/* All operation nodes, sorted topologically: every operation comes before
+	 * operations which depend on it (ignoring cyclic relations).
+	 */
 	OperationNodes operations;
 
+	/* Flat representation of operations and relations, used for update
+	 * flush and evaluation.
+	 */
+	CompiledGraph compiled;
+
 	/* Spin lock for threading-critical operations.
 	 * Mainly used by graph evaluation.
 	 */
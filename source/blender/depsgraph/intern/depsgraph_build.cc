@@ -56,6 +56,7 @@ extern "C" {
 
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
+#include "builder/deg_builder_incremental.h"
 #include "builder/deg_builder_nodes.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
@@ -248,6 +249,8 @@ void DEG_graph_tag_relations_update(Depsgraph *graph)
 {
 	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
 	deg_graph->need_update = true;
+	/* Whole graph is re-built, tagged IDs might also be freed before that. */
+	BLI_gset_clear(deg_graph->id_relations_tags, NULL);
 }
 
 /* Tag all relations for update. */
@@ -263,6 +266,58 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_graph_id_tag_relations_update(Depsgraph *graph, ID *id)
+{
+	DEG::Depsgraph *deg_graph = reinterpret_cast<DEG::Depsgraph *>(graph);
+	if (deg_graph->need_update) {
+		/* Whole graph is to be re-built anyway. */
+		return;
+	}
+	BLI_gset_add(deg_graph->id_relations_tags, id);
+}
+
+/* Tag relations of the given ID for update in all scenes. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph != NULL) {
+			DEG_graph_id_tag_relations_update(scene->depsgraph, id);
+		}
+	}
+}
+
+/* Update nodes and relations of tagged IDs only, returns false if the graph
+ * is to be re-built from scratch.
+ */
+static bool deg_scene_relations_update_incremental(Main *bmain, Scene *scene)
+{
+	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+	double start_time = 0.0;
+	if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+		start_time = PIL_check_seconds_timer();
+	}
+
+	const bool updated = DEG::deg_graph_build_incremental(bmain, graph, scene);
+	BLI_gset_clear(graph->id_relations_tags, NULL);
+	if (!updated) {
+		return false;
+	}
+
+#ifndef NDEBUG
+	DEG_debug_graph_relations_validate(scene->depsgraph, bmain, scene);
+#endif
+
+	if (G.debug & G_DEBUG_DEPSGRAPH_BUILD) {
+		printf("Depsgraph updated incrementally in %f seconds.\n",
+		       PIL_check_seconds_timer() - start_time);
+	}
+	return true;
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -277,14 +332,20 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_len(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		if (deg_scene_relations_update_incremental(bmain, scene)) {
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
 	graph->clear_all_nodes();
 	graph->operations.clear();
 	BLI_gset_clear(graph->entry_tags, NULL);
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 
 	/* Build new nodes and relations. */
 	DEG_graph_build_from_scene(reinterpret_cast< ::Depsgraph * >(graph),
@@ -30,8 +30,11 @@
  * Implementation of tools for debugging the depsgraph
  */
 
+#include <set>
+
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_string.h"
 
 extern "C" {
 #include "DNA_scene_types.h"
@@ -41,8 +44,13 @@ extern "C" {
 #include "DEG_depsgraph_debug.h"
 #include "DEG_depsgraph_build.h"
 
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
 #include "intern/depsgraph_intern.h"
+#include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
 #include "intern/nodes/deg_node_time.h"
 
 #include "util/deg_util_foreach.h"
@@ -82,6 +90,101 @@ bool DEG_debug_scene_relations_validate(Main *bmain,
 	return valid;
 }
 
+namespace {
+
+typedef std::multiset<DEG::string> DebugKeySet;
+
+DEG::string debug_node_key(const DEG::DepsNode *node)
+{
+	if (node->type != DEG::DEG_NODE_TYPE_OPERATION) {
+		return node->identifier();
+	}
+	const DEG::OperationDepsNode *op_node =
+	        reinterpret_cast<const DEG::OperationDepsNode *>(node);
+	const DEG::ComponentDepsNode *comp_node = op_node->owner;
+	char typebuf[16];
+	BLI_snprintf(typebuf, sizeof(typebuf), "(%d)", comp_node->type);
+	return DEG::string(comp_node->owner->id->name) + typebuf +
+	       comp_node->name + "." + op_node->identifier();
+}
+
+void debug_graph_keys(const DEG::Depsgraph *graph,
+                      DebugKeySet *r_nodes,
+                      DebugKeySet *r_relations)
+{
+	foreach (DEG::IDDepsNode *id_node, graph->id_nodes) {
+		r_nodes->insert(id_node->id->name);
+	}
+	foreach (DEG::OperationDepsNode *op_node, graph->operations) {
+		r_nodes->insert(debug_node_key(op_node));
+		foreach (DEG::DepsRelation *rel, op_node->inlinks) {
+			r_relations->insert(debug_node_key(rel->from) + " -> " +
+			                    debug_node_key(rel->to) + " (" + rel->name + ")");
+		}
+	}
+}
+
+/* Print keys which only exist in one of the sets. */
+bool debug_keys_compare(const DebugKeySet &keys,
+                        const DebugKeySet &keys_expected,
+                        const char *what)
+{
+	bool valid = true;
+	DebugKeySet::const_iterator it = keys.begin(), it_expected = keys_expected.begin();
+	while (it != keys.end() || it_expected != keys_expected.end()) {
+		if (it_expected == keys_expected.end() ||
+		    (it != keys.end() && *it < *it_expected))
+		{
+			fprintf(stderr, "Unexpected %s: %s\n", what, it->c_str());
+			valid = false;
+			++it;
+		}
+		else if (it == keys.end() || *it_expected < *it) {
+			fprintf(stderr, "Missing %s: %s\n", what, it_expected->c_str());
+			valid = false;
+			++it_expected;
+		}
+		else {
+			++it;
+			++it_expected;
+		}
+	}
+	return valid;
+}
+
+}  // namespace
+
+bool DEG_debug_graph_relations_validate(Depsgraph *graph,
+                                        Main *bmain,
+                                        Scene *scene)
+{
+	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
+	/* Build nodes and relations only, finalization tags IDs for update. */
+	Depsgraph *graph_full = DEG_graph_new();
+	DEG::Depsgraph *deg_graph_full = reinterpret_cast<DEG::Depsgraph *>(graph_full);
+	DEG::DepsgraphNodeBuilder node_builder(bmain, deg_graph_full);
+	node_builder.begin_build();
+	node_builder.build_scene(scene);
+	DEG::DepsgraphRelationBuilder relation_builder(bmain, deg_graph_full);
+	relation_builder.begin_build();
+	relation_builder.build_scene(scene);
+	DEG::deg_graph_detect_cycles(deg_graph_full);
+
+	DebugKeySet nodes, relations, nodes_full, relations_full;
+	debug_graph_keys(deg_graph, &nodes, &relations);
+	debug_graph_keys(deg_graph_full, &nodes_full, &relations_full);
+	DEG_graph_free(graph_full);
+
+	bool valid = true;
+	valid &= debug_keys_compare(nodes, nodes_full, "node");
+	valid &= debug_keys_compare(relations, relations_full, "relation");
+	if (!valid) {
+		fprintf(stderr, "ERROR! Depsgraph differs from the one built from scratch!\n");
+		BLI_assert(!"This should not happen!");
+	}
+	return valid;
+}
+
 bool DEG_debug_consistency_check(Depsgraph *graph)
 {
 	const DEG::Depsgraph *deg_graph = reinterpret_cast<const DEG::Depsgraph *>(graph);
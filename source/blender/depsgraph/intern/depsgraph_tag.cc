@@ -58,6 +58,7 @@ extern "C" {
 #include "DEG_depsgraph.h"
 
 #include "intern/builder/deg_builder.h"
+#include "intern/eval/deg_eval_compiled.h"
 #include "intern/eval/deg_eval_flush.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
@@ -341,6 +342,7 @@ void DEG_graph_on_visible_update(Main *bmain, Scene *scene)
 			/* Camera should always be updated, it used directly by viewport. */
 			id_node->layers |= (unsigned int)(-1);
 		}
+		id_node->layers_base = id_node->layers;
 	}
 	DEG::deg_graph_build_flush_layers(graph);
 	LISTBASE_FOREACH (Base *, base, &scene->base) {
@@ -352,6 +354,8 @@ void DEG_graph_on_visible_update(Main *bmain, Scene *scene)
 		}
 		GHASH_FOREACH_END();
 	}
+	/* Layers are stored in the compiled graph. */
+	DEG::deg_graph_compile(graph);
 }
 
 void DEG_on_visible_update(Main *bmain, const bool UNUSED(do_time))
@@ -47,7 +47,9 @@ extern "C" {
 
 #include "atomic_ops.h"
 
+#include "intern/eval/deg_eval_compiled.h"
 #include "intern/eval/deg_eval_flush.h"
+#include "intern/eval/deg_eval_profile.h"
 #include "intern/eval/deg_eval_stats.h"
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
@@ -64,46 +66,120 @@ namespace DEG {
 /* ********************** */
 /* Evaluation Entrypoints */
 
+/* Cost of an operation which was never evaluated yet, in seconds.
+ *
+ * Without any timing information the critical path becomes the longest chain
+ * of operations.
+ */
+static const double DEFAULT_OPERATION_COST = 1e-5;
+
+/* Indices of operations in the compiled graph. */
+typedef vector<int> ReadyNodes;
+
 /* Forward declarations. */
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id);
+static void schedule_children(ReadyNodes *ready_nodes,
+                              CompiledGraph *compiled,
+                              const int index,
+                              const unsigned int layers);
 
 struct DepsgraphEvalState {
 	EvaluationContext *eval_ctx;
 	Depsgraph *graph;
 	unsigned int layers;
 	bool do_stats;
+	bool do_profile;
+	/* Events of all evaluated operations, when profiling. */
+	ProfileThreadEvents profile_events;
+	/* Per-thread storage of operations which became ready for evaluation,
+	 * indexed by thread_id of the task pool.
+	 */
+	vector<ReadyNodes> ready_nodes;
 };
 
+struct ReadyNodeComparator {
+	ReadyNodeComparator(const CompiledGraph *compiled)
+	        : compiled(compiled) {}
+	bool operator() (const int a, const int b) const
+	{
+		return compiled->priority[a] < compiled->priority[b];
+	}
+	const CompiledGraph *compiled;
+};
+
+/* Push all ready operations to the pool, critical ones first.
+ *
+ * The most recently pushed task is the first one to be picked up (the local
+ * queue of the thread is LIFO for its owner and high priority tasks are added
+ * to the head of the global queue), so tasks are pushed in order of increasing
+ * priority.
+ */
+static void push_ready_nodes(TaskPool *pool,
+                             const CompiledGraph *compiled,
+                             ReadyNodes *ready_nodes,
+                             TaskRunFunction run,
+                             const int thread_id)
+{
+	if (ready_nodes->size() > 1) {
+		std::sort(ready_nodes->begin(),
+		          ready_nodes->end(),
+		          ReadyNodeComparator(compiled));
+	}
+	foreach (const int index, *ready_nodes) {
+		BLI_task_pool_push_from_thread(pool,
+		                               run,
+		                               SET_INT_IN_POINTER(index),
+		                               false,
+		                               TASK_PRIORITY_HIGH,
+		                               thread_id);
+	}
+	ready_nodes->clear();
+}
+
 static void deg_task_run_func(TaskPool *pool,
                               void *taskdata,
                               int thread_id)
 {
 	void *userdata_v = BLI_task_pool_userdata(pool);
 	DepsgraphEvalState *state = (DepsgraphEvalState *)userdata_v;
-	OperationDepsNode *node = (OperationDepsNode *)taskdata;
+	CompiledGraph *compiled = &state->graph->compiled;
+	const int index = GET_INT_FROM_POINTER(taskdata);
+	OperationDepsNode *node = compiled->operations[index];
 	/* Sanity checks. */
 	BLI_assert(!node->is_noop() && "NOOP nodes should not actually be scheduled");
-	/* Perform operation. */
-	if (state->do_stats) {
-		const double start_time = PIL_check_seconds_timer();
-		node->evaluate(state->eval_ctx);
-		node->stats.current_time += PIL_check_seconds_timer() - start_time;
-	}
-	else {
-		node->evaluate(state->eval_ctx);
+	/* Perform operation. Timing is always measured, it is used to predict
+	 * critical path of the next evaluation.
+	 */
+	const double start_time = PIL_check_seconds_timer();
+	node->evaluate(state->eval_ctx);
+	const double end_time = PIL_check_seconds_timer();
+	node->stats.current_time = end_time - start_time;
+	node->stats.accumulate_current();
+	if (state->do_profile) {
+		ProfileEvent event;
+		event.node = node;
+		event.thread_id = thread_id;
+		event.start_time = start_time;
+		event.end_time = end_time;
+		state->profile_events[thread_id].push_back(event);
 	}
 	/* Schedule children. */
+	ReadyNodes *ready_nodes = &state->ready_nodes[thread_id];
+	schedule_children(ready_nodes, compiled, index, state->layers);
 	BLI_task_pool_delayed_push_begin(pool, thread_id);
-	schedule_children(pool, state->graph, node, state->layers, thread_id);
+	push_ready_nodes(pool, compiled, ready_nodes, deg_task_run_func, thread_id);
 	BLI_task_pool_delayed_push_end(pool, thread_id);
 }
 
+BLI_INLINE bool operation_needs_evaluation(const CompiledGraph *compiled,
+                                           const int index,
+                                           const unsigned int layers)
+{
+	return compiled->needs_update[index] &&
+	       (compiled->layers[index] & layers) != 0;
+}
+
 typedef struct CalculatePengindData {
-	Depsgraph *graph;
+	CompiledGraph *compiled;
 	unsigned int layers;
 } CalculatePengindData;
 
@@ -113,39 +189,32 @@ static void calculate_pending_func(
         const ParallelRangeTLS *__restrict /*tls*/)
 {
 	CalculatePengindData *data = (CalculatePengindData *)data_v;
-	Depsgraph *graph = data->graph;
+	CompiledGraph *compiled = data->compiled;
 	unsigned int layers = data->layers;
-	OperationDepsNode *node = graph->operations[i];
-	IDDepsNode *id_node = node->owner->owner;
-
-	node->num_links_pending = 0;
-	node->scheduled = false;
+	uint32_t num_links_pending = 0;
 
 	/* count number of inputs that need updates */
-	if ((id_node->layers & layers) != 0 &&
-	    (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-	{
-		foreach (DepsRelation *rel, node->inlinks) {
-			if (rel->from->type == DEG_NODE_TYPE_OPERATION &&
-			    (rel->flag & DEPSREL_FLAG_CYCLIC) == 0)
+	if (operation_needs_evaluation(compiled, i, layers)) {
+		const int parents_end = compiled->parents_offset[i + 1];
+		for (int p = compiled->parents_offset[i]; p < parents_end; ++p) {
+			if (operation_needs_evaluation(compiled,
+			                               compiled->parents[p],
+			                               layers))
 			{
-				OperationDepsNode *from = (OperationDepsNode *)rel->from;
-				IDDepsNode *id_from_node = from->owner->owner;
-				if ((id_from_node->layers & layers) != 0 &&
-				    (from->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0)
-				{
-					++node->num_links_pending;
-				}
+				++num_links_pending;
 			}
 		}
 	}
+	compiled->num_links_pending[i] = num_links_pending;
+	compiled->scheduled[i] = false;
 }
 
-static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
+static void calculate_pending_parents(CompiledGraph *compiled,
+                                      unsigned int layers)
 {
-	const int num_operations = graph->operations.size();
+	const int num_operations = compiled->num_operations();
 	CalculatePengindData data;
-	data.graph = graph;
+	data.compiled = compiled;
 	data.layers = layers;
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
@@ -157,53 +226,92 @@ static void calculate_pending_parents(Depsgraph *graph, unsigned int layers)
 	                        &settings);
 }
 
-static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
+BLI_INLINE double get_operation_cost(const OperationDepsNode *node)
+{
+	if (node->is_noop()) {
+		return 0.0;
+	}
+	if (node->stats.num_evaluations == 0) {
+		return DEFAULT_OPERATION_COST;
+	}
+	return node->stats.average_time;
+}
+
+/* Priority of an operation is its predicted cost plus the longest path of
+ * operations which are to be evaluated after it.
+ */
+static void calculate_priorities(CompiledGraph *compiled,
+                                 const unsigned int layers)
 {
-	const bool do_stats = state->do_stats;
-	calculate_pending_parents(graph, state->layers);
-	/* Clear tags and other things which needs to be clear. */
-	foreach (OperationDepsNode *node, graph->operations) {
-		node->done = 0;
-		if (do_stats) {
-			node->stats.reset_current();
+	/* Operations are sorted topologically, so traverse them backwards to have
+	 * all children handled before their parents.
+	 */
+	for (int i = compiled->num_operations() - 1; i >= 0; --i) {
+		if (!operation_needs_evaluation(compiled, i, layers)) {
+			compiled->priority[i] = 0.0;
+			continue;
+		}
+		double children_priority = 0.0;
+		const int children_end = compiled->children_offset[i + 1];
+		for (int c = compiled->children_offset[i]; c < children_end; ++c) {
+			if ((compiled->children_flag[c] & DEPSREL_FLAG_CYCLIC) != 0) {
+				continue;
+			}
+			children_priority = std::max(children_priority,
+			                             compiled->priority[compiled->children[c]]);
 		}
+		compiled->priority[i] =
+		        get_operation_cost(compiled->operations[i]) + children_priority;
 	}
 }
 
+static void initialize_execution(DepsgraphEvalState *state, Depsgraph *graph)
+{
+	CompiledGraph *compiled = &graph->compiled;
+	BLI_assert(compiled->operations.size() == graph->operations.size());
+	/* Entry tags are normally flushed already, but evaluation is also
+	 * possible without flush.
+	 */
+	GSET_FOREACH_BEGIN(OperationDepsNode *, node, graph->entry_tags)
+	{
+		compiled->needs_update[node->index] = true;
+	}
+	GSET_FOREACH_END();
+	calculate_pending_parents(compiled, state->layers);
+	calculate_priorities(compiled, state->layers);
+}
+
 /* Schedule a node if it needs evaluation.
  *   dec_parents: Decrement pending parents count, true when child nodes are
  *                scheduled after a task has been completed.
+ *
+ * Nodes which are ready for evaluation are added to ready_nodes, it's up to
+ * the caller to push them to the task pool.
  */
-static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
-                          OperationDepsNode *node, bool dec_parents,
-                          const int thread_id)
+static void schedule_node(ReadyNodes *ready_nodes,
+                          CompiledGraph *compiled,
+                          unsigned int layers,
+                          const int index,
+                          bool dec_parents)
 {
-	unsigned int id_layers = node->owner->owner->layers;
-
-	if ((node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0 &&
-	    (id_layers & layers) != 0)
-	{
+	if (operation_needs_evaluation(compiled, index, layers)) {
+		uint32_t *num_links_pending = &compiled->num_links_pending[index];
 		if (dec_parents) {
-			BLI_assert(node->num_links_pending > 0);
-			atomic_sub_and_fetch_uint32(&node->num_links_pending, 1);
+			BLI_assert(*num_links_pending > 0);
+			atomic_sub_and_fetch_uint32(num_links_pending, 1);
 		}
 
-		if (node->num_links_pending == 0) {
+		if (*num_links_pending == 0) {
 			bool is_scheduled = atomic_fetch_and_or_uint8(
-			        (uint8_t *)&node->scheduled, (uint8_t)true);
+			        &compiled->scheduled[index], (uint8_t)true);
 			if (!is_scheduled) {
-				if (node->is_noop()) {
+				if (compiled->operations[index]->is_noop()) {
 					/* skip NOOP node, schedule children right away */
-					schedule_children(pool, graph, node, layers, thread_id);
+					schedule_children(ready_nodes, compiled, index, layers);
 				}
 				else {
 					/* children are scheduled once this task is completed */
-					BLI_task_pool_push_from_thread(pool,
-					                               deg_task_run_func,
-					                               node,
-					                               false,
-					                               TASK_PRIORITY_HIGH,
-					                               thread_id);
+					ready_nodes->push_back(index);
 				}
 			}
 		}
@@ -211,33 +319,34 @@ static void schedule_node(TaskPool *pool, Depsgraph *graph, unsigned int layers,
 }
 
 static void schedule_graph(TaskPool *pool,
-                           Depsgraph *graph,
-                           const unsigned int layers)
+                           DepsgraphEvalState *state)
 {
-	foreach (OperationDepsNode *node, graph->operations) {
-		schedule_node(pool, graph, layers, node, false, 0);
+	CompiledGraph *compiled = &state->graph->compiled;
+	ReadyNodes *ready_nodes = &state->ready_nodes[0];
+	const int num_operations = compiled->num_operations();
+	for (int i = 0; i < num_operations; ++i) {
+		schedule_node(ready_nodes, compiled, state->layers, i, false);
 	}
+	push_ready_nodes(pool, compiled, ready_nodes, deg_task_run_func, 0);
 }
 
-static void schedule_children(TaskPool *pool,
-                              Depsgraph *graph,
-                              OperationDepsNode *node,
-                              const unsigned int layers,
-                              const int thread_id)
+static void schedule_children(ReadyNodes *ready_nodes,
+                              CompiledGraph *compiled,
+                              const int index,
+                              const unsigned int layers)
 {
-	foreach (DepsRelation *rel, node->outlinks) {
-		OperationDepsNode *child = (OperationDepsNode *)rel->to;
-		BLI_assert(child->type == DEG_NODE_TYPE_OPERATION);
-		if (child->scheduled) {
+	const int children_end = compiled->children_offset[index + 1];
+	for (int c = compiled->children_offset[index]; c < children_end; ++c) {
+		const int child = compiled->children[c];
+		if (compiled->scheduled[child]) {
 			/* Happens when having cyclic dependencies. */
 			continue;
 		}
-		schedule_node(pool,
-		              graph,
+		schedule_node(ready_nodes,
+		              compiled,
 		              layers,
 		              child,
-		              (rel->flag & DEPSREL_FLAG_CYCLIC) == 0,
-		              thread_id);
+		              (compiled->children_flag[c] & DEPSREL_FLAG_CYCLIC) == 0);
 	}
 }
 
@@ -264,13 +373,17 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	                 layers,
 	                 graph->layers);
 	const bool do_time_debug = ((G.debug & G_DEBUG_DEPSGRAPH_TIME) != 0);
-	const double start_time = do_time_debug ? PIL_check_seconds_timer() : 0;
+	const bool do_profile = deg_eval_profile_is_enabled();
+	const double start_time = (do_time_debug || do_profile)
+	        ? PIL_check_seconds_timer()
+	        : 0;
 	/* Set up evaluation context for depsgraph itself. */
 	DepsgraphEvalState state;
 	state.eval_ctx = eval_ctx;
 	state.graph = graph;
 	state.layers = layers;
 	state.do_stats = do_time_debug;
+	state.do_profile = do_profile;
 	/* Set up task scheduler and pull for threaded evaluation. */
 	TaskScheduler *task_scheduler;
 	bool need_free_scheduler;
@@ -283,10 +396,15 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 		need_free_scheduler = false;
 	}
 	TaskPool *task_pool = BLI_task_pool_create_suspended(task_scheduler, &state);
+	const int num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+	state.ready_nodes.resize(num_threads + 1);
+	if (do_profile) {
+		state.profile_events.resize(num_threads + 1);
+	}
 	/* Prepare all nodes for evaluation. */
 	initialize_execution(&state, graph);
 	/* Do actual evaluation now. */
-	schedule_graph(task_pool, graph, layers);
+	schedule_graph(task_pool, &state);
 	BLI_task_pool_work_and_wait(task_pool);
 	BLI_task_pool_free(task_pool);
 	/* Finalize statistics gathering. This is because we only gather single
@@ -296,6 +414,12 @@ void deg_evaluate_on_refresh(EvaluationContext *eval_ctx,
 	if (state.do_stats) {
 		deg_eval_stats_aggregate(graph);
 	}
+	if (state.do_profile) {
+		deg_eval_profile_add_events(graph,
+		                            state.profile_events,
+		                            start_time,
+		                            PIL_check_seconds_timer());
+	}
 	/* Clear any uncleared tags - just in case. */
 	deg_graph_clear_tags(graph);
 	if (need_free_scheduler) {
@@ -0,0 +1,112 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_compiled.cc
+ *  \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_compiled.h"
+
+#include "BLI_utildefines.h"
+
+#include "intern/depsgraph.h"
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+void CompiledGraph::clear()
+{
+	operations.clear();
+	children_offset.clear();
+	children.clear();
+	children_flag.clear();
+	parents_offset.clear();
+	parents.clear();
+	layers.clear();
+	needs_update.clear();
+	num_links_pending.clear();
+	scheduled.clear();
+	flushed.clear();
+	priority.clear();
+}
+
+void deg_graph_compile(Depsgraph *graph)
+{
+	CompiledGraph *compiled = &graph->compiled;
+	const int num_operations = graph->operations.size();
+	compiled->clear();
+	compiled->operations = graph->operations;
+	/* Per-operation data. */
+	for (int i = 0; i < num_operations; ++i) {
+		graph->operations[i]->index = i;
+	}
+	compiled->layers.resize(num_operations);
+	compiled->needs_update.resize(num_operations);
+	size_t num_children = 0, num_parents = 0;
+	for (int i = 0; i < num_operations; ++i) {
+		OperationDepsNode *node = graph->operations[i];
+		compiled->layers[i] = node->owner->owner->layers;
+		compiled->needs_update[i] =
+		        (node->flag & DEPSOP_FLAG_NEEDS_UPDATE) != 0;
+		num_children += node->outlinks.size();
+		num_parents += node->inlinks.size();
+	}
+	compiled->num_links_pending.resize(num_operations, 0);
+	compiled->scheduled.resize(num_operations, 0);
+	compiled->flushed.resize(num_operations, 0);
+	compiled->priority.resize(num_operations, 0.0);
+	/* Children. */
+	compiled->children_offset.reserve(num_operations + 1);
+	compiled->children.reserve(num_children);
+	compiled->children_flag.reserve(num_children);
+	foreach (OperationDepsNode *node, graph->operations) {
+		compiled->children_offset.push_back(compiled->children.size());
+		foreach (DepsRelation *rel, node->outlinks) {
+			BLI_assert(rel->to->type == DEG_NODE_TYPE_OPERATION);
+			OperationDepsNode *child = (OperationDepsNode *)rel->to;
+			compiled->children.push_back(child->index);
+			compiled->children_flag.push_back((uint8_t)rel->flag);
+		}
+	}
+	compiled->children_offset.push_back(compiled->children.size());
+	/* Parents, only those which are counted during evaluation. */
+	compiled->parents_offset.reserve(num_operations + 1);
+	compiled->parents.reserve(num_parents);
+	foreach (OperationDepsNode *node, graph->operations) {
+		compiled->parents_offset.push_back(compiled->parents.size());
+		foreach (DepsRelation *rel, node->inlinks) {
+			if (rel->from->type != DEG_NODE_TYPE_OPERATION ||
+			    (rel->flag & DEPSREL_FLAG_CYCLIC) != 0)
+			{
+				continue;
+			}
+			OperationDepsNode *parent = (OperationDepsNode *)rel->from;
+			compiled->parents.push_back(parent->index);
+		}
+	}
+	compiled->parents_offset.push_back(compiled->parents.size());
+}
+
+}  // namespace DEG
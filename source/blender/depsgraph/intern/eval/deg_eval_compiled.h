@@ -0,0 +1,103 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_compiled.h
+ *  \ingroup depsgraph
+ *
+ * Flat representation of the graph used by per-frame traversals.
+ */
+
+#pragma once
+
+#include "BLI_sys_types.h"
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationDepsNode;
+
+/* Operations and relations between them, stored in flat arrays which are
+ * cheap to traverse for update flush and evaluation of big graphs.
+ *
+ * Operations are referred to by their index in the operations array, which
+ * is sorted topologically. Relations are stored in compressed sparse row form:
+ * children of operation i are children[children_offset[i]] up to (excluding)
+ * children[children_offset[i + 1]]. Per-operation state is stored in separate
+ * arrays, so traversals don't touch the nodes themselves.
+ *
+ * Built after relations are finished, and rebuilt when visibility changes.
+ */
+struct CompiledGraph {
+	void clear();
+
+	int num_operations() const { return operations.size(); }
+
+	/* Topology ............................ */
+
+	/* All operation nodes, sorted topologically. */
+	vector<OperationDepsNode *> operations;
+
+	/* All outgoing relations of operations, with their eDepsRelation_Flag. */
+	vector<int> children_offset;
+	vector<int> children;
+	vector<uint8_t> children_flag;
+
+	/* Operations which an operation is to wait for during evaluation, cyclic
+	 * relations are not included.
+	 */
+	vector<int> parents_offset;
+	vector<int> parents;
+
+	/* Layers of the ID which owns the operation. */
+	vector<unsigned int> layers;
+
+	/* Evaluation State .................... */
+
+	/* Operation is to be evaluated, mirrors DEPSOP_FLAG_NEEDS_UPDATE. */
+	vector<uint8_t> needs_update;
+
+	/* Number of parents which are still to be evaluated. */
+	vector<uint32_t> num_links_pending;
+
+	/* Operation has been scheduled for evaluation. Kept after evaluation, so
+	 * it tells which operations were evaluated the last time.
+	 */
+	vector<uint8_t> scheduled;
+
+	/* Operation was reached by the update flush. */
+	vector<uint8_t> flushed;
+
+	/* Predicted time needed to evaluate the operation and the longest chain
+	 * of operations depending on it. Ready operations with the highest priority
+	 * are on the critical path and are evaluated first.
+	 */
+	vector<double> priority;
+};
+
+/* (Re)build flat representation of the graph from its nodes and relations.
+ *
+ * Operations must be sorted topologically already, see
+ * deg_graph_build_flush_layers().
+ */
+void deg_graph_compile(Depsgraph *graph);
+
+}  // namespace DEG
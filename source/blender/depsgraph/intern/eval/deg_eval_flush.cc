@@ -45,11 +45,14 @@ extern "C" {
 
 #include "DEG_depsgraph.h"
 
+#include "atomic_ops.h"
+
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_id.h"
 #include "intern/nodes/deg_node_operation.h"
 
+#include "intern/depsgraph.h"
 #include "intern/depsgraph_intern.h"
 #include "util/deg_util_foreach.h"
 
@@ -66,7 +69,18 @@ enum {
 	COMPONENT_STATE_DONE      = 2,
 };
 
-typedef std::deque<OperationDepsNode *> FlushQueue;
+/* Indices of operations in the compiled graph. */
+typedef std::deque<int> FlushQueue;
+
+/* Graphs with less operations are flushed from a single thread, threading
+ * overhead is higher than the benefit there.
+ */
+static const int FLUSH_THREADED_MIN_OPERATIONS = 8192;
+
+/* Frontiers smaller than this are handled by the calling thread using a
+ * single work stack, happens for long chains of dependencies.
+ */
+static const int FLUSH_THREADED_MIN_FRONTIER = 256;
 
 namespace {
 
@@ -83,16 +97,6 @@ void lib_id_recalc_data_tag(Main *bmain, ID *id)
 	DEG_id_type_tag(bmain, GS(id->name));
 }
 
-void flush_init_operation_node_func(
-        void *__restrict data_v,
-        const int i,
-        const ParallelRangeTLS *__restrict /*tls*/)
-{
-	Depsgraph *graph = (Depsgraph *)data_v;
-	OperationDepsNode *node = graph->operations[i];
-	node->scheduled = false;
-}
-
 void flush_init_id_node_func(
         void *__restrict data_v,
         const int i,
@@ -109,14 +113,8 @@ void flush_init_id_node_func(
 BLI_INLINE void flush_prepare(Depsgraph *graph)
 {
 	{
-		const int num_operations = graph->operations.size();
-		ParallelRangeSettings settings;
-		BLI_parallel_range_settings_defaults(&settings);
-		settings.min_iter_per_thread = 1024;
-		BLI_task_parallel_range(0, num_operations,
-		                        graph,
-		                        flush_init_operation_node_func,
-		                        &settings);
+		CompiledGraph *compiled = &graph->compiled;
+		std::fill(compiled->flushed.begin(), compiled->flushed.end(), 0);
 	}
 	{
 		const int num_id_nodes = graph->id_nodes.size();
@@ -132,10 +130,11 @@ BLI_INLINE void flush_prepare(Depsgraph *graph)
 
 BLI_INLINE void flush_schedule_entrypoints(Depsgraph *graph, FlushQueue *queue)
 {
+	CompiledGraph *compiled = &graph->compiled;
 	GSET_FOREACH_BEGIN(OperationDepsNode *, op_node, graph->entry_tags)
 	{
-		queue->push_back(op_node);
-		op_node->scheduled = true;
+		queue->push_back(op_node->index);
+		compiled->flushed[op_node->index] = true;
 	}
 	GSET_FOREACH_END();
 }
@@ -145,20 +144,15 @@ BLI_INLINE void flush_handle_id_node(IDDepsNode *id_node)
 	id_node->done = ID_STATE_MODIFIED;
 }
 
-/* TODO(sergey): We can reduce number of arguments here. */
-BLI_INLINE void flush_handle_component_node(Depsgraph * /*graph*/,
-                                            IDDepsNode *id_node,
-                                            ComponentDepsNode *comp_node,
-                                            FlushQueue *queue)
+/* Tag all operations of the component and corresponding object. */
+BLI_INLINE void flush_tag_component_node(CompiledGraph *compiled,
+                                         IDDepsNode *id_node,
+                                         ComponentDepsNode *comp_node)
 {
-	/* We only handle component once. */
-	if (comp_node->done == COMPONENT_STATE_DONE) {
-		return;
-	}
-	comp_node->done = COMPONENT_STATE_DONE;
 	/* Tag all required operations in component for update.  */
 	foreach (OperationDepsNode *op, comp_node->operations) {
 		op->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+		compiled->needs_update[op->index] = true;
 	}
 	if (GS(id_node->id->name) == ID_OB) {
 		Object *object = (Object *)id_node->id;
@@ -197,6 +191,20 @@ BLI_INLINE void flush_handle_component_node(Depsgraph * /*graph*/,
 				break;
 		}
 	}
+}
+
+/* TODO(sergey): We can reduce number of arguments here. */
+BLI_INLINE void flush_handle_component_node(CompiledGraph *compiled,
+                                            IDDepsNode *id_node,
+                                            ComponentDepsNode *comp_node,
+                                            FlushQueue *queue)
+{
+	/* We only handle component once. */
+	if (comp_node->done == COMPONENT_STATE_DONE) {
+		return;
+	}
+	comp_node->done = COMPONENT_STATE_DONE;
+	flush_tag_component_node(compiled, id_node, comp_node);
 	/* When some target changes bone, we might need to re-run the
 	 * whole IK solver, otherwise result might be unpredictable.
 	 */
@@ -205,7 +213,7 @@ BLI_INLINE void flush_handle_component_node(Depsgraph * /*graph*/,
 		        id_node->find_component(DEG_NODE_TYPE_EVAL_POSE);
 		BLI_assert(pose_comp != NULL);
 		if (pose_comp->done == COMPONENT_STATE_NONE) {
-			queue->push_front(pose_comp->get_entry_operation());
+			queue->push_front(pose_comp->get_entry_operation()->index);
 			pose_comp->done = COMPONENT_STATE_SCHEDULED;
 		}
 	}
@@ -217,24 +225,25 @@ BLI_INLINE void flush_handle_component_node(Depsgraph * /*graph*/,
  * return value, so it can start being handled right away, without building too
  * much of a queue.
  */
-BLI_INLINE OperationDepsNode *flush_schedule_children(
-        OperationDepsNode *op_node,
-        FlushQueue *queue)
+BLI_INLINE int flush_schedule_children(CompiledGraph *compiled,
+                                      const int index,
+                                      FlushQueue *queue)
 {
-	OperationDepsNode *result = NULL;
-	foreach (DepsRelation *rel, op_node->outlinks) {
-		if (rel->flag & DEPSREL_FLAG_NO_FLUSH) {
+	int result = -1;
+	const int children_end = compiled->children_offset[index + 1];
+	for (int c = compiled->children_offset[index]; c < children_end; ++c) {
+		if (compiled->children_flag[c] & DEPSREL_FLAG_NO_FLUSH) {
 			continue;
 		}
-		OperationDepsNode *to_node = (OperationDepsNode *)rel->to;
-		if (to_node->scheduled == false) {
-			if (result != NULL) {
-				queue->push_front(to_node);
+		const int child = compiled->children[c];
+		if (!compiled->flushed[child]) {
+			if (result != -1) {
+				queue->push_front(child);
 			}
 			else {
-				result = to_node;
+				result = child;
 			}
-			to_node->scheduled = true;
+			compiled->flushed[child] = true;
 		}
 	}
 	return result;
@@ -256,72 +265,254 @@ BLI_INLINE void flush_editors_id_update(Main *bmain,
 	}
 }
 
-}  // namespace
-
-/* Flush updates from tagged nodes outwards until all affected nodes
- * are tagged.
- */
-void deg_graph_flush_updates(Main *bmain, Depsgraph *graph)
+BLI_INLINE void flush_serial(Depsgraph *graph)
 {
-	/* Sanity checks. */
-	BLI_assert(bmain != NULL);
-	BLI_assert(graph != NULL);
-	/* Nothing to update, early out. */
-	if (BLI_gset_len(graph->entry_tags) == 0) {
-		return;
-	}
-	/* Reset all flags, get ready for the flush. */
-	flush_prepare(graph);
+	CompiledGraph *compiled = &graph->compiled;
 	/* Starting from the tagged "entry" nodes, flush outwards. */
 	FlushQueue queue;
 	flush_schedule_entrypoints(graph, &queue);
 	/* Do actual flush. */
 	while (!queue.empty()) {
-		OperationDepsNode *op_node = queue.front();
+		int index = queue.front();
 		queue.pop_front();
-		while (op_node != NULL) {
+		while (index != -1) {
+			OperationDepsNode *op_node = compiled->operations[index];
 			/* Tag operation as required for update. */
 			op_node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+			compiled->needs_update[index] = true;
 			/* Inform corresponding ID and component nodes about the change. */
 			ComponentDepsNode *comp_node = op_node->owner;
 			IDDepsNode *id_node = comp_node->owner;
 			flush_handle_id_node(id_node);
-			flush_handle_component_node(graph,
+			flush_handle_component_node(compiled,
 			                            id_node,
 			                            comp_node,
 			                            &queue);
 			/* Flush to nodes along links. */
-			op_node = flush_schedule_children(op_node, &queue);
+			index = flush_schedule_children(compiled, index, &queue);
 		}
 	}
+}
+
+/* Threaded flush, frontier of operations is traversed in parallel, level by
+ * level. Operations are claimed using atomic tags, components are handled
+ * once the traversal is finished.
+ */
+
+/* Output of the traversal of a frontier, per thread. */
+struct FlushThreadData {
+	/* Operations to be handled in the next level. */
+	vector<int> frontier;
+	/* Components which were reached by the flush for the first time. */
+	vector<ComponentDepsNode *> components;
+};
+
+struct FlushFrontierData {
+	CompiledGraph *compiled;
+	const vector<int> *frontier;
+	vector<FlushThreadData> *thread_data;
+};
+
+BLI_INLINE void flush_frontier_push(CompiledGraph *compiled,
+                                    const int index,
+                                    FlushThreadData *thread_data)
+{
+	if (atomic_fetch_and_or_uint8(&compiled->flushed[index], 1) == 0) {
+		thread_data->frontier.push_back(index);
+	}
+}
+
+BLI_INLINE void flush_frontier_handle_operation(CompiledGraph *compiled,
+                                                const int index,
+                                                FlushThreadData *thread_data)
+{
+	OperationDepsNode *op_node = compiled->operations[index];
+	/* Tag operation as required for update, operation is only reached once,
+	 * so no other thread is touching it.
+	 */
+	op_node->flag |= DEPSOP_FLAG_NEEDS_UPDATE;
+	compiled->needs_update[index] = true;
+	/* Claim the component, it is tagged after traversal is done. */
+	ComponentDepsNode *comp_node = op_node->owner;
+	if (atomic_cas_int32((int32_t *)&comp_node->done,
+	                     COMPONENT_STATE_NONE,
+	                     COMPONENT_STATE_DONE) == COMPONENT_STATE_NONE)
+	{
+		thread_data->components.push_back(comp_node);
+		/* Same as in flush_handle_component_node(): re-run the whole IK
+		 * solver when bone changes. Unlike the single threaded flush, pose is
+		 * flushed even if some other operation of the pose was reached
+		 * already, which could only lead to extra updates.
+		 */
+		if (comp_node->type == DEG_NODE_TYPE_BONE) {
+			ComponentDepsNode *pose_comp =
+			        comp_node->owner->find_component(DEG_NODE_TYPE_EVAL_POSE);
+			BLI_assert(pose_comp != NULL);
+			flush_frontier_push(compiled,
+			                    pose_comp->get_entry_operation()->index,
+			                    thread_data);
+		}
+	}
+	/* Flush to nodes along links. */
+	const int children_end = compiled->children_offset[index + 1];
+	for (int c = compiled->children_offset[index]; c < children_end; ++c) {
+		if (compiled->children_flag[c] & DEPSREL_FLAG_NO_FLUSH) {
+			continue;
+		}
+		flush_frontier_push(compiled, compiled->children[c], thread_data);
+	}
+}
+
+void flush_frontier_func(void *__restrict data_v,
+                         const int i,
+                         const ParallelRangeTLS *__restrict tls)
+{
+	FlushFrontierData *data = (FlushFrontierData *)data_v;
+	flush_frontier_handle_operation(data->compiled,
+	                                (*data->frontier)[i],
+	                                &(*data->thread_data)[tls->thread_id]);
+}
+
+BLI_INLINE void flush_threaded(Depsgraph *graph)
+{
+	CompiledGraph *compiled = &graph->compiled;
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	const int num_threads = BLI_task_scheduler_num_threads(task_scheduler);
+	vector<FlushThreadData> thread_data(num_threads + 1);
+	/* Starting from the tagged "entry" nodes, flush outwards. */
+	vector<int> frontier;
+	GSET_FOREACH_BEGIN(OperationDepsNode *, op_node, graph->entry_tags)
+	{
+		frontier.push_back(op_node->index);
+		compiled->flushed[op_node->index] = true;
+	}
+	GSET_FOREACH_END();
+	FlushFrontierData data;
+	data.compiled = compiled;
+	data.frontier = &frontier;
+	data.thread_data = &thread_data;
+	while (!frontier.empty()) {
+		const int frontier_size = frontier.size();
+		if (frontier_size < FLUSH_THREADED_MIN_FRONTIER) {
+			/* Traverse from the calling thread without gathering levels,
+			 * until enough work is pending to be worth threading again.
+			 */
+			vector<int>& stack = thread_data[0].frontier;
+			stack.swap(frontier);
+			while (!stack.empty() &&
+			       stack.size() < FLUSH_THREADED_MIN_FRONTIER)
+			{
+				const int index = stack.back();
+				stack.pop_back();
+				flush_frontier_handle_operation(compiled,
+				                                index,
+				                                &thread_data[0]);
+			}
+			frontier.swap(stack);
+			continue;
+		}
+		ParallelRangeSettings settings;
+		BLI_parallel_range_settings_defaults(&settings);
+		settings.min_iter_per_thread = FLUSH_THREADED_MIN_FRONTIER / 2;
+		BLI_task_parallel_range(0, frontier_size,
+		                        &data,
+		                        flush_frontier_func,
+		                        &settings);
+		/* Gather the next level. */
+		frontier.clear();
+		foreach (FlushThreadData& tdata, thread_data) {
+			frontier.insert(frontier.end(),
+			                tdata.frontier.begin(),
+			                tdata.frontier.end());
+			tdata.frontier.clear();
+		}
+	}
+	/* Tag components which were reached, they are not shared between
+	 * threads anymore.
+	 */
+	foreach (const FlushThreadData& tdata, thread_data) {
+		foreach (ComponentDepsNode *comp_node, tdata.components) {
+			IDDepsNode *id_node = comp_node->owner;
+			flush_handle_id_node(id_node);
+			flush_tag_component_node(compiled, id_node, comp_node);
+		}
+	}
+}
+
+}  // namespace
+
+void deg_graph_flush_updates_ex(Main *bmain,
+                                Depsgraph *graph,
+                                const bool use_threading)
+{
+	/* Sanity checks. */
+	BLI_assert(bmain != NULL);
+	BLI_assert(graph != NULL);
+	/* Nothing to update, early out. */
+	if (BLI_gset_len(graph->entry_tags) == 0) {
+		return;
+	}
+	BLI_assert(graph->compiled.operations.size() == graph->operations.size());
+	/* Reset all flags, get ready for the flush. */
+	flush_prepare(graph);
+	/* Do actual flush. */
+	if (use_threading) {
+		flush_threaded(graph);
+	}
+	else {
+		flush_serial(graph);
+	}
 	/* Inform editors about all changes. */
 	flush_editors_id_update(bmain, graph);
 }
 
+/* Flush updates from tagged nodes outwards until all affected nodes
+ * are tagged.
+ */
+void deg_graph_flush_updates(Main *bmain, Depsgraph *graph)
+{
+	TaskScheduler *task_scheduler = BLI_task_scheduler_get();
+	const bool use_threading =
+	        BLI_task_scheduler_num_threads(task_scheduler) > 1 &&
+	        graph->compiled.num_operations() >= FLUSH_THREADED_MIN_OPERATIONS;
+	deg_graph_flush_updates_ex(bmain, graph, use_threading);
+}
+
 static void graph_clear_func(
         void *__restrict data_v,
         const int i,
         const ParallelRangeTLS *__restrict /*tls*/)
 {
-	Depsgraph *graph = (Depsgraph *)data_v;
-	OperationDepsNode *node = graph->operations[i];
-	/* Clear node's "pending update" settings. */
-	node->flag &= ~(DEPSOP_FLAG_DIRECTLY_MODIFIED | DEPSOP_FLAG_NEEDS_UPDATE);
+	CompiledGraph *compiled = (CompiledGraph *)data_v;
+	/* Only operations which are tagged need to be touched. */
+	if (compiled->needs_update[i]) {
+		OperationDepsNode *node = compiled->operations[i];
+		/* Clear node's "pending update" settings. */
+		node->flag &= ~(DEPSOP_FLAG_DIRECTLY_MODIFIED | DEPSOP_FLAG_NEEDS_UPDATE);
+		compiled->needs_update[i] = false;
+	}
 }
 
 /* Clear tags from all operation nodes. */
 void deg_graph_clear_tags(Depsgraph *graph)
 {
+	CompiledGraph *compiled = &graph->compiled;
+	BLI_assert(compiled->operations.size() == graph->operations.size());
 	/* Go over all operation nodes, clearing tags. */
-	const int num_operations = graph->operations.size();
+	const int num_operations = compiled->num_operations();
 	ParallelRangeSettings settings;
 	BLI_parallel_range_settings_defaults(&settings);
 	settings.min_iter_per_thread = 1024;
 	BLI_task_parallel_range(0, num_operations,
-	                        graph,
+	                        compiled,
 	                        graph_clear_func,
 	                        &settings);
 	/* Clear any entry tags which haven't been flushed. */
+	GSET_FOREACH_BEGIN(OperationDepsNode *, node, graph->entry_tags)
+	{
+		node->flag &= ~(DEPSOP_FLAG_DIRECTLY_MODIFIED | DEPSOP_FLAG_NEEDS_UPDATE);
+	}
+	GSET_FOREACH_END();
 	BLI_gset_clear(graph->entry_tags, NULL);
 }
 
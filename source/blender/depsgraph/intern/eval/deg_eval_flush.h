@@ -43,6 +43,13 @@ struct Depsgraph;
  */
 void deg_graph_flush_updates(struct Main *bmain, struct Depsgraph *graph);
 
+/* Same as above, but with explicit choice between single threaded and
+ * threaded flush, instead of choosing based on the graph size.
+ */
+void deg_graph_flush_updates_ex(struct Main *bmain,
+                                struct Depsgraph *graph,
+                                const bool use_threading);
+
 /* Clear tags from all operation nodes. */
 void deg_graph_clear_tags(struct Depsgraph *graph);
 
@@ -0,0 +1,363 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.cc
+ *  \ingroup depsgraph
+ */
+
+#include "intern/eval/deg_eval_profile.h"
+
+#include <cstdio>
+#include <map>
+
+#include "PIL_time.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_threads.h"
+#include "BLI_math_base.h"
+
+extern "C" {
+#include "BKE_blender.h"
+} /* extern "C" */
+
+#include "DEG_depsgraph_debug.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_intern.h"
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+namespace {
+
+/* Number of operations listed in the summary. */
+const int PROFILE_SUMMARY_NUM_OPERATIONS = 20;
+
+/* Limit the size of the trace for long sessions (like an animation render),
+ * summary is still gathered for all evaluations.
+ */
+const size_t PROFILE_MAX_TRACE_EVENTS = 4 * 1024 * 1024;
+
+/* Operation which was evaluated at least once, referred to by index. */
+struct ProfileOperation {
+	string id_name;
+	string component_name;
+	string component_type;
+	string operation_name;
+	string full_identifier;
+	/* Summary. */
+	double total_time;
+	double max_time;
+	int num_evaluations;
+};
+
+/* Times are relative to the profile start, in seconds. */
+struct ProfileTraceEvent {
+	int operation_index;
+	int thread_id;
+	double start_time;
+	double end_time;
+};
+
+struct ProfileGraphEvaluation {
+	double start_time;
+	double end_time;
+};
+
+struct Profile {
+	string filepath;
+	double start_time;
+	vector<ProfileOperation> operations;
+	std::map<string, int> operation_indices;
+	vector<ProfileTraceEvent> trace_events;
+	vector<ProfileGraphEvaluation> graph_evaluations;
+	size_t num_dropped_trace_events;
+	int max_thread_id;
+};
+
+Profile *g_profile = NULL;
+ThreadMutex g_profile_mutex = BLI_MUTEX_INITIALIZER;
+
+int profile_operation_index(Profile *profile, const OperationDepsNode *node)
+{
+	const ComponentDepsNode *comp_node = node->owner;
+	const char *component_type =
+	        deg_type_get_factory(comp_node->type)->tname();
+	const string full_identifier = node->full_identifier();
+	const string key = full_identifier + "|" + component_type;
+	std::map<string, int>::const_iterator it =
+	        profile->operation_indices.find(key);
+	if (it != profile->operation_indices.end()) {
+		return it->second;
+	}
+	ProfileOperation operation;
+	operation.id_name = comp_node->owner->name;
+	operation.component_name = comp_node->name;
+	operation.component_type = component_type;
+	operation.operation_name = node->identifier();
+	operation.full_identifier = full_identifier;
+	operation.total_time = 0.0;
+	operation.max_time = 0.0;
+	operation.num_evaluations = 0;
+	const int index = profile->operations.size();
+	profile->operations.push_back(operation);
+	profile->operation_indices[key] = index;
+	return index;
+}
+
+string json_escape(const string& str)
+{
+	string result;
+	result.reserve(str.size());
+	for (size_t i = 0; i < str.size(); ++i) {
+		const char c = str[i];
+		if (c == '"' || c == '\\') {
+			result += '\\';
+			result += c;
+		}
+		else if ((unsigned char)c < 0x20) {
+			char buf[8];
+			sprintf(buf, "\\u%04x", (int)c);
+			result += buf;
+		}
+		else {
+			result += c;
+		}
+	}
+	return result;
+}
+
+/* Timestamps of trace events are in microseconds. */
+BLI_INLINE double trace_time(const double time)
+{
+	return time * 1e6;
+}
+
+bool profile_write_trace(const Profile *profile)
+{
+	FILE *f = fopen(profile->filepath.c_str(), "w");
+	if (f == NULL) {
+		fprintf(stderr,
+		        "Depsgraph profile: failed to open '%s' for writing.\n",
+		        profile->filepath.c_str());
+		return false;
+	}
+	fprintf(f, "{\"traceEvents\":[\n");
+	/* Events are separated by commas, JSON does not allow a trailing one. */
+	const char *separator = "";
+	/* Thread names. */
+	for (int thread_id = 0; thread_id <= profile->max_thread_id; ++thread_id) {
+		fprintf(f,
+		        "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+		        "\"args\":{\"name\":\"%s %d\"}}",
+		        separator,
+		        thread_id,
+		        (thread_id == 0) ? "Main" : "Worker",
+		        thread_id);
+		separator = ",\n";
+	}
+	/* Whole graph evaluations, enclosing operations of the main thread. */
+	foreach (const ProfileGraphEvaluation& evaluation,
+	         profile->graph_evaluations)
+	{
+		fprintf(f,
+		        "%s{\"name\":\"Depsgraph Evaluation\",\"cat\":\"Depsgraph\","
+		        "\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":0}",
+		        separator,
+		        trace_time(evaluation.start_time),
+		        trace_time(evaluation.end_time - evaluation.start_time));
+		separator = ",\n";
+	}
+	/* Operations. */
+	const size_t num_events = profile->trace_events.size();
+	for (size_t i = 0; i < num_events; ++i) {
+		const ProfileTraceEvent& event = profile->trace_events[i];
+		const ProfileOperation& operation =
+		        profile->operations[event.operation_index];
+		fprintf(f,
+		        "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+		        "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d,"
+		        "\"args\":{\"id\":\"%s\",\"component\":\"%s\"}}",
+		        separator,
+		        json_escape(operation.operation_name).c_str(),
+		        json_escape(operation.component_type).c_str(),
+		        trace_time(event.start_time),
+		        trace_time(event.end_time - event.start_time),
+		        event.thread_id,
+		        json_escape(operation.id_name).c_str(),
+		        json_escape(operation.component_name).c_str());
+		separator = ",\n";
+	}
+	fprintf(f, "\n],\n\"displayTimeUnit\":\"ms\"}\n");
+	fclose(f);
+	return true;
+}
+
+bool profile_operation_comparator(const ProfileOperation *a,
+                                  const ProfileOperation *b)
+{
+	return a->total_time > b->total_time;
+}
+
+void profile_print_summary(const Profile *profile)
+{
+	vector<const ProfileOperation *> operations;
+	operations.reserve(profile->operations.size());
+	int num_evaluations = 0;
+	foreach (const ProfileOperation& operation, profile->operations) {
+		operations.push_back(&operation);
+		num_evaluations += operation.num_evaluations;
+	}
+	std::sort(operations.begin(),
+	          operations.end(),
+	          profile_operation_comparator);
+	printf("Depsgraph profile: %d graph evaluations, %d operations evaluated, "
+	       "trace written to '%s'.\n",
+	       (int)profile->graph_evaluations.size(),
+	       num_evaluations,
+	       profile->filepath.c_str());
+	if (profile->num_dropped_trace_events != 0) {
+		printf("Depsgraph profile: trace is truncated, %d events dropped.\n",
+		       (int)profile->num_dropped_trace_events);
+	}
+	const int num_operations = min_ii(operations.size(),
+	                                  PROFILE_SUMMARY_NUM_OPERATIONS);
+	printf("Top %d slowest operations:\n", num_operations);
+	printf("%-12s %-8s %-12s %-12s %s\n",
+	       "Total (sec)", "Count", "Avg (msec)", "Max (msec)", "Operation");
+	for (int i = 0; i < num_operations; ++i) {
+		const ProfileOperation *operation = operations[i];
+		printf("%-12.6f %-8d %-12.6f %-12.6f %s (%s)\n",
+		       operation->total_time,
+		       operation->num_evaluations,
+		       operation->total_time * 1000.0 / operation->num_evaluations,
+		       operation->max_time * 1000.0,
+		       operation->full_identifier.c_str(),
+		       operation->component_type.c_str());
+	}
+}
+
+void profile_end(const bool from_atexit);
+
+void profile_atexit(void * /*user_data*/)
+{
+	/* Callback is freed by the caller. */
+	profile_end(true);
+}
+
+void profile_begin(const char *filepath)
+{
+	BLI_mutex_lock(&g_profile_mutex);
+	if (g_profile == NULL) {
+		BKE_blender_atexit_register(profile_atexit, NULL);
+	}
+	else {
+		OBJECT_GUARDED_DELETE(g_profile, Profile);
+	}
+	Profile *profile = OBJECT_GUARDED_NEW(Profile);
+	profile->filepath = filepath;
+	profile->start_time = PIL_check_seconds_timer();
+	profile->num_dropped_trace_events = 0;
+	profile->max_thread_id = 0;
+	g_profile = profile;
+	BLI_mutex_unlock(&g_profile_mutex);
+}
+
+void profile_end(const bool from_atexit)
+{
+	BLI_mutex_lock(&g_profile_mutex);
+	Profile *profile = g_profile;
+	g_profile = NULL;
+	BLI_mutex_unlock(&g_profile_mutex);
+	if (profile == NULL) {
+		return;
+	}
+	if (!from_atexit) {
+		BKE_blender_atexit_unregister(profile_atexit, NULL);
+	}
+	if (profile_write_trace(profile)) {
+		profile_print_summary(profile);
+	}
+	OBJECT_GUARDED_DELETE(profile, Profile);
+}
+
+}  // namespace
+
+bool deg_eval_profile_is_enabled()
+{
+	return g_profile != NULL;
+}
+
+void deg_eval_profile_add_events(const Depsgraph * /*graph*/,
+                                 const ProfileThreadEvents& thread_events,
+                                 const double start_time,
+                                 const double end_time)
+{
+	BLI_mutex_lock(&g_profile_mutex);
+	Profile *profile = g_profile;
+	if (profile == NULL) {
+		BLI_mutex_unlock(&g_profile_mutex);
+		return;
+	}
+	ProfileGraphEvaluation evaluation;
+	evaluation.start_time = start_time - profile->start_time;
+	evaluation.end_time = end_time - profile->start_time;
+	profile->graph_evaluations.push_back(evaluation);
+	foreach (const vector<ProfileEvent>& events, thread_events) {
+		foreach (const ProfileEvent& event, events) {
+			const int index = profile_operation_index(profile, event.node);
+			ProfileOperation *operation = &profile->operations[index];
+			const double time = event.end_time - event.start_time;
+			operation->total_time += time;
+			operation->max_time = std::max(operation->max_time, time);
+			++operation->num_evaluations;
+			if (profile->trace_events.size() >= PROFILE_MAX_TRACE_EVENTS) {
+				++profile->num_dropped_trace_events;
+				continue;
+			}
+			ProfileTraceEvent trace_event;
+			trace_event.operation_index = index;
+			trace_event.thread_id = event.thread_id;
+			trace_event.start_time = event.start_time - profile->start_time;
+			trace_event.end_time = event.end_time - profile->start_time;
+			profile->trace_events.push_back(trace_event);
+			profile->max_thread_id = max_ii(profile->max_thread_id,
+			                                event.thread_id);
+		}
+	}
+	BLI_mutex_unlock(&g_profile_mutex);
+}
+
+}  // namespace DEG
+
+void DEG_debug_profile_begin(const char *filepath)
+{
+	DEG::profile_begin(filepath);
+}
+
+void DEG_debug_profile_end(void)
+{
+	DEG::profile_end(false);
+}
@@ -0,0 +1,60 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/eval/deg_eval_profile.h
+ *  \ingroup depsgraph
+ *
+ * Profiling of operations evaluation, for the export to the Chrome trace
+ * event format.
+ */
+
+#pragma once
+
+#include "intern/depsgraph_types.h"
+
+namespace DEG {
+
+struct Depsgraph;
+struct OperationDepsNode;
+
+/* Evaluation of a single operation. */
+struct ProfileEvent {
+	const OperationDepsNode *node;
+	int thread_id;
+	double start_time;
+	double end_time;
+};
+
+/* Events of a single graph evaluation, indexed by thread_id of the task pool,
+ * so they can be recorded without any locking.
+ */
+typedef vector<vector<ProfileEvent> > ProfileThreadEvents;
+
+bool deg_eval_profile_is_enabled();
+
+/* Store events of the graph evaluation in the profile. Called after the
+ * evaluation is finished, while the nodes are still valid.
+ */
+void deg_eval_profile_add_events(const Depsgraph *graph,
+                                 const ProfileThreadEvents& thread_events,
+                                 const double start_time,
+                                 const double end_time);
+
+}  // namespace DEG
@@ -58,8 +58,16 @@ void deg_eval_stats_aggregate(Depsgraph *graph)
 		GHASH_FOREACH_END();
 		id_node->stats.reset_current();
 	}
-	/* Now accumulate operation timings to components and IDs. */
-	foreach (OperationDepsNode *op_node, graph->operations) {
+	/* Now accumulate operation timings to components and IDs. Timing of
+	 * operations which were not evaluated is left from previous evaluations.
+	 */
+	const CompiledGraph *compiled = &graph->compiled;
+	const int num_operations = compiled->num_operations();
+	for (int i = 0; i < num_operations; ++i) {
+		if (!compiled->scheduled[i]) {
+			continue;
+		}
+		OperationDepsNode *op_node = compiled->operations[i];
 		ComponentDepsNode *comp_node = op_node->owner;
 		IDDepsNode *id_node = comp_node->owner;
 		id_node->stats.current_time += op_node->stats.current_time;
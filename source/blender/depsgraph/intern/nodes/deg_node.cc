@@ -69,6 +69,8 @@ DepsNode::Stats::Stats()
 void DepsNode::Stats::reset()
 {
 	current_time = 0.0;
+	average_time = 0.0;
+	num_evaluations = 0;
 }
 
 void DepsNode::Stats::reset_current()
@@ -76,6 +78,21 @@ void DepsNode::Stats::reset_current()
 	current_time = 0.0;
 }
 
+void DepsNode::Stats::accumulate_current()
+{
+	/* Weight of the most recent evaluation, high enough to adapt quickly to
+	 * changes in the scene, low enough to smooth out noise of the timer.
+	 */
+	const double factor = 0.25;
+	if (num_evaluations == 0) {
+		average_time = current_time;
+	}
+	else {
+		average_time += (current_time - average_time) * factor;
+	}
+	++num_evaluations;
+}
+
 /*******************************************************************************
  * Node itself.
  */
@@ -66,8 +66,14 @@ struct DepsNode {
 		 * touch averaging accumulators.
 		 */
 		void reset_current();
+		/* Fold time of the current evaluation into the running average. */
+		void accumulate_current();
 		/* Time spend on this node during current graph evaluation. */
 		double current_time;
+		/* Exponential moving average of the evaluation time. */
+		double average_time;
+		/* Number of evaluations accumulated into the average. */
+		unsigned int num_evaluations;
 	};
 	/* Relationships between nodes
 	 * The reason why all depsgraph nodes are descended from this type (apart
@@ -144,11 +144,9 @@ void ComponentDepsNode::init(const ID * /*id*/,
 ComponentDepsNode::~ComponentDepsNode()
 {
 	clear_operations();
-	if (operations_map != NULL) {
-		BLI_ghash_free(operations_map,
-		               comp_node_hash_key_free,
-		               comp_node_hash_value_free);
-	}
+	BLI_ghash_free(operations_map,
+	               comp_node_hash_key_free,
+	               comp_node_hash_value_free);
 }
 
 string ComponentDepsNode::identifier() const
@@ -166,22 +164,7 @@ string ComponentDepsNode::identifier() const
 
 OperationDepsNode *ComponentDepsNode::find_operation(OperationIDKey key) const
 {
-	OperationDepsNode *node = NULL;
-	if (operations_map != NULL) {
-		node = (OperationDepsNode *)BLI_ghash_lookup(operations_map, &key);
-	}
-	else {
-		BLI_assert(key.name_tag == -1);
-		foreach (OperationDepsNode *op_node, operations) {
-			if (op_node->opcode == key.opcode &&
-			    STREQ(op_node->name, key.name))
-			{
-				node = op_node;
-				break;
-			}
-		}
-	}
-	return node;
+	return (OperationDepsNode *)BLI_ghash_lookup(operations_map, &key);
 }
 
 OperationDepsNode *ComponentDepsNode::find_operation(eDepsOperation_Code opcode,
@@ -270,14 +253,10 @@ void ComponentDepsNode::set_exit_operation(OperationDepsNode *op_node)
 
 void ComponentDepsNode::clear_operations()
 {
-	if (operations_map != NULL) {
-		BLI_ghash_clear(operations_map,
-		                comp_node_hash_key_free,
-		                comp_node_hash_value_free);
-	}
-	foreach (OperationDepsNode *op_node, operations) {
-		OBJECT_GUARDED_DELETE(op_node, OperationDepsNode);
-	}
+	/* NOTE: Vector only references operations owned by the hash map. */
+	BLI_ghash_clear(operations_map,
+	                comp_node_hash_key_free,
+	                comp_node_hash_value_free);
 	operations.clear();
 }
 
@@ -287,17 +266,12 @@ void ComponentDepsNode::tag_update(Depsgraph *graph)
 	if (entry_op != NULL && entry_op->flag & DEPSOP_FLAG_NEEDS_UPDATE) {
 		return;
 	}
-	foreach (OperationDepsNode *op_node, operations) {
+	/* NOTE: Use hash map, tag might happen before finalization. */
+	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
+	{
 		op_node->tag_update(graph);
 	}
-	// It is possible that tag happens before finalization.
-	if (operations_map != NULL) {
-		GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
-		{
-			op_node->tag_update(graph);
-		}
-		GHASH_FOREACH_END();
-	}
+	GHASH_FOREACH_END();
 }
 
 OperationDepsNode *ComponentDepsNode::get_entry_operation()
@@ -305,7 +279,7 @@ OperationDepsNode *ComponentDepsNode::get_entry_operation()
 	if (entry_operation) {
 		return entry_operation;
 	}
-	else if (operations_map != NULL && BLI_ghash_len(operations_map) == 1) {
+	else if (BLI_ghash_len(operations_map) == 1) {
 		OperationDepsNode *op_node = NULL;
 		/* TODO(sergey): This is somewhat slow. */
 		GHASH_FOREACH_BEGIN(OperationDepsNode *, tmp, operations_map)
@@ -317,9 +291,6 @@ OperationDepsNode *ComponentDepsNode::get_entry_operation()
 		entry_operation = op_node;
 		return op_node;
 	}
-	else if (operations.size() == 1) {
-		return operations[0];
-	}
 	return NULL;
 }
 
@@ -328,7 +299,7 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 	if (exit_operation) {
 		return exit_operation;
 	}
-	else if (operations_map != NULL && BLI_ghash_len(operations_map) == 1) {
+	else if (BLI_ghash_len(operations_map) == 1) {
 		OperationDepsNode *op_node = NULL;
 		/* TODO(sergey): This is somewhat slow. */
 		GHASH_FOREACH_BEGIN(OperationDepsNode *, tmp, operations_map)
@@ -340,24 +311,21 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 		exit_operation = op_node;
 		return op_node;
 	}
-	else if (operations.size() == 1) {
-		return operations[0];
-	}
 	return NULL;
 }
 
 void ComponentDepsNode::finalize_build()
 {
+	/* NOTE: Hash map is kept, so relations can be updated incrementally
+	 * without re-creating all the nodes.
+	 */
+	operations.clear();
 	operations.reserve(BLI_ghash_len(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
 		operations.push_back(op_node);
 	}
 	GHASH_FOREACH_END();
-	BLI_ghash_free(operations_map,
-	               comp_node_hash_key_free,
-	               NULL);
-	operations_map = NULL;
 }
 
 /* Bone Component ========================================= */
@@ -133,8 +133,9 @@ struct ComponentDepsNode : public DepsNode {
 
 	/* ** Inner nodes for this component ** */
 
-	/* Operations stored as a hash map, for faster build.
-	 * This hash map will be freed when graph is fully built.
+	/* Operations stored as a hash map, for faster lookups.
+	 * This hash map owns the operations, it is kept after the graph is built
+	 * so nodes can be added for an incremental relations update.
 	 */
 	GHash *operations_map;
 
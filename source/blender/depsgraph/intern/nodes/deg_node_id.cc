@@ -99,7 +99,9 @@ void IDDepsNode::init(const ID *id, const char *UNUSED(subdata))
 	BLI_assert(id != NULL);
 	this->id = (ID *)id;
 	this->layers = (1 << 20) - 1;
+	this->layers_base = 0;
 	this->eval_flags = 0;
+	this->build_owner = NULL;
 
 	/* For object we initialize layers to layer from base. */
 	if (GS(id->name) == ID_OB) {
@@ -67,6 +67,17 @@ struct IDDepsNode : public DepsNode {
 	/* Layers of this node with accumulated layers of it's output relations. */
 	unsigned int layers;
 
+	/* Layers as they were set by the node builder, before flushing them from
+	 * the dependent nodes. Used by incremental relations update.
+	 */
+	unsigned int layers_base;
+
+	/* Object (or scene) which was being built when this node was created.
+	 * All the nodes and relations of such build owner are re-created together
+	 * on incremental relations update.
+	 */
+	ID *build_owner;
+
 	/* Additional flags needed for scene evaluation.
 	 * TODO(sergey): Only needed for until really granular updates
 	 * of all the entities.
@@ -45,6 +45,7 @@ namespace DEG {
 /* Inner Nodes */
 
 OperationDepsNode::OperationDepsNode() :
+    index(-1),
     flag(0),
     customdata_mask(0)
 {
@@ -78,6 +78,9 @@ struct OperationDepsNode : public DepsNode {
 	uint32_t num_links_pending;
 	bool scheduled;
 
+	/* Index of the operation in the compiled graph. */
+	int index;
+
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
 
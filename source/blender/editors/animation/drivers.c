@@ -843,7 +843,7 @@ static int add_driver_button_none(bContext *C, wmOperator *op, short mapping_typ
 	if (success) {
 		/* send updates */
 		UI_context_update_anim_flag(C);
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_relations_tag_update(CTX_data_main(C), ptr.id.data);
 		WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL);  // XXX
 		
 		return OPERATOR_FINISHED;
@@ -941,7 +941,7 @@ static int remove_driver_button_exec(bContext *C, wmOperator *op)
 	if (success) {
 		/* send updates */
 		UI_context_update_anim_flag(C);
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_relations_tag_update(CTX_data_main(C), ptr.id.data);
 		WM_event_add_notifier(C, NC_ANIMATION | ND_FCURVES_ORDER, NULL);  // XXX
 	}
 	
@@ -1031,7 +1031,7 @@ static int paste_driver_button_exec(bContext *C, wmOperator *op)
 			
 			UI_context_update_anim_flag(C);
 			
-			DAG_relations_tag_update(CTX_data_main(C));
+			DAG_id_relations_tag_update(CTX_data_main(C), ptr.id.data);
 			DAG_id_tag_update(ptr.id.data, OB_RECALC_OB | OB_RECALC_DATA);
 			
 			WM_event_add_notifier(C, NC_ANIMATION | ND_KEYFRAME_PROP, NULL);  // XXX
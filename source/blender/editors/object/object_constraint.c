@@ -1221,7 +1221,7 @@ void ED_object_constraint_dependency_update(Main *bmain, Object *ob)
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 }
 
 void ED_object_constraint_tag_update(Object *ob, bConstraint *con)
@@ -1245,7 +1245,7 @@ void ED_object_constraint_dependency_tag_update(Main *bmain, Object *ob, bConstr
 	if (ob->pose) {
 		object_pose_tag_update(bmain, ob);
 	}
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 }
 
 static int constraint_poll(bContext *C)
@@ -1269,7 +1269,7 @@ static int constraint_delete_exec(bContext *C, wmOperator *UNUSED(op))
 		ED_object_constraint_update(ob); /* needed to set the flags on posebones correctly */
 
 		/* relatiols */
-		DAG_relations_tag_update(CTX_data_main(C));
+		DAG_id_relations_tag_update(CTX_data_main(C), &ob->id);
 
 		/* notifiers */
 		WM_event_add_notifier(C, NC_OBJECT | ND_CONSTRAINT | NA_REMOVED, ob);
@@ -1444,12 +1444,11 @@ static int object_constraints_clear_exec(bContext *C, wmOperator *UNUSED(op))
 	{
 		BKE_constraints_free(&ob->constraints);
 		DAG_id_tag_update(&ob->id, OB_RECALC_OB);
+		/* force depsgraph to get recalculated since relationships removed */
+		DAG_id_relations_tag_update(bmain, &ob->id);
 	}
 	CTX_DATA_END;
 	
-	/* force depsgraph to get recalculated since relationships removed */
-	DAG_relations_tag_update(bmain);
-	
 	/* do updates */
 	WM_event_add_notifier(C, NC_OBJECT | ND_CONSTRAINT | NA_REMOVED, NULL);
 	
@@ -1536,13 +1535,12 @@ static int object_constraint_copy_exec(bContext *C, wmOperator *UNUSED(op))
 		if (obact != ob) {
 			BKE_constraints_copy(&ob->constraints, &obact->constraints, true);
 			DAG_id_tag_update(&ob->id, OB_RECALC_DATA);
+			/* force depsgraph to get recalculated since new relationships added */
+			DAG_id_relations_tag_update(bmain, &ob->id);
 		}
 	}
 	CTX_DATA_END;
 	
-	/* force depsgraph to get recalculated since new relationships added */
-	DAG_relations_tag_update(bmain);
-	
 	/* notifiers for updates */
 	WM_event_add_notifier(C, NC_OBJECT | ND_CONSTRAINT | NA_ADDED, NULL);
 	
@@ -1687,6 +1685,8 @@ static bool get_new_constraint_target(bContext *C, int con_type, Object **tar_ob
 		
 		/* add new target object */
 		obt = BKE_object_add(bmain, scene, OB_EMPTY, NULL);
+		/* new object needs a full relations update */
+		DAG_relations_tag_update(bmain);
 		
 		/* set layers OK */
 		newbase = BASACT;
@@ -1817,7 +1817,7 @@ static int constraint_add_exec(bContext *C, wmOperator *op, Object *ob, ListBase
 
 
 	/* force depsgraph to get recalculated since new relationships added */
-	DAG_relations_tag_update(bmain);
+	DAG_id_relations_tag_update(bmain, &ob->id);
 	
 	if ((ob->type == OB_ARMATURE) && (pchan)) {
 		BKE_pose_tag_recalc(bmain, ob->pose);  /* sort pose channels */
@@ -55,6 +55,7 @@ struct SoftBody;
 struct FluidsimSettings;
 struct ParticleSystem;
 struct DerivedMesh;
+struct MeshDeformNormalsCache;
 struct SculptSession;
 struct bGPdata;
 struct RigidBodyOb;
@@ -282,6 +283,9 @@ typedef struct Object {
 	struct CurveCache *curve_cache;
 
 	struct DerivedMesh *derivedDeform, *derivedFinal;
+	/* Runtime normals of the deform-only modifier stack result, kept between evaluations */
+	struct MeshDeformNormalsCache *deform_normals_cache;
+	void *pad4;
 	uint64_t lastDataMask;   /* the custom data layer mask that was last used to calculate derivedDeform and derivedFinal */
 	uint64_t customdata_mask; /* (extra) custom data layer mask to use for creating derivedmesh, set by depsgraph */
 	unsigned int state;			/* bit masks of game controllers that are active */
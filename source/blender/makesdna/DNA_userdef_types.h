@@ -630,6 +630,7 @@ typedef enum eUserPref_Flag {
 	USER_NONEGFRAMES		= (1 << 24),
 	USER_TXT_TABSTOSPACES_DISABLE	= (1 << 25),
 	USER_TOOLTIPS_PYTHON    = (1 << 26),
+	USER_LIBRARY_INDEX		= (1 << 27),
 } eUserPref_Flag;
 
 /* bPathCompare.flag */
@@ -4544,6 +4544,12 @@ static void rna_def_userdef_filepaths(BlenderRNA *brna)
 	RNA_def_property_boolean_sdna(prop, NULL, "flag", USER_FILECOMPRESS);
 	RNA_def_property_ui_text(prop, "Compress File", "Enable file compression when saving .blend files");
 
+	prop = RNA_def_property(srna, "use_library_index", PROP_BOOLEAN, PROP_NONE);
+	RNA_def_property_boolean_sdna(prop, NULL, "flag", USER_LIBRARY_INDEX);
+	RNA_def_property_ui_text(prop, "Index Libraries",
+	                         "Keep an index next to uncompressed .blend files that data is linked or appended from "
+	                         "(file.blend.idx), to list and link their contents faster");
+
 	prop = RNA_def_property(srna, "use_load_ui", PROP_BOOLEAN, PROP_NONE);
 	RNA_def_property_boolean_negative_sdna(prop, NULL, "flag", USER_FILENOUI);
 	RNA_def_property_ui_text(prop, "Load UI", "Load user interface setup when loading .blend files");
@@ -1173,6 +1173,7 @@ static int wm_file_write(bContext *C, const char *filepath, int fileflags, Repor
 		}
 
 		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS, G_FILE_COMPRESS);
+		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_COMPRESS_LZO, G_FILE_COMPRESS_LZO);
 		SET_FLAG_FROM_TEST(G.fileflags, fileflags & G_FILE_AUTOPLAY, G_FILE_AUTOPLAY);
 
 		/* prevent background mode scripts from clobbering history */
@@ -2005,6 +2006,13 @@ static void save_set_compress(wmOperator *op)
 			RNA_property_boolean_set(op->ptr, prop, (U.flag & USER_FILECOMPRESS) != 0);
 		}
 	}
+
+	prop = RNA_struct_find_property(op->ptr, "compress_fast");
+	if (!RNA_property_is_set(op->ptr, prop)) {
+		if (G.save_over) {  /* keep flag for existing file */
+			RNA_property_boolean_set(op->ptr, prop, (G.fileflags & G_FILE_COMPRESS_LZO) != 0);
+		}
+	}
 }
 
 static void save_set_filepath(wmOperator *op)
@@ -2057,10 +2065,13 @@ static int wm_save_as_mainfile_exec(bContext *C, wmOperator *op)
 
 	fileflags = G.fileflags & ~G_FILE_USERPREFS;
 
-	/* set compression flag */
+	/* set compression flag, fast compression is only used for compressed files */
 	SET_FLAG_FROM_TEST(
 	        fileflags, RNA_boolean_get(op->ptr, "compress"),
 	        G_FILE_COMPRESS);
+	SET_FLAG_FROM_TEST(
+	        fileflags, RNA_boolean_get(op->ptr, "compress") && RNA_boolean_get(op->ptr, "compress_fast"),
+	        G_FILE_COMPRESS_LZO);
 	SET_FLAG_FROM_TEST(
 	        fileflags, RNA_boolean_get(op->ptr, "relative_remap"),
 	        G_FILE_RELATIVE_REMAP);
@@ -2107,6 +2118,30 @@ static bool blend_save_check(bContext *UNUSED(C), wmOperator *op)
 	return false;
 }
 
+static void wm_save_as_mainfile_ui(bContext *UNUSED(C), wmOperator *op)
+{
+	uiLayout *layout = op->layout;
+	uiLayout *col;
+
+	uiItemR(layout, op->ptr, "compress", 0, NULL, ICON_NONE);
+
+	/* fast compression is only used for compressed files */
+	col = uiLayoutColumn(layout, false);
+	uiLayoutSetEnabled(col, RNA_boolean_get(op->ptr, "compress"));
+	uiItemR(col, op->ptr, "compress_fast", 0, NULL, ICON_NONE);
+
+	uiItemR(layout, op->ptr, "relative_remap", 0, NULL, ICON_NONE);
+
+	if (RNA_struct_find_property(op->ptr, "copy")) {
+		uiItemR(layout, op->ptr, "copy", 0, NULL, ICON_NONE);
+	}
+#ifdef USE_BMESH_SAVE_AS_COMPAT
+	if (RNA_struct_find_property(op->ptr, "use_mesh_compat")) {
+		uiItemR(layout, op->ptr, "use_mesh_compat", 0, NULL, ICON_NONE);
+	}
+#endif
+}
+
 void WM_OT_save_as_mainfile(wmOperatorType *ot)
 {
 	PropertyRNA *prop;
@@ -2118,12 +2153,16 @@ void WM_OT_save_as_mainfile(wmOperatorType *ot)
 	ot->invoke = wm_save_as_mainfile_invoke;
 	ot->exec = wm_save_as_mainfile_exec;
 	ot->check = blend_save_check;
+	ot->ui = wm_save_as_mainfile_ui;
 	/* omit window poll so this can work in background mode */
 
 	WM_operator_properties_filesel(
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_fast", false, "Fast Compression",
+	                "Compress using multiple threads with a faster codec (only used with Compress), "
+	                "larger files that can't be opened by older versions of Blender");
 	RNA_def_boolean(ot->srna, "relative_remap", true, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 	prop = RNA_def_boolean(ot->srna, "copy", false, "Save Copy",
@@ -2186,6 +2225,7 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	ot->invoke = wm_save_mainfile_invoke;
 	ot->exec = wm_save_as_mainfile_exec;
 	ot->check = blend_save_check;
+	ot->ui = wm_save_as_mainfile_ui;
 	/* omit window poll so this can work in background mode */
 
 	PropertyRNA *prop;
@@ -2193,6 +2233,9 @@ void WM_OT_save_mainfile(wmOperatorType *ot)
 	        ot, FILE_TYPE_FOLDER | FILE_TYPE_BLENDER, FILE_BLENDER, FILE_SAVE,
 	        WM_FILESEL_FILEPATH, FILE_DEFAULTDISPLAY, FILE_SORT_ALPHA);
 	RNA_def_boolean(ot->srna, "compress", false, "Compress", "Write compressed .blend file");
+	RNA_def_boolean(ot->srna, "compress_fast", false, "Fast Compression",
+	                "Compress using multiple threads with a faster codec (only used with Compress), "
+	                "larger files that can't be opened by older versions of Blender");
 	RNA_def_boolean(ot->srna, "relative_remap", false, "Remap Relative",
 	                "Remap relative paths when saving in a different directory");
 
@@ -60,6 +60,7 @@
 #include "BKE_image.h"
 
 #include "DEG_depsgraph.h"
+#include "DEG_depsgraph_debug.h"
 
 #ifdef WITH_FFMPEG
 #include "IMB_imbuf.h"
@@ -563,6 +564,7 @@ static int arg_handle_print_help(int UNUSED(argc), const char **UNUSED(argv), vo
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-build");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-tag");
 	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-no-threads");
+	BLI_argsPrintArgDoc(ba, "--debug-depsgraph-profile");
 
 	BLI_argsPrintArgDoc(ba, "--debug-gpumem");
 	BLI_argsPrintArgDoc(ba, "--debug-wm");
@@ -887,7 +889,7 @@ static int arg_handle_debug_mode_generic_set(int UNUSED(argc), const char **UNUS
 }
 
 static const char arg_handle_debug_mode_io_doc[] =
-"\n\tEnable debug messages for I/O (collada, ...).";
+"\n\tEnable debug messages for I/O (collada, .blend load timings, ...).";
 static int arg_handle_debug_mode_io(int UNUSED(argc), const char **UNUSED(argv), void *UNUSED(data))
 {
 	G.debug |= G_DEBUG_IO;
@@ -965,6 +967,23 @@ static int arg_handle_debug_value_set(int argc, const char **argv, void *UNUSED(
 	}
 }
 
+static const char arg_handle_debug_depsgraph_profile_set_doc[] =
+"<filepath>\n"
+"\tRecord evaluation of every dependency graph operation (new dependency graph only),\n"
+"\twrite them to <filepath> in Chrome trace event format on exit and print the slowest operations."
+;
+static int arg_handle_debug_depsgraph_profile_set(int argc, const char **argv, void *UNUSED(data))
+{
+	if (argc > 1) {
+		DEG_debug_profile_begin(argv[1]);
+		return 1;
+	}
+	else {
+		printf("\nError: you must specify a path after '--debug-depsgraph-profile'.\n");
+		return 0;
+	}
+}
+
 static const char arg_handle_debug_fpe_set_doc[] =
 "\n\tEnable floating point exceptions."
 ;
@@ -2002,6 +2021,8 @@ void main_args_setup(bContext *C, bArgs *ba, SYS_SystemHandle *syshandle)
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_no_threads), (void *)G_DEBUG_DEPSGRAPH_NO_THREADS);
 	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-pretty",
 	            CB_EX(arg_handle_debug_mode_generic_set, depsgraph_pretty), (void *)G_DEBUG_DEPSGRAPH_PRETTY);
+	BLI_argsAdd(ba, 1, NULL, "--debug-depsgraph-profile",
+	            CB(arg_handle_debug_depsgraph_profile_set), NULL);
 	BLI_argsAdd(ba, 1, NULL, "--debug-gpumem",
 	            CB_EX(arg_handle_debug_mode_generic_set, gpumem), (void *)G_DEBUG_GPU_MEM);
 
@@ -0,0 +1,116 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BKE_mesh.h"
+#include "DNA_meshdata_types.h"
+#include "PIL_time.h"
+}
+
+#define NUM_RUNS 5
+
+/* Times split normals of grids with autosmooth, the largest one has about 10M loops.
+ * Terraced so that an auto-smooth angle gives sharp edges, and both single loops and smooth fans. */
+
+static void loop_split_bench(const int size, const float split_angle, const bool use_clnors)
+{
+	const int totvert = size * size;
+	const int totedge = 2 * size * (size - 1);
+	const int totpoly = (size - 1) * (size - 1);
+	const int totloop = totpoly * 4;
+
+	MVert *mverts = (MVert *)MEM_callocN(sizeof(MVert) * totvert, __func__);
+	MEdge *medges = (MEdge *)MEM_callocN(sizeof(MEdge) * totedge, __func__);
+	MLoop *mloops = (MLoop *)MEM_mallocN(sizeof(MLoop) * totloop, __func__);
+	MPoly *mpolys = (MPoly *)MEM_callocN(sizeof(MPoly) * totpoly, __func__);
+	float (*polynors)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * totpoly, __func__);
+	float (*loopnors)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * totloop, __func__);
+	short (*clnors)[2] = use_clnors ? (short (*)[2])MEM_callocN(sizeof(short[2]) * totloop, __func__) : NULL;
+	double time_best = 0.0;
+
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size; x++) {
+			MVert *mv = &mverts[y * size + x];
+			mv->co[0] = (float)x;
+			mv->co[1] = (float)y;
+			mv->co[2] = (float)((x / 4) % 2) * 2.0f + sinf((float)y * 0.1f);
+		}
+	}
+	/* Horizontal edges first, then vertical ones. */
+	for (int y = 0; y < size; y++) {
+		for (int x = 0; x < size - 1; x++) {
+			MEdge *me = &medges[y * (size - 1) + x];
+			me->v1 = (unsigned int)(y * size + x);
+			me->v2 = me->v1 + 1;
+			me = &medges[size * (size - 1) + x * size + y];
+			me->v1 = (unsigned int)(x * size + y);
+			me->v2 = me->v1 + (unsigned int)size;
+		}
+	}
+	for (int y = 0, p = 0; y < size - 1; y++) {
+		for (int x = 0; x < size - 1; x++, p++) {
+			MLoop *ml = &mloops[p * 4];
+			mpolys[p].loopstart = p * 4;
+			mpolys[p].totloop = 4;
+			mpolys[p].flag = ME_SMOOTH;
+			ml[0].v = (unsigned int)(y * size + x);
+			ml[0].e = (unsigned int)(y * (size - 1) + x);
+			ml[1].v = ml[0].v + 1;
+			ml[1].e = (unsigned int)(size * (size - 1) + y * size + x + 1);
+			ml[2].v = ml[1].v + (unsigned int)size;
+			ml[2].e = (unsigned int)((y + 1) * (size - 1) + x);
+			ml[3].v = ml[0].v + (unsigned int)size;
+			ml[3].e = (unsigned int)(size * (size - 1) + y * size + x);
+		}
+	}
+
+	BKE_mesh_calc_normals_poly(mverts, NULL, totvert, mloops, mpolys, totloop, totpoly, polynors, false);
+
+	for (int run = 0; run < NUM_RUNS; run++) {
+		MLoopNorSpaceArray lnors_spacearr = {NULL};
+
+		const double time_start = PIL_check_seconds_timer();
+		BKE_mesh_normals_loop_split(
+		        mverts, totvert, medges, totedge, mloops, loopnors, totloop,
+		        mpolys, (const float (*)[3])polynors, totpoly,
+		        true, split_angle, use_clnors ? &lnors_spacearr : NULL, clnors, NULL);
+		const double time = PIL_check_seconds_timer() - time_start;
+
+		if (lnors_spacearr.mem) {
+			BKE_lnor_spacearr_free(&lnors_spacearr);
+		}
+		if (run == 0 || time < time_best) {
+			time_best = time;
+		}
+	}
+
+	printf("%-10d %-10d %-10s %.4f\n", totloop, totpoly, use_clnors ? "yes" : "no", time_best);
+
+	MEM_freeN(mverts);
+	MEM_freeN(medges);
+	MEM_freeN(mloops);
+	MEM_freeN(mpolys);
+	MEM_freeN(polynors);
+	MEM_freeN(loopnors);
+	MEM_SAFE_FREE(clnors);
+}
+
+TEST(mesh_normals, LoopSplitPerformance)
+{
+	BLI_threadapi_init();
+
+	printf("\n========== STARTING LoopSplitNormals ==========\n");
+	printf("Loops      Polys      Custom     Time (sec)\n");
+	loop_split_bench(128, DEG2RADF(30.0f), false);
+	loop_split_bench(512, DEG2RADF(30.0f), false);
+	loop_split_bench(1582, DEG2RADF(30.0f), false);
+	loop_split_bench(1582, (float)M_PI, true);
+	printf("========== ENDED LoopSplitNormals ==========\n\n");
+
+	BLI_threadapi_exit();
+}
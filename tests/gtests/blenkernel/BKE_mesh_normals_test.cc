@@ -0,0 +1,311 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_bitmap.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BKE_mesh.h"
+#include "DNA_meshdata_types.h"
+}
+
+#define GRID_SIZE 64
+#define EPS 1e-5f
+
+/* The task scheduler can't be re-created once freed, share it between all tests. */
+class ThreadAPIEnvironment : public ::testing::Environment {
+public:
+	void SetUp() { BLI_threadapi_init(); }
+	void TearDown() { BLI_threadapi_exit(); }
+};
+
+static ::testing::Environment *const thread_env =
+        ::testing::AddGlobalTestEnvironment(new ThreadAPIEnvironment);
+
+/* Wavy grid of smooth quads, with a few sharp edges so there are both single loops and fans. */
+struct NormalsGrid {
+	MVert *mverts;
+	MEdge *medges;
+	MLoop *mloops;
+	MPoly *mpolys;
+	int totvert, totedge, totloop, totpoly;
+
+	float (*polynors)[3];
+	float (*vertnors)[3];
+	float (*loopnors)[3];
+	short (*clnors)[2];
+	int *loop_to_poly;
+	MLoopNorSpaceArray lnors_spacearr;
+};
+
+static int grid_edge_x(int x, int y)
+{
+	return y * (GRID_SIZE - 1) + x;
+}
+
+static int grid_edge_y(int x, int y)
+{
+	return GRID_SIZE * (GRID_SIZE - 1) + y * GRID_SIZE + x;
+}
+
+static void grid_create(NormalsGrid *grid, const bool use_clnors)
+{
+	memset(grid, 0, sizeof(*grid));
+	grid->totvert = GRID_SIZE * GRID_SIZE;
+	grid->totedge = 2 * GRID_SIZE * (GRID_SIZE - 1);
+	grid->totpoly = (GRID_SIZE - 1) * (GRID_SIZE - 1);
+	grid->totloop = grid->totpoly * 4;
+
+	grid->mverts = (MVert *)MEM_callocN(sizeof(MVert) * grid->totvert, __func__);
+	grid->medges = (MEdge *)MEM_callocN(sizeof(MEdge) * grid->totedge, __func__);
+	grid->mloops = (MLoop *)MEM_callocN(sizeof(MLoop) * grid->totloop, __func__);
+	grid->mpolys = (MPoly *)MEM_callocN(sizeof(MPoly) * grid->totpoly, __func__);
+
+	for (int y = 0; y < GRID_SIZE; y++) {
+		for (int x = 0; x < GRID_SIZE; x++) {
+			MVert *mv = &grid->mverts[y * GRID_SIZE + x];
+			mv->co[0] = (float)x;
+			mv->co[1] = (float)y;
+			mv->co[2] = sinf((float)x * 0.3f) * cosf((float)y * 0.2f) * 2.0f;
+		}
+	}
+	for (int y = 0; y < GRID_SIZE; y++) {
+		for (int x = 0; x < GRID_SIZE - 1; x++) {
+			MEdge *me = &grid->medges[grid_edge_x(x, y)];
+			me->v1 = (unsigned int)(y * GRID_SIZE + x);
+			me->v2 = me->v1 + 1;
+			me = &grid->medges[grid_edge_y(y, x)];
+			me->v1 = (unsigned int)(x * GRID_SIZE + y);
+			me->v2 = me->v1 + GRID_SIZE;
+			if (y % 7 == 3) {
+				me->flag |= ME_SHARP;
+			}
+		}
+	}
+	for (int y = 0, p = 0; y < GRID_SIZE - 1; y++) {
+		for (int x = 0; x < GRID_SIZE - 1; x++, p++) {
+			MPoly *mp = &grid->mpolys[p];
+			MLoop *ml = &grid->mloops[p * 4];
+			mp->loopstart = p * 4;
+			mp->totloop = 4;
+			mp->flag = ME_SMOOTH;
+			ml[0].v = (unsigned int)(y * GRID_SIZE + x);
+			ml[0].e = (unsigned int)grid_edge_x(x, y);
+			ml[1].v = ml[0].v + 1;
+			ml[1].e = (unsigned int)grid_edge_y(x + 1, y);
+			ml[2].v = ml[1].v + GRID_SIZE;
+			ml[2].e = (unsigned int)grid_edge_x(x, y + 1);
+			ml[3].v = ml[0].v + GRID_SIZE;
+			ml[3].e = (unsigned int)grid_edge_y(x, y);
+		}
+	}
+
+	grid->polynors = (float (*)[3])MEM_callocN(sizeof(float[3]) * grid->totpoly, __func__);
+	grid->vertnors = (float (*)[3])MEM_callocN(sizeof(float[3]) * grid->totvert, __func__);
+	grid->loopnors = (float (*)[3])MEM_callocN(sizeof(float[3]) * grid->totloop, __func__);
+	grid->loop_to_poly = (int *)MEM_callocN(sizeof(int) * grid->totloop, __func__);
+	if (use_clnors) {
+		grid->clnors = (short (*)[2])MEM_callocN(sizeof(short[2]) * grid->totloop, __func__);
+		for (int i = 0; i < grid->totloop; i++) {
+			grid->clnors[i][0] = (short)((i * 7919) % 4096);
+			grid->clnors[i][1] = (short)((i * 104729) % 4096);
+		}
+	}
+}
+
+static void grid_free(NormalsGrid *grid)
+{
+	MEM_freeN(grid->mverts);
+	MEM_freeN(grid->medges);
+	MEM_freeN(grid->mloops);
+	MEM_freeN(grid->mpolys);
+	MEM_freeN(grid->polynors);
+	MEM_freeN(grid->vertnors);
+	MEM_freeN(grid->loopnors);
+	MEM_freeN(grid->loop_to_poly);
+	MEM_SAFE_FREE(grid->clnors);
+	if (grid->lnors_spacearr.mem) {
+		BKE_lnor_spacearr_free(&grid->lnors_spacearr);
+	}
+}
+
+static void grid_calc_normals(NormalsGrid *grid, const float split_angle)
+{
+	BKE_mesh_calc_normals_poly(
+	        grid->mverts, grid->vertnors, grid->totvert, grid->mloops, grid->mpolys,
+	        grid->totloop, grid->totpoly, grid->polynors, false);
+	if (grid->lnors_spacearr.mem) {
+		BKE_lnor_spacearr_clear(&grid->lnors_spacearr);
+	}
+	BKE_mesh_normals_loop_split(
+	        grid->mverts, grid->totvert, grid->medges, grid->totedge,
+	        grid->mloops, grid->loopnors, grid->totloop, grid->mpolys,
+	        (const float (*)[3])grid->polynors, grid->totpoly,
+	        true, split_angle, &grid->lnors_spacearr, grid->clnors, grid->loop_to_poly);
+}
+
+/* Move a round region of the grid, tagging moved vertices. */
+static void grid_deform(NormalsGrid *grid, BLI_bitmap *verts_dirty)
+{
+	const float center[2] = {GRID_SIZE * 0.3f, GRID_SIZE * 0.6f};
+	const float radius = GRID_SIZE * 0.15f;
+
+	for (int i = 0; i < grid->totvert; i++) {
+		MVert *mv = &grid->mverts[i];
+		const float dist = len_v2v2(mv->co, center);
+		if (dist < radius) {
+			mv->co[2] += (radius - dist) * 0.5f;
+			mv->co[0] += (radius - dist) * 0.1f;
+			BLI_BITMAP_ENABLE(verts_dirty, i);
+		}
+	}
+}
+
+static void grid_expect_normals_equal(const NormalsGrid *grid_a, const NormalsGrid *grid_b)
+{
+	for (int i = 0; i < grid_a->totpoly; i++) {
+		EXPECT_V3_NEAR(grid_a->polynors[i], grid_b->polynors[i], EPS);
+	}
+	for (int i = 0; i < grid_a->totvert; i++) {
+		EXPECT_V3_NEAR(grid_a->vertnors[i], grid_b->vertnors[i], EPS);
+		EXPECT_EQ(grid_a->mverts[i].no[0], grid_b->mverts[i].no[0]);
+		EXPECT_EQ(grid_a->mverts[i].no[1], grid_b->mverts[i].no[1]);
+		EXPECT_EQ(grid_a->mverts[i].no[2], grid_b->mverts[i].no[2]);
+	}
+	for (int i = 0; i < grid_a->totloop; i++) {
+		EXPECT_V3_NEAR(grid_a->loopnors[i], grid_b->loopnors[i], EPS);
+	}
+}
+
+static void test_partial_matches_full(const bool use_clnors)
+{
+	NormalsGrid grid_partial, grid_full;
+	grid_create(&grid_partial, use_clnors);
+	grid_create(&grid_full, use_clnors);
+
+	grid_calc_normals(&grid_partial, (float)M_PI);
+	/* Custom normals get validated by the full calculation, start from the same ones. */
+	if (use_clnors) {
+		memcpy(grid_full.clnors, grid_partial.clnors, sizeof(short[2]) * grid_full.totloop);
+	}
+
+	BLI_bitmap *verts_dirty = BLI_BITMAP_NEW(grid_partial.totvert, __func__);
+	BLI_bitmap *verts_update = BLI_BITMAP_NEW(grid_partial.totvert, __func__);
+	grid_deform(&grid_partial, verts_dirty);
+	BLI_BITMAP_SET_ALL(verts_dirty, false, grid_full.totvert);
+	grid_deform(&grid_full, verts_dirty);
+
+	BKE_mesh_calc_normals_poly_partial(
+	        grid_partial.mverts, grid_partial.vertnors, grid_partial.totvert,
+	        grid_partial.mloops, grid_partial.mpolys, grid_partial.totloop, grid_partial.totpoly,
+	        grid_partial.polynors, verts_dirty, verts_update);
+	EXPECT_TRUE(BKE_mesh_normals_loop_split_partial(
+	        grid_partial.mverts, grid_partial.medges, grid_partial.mloops, grid_partial.loopnors,
+	        grid_partial.totloop, grid_partial.mpolys, (const float (*)[3])grid_partial.polynors,
+	        true, (float)M_PI, &grid_partial.lnors_spacearr, grid_partial.clnors, grid_partial.loop_to_poly,
+	        verts_update));
+
+	grid_calc_normals(&grid_full, (float)M_PI);
+
+	grid_expect_normals_equal(&grid_partial, &grid_full);
+
+	MEM_freeN(verts_dirty);
+	MEM_freeN(verts_update);
+	grid_free(&grid_partial);
+	grid_free(&grid_full);
+}
+
+TEST(mesh_normals, PartialMatchesFull)
+{
+	test_partial_matches_full(false);
+}
+
+TEST(mesh_normals, PartialMatchesFullCustomNormals)
+{
+	test_partial_matches_full(true);
+}
+
+TEST(mesh_normals, PartialSplitAngle)
+{
+	NormalsGrid grid;
+	grid_create(&grid, false);
+	grid_calc_normals(&grid, DEG2RADF(30.0f));
+
+	BLI_bitmap *verts_update = BLI_BITMAP_NEW(grid.totvert, __func__);
+	BLI_BITMAP_ENABLE(verts_update, 0);
+
+	/* Fans depend on geometry, can't be re-used. */
+	EXPECT_FALSE(BKE_mesh_normals_loop_split_partial(
+	        grid.mverts, grid.medges, grid.mloops, grid.loopnors,
+	        grid.totloop, grid.mpolys, (const float (*)[3])grid.polynors,
+	        true, DEG2RADF(30.0f), &grid.lnors_spacearr, grid.clnors, grid.loop_to_poly,
+	        verts_update));
+
+	MEM_freeN(verts_update);
+	grid_free(&grid);
+}
+
+static bool grid_calc_normals_deform_cached(
+        NormalsGrid *grid, MeshDeformNormalsCache **cache_p, const float split_angle)
+{
+	const bool use_partial = BKE_mesh_calc_normals_deform_cached(
+	        cache_p, grid->mverts, grid->totvert, grid->medges, grid->totedge,
+	        grid->mloops, grid->loopnors, grid->totloop, grid->mpolys, grid->polynors, grid->totpoly,
+	        true, split_angle, grid->clnors);
+	/* Only MVert normals are calculated. */
+	for (int i = 0; i < grid->totvert; i++) {
+		normal_short_to_float_v3(grid->vertnors[i], grid->mverts[i].no);
+	}
+	return use_partial;
+}
+
+static void test_deform_cached_matches_full(const float split_angle)
+{
+	NormalsGrid grid_cached, grid_full;
+	MeshDeformNormalsCache *cache = NULL;
+	grid_create(&grid_cached, false);
+	grid_create(&grid_full, false);
+
+	EXPECT_FALSE(grid_calc_normals_deform_cached(&grid_cached, &cache, split_angle));
+
+	BLI_bitmap *verts_dirty = BLI_BITMAP_NEW(grid_cached.totvert, __func__);
+	grid_deform(&grid_cached, verts_dirty);
+	grid_deform(&grid_full, verts_dirty);
+
+	/* Only the deformed region is updated. */
+	EXPECT_TRUE(grid_calc_normals_deform_cached(&grid_cached, &cache, split_angle));
+	grid_calc_normals(&grid_full, split_angle);
+	for (int i = 0; i < grid_full.totvert; i++) {
+		normal_short_to_float_v3(grid_full.vertnors[i], grid_full.mverts[i].no);
+	}
+	grid_expect_normals_equal(&grid_cached, &grid_full);
+
+	/* Changed smooth flags can't re-use the cache. */
+	grid_cached.mpolys[10].flag &= ~ME_SMOOTH;
+	grid_full.mpolys[10].flag &= ~ME_SMOOTH;
+	EXPECT_FALSE(grid_calc_normals_deform_cached(&grid_cached, &cache, split_angle));
+	grid_calc_normals(&grid_full, split_angle);
+	for (int i = 0; i < grid_full.totvert; i++) {
+		normal_short_to_float_v3(grid_full.vertnors[i], grid_full.mverts[i].no);
+	}
+	grid_expect_normals_equal(&grid_cached, &grid_full);
+
+	BKE_mesh_deform_normals_cache_free(cache);
+	MEM_freeN(verts_dirty);
+	grid_free(&grid_cached);
+	grid_free(&grid_full);
+}
+
+TEST(mesh_normals, DeformCachedMatchesFull)
+{
+	test_deform_cached_matches_full((float)M_PI);
+}
+
+TEST(mesh_normals, DeformCachedSplitAngle)
+{
+	/* Loop normals are fully calculated, vertex and poly normals are still partially updated. */
+	test_deform_cached_matches_full(DEG2RADF(30.0f));
+}
@@ -0,0 +1,114 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_ghash_flat.h"
+#include "BLI_rand.h"
+#include "BLI_string.h"
+}
+
+#define TESTCASE_SIZE 10000
+
+/* Note: for pure-ghash testing, nature of the keys and data have absolutely no importance! So here we just use mere
+ *       random integers stored in pointers. */
+
+static void init_keys(unsigned int keys[TESTCASE_SIZE], const int seed)
+{
+	RNG *rng = BLI_rng_new(seed);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		keys[i] = BLI_rng_get_uint(rng);
+	}
+	BLI_rng_free(rng);
+}
+
+/* Here we simply insert and then lookup all keys, ensuring we do get back the expected stored 'data'. */
+TEST(ghash_flat, InsertLookup)
+{
+	GHashFlat *ghash = BLI_ghash_flat_int_new(__func__);
+	unsigned int keys[TESTCASE_SIZE];
+	unsigned int num_keys = 0;
+
+	init_keys(keys, 0);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		if (BLI_ghash_flat_reinsert(ghash, SET_UINT_IN_POINTER(keys[i]), SET_UINT_IN_POINTER(keys[i]), NULL, NULL)) {
+			num_keys++;
+		}
+	}
+
+	EXPECT_EQ(BLI_ghash_flat_len(ghash), num_keys);
+
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		void *v = BLI_ghash_flat_lookup(ghash, SET_UINT_IN_POINTER(keys[i]));
+		EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i]);
+	}
+
+	BLI_ghash_flat_free(ghash, NULL, NULL);
+}
+
+/* Here we insert and remove keys in turns, so the hash is full of deleted slots. */
+TEST(ghash_flat, InsertRemove)
+{
+	GHashFlat *ghash = BLI_ghash_flat_ptr_new(__func__);
+	unsigned int keys[TESTCASE_SIZE];
+
+	/* Unique keys, multiplication by an odd number is a bijection. */
+	for (int i = 0; i < TESTCASE_SIZE; i++) {
+		keys[i] = (unsigned int)i * 2654435761u;
+	}
+
+	for (int pass = 0; pass < 4; pass++) {
+		for (int i = 0; i < TESTCASE_SIZE; i++) {
+			BLI_ghash_flat_insert(ghash, SET_UINT_IN_POINTER(keys[i]), SET_UINT_IN_POINTER(keys[i]));
+			if (i % 2) {
+				void *v = BLI_ghash_flat_popkey(ghash, SET_UINT_IN_POINTER(keys[i - 1]), NULL);
+				EXPECT_EQ(GET_UINT_FROM_POINTER(v), keys[i - 1]);
+			}
+		}
+		for (int i = 1; i < TESTCASE_SIZE; i += 2) {
+			EXPECT_TRUE(BLI_ghash_flat_remove(ghash, SET_UINT_IN_POINTER(keys[i]), NULL, NULL));
+		}
+		EXPECT_EQ(BLI_ghash_flat_len(ghash), 0);
+	}
+
+	BLI_ghash_flat_free(ghash, NULL, NULL);
+}
+
+/* Check ensure_p and iteration. */
+TEST(ghash_flat, EnsureIter)
+{
+	GHashFlat *ghash = BLI_ghash_flat_str_new(__func__);
+	char *keys[TESTCASE_SIZE / 10];
+
+	for (int i = 0; i < ARRAY_SIZE(keys); i++) {
+		keys[i] = BLI_sprintfN("key_%d", i);
+		void **val_p;
+		EXPECT_FALSE(BLI_ghash_flat_ensure_p(ghash, keys[i], &val_p));
+		*val_p = SET_INT_IN_POINTER(i);
+	}
+
+	for (int i = 0; i < ARRAY_SIZE(keys); i++) {
+		char key[32];
+		BLI_snprintf(key, sizeof(key), "key_%d", i);
+		void **val_p;
+		EXPECT_TRUE(BLI_ghash_flat_ensure_p(ghash, key, &val_p));
+		EXPECT_EQ(GET_INT_FROM_POINTER(*val_p), i);
+	}
+
+	int num_iter = 0, sum_iter = 0;
+	GHashFlatIterator ghi;
+	GHASH_FLAT_ITER (ghi, ghash) {
+		const int i = GET_INT_FROM_POINTER(BLI_ghash_flatIterator_getValue(&ghi));
+		EXPECT_STREQ((const char *)BLI_ghash_flatIterator_getKey(&ghi), keys[i]);
+		num_iter++;
+		sum_iter += i;
+	}
+	EXPECT_EQ(num_iter, ARRAY_SIZE(keys));
+	EXPECT_EQ(sum_iter, (ARRAY_SIZE(keys) * (ARRAY_SIZE(keys) - 1)) / 2);
+
+	BLI_ghash_flat_free(ghash, MEM_freeN, NULL);
+}
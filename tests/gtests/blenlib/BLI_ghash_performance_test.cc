@@ -9,7 +9,9 @@ extern "C" {
 #include "MEM_guardedalloc.h"
 #include "BLI_utildefines.h"
 #include "BLI_ghash.h"
+#include "BLI_ghash_flat.h"
 #include "BLI_rand.h"
+#include "BLI_array_utils.h"
 #include "BLI_string.h"
 #include "PIL_time_utildefines.h"
 }
@@ -534,3 +536,284 @@ TEST(ghash, MultiRandIntMurmur2a200000)
 
 	multi_small_ghash_tests(ghash, "MultiSmall RandIntGHash - Murmur2a - 200000", 200000);
 }
+
+
+/* GHashFlat: same as some of above tests, comparing open-addressing hash against GHash. */
+
+static void str_ghash_flat_tests(GHashFlat *ghash, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	char *data = BLI_strdup(words10k);
+	char *data_bis = BLI_strdup(words10k);
+
+	{
+		char *w, *c;
+
+		TIMEIT_START(string_insert);
+
+		for (w = c = data; *c; c++) {
+			if (ELEM(*c, '.', ' ')) {
+				*c = '\0';
+				void **val_p;
+				if (!BLI_ghash_flat_ensure_p(ghash, w, &val_p)) {
+					*val_p = SET_INT_IN_POINTER(w[0]);
+				}
+				w = c + 1;
+			}
+		}
+
+		TIMEIT_END(string_insert);
+	}
+
+	printf("GHashFlat: %u entries\n", BLI_ghash_flat_len(ghash));
+
+	{
+		char *w, *c;
+		void *v;
+
+		TIMEIT_START(string_lookup);
+
+		for (w = c = data_bis; *c; c++) {
+			if (ELEM(*c, '.', ' ')) {
+				*c = '\0';
+				v = BLI_ghash_flat_lookup(ghash, w);
+				EXPECT_EQ(GET_INT_FROM_POINTER(v), w[0]);
+				w = c + 1;
+			}
+		}
+
+		TIMEIT_END(string_lookup);
+	}
+
+	BLI_ghash_flat_free(ghash, NULL, NULL);
+	MEM_freeN(data);
+	MEM_freeN(data_bis);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, TextFlat)
+{
+	GHashFlat *ghash = BLI_ghash_flat_str_new(__func__);
+
+	str_ghash_flat_tests(ghash, "StrGHashFlat - Specialized");
+}
+
+TEST(ghash, TextFlatGeneric)
+{
+	GHashFlat *ghash = BLI_ghash_flat_new(BLI_ghashutil_strhash_p, BLI_ghashutil_strcmp, __func__);
+
+	str_ghash_flat_tests(ghash, "StrGHashFlat - Generic");
+}
+
+static void int_ghash_flat_tests(GHashFlat *ghash, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_insert);
+
+#ifdef GHASH_RESERVE
+		BLI_ghash_flat_reserve(ghash, nbr);
+#endif
+
+		while (i--) {
+			BLI_ghash_flat_insert(ghash, SET_UINT_IN_POINTER(i), SET_UINT_IN_POINTER(i));
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_lookup);
+
+		while (i--) {
+			void *v = BLI_ghash_flat_lookup(ghash, SET_UINT_IN_POINTER(i));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	{
+		unsigned int i = nbr;
+
+		TIMEIT_START(int_remove);
+
+		while (i--) {
+			void *v = BLI_ghash_flat_popkey(ghash, SET_UINT_IN_POINTER(i), NULL);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), i);
+		}
+
+		TIMEIT_END(int_remove);
+	}
+	EXPECT_EQ(BLI_ghash_flat_len(ghash), 0);
+
+	BLI_ghash_flat_free(ghash, NULL, NULL);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntFlat12000)
+{
+	GHashFlat *ghash = BLI_ghash_flat_int_new(__func__);
+
+	int_ghash_flat_tests(ghash, "IntGHashFlat - Specialized - 12000", 12000);
+}
+
+TEST(ghash, IntFlatGeneric12000)
+{
+	GHashFlat *ghash = BLI_ghash_flat_new(BLI_ghashutil_inthash_p, BLI_ghashutil_intcmp, __func__);
+
+	int_ghash_flat_tests(ghash, "IntGHashFlat - Generic - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntFlat100000000)
+{
+	GHashFlat *ghash = BLI_ghash_flat_int_new(__func__);
+
+	int_ghash_flat_tests(ghash, "IntGHashFlat - Specialized - 100000000", 100000000);
+}
+#endif
+
+static void randint_ghash_flat_tests(GHashFlat *ghash, const char *id, const unsigned int nbr)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	unsigned int *data = (unsigned int *)MEM_mallocN(sizeof(*data) * (size_t)nbr, __func__);
+	unsigned int *dt;
+	unsigned int i;
+
+	{
+		RNG *rng = BLI_rng_new(0);
+		for (i = nbr, dt = data; i--; dt++) {
+			*dt = BLI_rng_get_uint(rng);
+		}
+		BLI_rng_free(rng);
+	}
+
+	{
+		TIMEIT_START(int_insert);
+
+#ifdef GHASH_RESERVE
+		BLI_ghash_flat_reserve(ghash, nbr);
+#endif
+
+		for (i = nbr, dt = data; i--; dt++) {
+			BLI_ghash_flat_reinsert(ghash, SET_UINT_IN_POINTER(*dt), SET_UINT_IN_POINTER(*dt), NULL, NULL);
+		}
+
+		TIMEIT_END(int_insert);
+	}
+
+	{
+		TIMEIT_START(int_lookup);
+
+		for (i = nbr, dt = data; i--; dt++) {
+			void *v = BLI_ghash_flat_lookup(ghash, SET_UINT_IN_POINTER(*dt));
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), *dt);
+		}
+
+		TIMEIT_END(int_lookup);
+	}
+
+	BLI_ghash_flat_free(ghash, NULL, NULL);
+	MEM_freeN(data);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, IntRandFlat12000)
+{
+	GHashFlat *ghash = BLI_ghash_flat_int_new(__func__);
+
+	randint_ghash_flat_tests(ghash, "RandIntGHashFlat - Specialized - 12000", 12000);
+}
+
+#ifdef GHASH_RUN_BIG
+TEST(ghash, IntRandFlat50000000)
+{
+	GHashFlat *ghash = BLI_ghash_flat_int_new(__func__);
+
+	randint_ghash_flat_tests(ghash, "RandIntGHashFlat - Specialized - 50000000", 50000000);
+}
+#endif
+
+/* Ptr: pointers to allocated elements, typical for ID and BMesh element maps. */
+
+#define PTR_TESTCASE_SIZE 1000000
+
+static void ptr_ghash_tests(GHash *ghash, GHashFlat *ghash_flat, const char *id)
+{
+	printf("\n========== STARTING %s ==========\n", id);
+
+	const unsigned int nbr = PTR_TESTCASE_SIZE;
+	/* Use a single block, like mempool chunks would. */
+	char *data = (char *)MEM_mallocN(sizeof(*data) * 32 * (size_t)nbr, __func__);
+	/* Lookups happen in random order. */
+	unsigned int *order = (unsigned int *)MEM_mallocN(sizeof(*order) * (size_t)nbr, __func__);
+	unsigned int i;
+
+	for (i = 0; i < nbr; i++) {
+		order[i] = i;
+	}
+	BLI_array_randomize(order, sizeof(*order), nbr, 0);
+
+	if (ghash) {
+		TIMEIT_START(ptr_insert);
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_insert(ghash, &data[i * 32], SET_UINT_IN_POINTER(i));
+		}
+		TIMEIT_END(ptr_insert);
+
+		TIMEIT_START(ptr_lookup);
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ghash_lookup(ghash, &data[order[i] * 32]);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), order[i]);
+		}
+		TIMEIT_END(ptr_lookup);
+
+		BLI_ghash_free(ghash, NULL, NULL);
+	}
+	else {
+		TIMEIT_START(ptr_insert);
+		for (i = 0; i < nbr; i++) {
+			BLI_ghash_flat_insert(ghash_flat, &data[i * 32], SET_UINT_IN_POINTER(i));
+		}
+		TIMEIT_END(ptr_insert);
+
+		TIMEIT_START(ptr_lookup);
+		for (i = 0; i < nbr; i++) {
+			void *v = BLI_ghash_flat_lookup(ghash_flat, &data[order[i] * 32]);
+			EXPECT_EQ(GET_UINT_FROM_POINTER(v), order[i]);
+		}
+		TIMEIT_END(ptr_lookup);
+
+		BLI_ghash_flat_free(ghash_flat, NULL, NULL);
+	}
+
+	MEM_freeN(data);
+	MEM_freeN(order);
+
+	printf("========== ENDED %s ==========\n\n", id);
+}
+
+TEST(ghash, PtrGHash)
+{
+	GHash *ghash = BLI_ghash_ptr_new(__func__);
+
+	ptr_ghash_tests(ghash, NULL, "PtrGHash - GHash");
+}
+
+TEST(ghash, PtrFlat)
+{
+	GHashFlat *ghash = BLI_ghash_flat_ptr_new(__func__);
+
+	ptr_ghash_tests(NULL, ghash, "PtrGHash - GHashFlat");
+}
@@ -0,0 +1,97 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_kdtree.h"
+#include "BLI_rand.h"
+#include "BLI_utildefines.h"
+#include "PIL_time_utildefines.h"
+}
+
+/* Run the longest tests! */
+//#define KDTREE_RUN_BIG
+
+#ifdef KDTREE_RUN_BIG
+#  define POINTS_LEN 10000000
+#else
+#  define POINTS_LEN 1000000
+#endif
+
+/* Compares single point queries with the (threaded) batch queries. */
+
+static void rng_points(float (*points)[3], int points_len, struct RNG *rng)
+{
+	for (int i = 0; i < points_len; i++) {
+		for (int j = 0; j < 3; j++) {
+			points[i][j] = BLI_rng_get_float(rng);
+		}
+	}
+}
+
+TEST(kdtree, BatchQueries)
+{
+	printf("\n========== STARTING BatchQueries ==========\n");
+
+	struct RNG *rng = BLI_rng_new(0);
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * POINTS_LEN, __func__);
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * POINTS_LEN, __func__);
+	KDTreeNearest *nearest = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * POINTS_LEN, __func__);
+	rng_points(points, POINTS_LEN, rng);
+	rng_points(co, POINTS_LEN, rng);
+
+	KDTree *tree = BLI_kdtree_new(POINTS_LEN);
+	for (int i = 0; i < POINTS_LEN; i++) {
+		BLI_kdtree_insert(tree, i, points[i]);
+	}
+
+	TIMEIT_START(kdtree_balance);
+	BLI_kdtree_balance(tree);
+	TIMEIT_END(kdtree_balance);
+
+	TIMEIT_START(kdtree_find_nearest);
+	for (int i = 0; i < POINTS_LEN; i++) {
+		BLI_kdtree_find_nearest(tree, co[i], &nearest[i]);
+	}
+	TIMEIT_END(kdtree_find_nearest);
+
+	TIMEIT_START(kdtree_find_nearest_batch);
+	BLI_kdtree_find_nearest_batch(tree, co, POINTS_LEN, nearest);
+	TIMEIT_END(kdtree_find_nearest_batch);
+
+	/* around 4 points in range */
+	const float range = 0.01f;
+
+	TIMEIT_START(kdtree_range_search);
+	for (int i = 0; i < POINTS_LEN; i++) {
+		KDTreeNearest *nearest_range;
+		if (BLI_kdtree_range_search(tree, co[i], &nearest_range, range)) {
+			MEM_freeN(nearest_range);
+		}
+	}
+	TIMEIT_END(kdtree_range_search);
+
+	KDTreeNearest **nearest_range = (KDTreeNearest **)MEM_mallocN(sizeof(*nearest_range) * POINTS_LEN, __func__);
+	int *nearest_range_len = (int *)MEM_mallocN(sizeof(*nearest_range_len) * POINTS_LEN, __func__);
+
+	TIMEIT_START(kdtree_range_search_batch);
+	BLI_kdtree_range_search_batch(tree, co, POINTS_LEN, range, nearest_range, nearest_range_len);
+	TIMEIT_END(kdtree_range_search_batch);
+
+	for (int i = 0; i < POINTS_LEN; i++) {
+		if (nearest_range[i]) {
+			MEM_freeN(nearest_range[i]);
+		}
+	}
+
+	MEM_freeN(nearest_range);
+	MEM_freeN(nearest_range_len);
+	BLI_kdtree_free(tree);
+	MEM_freeN(nearest);
+	MEM_freeN(co);
+	MEM_freeN(points);
+	BLI_rng_free(rng);
+
+	printf("========== ENDED BatchQueries ==========\n\n");
+}
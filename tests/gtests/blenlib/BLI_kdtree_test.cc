@@ -0,0 +1,171 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "BLI_compiler_attrs.h"
+#include "BLI_kdtree.h"
+#include "BLI_rand.h"
+#include "BLI_math_vector.h"
+#include "BLI_utildefines.h"
+#include "MEM_guardedalloc.h"
+}
+
+/* -------------------------------------------------------------------- */
+/* Helper Functions */
+
+static KDTree *kdtree_random_new(
+        float (**r_points)[3], int points_len,
+        struct RNG *rng, int round)
+{
+	KDTree *tree = BLI_kdtree_new(points_len);
+	float (*points)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * points_len, __func__);
+
+	for (int i = 0; i < points_len; i++) {
+		for (int j = 0; j < 3; j++) {
+			/* rounding gives many points with equal coordinates */
+			const float f = BLI_rng_get_float(rng) * 2.0f - 1.0f;
+			points[i][j] = round ? ((float)((int)(f * round)) / (float)round) : f;
+		}
+		BLI_kdtree_insert(tree, i, points[i]);
+	}
+	BLI_kdtree_balance(tree);
+
+	*r_points = points;
+	return tree;
+}
+
+static void rng_points(float (*points)[3], int points_len, struct RNG *rng)
+{
+	for (int i = 0; i < points_len; i++) {
+		for (int j = 0; j < 3; j++) {
+			points[i][j] = BLI_rng_get_float(rng) * 2.4f - 1.2f;
+		}
+	}
+}
+
+static int cmp_nearest_index(const void *a, const void *b)
+{
+	const int index_a = ((const KDTreeNearest *)a)->index;
+	const int index_b = ((const KDTreeNearest *)b)->index;
+	return (index_a > index_b) - (index_a < index_b);
+}
+
+/* -------------------------------------------------------------------- */
+/* Tests */
+
+TEST(kdtree, Empty)
+{
+	KDTree *tree = BLI_kdtree_new(0);
+	BLI_kdtree_balance(tree);
+
+	const float co[1][3] = {{0.0f, 0.0f, 0.0f}};
+	KDTreeNearest nearest;
+	BLI_kdtree_find_nearest_batch(tree, co, 1, &nearest);
+	EXPECT_EQ(-1, nearest.index);
+
+	KDTreeNearest *nearest_range;
+	int nearest_range_len;
+	BLI_kdtree_range_search_batch(tree, co, 1, 1.0f, &nearest_range, &nearest_range_len);
+	EXPECT_EQ(0, nearest_range_len);
+	EXPECT_EQ(NULL, nearest_range);
+
+	BLI_kdtree_free(tree);
+}
+
+/**
+ * Compare the batch nearest search with a brute force search
+ * (large trees are balanced in parallel).
+ */
+static void find_nearest_batch_test(int points_len, int round, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	float (*points)[3];
+	KDTree *tree = kdtree_random_new(&points, points_len, rng, round);
+
+	const int co_len = 1000;
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * co_len, __func__);
+	rng_points(co, co_len, rng);
+
+	KDTreeNearest *nearest = (KDTreeNearest *)MEM_mallocN(sizeof(*nearest) * co_len, __func__);
+	BLI_kdtree_find_nearest_batch(tree, co, co_len, nearest);
+
+	for (int i = 0; i < co_len; i++) {
+		float dist_sq_best = FLT_MAX;
+		for (int j = 0; j < points_len; j++) {
+			dist_sq_best = min_ff(dist_sq_best, len_squared_v3v3(co[i], points[j]));
+		}
+		ASSERT_GE(nearest[i].index, 0);
+		ASSERT_LT(nearest[i].index, points_len);
+		EXPECT_EQ_ARRAY(points[nearest[i].index], nearest[i].co, 3);
+		EXPECT_FLOAT_EQ(len_squared_v3v3(co[i], points[nearest[i].index]), dist_sq_best);
+
+		KDTreeNearest nearest_single;
+		BLI_kdtree_find_nearest(tree, co[i], &nearest_single);
+		EXPECT_FLOAT_EQ(nearest_single.dist, nearest[i].dist);
+	}
+
+	MEM_freeN(nearest);
+	MEM_freeN(co);
+	MEM_freeN(points);
+	BLI_kdtree_free(tree);
+	BLI_rng_free(rng);
+}
+
+TEST(kdtree, FindNearestBatch_1)        { find_nearest_batch_test(1, 0, 1234); }
+TEST(kdtree, FindNearestBatch_7)        { find_nearest_batch_test(7, 0, 123); }
+TEST(kdtree, FindNearestBatch_500)      { find_nearest_batch_test(500, 0, 12); }
+TEST(kdtree, FindNearestBatch_500_Round)    { find_nearest_batch_test(500, 10, 12); }
+TEST(kdtree, FindNearestBatch_20000)    { find_nearest_batch_test(20000, 0, 1); }
+TEST(kdtree, FindNearestBatch_20000_Round)  { find_nearest_batch_test(20000, 10, 2); }
+
+/**
+ * The batch range search must find the same nodes as #BLI_kdtree_range_search.
+ */
+static void range_search_batch_test(int points_len, int round, float range, int random_seed)
+{
+	struct RNG *rng = BLI_rng_new(random_seed);
+	float (*points)[3];
+	KDTree *tree = kdtree_random_new(&points, points_len, rng, round);
+
+	const int co_len = 500;
+	float (*co)[3] = (float (*)[3])MEM_mallocN(sizeof(float[3]) * co_len, __func__);
+	rng_points(co, co_len, rng);
+
+	KDTreeNearest **nearest = (KDTreeNearest **)MEM_mallocN(sizeof(*nearest) * co_len, __func__);
+	int *nearest_len = (int *)MEM_mallocN(sizeof(*nearest_len) * co_len, __func__);
+	BLI_kdtree_range_search_batch(tree, co, co_len, range, nearest, nearest_len);
+
+	for (int i = 0; i < co_len; i++) {
+		KDTreeNearest *nearest_single;
+		const int nearest_single_len = BLI_kdtree_range_search(tree, co[i], &nearest_single, range);
+		ASSERT_EQ(nearest_single_len, nearest_len[i]);
+
+		for (int j = 1; j < nearest_len[i]; j++) {
+			EXPECT_LE(nearest[i][j - 1].dist, nearest[i][j].dist);
+		}
+
+		if (nearest_len[i]) {
+			qsort(nearest[i], nearest_len[i], sizeof(KDTreeNearest), cmp_nearest_index);
+			qsort(nearest_single, nearest_single_len, sizeof(KDTreeNearest), cmp_nearest_index);
+			for (int j = 0; j < nearest_len[i]; j++) {
+				EXPECT_EQ(nearest_single[j].index, nearest[i][j].index);
+				EXPECT_FLOAT_EQ(nearest_single[j].dist, nearest[i][j].dist);
+			}
+			MEM_freeN(nearest[i]);
+			MEM_freeN(nearest_single);
+		}
+	}
+
+	MEM_freeN(nearest);
+	MEM_freeN(nearest_len);
+	MEM_freeN(co);
+	MEM_freeN(points);
+	BLI_kdtree_free(tree);
+	BLI_rng_free(rng);
+}
+
+TEST(kdtree, RangeSearchBatch_7)        { range_search_batch_test(7, 0, 1.0f, 123); }
+TEST(kdtree, RangeSearchBatch_500)      { range_search_batch_test(500, 0, 0.2f, 12); }
+TEST(kdtree, RangeSearchBatch_20000)    { range_search_batch_test(20000, 0, 0.1f, 1); }
+TEST(kdtree, RangeSearchBatch_20000_Round)  { range_search_batch_test(20000, 10, 0.1f, 2); }
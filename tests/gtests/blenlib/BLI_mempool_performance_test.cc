@@ -0,0 +1,124 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* Run the longest tests! */
+//#define MEMPOOL_RUN_BIG
+
+#ifdef MEMPOOL_RUN_BIG
+#  define NUM_RUNS 10
+#  define NUM_ITER 2000
+#else
+#  define NUM_RUNS 3
+#  define NUM_ITER 200
+#endif
+
+/* Number of elements every task keeps alive at once. */
+#define NUM_LIVE 1024
+#define ELEM_SIZE 64
+
+/* Throughput of concurrent alloc/free, every task allocates a set of
+ * elements, then frees them again (in a different order), many times.
+ *
+ * Compares a mempool behind a single lock with the per-thread caches. */
+
+typedef struct MempoolBenchData {
+	BLI_mempool *mempool;
+	ThreadMutex mutex;
+	bool use_thread_cache;
+} MempoolBenchData;
+
+static void mempool_bench_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int thread_id)
+{
+	MempoolBenchData *data = (MempoolBenchData *)BLI_task_pool_userdata(pool);
+	void **elems = (void **)MEM_mallocN(sizeof(*elems) * NUM_LIVE, __func__);
+
+	for (int iter = 0; iter < NUM_ITER; iter++) {
+		if (data->use_thread_cache) {
+			for (int i = 0; i < NUM_LIVE; i++) {
+				elems[i] = BLI_mempool_alloc_thread(data->mempool, thread_id);
+			}
+			for (int i = 0; i < NUM_LIVE; i++) {
+				BLI_mempool_free_thread(data->mempool, elems[(i * 7) % NUM_LIVE], thread_id);
+			}
+		}
+		else {
+			for (int i = 0; i < NUM_LIVE; i++) {
+				BLI_mutex_lock(&data->mutex);
+				elems[i] = BLI_mempool_alloc(data->mempool);
+				BLI_mutex_unlock(&data->mutex);
+			}
+			for (int i = 0; i < NUM_LIVE; i++) {
+				BLI_mutex_lock(&data->mutex);
+				BLI_mempool_free(data->mempool, elems[(i * 7) % NUM_LIVE]);
+				BLI_mutex_unlock(&data->mutex);
+			}
+		}
+	}
+
+	MEM_freeN(elems);
+}
+
+static double mempool_bench_throughput(TaskScheduler *scheduler, const bool use_thread_cache)
+{
+	const int num_tasks = BLI_task_scheduler_num_threads(scheduler);
+	double best_time = 0.0;
+
+	for (int run = 0; run < NUM_RUNS; run++) {
+		MempoolBenchData data;
+		data.mempool = BLI_mempool_create(ELEM_SIZE, 0, 512, BLI_MEMPOOL_ALLOW_ITER);
+		data.use_thread_cache = use_thread_cache;
+		BLI_mutex_init(&data.mutex);
+		if (use_thread_cache) {
+			BLI_mempool_thread_cache_init(data.mempool, num_tasks);
+		}
+
+		TaskPool *pool = BLI_task_pool_create(scheduler, &data);
+
+		const double start_time = PIL_check_seconds_timer();
+
+		for (int i = 0; i < num_tasks; i++) {
+			BLI_task_pool_push(pool, mempool_bench_func, NULL, false, TASK_PRIORITY_HIGH);
+		}
+		BLI_task_pool_work_and_wait(pool);
+
+		const double time = PIL_check_seconds_timer() - start_time;
+		if (run == 0 || time < best_time) {
+			best_time = time;
+		}
+
+		BLI_task_pool_free(pool);
+		EXPECT_EQ(BLI_mempool_len(data.mempool), 0);
+		BLI_mutex_end(&data.mutex);
+		BLI_mempool_destroy(data.mempool);
+	}
+
+	/* One alloc and one free per operation. */
+	return (double)num_tasks * NUM_ITER * NUM_LIVE / best_time;
+}
+
+TEST(mempool, ThreadCacheScaling)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 2);
+
+	printf("\n========== STARTING ThreadCacheScaling ==========\n");
+	printf("Threads    Locked ops/sec  Cached ops/sec  Speedup\n");
+	for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+		const double throughput_locked = mempool_bench_throughput(scheduler, false);
+		const double throughput_cached = mempool_bench_throughput(scheduler, true);
+		printf("%-10d %-15.0f %-15.0f %.2f\n",
+		       num_threads, throughput_locked, throughput_cached, throughput_cached / throughput_locked);
+		BLI_task_scheduler_free(scheduler);
+	}
+	printf("========== ENDED ThreadCacheScaling ==========\n\n");
+}
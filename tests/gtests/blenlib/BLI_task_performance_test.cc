@@ -0,0 +1,146 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include "atomic_ops.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "PIL_time.h"
+}
+
+/* Run the longest tests! */
+//#define TASK_RUN_BIG
+
+#ifdef TASK_RUN_BIG
+#  define NUM_RUNS 10
+#  define TREE_DEPTH 13
+#else
+#  define NUM_RUNS 3
+#  define TREE_DEPTH 10
+#endif
+
+#define TREE_FANOUT 3
+/* Amount of dummy work done by every task. */
+#define TASK_WORK_SIZE 256
+
+/* Scaling of task throughput with the number of threads.
+ *
+ * Every task spawns children, so most of the tasks go through the local
+ * queues of worker threads and are distributed by stealing. */
+
+typedef struct TaskTreeData {
+	int depth;
+} TaskTreeData;
+
+static void task_tree_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	TaskTreeData *data = (TaskTreeData *)taskdata;
+	int *num_done = (int *)BLI_task_pool_userdata(pool);
+
+	volatile float value = 0.0f;
+	for (int i = 0; i < TASK_WORK_SIZE; i++) {
+		value += (float)i;
+	}
+
+	atomic_add_and_fetch_int32(num_done, 1);
+
+	if (data->depth < TREE_DEPTH) {
+		for (int i = 0; i < TREE_FANOUT; i++) {
+			TaskTreeData *child = (TaskTreeData *)MEM_mallocN(sizeof(*child), __func__);
+			child->depth = data->depth + 1;
+			BLI_task_pool_push_from_thread(pool, task_tree_func, child, true, TASK_PRIORITY_LOW, thread_id);
+		}
+	}
+}
+
+static double task_tree_throughput(TaskScheduler *scheduler)
+{
+	double best_time = 0.0;
+	int num_done = 0;
+
+	for (int run = 0; run < NUM_RUNS; run++) {
+		TaskPool *pool = BLI_task_pool_create(scheduler, &num_done);
+		num_done = 0;
+
+		const double start_time = PIL_check_seconds_timer();
+
+		TaskTreeData *root = (TaskTreeData *)MEM_mallocN(sizeof(*root), __func__);
+		root->depth = 0;
+		BLI_task_pool_push(pool, task_tree_func, root, true, TASK_PRIORITY_HIGH);
+		BLI_task_pool_work_and_wait(pool);
+
+		const double time = PIL_check_seconds_timer() - start_time;
+		if (run == 0 || time < best_time) {
+			best_time = time;
+		}
+
+		BLI_task_pool_free(pool);
+	}
+
+	return (double)num_done / best_time;
+}
+
+/* Scaling of BLI_task_parallel_range() with the number of threads. */
+
+static void task_parallel_range_func(void *userdata, const int index, const ParallelRangeTLS *__restrict UNUSED(tls))
+{
+	float *data = (float *)userdata;
+	float value = 0.0f;
+	for (int i = 0; i < TASK_WORK_SIZE; i++) {
+		value += (float)(i ^ index);
+	}
+	data[index] = value;
+}
+
+TEST(task, TreeScaling)
+{
+	const int max_threads = MAX2(BLI_system_thread_count(), 2);
+	double single_thread_throughput = 0.0;
+
+	printf("\n========== STARTING TreeScaling ==========\n");
+	printf("Threads    Tasks/sec       Speedup\n");
+	for (int num_threads = 1; num_threads <= max_threads; num_threads *= 2) {
+		TaskScheduler *scheduler = BLI_task_scheduler_create(num_threads);
+		const double throughput = task_tree_throughput(scheduler);
+		if (num_threads == 1) {
+			single_thread_throughput = throughput;
+		}
+		printf("%-10d %-15.0f %.2f\n", num_threads, throughput, throughput / single_thread_throughput);
+		BLI_task_scheduler_free(scheduler);
+	}
+	printf("========== ENDED TreeScaling ==========\n\n");
+}
+
+TEST(task, ParallelRangeScaling)
+{
+	const int num_items = 1000000;
+	float *data = (float *)MEM_mallocN(sizeof(*data) * num_items, __func__);
+
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+	printf("\n========== STARTING ParallelRangeScaling ==========\n");
+	/* Global scheduler is used by parallel range, so only compare against
+	 * non-threaded execution here. */
+	for (int use_threading = 0; use_threading < 2; use_threading++) {
+		settings.use_threading = (use_threading != 0);
+		double best_time = 0.0;
+		for (int run = 0; run < NUM_RUNS; run++) {
+			const double start_time = PIL_check_seconds_timer();
+			BLI_task_parallel_range(0, num_items, data, task_parallel_range_func, &settings);
+			const double time = PIL_check_seconds_timer() - start_time;
+			if (run == 0 || time < best_time) {
+				best_time = time;
+			}
+		}
+		printf("Threading %s: %.0f items/sec\n", use_threading ? "on " : "off", (double)num_items / best_time);
+	}
+	printf("========== ENDED ParallelRangeScaling ==========\n\n");
+
+	MEM_freeN(data);
+}
@@ -6,6 +6,7 @@
 #include "atomic_ops.h"
 
 extern "C" {
+#include "MEM_guardedalloc.h"
 #include "BLI_mempool.h"
 #include "BLI_task.h"
 #include "BLI_utildefines.h"
@@ -74,3 +75,183 @@ TEST(task, MempoolIter)
 
 	BLI_mempool_destroy(mempool);
 }
+
+/* Allocate and free from all threads through the thread caches,
+ * freeing from other threads than the one which allocated. */
+
+typedef struct MempoolThreadCacheData {
+	BLI_mempool *mempool;
+	int **data;
+} MempoolThreadCacheData;
+
+static void task_mempool_alloc_func(void *__restrict userdata,
+                                    const int index,
+                                    const ParallelRangeTLS *__restrict tls)
+{
+	MempoolThreadCacheData *data = (MempoolThreadCacheData *)userdata;
+	data->data[index] = (int *)BLI_mempool_alloc_thread(data->mempool, tls->thread_id);
+	*data->data[index] = index;
+}
+
+static void task_mempool_free_func(void *__restrict userdata,
+                                   const int index,
+                                   const ParallelRangeTLS *__restrict tls)
+{
+	MempoolThreadCacheData *data = (MempoolThreadCacheData *)userdata;
+	/* Free in a different order than allocated. */
+	const int index_free = (int)(((unsigned int)index * 7919u) % NUM_ITEMS);
+	if (index_free % 3 == 0) {
+		BLI_mempool_free_thread(data->mempool, data->data[index_free], tls->thread_id);
+		data->data[index_free] = NULL;
+	}
+}
+
+TEST(task, MempoolThreadCache)
+{
+	int *data[NUM_ITEMS];
+	BLI_mempool *mempool = BLI_mempool_create(sizeof(*data[0]), 0, 32, BLI_MEMPOOL_ALLOW_ITER);
+	BLI_mempool_thread_cache_init(mempool, BLI_task_scheduler_num_threads(BLI_task_scheduler_get()));
+
+	MempoolThreadCacheData userdata = {mempool, data};
+	ParallelRangeSettings settings;
+	BLI_parallel_range_settings_defaults(&settings);
+	settings.scheduling_mode = TASK_SCHEDULING_DYNAMIC;
+
+	BLI_task_parallel_range(0, NUM_ITEMS, &userdata, task_mempool_alloc_func, &settings);
+	EXPECT_EQ(BLI_mempool_len(mempool), NUM_ITEMS);
+
+	BLI_task_parallel_range(0, NUM_ITEMS, &userdata, task_mempool_free_func, &settings);
+
+	/* Iteration sees every allocated element, and nothing held by the caches. */
+	int num_items = 0;
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		if (data[i] != NULL) {
+			EXPECT_EQ(*data[i], i);
+			*data[i] = -1;
+			num_items++;
+		}
+	}
+	EXPECT_EQ(BLI_mempool_len(mempool), num_items);
+
+	BLI_mempool_iter iter;
+	int *elem;
+	int num_iter = 0;
+	BLI_mempool_iternew(mempool, &iter);
+	while ((elem = (int *)BLI_mempool_iterstep(&iter))) {
+		EXPECT_EQ(*elem, -1);
+		num_iter++;
+	}
+	EXPECT_EQ(num_iter, num_items);
+
+	BLI_mempool_thread_cache_flush(mempool);
+	EXPECT_EQ(BLI_mempool_len(mempool), num_items);
+
+	for (int i = 0; i < NUM_ITEMS; i++) {
+		if (data[i] != NULL) {
+			BLI_mempool_free(mempool, data[i]);
+		}
+	}
+	EXPECT_EQ(BLI_mempool_len(mempool), 0);
+
+	BLI_mempool_destroy(mempool);
+}
+
+/* Each task spawns children until given depth is reached, so most of the
+ * tasks are pushed to local queues of worker threads and are to be stolen
+ * by other threads. */
+
+#define TREE_DEPTH 10
+#define TREE_FANOUT 3
+
+typedef struct TaskTreeData {
+	int depth;
+} TaskTreeData;
+
+static void task_tree_func(TaskPool *__restrict pool, void *taskdata, int thread_id)
+{
+	TaskTreeData *data = (TaskTreeData *)taskdata;
+	int *num_done = (int *)BLI_task_pool_userdata(pool);
+
+	atomic_add_and_fetch_int32(num_done, 1);
+
+	if (data->depth < TREE_DEPTH) {
+		for (int i = 0; i < TREE_FANOUT; i++) {
+			TaskTreeData *child = (TaskTreeData *)MEM_mallocN(sizeof(*child), __func__);
+			child->depth = data->depth + 1;
+			BLI_task_pool_push_from_thread(pool, task_tree_func, child, true, TASK_PRIORITY_LOW, thread_id);
+		}
+	}
+}
+
+static int task_tree_num_tasks(void)
+{
+	int num_tasks = 0, level_tasks = 1;
+	for (int depth = 0; depth <= TREE_DEPTH; depth++) {
+		num_tasks += level_tasks;
+		level_tasks *= TREE_FANOUT;
+	}
+	return num_tasks;
+}
+
+static void task_tree_run(TaskScheduler *scheduler)
+{
+	int num_done = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &num_done);
+
+	TaskTreeData *root = (TaskTreeData *)MEM_mallocN(sizeof(*root), __func__);
+	root->depth = 0;
+	BLI_task_pool_push(pool, task_tree_func, root, true, TASK_PRIORITY_HIGH);
+
+	BLI_task_pool_work_and_wait(pool);
+	BLI_task_pool_free(pool);
+
+	EXPECT_EQ(num_done, task_tree_num_tasks());
+}
+
+TEST(task, PoolNestedPushSingleThread)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create(TASK_SCHEDULER_SINGLE_THREAD);
+	task_tree_run(scheduler);
+	BLI_task_scheduler_free(scheduler);
+}
+
+TEST(task, PoolNestedPushWorkStealing)
+{
+	/* More threads than cores is fine here, we want to stress stealing. */
+	TaskScheduler *scheduler = BLI_task_scheduler_create(8);
+	for (int i = 0; i < 10; i++) {
+		task_tree_run(scheduler);
+	}
+	BLI_task_scheduler_free(scheduler);
+}
+
+static void task_cancel_func(TaskPool *__restrict pool, void *UNUSED(taskdata), int thread_id)
+{
+	int *num_done = (int *)BLI_task_pool_userdata(pool);
+	atomic_add_and_fetch_int32(num_done, 1);
+	for (int i = 0; i < 2; i++) {
+		BLI_task_pool_push_from_thread(pool, task_cancel_func, NULL, false, TASK_PRIORITY_LOW, thread_id);
+	}
+}
+
+TEST(task, PoolCancelWorkStealing)
+{
+	TaskScheduler *scheduler = BLI_task_scheduler_create(8);
+	int num_done = 0;
+	TaskPool *pool = BLI_task_pool_create(scheduler, &num_done);
+
+	/* Endless tasks tree, only cancel stops it. */
+	BLI_task_pool_push(pool, task_cancel_func, NULL, false, TASK_PRIORITY_HIGH);
+	while (atomic_add_and_fetch_int32(&num_done, 0) < 10000) {
+		/* Pass. */
+	}
+	BLI_task_pool_cancel(pool);
+
+	/* Nothing is to be run after cancel. */
+	const int num_done_cancel = num_done;
+	BLI_task_pool_work_and_wait(pool);
+	EXPECT_EQ(num_done, num_done_cancel);
+
+	BLI_task_pool_free(pool);
+	BLI_task_scheduler_free(scheduler);
+}
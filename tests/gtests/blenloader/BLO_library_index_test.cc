@@ -0,0 +1,200 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <set>
+#include <string>
+#include <string.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_linklist.h"
+#include "BLI_path_util.h"
+#include "BLI_string.h"
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+#include "DNA_genfile.h"
+#include "DNA_ID.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_sdna_types.h"
+#include "DNA_userdef_types.h"
+#include "intern/readfile.h"
+}
+
+#define TOT_VERT 1000
+
+/* Library files are written with meshes, then listed through a blend handle
+ * like the file browser does, which keeps an index next to the file. */
+
+class LibraryIndexTest : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+		BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), "library_index_test.blend");
+		BLI_snprintf(index_filepath, sizeof(index_filepath), "%s.idx", filepath);
+		BLI_delete(filepath, false, false);
+		BLI_delete(index_filepath, false, false);
+
+		userflag_orig = U.flag;
+		U.flag |= USER_LIBRARY_INDEX;
+
+		bmain = BKE_main_new();
+		mesh_a = BKE_mesh_add(bmain, "Alpha");
+		mesh_b = BKE_mesh_add(bmain, "Beta");
+	}
+
+	virtual void TearDown()
+	{
+		BKE_main_free(bmain);
+		U.flag = userflag_orig;
+
+		BLI_delete(filepath, false, false);
+		BLI_delete(index_filepath, false, false);
+		BKE_tempdir_session_purge();
+		DNA_sdna_current_free();
+	}
+
+	bool write_file()
+	{
+		return BLO_write_file(bmain, filepath, 0, NULL, NULL);
+	}
+
+	std::set<std::string> mesh_names()
+	{
+		std::set<std::string> names;
+		BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+		if (bh == NULL) {
+			return names;
+		}
+
+		int tot_names;
+		LinkNode *linknames = BLO_blendhandle_get_datablock_names(bh, ID_ME, &tot_names);
+		for (LinkNode *link = linknames; link; link = link->next) {
+			names.insert((const char *)link->link);
+		}
+		EXPECT_EQ(tot_names, names.size());
+
+		BLI_linklist_free(linknames, free);
+		BLO_blendhandle_close(bh);
+		return names;
+	}
+
+	bool index_is_valid()
+	{
+		FileData *fd = blo_bhead_index_read(filepath, NULL);
+		if (fd == NULL) {
+			return false;
+		}
+		blo_freefiledata(fd);
+		return true;
+	}
+
+	char filepath[FILE_MAX];
+	char index_filepath[FILE_MAX];
+	int userflag_orig;
+	Main *bmain;
+	Mesh *mesh_a, *mesh_b;
+};
+
+TEST_F(LibraryIndexTest, WriteAndReuse)
+{
+	ASSERT_TRUE(write_file());
+	EXPECT_FALSE(BLI_exists(index_filepath));
+	EXPECT_FALSE(index_is_valid());
+
+	/* Listing the file writes the index. */
+	std::set<std::string> names = mesh_names();
+	EXPECT_EQ(2, names.size());
+	EXPECT_EQ(1, names.count("Alpha"));
+	EXPECT_EQ(1, names.count("Beta"));
+	EXPECT_TRUE(BLI_exists(index_filepath));
+	EXPECT_TRUE(index_is_valid());
+
+	/* Listing again uses the index, and gives the same names. */
+	EXPECT_EQ(names, mesh_names());
+	EXPECT_TRUE(index_is_valid());
+}
+
+TEST_F(LibraryIndexTest, InvalidateOnSave)
+{
+	ASSERT_TRUE(write_file());
+	mesh_names();
+	ASSERT_TRUE(index_is_valid());
+
+	/* Renaming to a name of the same length keeps the file size,
+	 * saving again right away may keep the modification time in seconds. */
+	BLI_strncpy(mesh_b->id.name + 2, "Beto", sizeof(mesh_b->id.name) - 2);
+	ASSERT_TRUE(write_file());
+	EXPECT_FALSE(index_is_valid());
+
+	std::set<std::string> names = mesh_names();
+	EXPECT_EQ(2, names.size());
+	EXPECT_EQ(1, names.count("Alpha"));
+	EXPECT_EQ(1, names.count("Beto"));
+	EXPECT_TRUE(index_is_valid());
+}
+
+TEST_F(LibraryIndexTest, IgnoredWhenDisabled)
+{
+	U.flag &= ~USER_LIBRARY_INDEX;
+
+	ASSERT_TRUE(write_file());
+	EXPECT_EQ(2, mesh_names().size());
+	EXPECT_FALSE(BLI_exists(index_filepath));
+}
+
+TEST_F(LibraryIndexTest, LinkMeshData)
+{
+	mesh_a->mvert = (MVert *)CustomData_add_layer(&mesh_a->vdata, CD_MVERT, CD_CALLOC, NULL, TOT_VERT);
+	mesh_a->totvert = TOT_VERT;
+	for (int i = 0; i < TOT_VERT; i++) {
+		mesh_a->mvert[i].co[0] = (float)i;
+		mesh_a->mvert[i].co[1] = -(float)i;
+		mesh_a->mvert[i].co[2] = (float)(i % 7);
+	}
+	ASSERT_TRUE(write_file());
+	mesh_names();
+	ASSERT_TRUE(index_is_valid());
+
+	/* Link the mesh into another file, linking uses G.main for relative paths. */
+	Main *bmain_link = BKE_main_new();
+	BLI_join_dirfile(bmain_link->name, sizeof(bmain_link->name), BKE_tempdir_base(), "library_index_link.blend");
+	Main *gmain = G.main;
+	G.main = bmain_link;
+
+	BlendHandle *bh = BLO_blendhandle_from_file(filepath, NULL);
+	ASSERT_TRUE(bh != NULL);
+	/* Opened from the index, all block data is read from the file at the stored offsets. */
+	const FileData *fd = (const FileData *)bh;
+	EXPECT_TRUE(fd->flags & FD_FLAGS_READ_ON_DEMAND);
+	EXPECT_FALSE(fd->flags & FD_FLAGS_FILE_DATA_MMAP);
+
+	Main *mainl = BLO_library_link_begin(bmain_link, &bh, filepath);
+	const Mesh *me = (const Mesh *)BLO_library_link_named_part(mainl, &bh, ID_ME, "Alpha");
+	EXPECT_TRUE(me != NULL);
+	BLO_library_link_end(mainl, &bh, 0, NULL, NULL);
+	if (bh) {
+		BLO_blendhandle_close(bh);
+	}
+	G.main = gmain;
+
+	if (me) {
+		EXPECT_TRUE(ID_IS_LINKED(me));
+		ASSERT_EQ(TOT_VERT, me->totvert);
+		ASSERT_TRUE(me->mvert != NULL);
+		EXPECT_EQ(0, memcmp(mesh_a->mvert, me->mvert, sizeof(MVert) * TOT_VERT));
+	}
+
+	BKE_main_free(bmain_link);
+}
@@ -0,0 +1,197 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <fcntl.h>
+#include <string.h>
+#include <vector>
+
+#ifndef WIN32
+#  include <unistd.h>
+#else
+#  include <io.h>
+#endif
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_global.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_sdna_types.h"
+#include "intern/readfile.h"
+}
+
+#ifdef WITH_LZO
+
+/* Large enough to be split in several chunks. */
+#define TOT_VERT 100000
+
+/* Files are saved with chunked LZO compression, then loaded back,
+ * or damaged on purpose to check corrupt files are refused. */
+
+class LZOCompressTest : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+		BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), "lzo_compress_test.blend");
+		BLI_join_dirfile(filepath_damaged, sizeof(filepath_damaged), BKE_tempdir_base(), "lzo_compress_damaged.blend");
+
+		bmain = BKE_main_new();
+		Mesh *me = BKE_mesh_add(bmain, "Grid");
+		me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, TOT_VERT);
+		me->totvert = TOT_VERT;
+		for (int i = 0; i < TOT_VERT; i++) {
+			me->mvert[i].co[0] = (float)(i % 100);
+			me->mvert[i].co[1] = (float)(i / 100);
+		}
+	}
+
+	virtual void TearDown()
+	{
+		BKE_main_free(bmain);
+		BLI_delete(filepath, false, false);
+		BLI_delete(filepath_damaged, false, false);
+		BKE_tempdir_session_purge();
+		DNA_sdna_current_free();
+	}
+
+	std::vector<unsigned char> write_file()
+	{
+		std::vector<unsigned char> contents;
+		if (!BLO_write_file(bmain, filepath, G_FILE_COMPRESS | G_FILE_COMPRESS_LZO, NULL, NULL)) {
+			return contents;
+		}
+		FILE *file = BLI_fopen(filepath, "rb");
+		unsigned char buf[4096];
+		size_t len;
+		while ((len = fread(buf, 1, sizeof(buf), file)) > 0) {
+			contents.insert(contents.end(), buf, buf + len);
+		}
+		fclose(file);
+		return contents;
+	}
+
+	/* Decompress \a contents written to a file, NULL when refused. */
+	char *decompress(const std::vector<unsigned char> &contents, size_t *r_size)
+	{
+		FILE *file = BLI_fopen(filepath_damaged, "wb");
+		fwrite(contents.data(), 1, contents.size(), file);
+		fclose(file);
+
+		int filedes = BLI_open(filepath_damaged, O_BINARY | O_RDONLY, 0);
+		char *data = blo_lzo_decompress_file(filedes, contents.size(), r_size);
+		close(filedes);
+		return data;
+	}
+
+	char filepath[FILE_MAX];
+	char filepath_damaged[FILE_MAX];
+	Main *bmain;
+};
+
+static uint32_t chunk_uint32(const std::vector<unsigned char> &contents, size_t pos)
+{
+	return ((uint32_t)contents[pos]) | ((uint32_t)contents[pos + 1] << 8) |
+	       ((uint32_t)contents[pos + 2] << 16) | ((uint32_t)contents[pos + 3] << 24);
+}
+
+TEST_F(LZOCompressTest, SaveLoad)
+{
+	std::vector<unsigned char> contents = write_file();
+	ASSERT_GT(contents.size(), BLEN_LZO_MAGIC_LEN);
+	EXPECT_EQ(0, memcmp(contents.data(), BLEN_LZO_MAGIC, BLEN_LZO_MAGIC_LEN));
+	/* Vertices compress well. */
+	EXPECT_LT(contents.size(), sizeof(MVert) * TOT_VERT / 2);
+
+	BlendFileData *bfd = BLO_read_from_file(filepath, NULL, BLO_READ_SKIP_USERDEF);
+	ASSERT_TRUE(bfd != NULL);
+	ASSERT_EQ(1, BLI_listbase_count(&bfd->main->mesh));
+	const Mesh *me = (const Mesh *)bfd->main->mesh.first;
+	const Mesh *me_orig = (const Mesh *)bmain->mesh.first;
+	EXPECT_STREQ(me_orig->id.name, me->id.name);
+	ASSERT_EQ(TOT_VERT, me->totvert);
+	for (int i = 0; i < TOT_VERT; i++) {
+		EXPECT_EQ(0, memcmp(me_orig->mvert[i].co, me->mvert[i].co, sizeof(float[3])));
+	}
+	BLO_blendfiledata_free(bfd);
+}
+
+TEST_F(LZOCompressTest, Truncated)
+{
+	std::vector<unsigned char> contents = write_file();
+	ASSERT_GT(contents.size(), BLEN_LZO_MAGIC_LEN + BLEN_LZO_CHUNK_HEADER_LEN * 2);
+
+	size_t size, data_size;
+	char *data = decompress(contents, &data_size);
+	ASSERT_TRUE(data != NULL);
+	MEM_freeN(data);
+
+	/* In the first chunk header, in the first chunk data, and without the end chunk. */
+	const size_t sizes[] = {
+	    BLEN_LZO_MAGIC_LEN + 4,
+	    BLEN_LZO_MAGIC_LEN + BLEN_LZO_CHUNK_HEADER_LEN + 16,
+	    contents.size() / 2,
+	    contents.size() - BLEN_LZO_CHUNK_HEADER_LEN,
+	};
+	for (int i = 0; i < ARRAY_SIZE(sizes); i++) {
+		std::vector<unsigned char> truncated(contents.begin(), contents.begin() + sizes[i]);
+		EXPECT_TRUE(decompress(truncated, &size) == NULL) << "truncated at " << sizes[i];
+	}
+
+	/* Loading reports the error instead of reading the file. */
+	std::vector<unsigned char> truncated(contents.begin(), contents.begin() + contents.size() / 2);
+	FILE *file = BLI_fopen(filepath, "wb");
+	fwrite(truncated.data(), 1, truncated.size(), file);
+	fclose(file);
+	EXPECT_TRUE(BLO_read_from_file(filepath, NULL, BLO_READ_SKIP_USERDEF) == NULL);
+}
+
+TEST_F(LZOCompressTest, CorruptChunk)
+{
+	std::vector<unsigned char> contents = write_file();
+	const size_t header = BLEN_LZO_MAGIC_LEN;
+	ASSERT_GT(contents.size(), header + BLEN_LZO_CHUNK_HEADER_LEN);
+
+	const uint32_t raw_len = chunk_uint32(contents, header);
+	const uint32_t data_len = chunk_uint32(contents, header + 4);
+	/* The first chunk is compressed. */
+	ASSERT_LT(data_len, raw_len);
+
+	size_t size;
+	std::vector<unsigned char> corrupt;
+
+	/* Stored data larger than its uncompressed size. */
+	corrupt = contents;
+	corrupt[header + 4] = corrupt[header];
+	corrupt[header + 5] = corrupt[header + 1];
+	corrupt[header + 6] = corrupt[header + 2];
+	corrupt[header + 7] = (unsigned char)(corrupt[header + 3] + 1);
+	EXPECT_TRUE(decompress(corrupt, &size) == NULL);
+
+	/* Uncompressed size that doesn't match the data. */
+	corrupt = contents;
+	corrupt[header] ^= 0x01;
+	EXPECT_TRUE(decompress(corrupt, &size) == NULL);
+
+	/* Compressed data overwritten. */
+	corrupt = contents;
+	memset(&corrupt[header + BLEN_LZO_CHUNK_HEADER_LEN], 0xff, data_len);
+	EXPECT_TRUE(decompress(corrupt, &size) == NULL);
+}
+
+#endif  /* WITH_LZO */
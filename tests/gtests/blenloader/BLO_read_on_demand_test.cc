@@ -0,0 +1,167 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_fileops.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BLO_blend_defs.h"
+#include "BLO_readfile.h"
+#include "BLO_writefile.h"
+#include "DNA_genfile.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_sdna_types.h"
+#include "intern/readfile.h"
+}
+
+#define TOT_VERT 1000
+
+/* Uncompressed files opened without memory mapping read their block data on demand,
+ * this must give the same data as reading the whole file. */
+
+class ReadOnDemandTest : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+		BLI_join_dirfile(filepath, sizeof(filepath), BKE_tempdir_base(), "read_on_demand_test.blend");
+
+		bmain = BKE_main_new();
+		for (int i = 0; i < 2; i++) {
+			Mesh *me = BKE_mesh_add(bmain, i ? "Beta" : "Alpha");
+			me->mvert = (MVert *)CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, TOT_VERT);
+			me->totvert = TOT_VERT;
+			for (int j = 0; j < TOT_VERT; j++) {
+				me->mvert[j].co[0] = (float)i;
+				me->mvert[j].co[1] = (float)j;
+				me->mvert[j].co[2] = -(float)j;
+			}
+		}
+		ASSERT_TRUE(BLO_write_file(bmain, filepath, 0, NULL, NULL));
+	}
+
+	virtual void TearDown()
+	{
+		BKE_main_free(bmain);
+		BLI_delete(filepath, false, false);
+		BKE_tempdir_session_purge();
+		DNA_sdna_current_free();
+	}
+
+	char filepath[FILE_MAX];
+	Main *bmain;
+};
+
+TEST_F(ReadOnDemandTest, BlockData)
+{
+	FileData *fd = blo_openblenderfile(filepath, NULL);
+	FileData *fd_demand = blo_openblenderfile_read_on_demand(filepath, NULL);
+	ASSERT_TRUE(fd != NULL);
+	ASSERT_TRUE(fd_demand != NULL);
+	EXPECT_FALSE(fd->flags & FD_FLAGS_READ_ON_DEMAND);
+	ASSERT_TRUE(fd_demand->flags & FD_FLAGS_READ_ON_DEMAND);
+
+	BHead *bhead_first_data = NULL;
+	void *data_first = NULL;
+	int tot_on_demand = 0;
+
+	BHead *bhead = blo_firstbhead(fd);
+	BHead *bhead_demand = blo_firstbhead(fd_demand);
+	for (; bhead && bhead_demand;
+	     bhead = blo_nextbhead(fd, bhead), bhead_demand = blo_nextbhead(fd_demand, bhead_demand))
+	{
+		ASSERT_EQ(bhead->code, bhead_demand->code);
+		ASSERT_EQ(bhead->len, bhead_demand->len);
+		EXPECT_EQ(bhead->SDNAnr, bhead_demand->SDNAnr);
+		EXPECT_EQ(bhead->nr, bhead_demand->nr);
+		EXPECT_EQ(bhead->old, bhead_demand->old);
+		if (bhead->code == ENDB) {
+			break;
+		}
+
+		const void *data = blo_bhead_data(bhead);
+		ASSERT_TRUE(data != NULL);
+
+		void *buf = MEM_mallocN(MAX2(bhead->len, 1), __func__);
+		if (blo_bhead_data(bhead_demand) == NULL) {
+			tot_on_demand++;
+		}
+		ASSERT_TRUE(blo_bhead_read_data(fd_demand, bhead_demand, buf));
+		EXPECT_EQ(0, memcmp(data, buf, (size_t)bhead->len)) << "block code " << bhead->code;
+		MEM_freeN(buf);
+
+		if (bhead->code == DATA) {
+			if (bhead_first_data == NULL) {
+				bhead_first_data = bhead_demand;
+				data_first = MEM_mallocN(bhead->len, __func__);
+				memcpy(data_first, data, (size_t)bhead->len);
+			}
+			else {
+				/* Reading back an earlier block must not move the position for the following headers. */
+				buf = MEM_mallocN(bhead_first_data->len, __func__);
+				ASSERT_TRUE(blo_bhead_read_data(fd_demand, bhead_first_data, buf));
+				EXPECT_EQ(0, memcmp(data_first, buf, (size_t)bhead_first_data->len));
+				MEM_freeN(buf);
+			}
+		}
+	}
+	EXPECT_TRUE(bhead != NULL);
+	EXPECT_TRUE(bhead_demand != NULL);
+	EXPECT_TRUE(bhead_demand == NULL || blo_nextbhead(fd_demand, bhead_demand) == NULL);
+	/* At least the vertices of both meshes. */
+	EXPECT_GE(tot_on_demand, 2);
+
+	if (data_first) {
+		MEM_freeN(data_first);
+	}
+	blo_freefiledata(fd);
+	blo_freefiledata(fd_demand);
+}
+
+TEST_F(ReadOnDemandTest, ReadFile)
+{
+	BlendFileData *bfd = BLO_read_from_file(filepath, NULL, BLO_READ_SKIP_USERDEF);
+	ASSERT_TRUE(bfd != NULL);
+
+	/* Same as #BLO_read_from_file, read_struct() reads all data blocks on demand. */
+	FileData *fd_demand = blo_openblenderfile_read_on_demand(filepath, NULL);
+	ASSERT_TRUE(fd_demand != NULL);
+	ASSERT_TRUE(fd_demand->flags & FD_FLAGS_READ_ON_DEMAND);
+	fd_demand->skip_flags = BLO_READ_SKIP_USERDEF;
+	BlendFileData *bfd_demand = blo_read_file_internal(fd_demand, filepath);
+	blo_freefiledata(fd_demand);
+	ASSERT_TRUE(bfd_demand != NULL);
+
+	ASSERT_EQ(2, BLI_listbase_count(&bfd->main->mesh));
+	ASSERT_EQ(2, BLI_listbase_count(&bfd_demand->main->mesh));
+	const Mesh *me_orig = (const Mesh *)bmain->mesh.first;
+	const Mesh *me = (const Mesh *)bfd->main->mesh.first;
+	const Mesh *me_demand = (const Mesh *)bfd_demand->main->mesh.first;
+	for (; me_orig; me_orig = (const Mesh *)me_orig->id.next, me = (const Mesh *)me->id.next,
+	     me_demand = (const Mesh *)me_demand->id.next)
+	{
+		EXPECT_STREQ(me_orig->id.name, me_demand->id.name);
+		ASSERT_EQ(TOT_VERT, me->totvert);
+		ASSERT_EQ(TOT_VERT, me_demand->totvert);
+		ASSERT_TRUE(me_demand->mvert != NULL);
+		EXPECT_EQ(0, memcmp(me->mvert, me_demand->mvert, sizeof(MVert) * TOT_VERT));
+		for (int i = 0; i < TOT_VERT; i++) {
+			EXPECT_EQ(0, memcmp(me_orig->mvert[i].co, me_demand->mvert[i].co, sizeof(float[3])));
+		}
+	}
+
+	BLO_blendfiledata_free(bfd);
+	BLO_blendfiledata_free(bfd_demand);
+}
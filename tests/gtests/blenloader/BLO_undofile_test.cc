@@ -0,0 +1,138 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <string.h>
+#include <vector>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_array_store.h"
+#include "BLI_listbase.h"
+#include "BLI_path_util.h"
+#include "BKE_appdir.h"
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "BLO_readfile.h"
+#include "BLO_undofile.h"
+#include "BLO_writefile.h"
+#include "DNA_genfile.h"
+#include "DNA_listBase.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+}
+
+#define TOT_VERT 10000
+#define TOT_STEP 4
+
+/* Undo steps are written to memfiles sharing an array store, read back on undo,
+ * merged when the oldest step is removed and freed when undo is cleared. */
+
+class MemFileUndoTest : public ::testing::Test {
+protected:
+	virtual void SetUp()
+	{
+		DNA_sdna_current_init();
+		BKE_tempdir_init(NULL);
+
+		bmain = BKE_main_new();
+		BLI_join_dirfile(bmain->name, sizeof(bmain->name), BKE_tempdir_base(), "undofile_test.blend");
+		mesh = BKE_mesh_add(bmain, "Grid");
+		mesh->mvert = (MVert *)CustomData_add_layer(&mesh->vdata, CD_MVERT, CD_CALLOC, NULL, TOT_VERT);
+		mesh->totvert = TOT_VERT;
+		for (int i = 0; i < TOT_VERT; i++) {
+			mesh->mvert[i].co[0] = (float)(i % 100);
+			mesh->mvert[i].co[1] = (float)(i / 100);
+		}
+		memset(memfiles, 0, sizeof(memfiles));
+	}
+
+	virtual void TearDown()
+	{
+		for (int i = 0; i < TOT_STEP; i++) {
+			BLO_memfile_free(&memfiles[i]);
+		}
+		BKE_main_free(bmain);
+		BKE_tempdir_session_purge();
+		DNA_sdna_current_free();
+	}
+
+	/* Write undo step \a step, after moving vertex \a step (like editing the mesh). */
+	void push(int step)
+	{
+		mesh->mvert[step].co[2] = (float)(step + 1);
+		EXPECT_TRUE(BLO_write_file_mem(bmain, step ? &memfiles[step - 1] : NULL, &memfiles[step], 0));
+		verts[step].assign(mesh->mvert, mesh->mvert + TOT_VERT);
+	}
+
+	/* Read undo step \a step back, like undo does, and compare it with the mesh that was written. */
+	void undo_check(int step)
+	{
+		Main *bmain_undo = BLO_memfile_main_get(&memfiles[step], bmain, NULL);
+		ASSERT_TRUE(bmain_undo != NULL);
+		ASSERT_EQ(1, BLI_listbase_count(&bmain_undo->mesh));
+		const Mesh *me = (const Mesh *)bmain_undo->mesh.first;
+		EXPECT_STREQ(mesh->id.name, me->id.name);
+		EXPECT_EQ(TOT_VERT, me->totvert);
+		if (me->totvert == TOT_VERT) {
+			EXPECT_EQ(0, memcmp(verts[step].data(), me->mvert, sizeof(MVert) * TOT_VERT)) << "undo step " << step;
+		}
+		BKE_main_free(bmain_undo);
+	}
+
+	Main *bmain;
+	Mesh *mesh;
+	MemFile memfiles[TOT_STEP];
+	std::vector<MVert> verts[TOT_STEP];
+};
+
+TEST_F(MemFileUndoTest, PushUndoMergeFree)
+{
+	EXPECT_TRUE(BLO_memfile_arraystore_get() == NULL);
+
+	for (int step = 0; step < TOT_STEP; step++) {
+		push(step);
+	}
+	BArrayStore *bs = BLO_memfile_arraystore_get();
+	ASSERT_TRUE(bs != NULL);
+	EXPECT_TRUE(BLI_array_store_is_valid(bs));
+
+	/* Only the changed data is stored again. */
+	EXPECT_GT(memfiles[0].size, sizeof(MVert) * TOT_VERT);
+	for (int step = 1; step < TOT_STEP; step++) {
+		EXPECT_LT(memfiles[step].size, memfiles[0].size / 4) << "undo step " << step;
+	}
+
+	/* Undo to each step, then redo. */
+	for (int step = TOT_STEP - 1; step >= 0; step--) {
+		undo_check(step);
+	}
+	undo_check(TOT_STEP - 1);
+
+	/* Remove the oldest steps like the undo stack does, the others still read back. */
+	for (int step = 1; step < TOT_STEP - 1; step++) {
+		BLO_memfile_merge(&memfiles[step - 1], &memfiles[step]);
+		EXPECT_TRUE(BLO_memfile_arraystore_get() == bs);
+		EXPECT_TRUE(BLI_array_store_is_valid(bs));
+		for (int step_check = step; step_check < TOT_STEP; step_check++) {
+			undo_check(step_check);
+		}
+	}
+
+	/* Freeing the last step frees the store. */
+	BLO_memfile_free(&memfiles[TOT_STEP - 2]);
+	EXPECT_TRUE(BLO_memfile_arraystore_get() == bs);
+	undo_check(TOT_STEP - 1);
+	BLO_memfile_free(&memfiles[TOT_STEP - 1]);
+	EXPECT_TRUE(BLO_memfile_arraystore_get() == NULL);
+
+	/* A new undo stack creates the store again. */
+	push(0);
+	EXPECT_TRUE(BLO_memfile_arraystore_get() != NULL);
+	undo_check(0);
+	BLO_memfile_free(&memfiles[0]);
+	EXPECT_TRUE(BLO_memfile_arraystore_get() == NULL);
+}
@@ -37,3 +37,41 @@ TEST(bmesh_core, BMVertCreate) {
 	EXPECT_EQ(BM_mesh_elem_count(bm, BM_VERT), 3);
 	BM_mesh_free(bm);
 }
+
+TEST(bmesh_core, BMDataColumns) {
+	BMesh *bm;
+	BMVert *verts[3];
+	BMDataColumns *columns;
+	float *column;
+
+	BMeshCreateParams bm_params;
+	bm_params.use_toolflags = false;
+	bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_INT);
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_FLT);
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_FLT);
+	for (int i = 0; i < 3; i++) {
+		verts[i] = BM_vert_create(bm, NULL, NULL, BM_CREATE_NOP);
+		BM_elem_float_data_set(&bm->vdata, verts[i], CD_PROP_FLT, (float)i);
+	}
+	/* only the float layers */
+	columns = BM_data_columns_create(bm, BM_VERT, CD_MASK_PROP_FLT);
+	EXPECT_EQ(BM_data_columns_len(columns), 3);
+	EXPECT_TRUE(BM_data_columns_layer_get(columns, CD_PROP_INT) == NULL);
+	EXPECT_TRUE(BM_data_columns_layer_get_n(columns, CD_PROP_FLT, 1) != NULL);
+	EXPECT_TRUE(BM_data_columns_layer_get_n(columns, CD_PROP_FLT, 2) == NULL);
+	column = (float *)BM_data_columns_layer_get(columns, CD_PROP_FLT);
+	ASSERT_TRUE(column != NULL);
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(column[BM_elem_index_get(verts[i])], (float)i);
+		column[BM_elem_index_get(verts[i])] = (float)(i * 2);
+	}
+	/* blocks are only written on flush */
+	EXPECT_EQ(BM_elem_float_data_get(&bm->vdata, verts[2], CD_PROP_FLT), 2.0f);
+	BM_data_columns_flush(bm, columns);
+	BM_data_columns_free(columns);
+	for (int i = 0; i < 3; i++) {
+		EXPECT_EQ(BM_elem_float_data_get(&bm->vdata, verts[i], CD_PROP_FLT), (float)(i * 2));
+	}
+	BM_mesh_free(bm);
+}
@@ -0,0 +1,106 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_threads.h"
+#include "BKE_customdata.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "PIL_time.h"
+#include "bmesh.h"
+}
+
+#define NUM_RUNS 5
+
+/* Times BMesh <-> Mesh conversion of grids, the way edit-mode enter and exit use it. */
+
+static BMesh *bm_grid_create(const int size)
+{
+	BMeshCreateParams bm_params = {0};
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * size * size, __func__);
+
+	/* Typical custom-data: UV's, a color layer and crease. */
+	BM_data_layer_add(bm, &bm->pdata, CD_MTEXPOLY);
+	BM_data_layer_add(bm, &bm->ldata, CD_MLOOPUV);
+	BM_data_layer_add(bm, &bm->ldata, CD_MLOOPCOL);
+	BM_data_layer_add(bm, &bm->edata, CD_CREASE);
+
+	for (int y = 0, i = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, i++) {
+			const float co[3] = {(float)x, (float)y, 0.0f};
+			verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+		}
+	}
+	for (int y = 0; y < size - 1; y++) {
+		for (int x = 0; x < size - 1; x++) {
+			BMVert *quad[4] = {
+			    verts[y * size + x], verts[y * size + x + 1],
+			    verts[(y + 1) * size + x + 1], verts[(y + 1) * size + x]};
+			BM_face_create_verts(bm, quad, 4, NULL, BM_CREATE_NOP, true);
+		}
+	}
+
+	MEM_freeN(verts);
+	return bm;
+}
+
+static void mesh_conv_bench(Main *bmain, const int size)
+{
+	Mesh *me = BKE_mesh_add(bmain, "Bench");
+	BMesh *bm = bm_grid_create(size);
+	double time_from_best = 0.0, time_to_best = 0.0;
+
+	BMeshToMeshParams to_params = {0};
+	BM_mesh_bm_to_me(bm, me, &to_params);
+	BM_mesh_free(bm);
+
+	for (int run = 0; run < NUM_RUNS; run++) {
+		BMeshCreateParams create_params = {0};
+		BMeshFromMeshParams from_params = {0};
+		from_params.calc_face_normal = true;
+
+		bm = BM_mesh_create(&bm_mesh_allocsize_default, &create_params);
+
+		double time_start = PIL_check_seconds_timer();
+		BM_mesh_bm_from_me(bm, me, &from_params);
+		const double time_from = PIL_check_seconds_timer() - time_start;
+
+		time_start = PIL_check_seconds_timer();
+		BM_mesh_bm_to_me(bm, me, &to_params);
+		const double time_to = PIL_check_seconds_timer() - time_start;
+
+		BM_mesh_free(bm);
+
+		if (run == 0 || time_from < time_from_best) {
+			time_from_best = time_from;
+		}
+		if (run == 0 || time_to < time_to_best) {
+			time_to_best = time_to;
+		}
+	}
+
+	printf("%-10d %-10d %-14.4f %-14.4f\n", me->totvert, me->totpoly, time_from_best, time_to_best);
+}
+
+TEST(bmesh_mesh_conv, Performance)
+{
+	BLI_threadapi_init();
+	Main *bmain = BKE_main_new();
+
+	printf("\n========== STARTING MeshConversion ==========\n");
+	printf("Verts      Faces      From Mesh (sec) To Mesh (sec)\n");
+	mesh_conv_bench(bmain, 64);
+	mesh_conv_bench(bmain, 256);
+	mesh_conv_bench(bmain, 1024);
+	printf("========== ENDED MeshConversion ==========\n\n");
+
+	BKE_main_free(bmain);
+	BLI_threadapi_exit();
+}
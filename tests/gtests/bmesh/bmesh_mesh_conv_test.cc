@@ -0,0 +1,341 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "BKE_customdata.h"
+#include "BKE_deform.h"
+#include "BKE_global.h"
+#include "BKE_key.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "BKE_mesh.h"
+#include "DNA_key_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "bmesh.h"
+}
+
+/* Grid of quads with some custom-data on every element type. */
+static BMesh *bm_grid_create(const int size)
+{
+	BMeshCreateParams bm_params = {0};
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * size * size, __func__);
+
+	BM_data_layer_add(bm, &bm->vdata, CD_MDEFORMVERT);
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_FLT);
+	BM_data_layer_add(bm, &bm->vdata, CD_PROP_FLT);
+	BM_data_layer_add(bm, &bm->vdata, CD_BWEIGHT);
+	BM_data_layer_add(bm, &bm->edata, CD_CREASE);
+	BM_data_layer_add(bm, &bm->ldata, CD_MLOOPCOL);
+	BM_data_layer_add(bm, &bm->pdata, CD_PROP_INT);
+
+	const int cd_dvert_offset = CustomData_get_offset(&bm->vdata, CD_MDEFORMVERT);
+	const int cd_flt_offset = CustomData_get_n_offset(&bm->vdata, CD_PROP_FLT, 1);
+	const int cd_bweight_offset = CustomData_get_offset(&bm->vdata, CD_BWEIGHT);
+	const int cd_crease_offset = CustomData_get_offset(&bm->edata, CD_CREASE);
+	const int cd_mloopcol_offset = CustomData_get_offset(&bm->ldata, CD_MLOOPCOL);
+	const int cd_int_offset = CustomData_get_offset(&bm->pdata, CD_PROP_INT);
+
+	for (int y = 0, i = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, i++) {
+			const float co[3] = {(float)x, (float)y, 0.0f};
+			BMVert *v = verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+			if (i % 3 == 0) {
+				defvert_add_index_notest((MDeformVert *)BM_ELEM_CD_GET_VOID_P(v, cd_dvert_offset), i % 4, 0.25f);
+			}
+			BM_ELEM_CD_SET_FLOAT(v, cd_flt_offset, (float)i);
+			BM_ELEM_CD_SET_FLOAT(v, cd_bweight_offset, (float)(i % 5) / 4.0f);
+		}
+	}
+	for (int y = 0; y < size - 1; y++) {
+		for (int x = 0; x < size - 1; x++) {
+			BMVert *quad[4] = {
+			    verts[y * size + x], verts[y * size + x + 1],
+			    verts[(y + 1) * size + x + 1], verts[(y + 1) * size + x]};
+			BMFace *f = BM_face_create_verts(bm, quad, 4, NULL, BM_CREATE_NOP, true);
+			BM_ELEM_CD_SET_INT(f, cd_int_offset, x * y);
+			BMLoop *l_iter, *l_first;
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				MLoopCol *mloopcol = (MLoopCol *)BM_ELEM_CD_GET_VOID_P(l_iter, cd_mloopcol_offset);
+				mloopcol->r = (unsigned char)x;
+				mloopcol->g = (unsigned char)y;
+			} while ((l_iter = l_iter->next) != l_first);
+		}
+	}
+	BMEdge *e;
+	BMIter iter;
+	int i;
+	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
+		BM_ELEM_CD_SET_FLOAT(e, cd_crease_offset, (float)(i % 3) / 2.0f);
+	}
+
+	MEM_freeN(verts);
+	return bm;
+}
+
+static void bm_to_mesh(BMesh *bm, Mesh *me)
+{
+	BMeshToMeshParams params = {0};
+	BM_mesh_bm_to_me(bm, me, &params);
+}
+
+static BMesh *bm_from_mesh(Mesh *me)
+{
+	BMeshCreateParams create_params = {0};
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &create_params);
+	BMeshFromMeshParams params = {0};
+	params.calc_face_normal = true;
+	BM_mesh_bm_from_me(bm, me, &params);
+	return bm;
+}
+
+/* Compare meshes, which are expected to be written from the same BMesh. */
+static void mesh_expect_equal(const Mesh *me_a, const Mesh *me_b)
+{
+	ASSERT_EQ(me_a->totvert, me_b->totvert);
+	ASSERT_EQ(me_a->totedge, me_b->totedge);
+	ASSERT_EQ(me_a->totloop, me_b->totloop);
+	ASSERT_EQ(me_a->totpoly, me_b->totpoly);
+	EXPECT_EQ(me_a->cd_flag, me_b->cd_flag);
+	for (int i = 0; i < me_a->totvert; i++) {
+		EXPECT_TRUE(equals_v3v3(me_a->mvert[i].co, me_b->mvert[i].co));
+		EXPECT_EQ(me_a->mvert[i].bweight, me_b->mvert[i].bweight);
+		EXPECT_EQ(me_a->dvert[i].totweight, me_b->dvert[i].totweight);
+		for (int j = 0; j < me_a->dvert[i].totweight; j++) {
+			EXPECT_EQ(me_a->dvert[i].dw[j].def_nr, me_b->dvert[i].dw[j].def_nr);
+			EXPECT_EQ(me_a->dvert[i].dw[j].weight, me_b->dvert[i].dw[j].weight);
+			/* Weights are copied, not shared. */
+			EXPECT_NE(me_a->dvert[i].dw, me_b->dvert[i].dw);
+		}
+	}
+	for (int i = 0; i < me_a->totedge; i++) {
+		EXPECT_EQ(me_a->medge[i].v1, me_b->medge[i].v1);
+		EXPECT_EQ(me_a->medge[i].v2, me_b->medge[i].v2);
+		EXPECT_EQ(me_a->medge[i].crease, me_b->medge[i].crease);
+	}
+	for (int i = 0; i < me_a->totloop; i++) {
+		EXPECT_EQ(me_a->mloop[i].v, me_b->mloop[i].v);
+		EXPECT_EQ(me_a->mloop[i].e, me_b->mloop[i].e);
+		EXPECT_EQ(me_a->mloopcol[i].r, me_b->mloopcol[i].r);
+		EXPECT_EQ(me_a->mloopcol[i].g, me_b->mloopcol[i].g);
+	}
+	for (int i = 0; i < me_a->totpoly; i++) {
+		EXPECT_EQ(me_a->mpoly[i].loopstart, me_b->mpoly[i].loopstart);
+		EXPECT_EQ(me_a->mpoly[i].totloop, me_b->mpoly[i].totloop);
+	}
+	for (int type = CD_PROP_FLT; type <= CD_PROP_INT; type++) {
+		const CustomData *data_a = (type == CD_PROP_FLT) ? &me_a->vdata : &me_a->pdata;
+		const CustomData *data_b = (type == CD_PROP_FLT) ? &me_b->vdata : &me_b->pdata;
+		const int totelem = (type == CD_PROP_FLT) ? me_a->totvert : me_a->totpoly;
+		const int totlayer = CustomData_number_of_layers(data_a, type);
+		ASSERT_EQ(totlayer, CustomData_number_of_layers(data_b, type));
+		for (int n = 0; n < totlayer; n++) {
+			const void *layer_a = CustomData_get_layer_n(data_a, type, n);
+			const void *layer_b = CustomData_get_layer_n(data_b, type, n);
+			EXPECT_EQ(memcmp(layer_a, layer_b, (size_t)totelem * CustomData_sizeof(type)), 0);
+		}
+	}
+}
+
+/* Compare element order, flags and disk/radial cycles, expects valid indices in both meshes. */
+static void bm_expect_topology_equal(BMesh *bm_a, BMesh *bm_b)
+{
+	ASSERT_EQ(bm_a->totvert, bm_b->totvert);
+	ASSERT_EQ(bm_a->totedge, bm_b->totedge);
+	ASSERT_EQ(bm_a->totloop, bm_b->totloop);
+	ASSERT_EQ(bm_a->totface, bm_b->totface);
+	EXPECT_EQ(bm_a->totvertsel, bm_b->totvertsel);
+	EXPECT_EQ(bm_a->totedgesel, bm_b->totedgesel);
+	EXPECT_EQ(bm_a->totfacesel, bm_b->totfacesel);
+
+	BM_mesh_elem_table_ensure(bm_a, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm_b, BM_VERT | BM_EDGE | BM_FACE);
+
+	for (int i = 0; i < bm_a->totvert; i++) {
+		BMVert *v_a = bm_a->vtable[i], *v_b = bm_b->vtable[i];
+		EXPECT_EQ(BM_elem_index_get(v_b), i);
+		EXPECT_EQ(v_a->head.hflag, v_b->head.hflag);
+		ASSERT_EQ(v_a->e == NULL, v_b->e == NULL);
+		if (v_a->e == NULL) {
+			continue;
+		}
+		BMEdge *e_a = v_a->e, *e_b = v_b->e;
+		do {
+			ASSERT_EQ(BM_elem_index_get(e_a), BM_elem_index_get(e_b));
+			ASSERT_EQ(BM_elem_index_get(BM_DISK_EDGE_PREV(e_a, v_a)), BM_elem_index_get(BM_DISK_EDGE_PREV(e_b, v_b)));
+			e_b = BM_DISK_EDGE_NEXT(e_b, v_b);
+		} while ((e_a = BM_DISK_EDGE_NEXT(e_a, v_a)) != v_a->e);
+		EXPECT_EQ(e_b, v_b->e);
+	}
+	for (int i = 0; i < bm_a->totedge; i++) {
+		BMEdge *e_a = bm_a->etable[i], *e_b = bm_b->etable[i];
+		EXPECT_EQ(BM_elem_index_get(e_b), i);
+		/* Edge draw flag depends on face angles when writing the mesh. */
+		EXPECT_EQ(e_a->head.hflag & ~BM_ELEM_DRAW, e_b->head.hflag & ~BM_ELEM_DRAW);
+		ASSERT_EQ(e_a->l == NULL, e_b->l == NULL);
+		if (e_a->l == NULL) {
+			continue;
+		}
+		BMLoop *l_a = e_a->l, *l_b = e_b->l;
+		do {
+			ASSERT_EQ(BM_elem_index_get(l_a->f), BM_elem_index_get(l_b->f));
+			ASSERT_EQ(BM_elem_index_get(l_a->radial_prev->f), BM_elem_index_get(l_b->radial_prev->f));
+			l_b = l_b->radial_next;
+		} while ((l_a = l_a->radial_next) != e_a->l);
+		EXPECT_EQ(l_b, e_b->l);
+	}
+	for (int i = 0; i < bm_a->totface; i++) {
+		BMFace *f_a = bm_a->ftable[i], *f_b = bm_b->ftable[i];
+		EXPECT_EQ(BM_elem_index_get(f_b), i);
+		EXPECT_EQ(f_a->head.hflag, f_b->head.hflag);
+		EXPECT_EQ(f_a->mat_nr, f_b->mat_nr);
+		ASSERT_EQ(f_a->len, f_b->len);
+		EXPECT_TRUE(equals_v3v3(f_a->no, f_b->no));
+		BMLoop *l_a = BM_FACE_FIRST_LOOP(f_a), *l_b = BM_FACE_FIRST_LOOP(f_b);
+		for (int j = 0; j < f_a->len; j++, l_a = l_a->next, l_b = l_b->next) {
+			EXPECT_EQ(BM_elem_index_get(l_a->v), BM_elem_index_get(l_b->v));
+			EXPECT_EQ(BM_elem_index_get(l_a->e), BM_elem_index_get(l_b->e));
+			EXPECT_EQ(l_b->f, f_b);
+			EXPECT_EQ(l_b->prev->next, l_b);
+		}
+	}
+}
+
+TEST(bmesh_mesh_conv, RoundTrip)
+{
+	Main *bmain = BKE_main_new();
+	Mesh *me_a = BKE_mesh_add(bmain, "A");
+	Mesh *me_b = BKE_mesh_add(bmain, "B");
+
+	BMesh *bm = bm_grid_create(32);
+	bm_to_mesh(bm, me_a);
+	BM_mesh_free(bm);
+
+	EXPECT_EQ(me_a->totvert, 32 * 32);
+	EXPECT_EQ(me_a->totpoly, 31 * 31);
+	EXPECT_EQ(((const float *)CustomData_get_layer_n(&me_a->vdata, CD_PROP_FLT, 1))[100], 100.0f);
+	EXPECT_EQ(defvert_find_weight(&me_a->dvert[3], 3), 0.25f);
+	EXPECT_EQ(me_a->medge[4].crease, 127);
+	EXPECT_EQ(me_a->mloopcol[33 * 4].r, 2);
+	EXPECT_EQ(me_a->mloopcol[33 * 4].g, 1);
+	EXPECT_EQ(((const int *)CustomData_get_layer(&me_a->pdata, CD_PROP_INT))[33], 2);
+
+	/* Mesh -> BMesh -> Mesh keeps all data. */
+	bm = bm_from_mesh(me_a);
+	bm_to_mesh(bm, me_b);
+	BM_mesh_free(bm);
+	mesh_expect_equal(me_a, me_b);
+
+	BKE_main_free(bmain);
+}
+
+TEST(bmesh_mesh_conv, ShapeKeys)
+{
+	const int size = 8;
+
+	Main *bmain = BKE_main_new();
+	Mesh *me = BKE_mesh_add(bmain, "A");
+
+	BMesh *bm = bm_grid_create(size);
+	bm_to_mesh(bm, me);
+	BM_mesh_free(bm);
+
+	/* Keys are added to the global main. */
+	Main *bmain_orig = G.main;
+	G.main = bmain;
+	me->key = BKE_key_add(&me->id);
+	me->key->type = KEY_RELATIVE;
+	KeyBlock *kb_basis = BKE_keyblock_add_ctime(me->key, "Basis", false);
+	BKE_keyblock_convert_from_mesh(me, kb_basis);
+	KeyBlock *kb_up = BKE_keyblock_add_ctime(me->key, "Up", false);
+	BKE_keyblock_convert_from_mesh(me, kb_up);
+	for (int i = 0; i < me->totvert; i++) {
+		((float (*)[3])kb_up->data)[i][2] = 1.0f;
+	}
+
+	/* Edit the basis, the offset is propagated to the key relative to it. */
+	BMeshCreateParams create_params = {0};
+	bm = BM_mesh_create(&bm_mesh_allocsize_default, &create_params);
+	BMeshFromMeshParams params = {0};
+	params.active_shapekey = 1;
+	params.use_shapekey = true;
+	BM_mesh_bm_from_me(bm, me, &params);
+	BMVert *v;
+	BMIter iter;
+	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
+		v->co[0] += 2.0f;
+	}
+	bm_to_mesh(bm, me);
+
+	/* Converting again keeps the offset, it was written back into the BMesh. */
+	bm_to_mesh(bm, me);
+	BM_mesh_free(bm);
+
+	ASSERT_EQ(kb_basis->totelem, size * size);
+	ASSERT_EQ(kb_up->totelem, size * size);
+	for (int i = 0; i < me->totvert; i++) {
+		const float co[3] = {(float)(i % size) + 2.0f, (float)(i / size), 0.0f};
+		const float co_up[3] = {co[0], co[1], 1.0f};
+		EXPECT_TRUE(equals_v3v3(me->mvert[i].co, co));
+		EXPECT_TRUE(equals_v3v3(((float (*)[3])kb_basis->data)[i], co));
+		EXPECT_TRUE(equals_v3v3(((float (*)[3])kb_up->data)[i], co_up));
+	}
+
+	G.main = bmain_orig;
+	BKE_main_free(bmain);
+}
+
+TEST(bmesh_mesh_conv, Topology)
+{
+	/* Large enough to be converted in parallel. */
+	const int size = 128;
+
+	BLI_threadapi_init();
+
+	Main *bmain = BKE_main_new();
+	Mesh *me = BKE_mesh_add(bmain, "A");
+
+	BMesh *bm_a = bm_grid_create(size);
+	BMFace *f;
+	BMEdge *e;
+	BMIter iter;
+	int i;
+	BM_ITER_MESH_INDEX (e, &iter, bm_a, BM_EDGES_OF_MESH, i) {
+		if (i % 7 == 0) {
+			BM_elem_flag_enable(e, BM_ELEM_HIDDEN);
+		}
+		else if (i % 11 == 0) {
+			BM_edge_select_set(bm_a, e, true);
+		}
+	}
+	BM_ITER_MESH_INDEX (f, &iter, bm_a, BM_FACES_OF_MESH, i) {
+		f->mat_nr = (short)(i % 3);
+		if (i % 5 == 0) {
+			BM_face_select_set(bm_a, f, true);
+		}
+		else if (i % 13 == 0) {
+			BM_elem_flag_enable(f, BM_ELEM_SMOOTH);
+		}
+		BM_face_normal_update(f);
+	}
+	BM_mesh_elem_index_ensure(bm_a, BM_ALL_NOLOOP);
+
+	bm_to_mesh(bm_a, me);
+	BMesh *bm_b = bm_from_mesh(me);
+
+	/* Same as creating the elements one by one. */
+	bm_expect_topology_equal(bm_a, bm_b);
+
+	BM_mesh_free(bm_a);
+	BM_mesh_free(bm_b);
+	BKE_main_free(bmain);
+
+	BLI_threadapi_exit();
+}
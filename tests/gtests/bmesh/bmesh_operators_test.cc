@@ -0,0 +1,200 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+#include <stdarg.h>
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_threads.h"
+#include "DNA_modifier_types.h"
+#include "bmesh.h"
+}
+
+/* The task scheduler can't be re-created once freed, share it between all tests. */
+class ThreadAPIEnvironment : public ::testing::Environment {
+public:
+	void SetUp() { BLI_threadapi_init(); }
+	void TearDown() { BLI_threadapi_exit(); }
+};
+
+static ::testing::Environment *const thread_env =
+        ::testing::AddGlobalTestEnvironment(new ThreadAPIEnvironment);
+
+/* Large enough for operators to use threads. */
+#define GRID_SIZE 160
+
+/* Grid of hexagons (pairs of quads), with some jitter so no corners are collinear. */
+static BMesh *bm_hex_grid_create(const int size, const float offset[3])
+{
+	BMeshCreateParams bm_params = {0};
+	bm_params.use_toolflags = true;
+	BMesh *bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+	BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * size * size, __func__);
+
+	for (int y = 0, i = 0; y < size; y++) {
+		for (int x = 0; x < size; x++, i++) {
+			const float jitter = (float)((i * 7919) % 101) / 500.0f;
+			float co[3] = {(float)x + jitter, (float)y - jitter, 0.0f};
+			add_v3_v3(co, offset);
+			verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+		}
+	}
+	for (int y = 0; y < size - 1; y++) {
+		for (int x = 0; x + 2 < size; x += 2) {
+			BMVert *hex[6] = {
+			    verts[y * size + x], verts[y * size + x + 1], verts[y * size + x + 2],
+			    verts[(y + 1) * size + x + 2], verts[(y + 1) * size + x + 1], verts[(y + 1) * size + x]};
+			BM_face_create_verts(bm, hex, 6, NULL, BM_CREATE_NOP, true);
+		}
+	}
+
+	MEM_freeN(verts);
+	BM_mesh_normals_update(bm);
+	return bm;
+}
+
+/* Run an operator, optionally ignoring that it may use threads. */
+static void bmo_call_ex(BMesh *bm, const bool use_threading, const char *fmt, ...)
+{
+	BMOperator op;
+	va_list list;
+
+	va_start(list, fmt);
+	ASSERT_TRUE(BMO_op_vinitf(bm, &op, BMO_FLAG_DEFAULTS, fmt, list));
+	va_end(list);
+
+	if (!use_threading) {
+		op.type_flag = (BMOpTypeFlag)(op.type_flag & ~BMO_OPTYPE_FLAG_THREADED);
+	}
+	BMO_op_exec(bm, &op);
+	BMO_op_finish(bm, &op);
+}
+
+static void bm_expect_equal(BMesh *bm_a, BMesh *bm_b)
+{
+	BMIter iter_a, iter_b;
+	BMVert *v_a, *v_b;
+	BMFace *f_a, *f_b;
+
+	ASSERT_EQ(bm_a->totvert, bm_b->totvert);
+	ASSERT_EQ(bm_a->totedge, bm_b->totedge);
+	ASSERT_EQ(bm_a->totface, bm_b->totface);
+
+	BM_mesh_elem_index_ensure(bm_a, BM_VERT);
+	BM_mesh_elem_index_ensure(bm_b, BM_VERT);
+
+	v_b = (BMVert *)BM_iter_new(&iter_b, bm_b, BM_VERTS_OF_MESH, NULL);
+	BM_ITER_MESH (v_a, &iter_a, bm_a, BM_VERTS_OF_MESH) {
+		EXPECT_TRUE(equals_v3v3(v_a->co, v_b->co));
+		v_b = (BMVert *)BM_iter_step(&iter_b);
+	}
+
+	f_b = (BMFace *)BM_iter_new(&iter_b, bm_b, BM_FACES_OF_MESH, NULL);
+	BM_ITER_MESH (f_a, &iter_a, bm_a, BM_FACES_OF_MESH) {
+		ASSERT_EQ(f_a->len, f_b->len);
+		BMLoop *l_a = BM_FACE_FIRST_LOOP(f_a), *l_b = BM_FACE_FIRST_LOOP(f_b);
+		for (int i = 0; i < f_a->len; i++, l_a = l_a->next, l_b = l_b->next) {
+			EXPECT_EQ(BM_elem_index_get(l_a->v), BM_elem_index_get(l_b->v));
+		}
+		f_b = (BMFace *)BM_iter_step(&iter_b);
+	}
+}
+
+TEST(bmesh_operators, TriangulateThreaded)
+{
+	const float offset[3] = {0.0f, 0.0f, 0.0f};
+	BMesh *bm_a = bm_hex_grid_create(GRID_SIZE, offset);
+	BMesh *bm_b = bm_hex_grid_create(GRID_SIZE, offset);
+	const int totface = bm_a->totface;
+
+	bmo_call_ex(bm_a, false, "triangulate faces=%af quad_method=%i ngon_method=%i",
+	            MOD_TRIANGULATE_QUAD_BEAUTY, MOD_TRIANGULATE_NGON_BEAUTY);
+	bmo_call_ex(bm_b, true, "triangulate faces=%af quad_method=%i ngon_method=%i",
+	            MOD_TRIANGULATE_QUAD_BEAUTY, MOD_TRIANGULATE_NGON_BEAUTY);
+
+	/* Every hexagon becomes 4 triangles. */
+	EXPECT_EQ(bm_b->totface, totface * 4);
+	bm_expect_equal(bm_a, bm_b);
+
+	BM_mesh_free(bm_a);
+	BM_mesh_free(bm_b);
+}
+
+TEST(bmesh_operators, RecalcFaceNormalsThreaded)
+{
+	BMesh *bm_pair[2];
+	for (int i = 0; i < 2; i++) {
+		/* Two islands, flip some faces of both. */
+		const float offset_a[3] = {0.0f, 0.0f, 0.0f};
+		const float offset_b[3] = {0.0f, 0.0f, 10.0f};
+		BMesh *bm = bm_hex_grid_create(GRID_SIZE, offset_a);
+		BMesh *bm_other = bm_hex_grid_create(GRID_SIZE / 2, offset_b);
+		BMVert **verts = (BMVert **)MEM_mallocN(sizeof(*verts) * bm_other->totvert, __func__);
+		BMIter iter;
+		BMVert *v;
+		BMFace *f;
+		int j;
+		BM_ITER_MESH_INDEX (v, &iter, bm_other, BM_VERTS_OF_MESH, j) {
+			verts[j] = BM_vert_create(bm, v->co, NULL, BM_CREATE_NOP);
+			BM_elem_index_set(v, j);  /* set_inline */
+		}
+		BM_ITER_MESH (f, &iter, bm_other, BM_FACES_OF_MESH) {
+			BMVert *f_verts[6];
+			BMLoop *l = BM_FACE_FIRST_LOOP(f);
+			for (int k = 0; k < 6; k++, l = l->next) {
+				f_verts[k] = verts[BM_elem_index_get(l->v)];
+			}
+			BM_face_create_verts(bm, f_verts, 6, NULL, BM_CREATE_NOP, true);
+		}
+		MEM_freeN(verts);
+		BM_mesh_free(bm_other);
+
+		BM_ITER_MESH_INDEX (f, &iter, bm, BM_FACES_OF_MESH, j) {
+			if (j % 3 == 0) {
+				BM_face_normal_flip(bm, f);
+			}
+		}
+		BM_mesh_normals_update(bm);
+		bm_pair[i] = bm;
+	}
+
+	bmo_call_ex(bm_pair[0], false, "recalc_face_normals faces=%af");
+	bmo_call_ex(bm_pair[1], true, "recalc_face_normals faces=%af");
+
+	/* Flat islands (one at Z=0, one above), all faces of each island point the same way. */
+	float island_sign[2] = {0.0f, 0.0f};
+	BMIter iter;
+	BMFace *f;
+	BM_ITER_MESH (f, &iter, bm_pair[1], BM_FACES_OF_MESH) {
+		const int island = (f->l_first->v->co[2] == 0.0f) ? 0 : 1;
+		EXPECT_GT(fabsf(f->no[2]), 0.5f);
+		if (island_sign[island] == 0.0f) {
+			island_sign[island] = signf(f->no[2]);
+		}
+		EXPECT_EQ(island_sign[island], signf(f->no[2]));
+	}
+	bm_expect_equal(bm_pair[0], bm_pair[1]);
+
+	BM_mesh_free(bm_pair[0]);
+	BM_mesh_free(bm_pair[1]);
+}
+
+TEST(bmesh_operators, SmoothVertThreaded)
+{
+	const float offset[3] = {0.0f, 0.0f, 0.0f};
+	BMesh *bm_a = bm_hex_grid_create(GRID_SIZE, offset);
+	BMesh *bm_b = bm_hex_grid_create(GRID_SIZE, offset);
+
+	bmo_call_ex(bm_a, false, "smooth_vert verts=%av factor=%f use_axis_x=%b use_axis_y=%b use_axis_z=%b",
+	            0.5f, true, true, false);
+	bmo_call_ex(bm_b, true, "smooth_vert verts=%av factor=%f use_axis_x=%b use_axis_y=%b use_axis_z=%b",
+	            0.5f, true, true, false);
+
+	bm_expect_equal(bm_a, bm_b);
+
+	BM_mesh_free(bm_a);
+	BM_mesh_free(bm_b);
+}
@@ -0,0 +1,201 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+#include "BLI_string.h"
+#include "BLI_task.h"
+#include "BLI_threads.h"
+#include "BKE_library.h"
+#include "BKE_main.h"
+#include "DNA_ID.h"
+#include "PIL_time.h"
+}
+
+#include "DEG_depsgraph.h"
+
+#include "intern/builder/deg_builder.h"
+#include "intern/depsgraph.h"
+#include "intern/eval/deg_eval_flush.h"
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_id.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#define NUM_RUNS 5
+
+/* Update flush of synthetic graphs, single threaded and threaded.
+ *
+ * Every ID of the graph has a single component with a chain of operations,
+ * relations between IDs go from the last operation of one chain to the first
+ * operation of another one.
+ */
+
+struct FlushBenchGraph {
+	DEG::Depsgraph *graph;
+	ID *ids;
+	int num_ids;
+	DEG::vector<DEG::OperationDepsNode *> first_operations;
+	DEG::vector<DEG::OperationDepsNode *> last_operations;
+};
+
+static void flush_bench_graph_create(FlushBenchGraph *bench_graph,
+                                     const int num_ids,
+                                     const int num_id_operations)
+{
+	DEG::Depsgraph *graph = (DEG::Depsgraph *)DEG_graph_new();
+	bench_graph->graph = graph;
+	bench_graph->ids = (ID *)MEM_callocN(sizeof(ID) * num_ids, __func__);
+	bench_graph->num_ids = num_ids;
+	for (int i = 0; i < num_ids; i++) {
+		ID *id = &bench_graph->ids[i];
+		BLI_snprintf(id->name, sizeof(id->name), "ME%d", i);
+		DEG::IDDepsNode *id_node = graph->add_id_node(id, id->name + 2);
+		DEG::ComponentDepsNode *comp_node =
+		        id_node->add_component(DEG::DEG_NODE_TYPE_PARAMETERS);
+		DEG::OperationDepsNode *prev_op = NULL;
+		for (int j = 0; j < num_id_operations; j++) {
+			DEG::OperationDepsNode *op = comp_node->add_operation(
+			        NULL, DEG::DEG_OPCODE_PARAMETERS_EVAL, "", j);
+			graph->operations.push_back(op);
+			if (prev_op != NULL) {
+				graph->add_new_relation(prev_op, op, "Chain");
+			}
+			else {
+				bench_graph->first_operations.push_back(op);
+			}
+			prev_op = op;
+		}
+		bench_graph->last_operations.push_back(prev_op);
+	}
+}
+
+static void flush_bench_graph_add_relation(FlushBenchGraph *bench_graph,
+                                           const int from,
+                                           const int to)
+{
+	bench_graph->graph->add_new_relation(bench_graph->last_operations[from],
+	                                     bench_graph->first_operations[to],
+	                                     "Dependency");
+}
+
+static void flush_bench_graph_free(FlushBenchGraph *bench_graph)
+{
+	DEG_graph_free((Depsgraph *)bench_graph->graph);
+	MEM_freeN(bench_graph->ids);
+}
+
+/* Returns time of the fastest flush. */
+static double flush_bench_run(Main *bmain,
+                              FlushBenchGraph *bench_graph,
+                              const bool use_threading,
+                              DEG::vector<uint8_t> *r_needs_update)
+{
+	DEG::Depsgraph *graph = bench_graph->graph;
+	double best_time = 0.0;
+	for (int run = 0; run < NUM_RUNS; run++) {
+		bench_graph->first_operations[0]->tag_update(graph);
+		const double start_time = PIL_check_seconds_timer();
+		DEG::deg_graph_flush_updates_ex(bmain, graph, use_threading);
+		const double time = PIL_check_seconds_timer() - start_time;
+		if (run == 0 || time < best_time) {
+			best_time = time;
+		}
+		*r_needs_update = graph->compiled.needs_update;
+		DEG::deg_graph_clear_tags(graph);
+	}
+	return best_time;
+}
+
+static void flush_bench(const char *name, FlushBenchGraph *bench_graph)
+{
+	Main *bmain = BKE_main_new();
+	DEG::deg_graph_build_finalize(bench_graph->graph);
+
+	DEG::vector<uint8_t> needs_update_serial, needs_update_threaded;
+	const double time_serial = flush_bench_run(
+	        bmain, bench_graph, false, &needs_update_serial);
+	const double time_threaded = flush_bench_run(
+	        bmain, bench_graph, true, &needs_update_threaded);
+
+	/* Both ways of flushing tag exactly the same operations. */
+	EXPECT_TRUE(needs_update_serial == needs_update_threaded);
+	int num_tagged = 0;
+	for (size_t i = 0; i < needs_update_serial.size(); i++) {
+		num_tagged += needs_update_serial[i];
+	}
+
+	printf("%-8s %-12d %-12d %-14.6f %-14.6f %.2f\n",
+	       name,
+	       (int)bench_graph->graph->operations.size(),
+	       num_tagged,
+	       time_serial,
+	       time_threaded,
+	       time_serial / time_threaded);
+
+	BKE_main_free(bmain);
+}
+
+/* Single root, all other IDs depend on it directly. */
+static void flush_bench_wide(const int num_ids)
+{
+	FlushBenchGraph bench_graph;
+	flush_bench_graph_create(&bench_graph, num_ids, 4);
+	for (int i = 1; i < num_ids; i++) {
+		flush_bench_graph_add_relation(&bench_graph, 0, i);
+	}
+	flush_bench("Wide", &bench_graph);
+	flush_bench_graph_free(&bench_graph);
+}
+
+/* Layers of IDs, every ID depends on two IDs of the previous layer. */
+static void flush_bench_deep(const int width, const int depth)
+{
+	FlushBenchGraph bench_graph;
+	flush_bench_graph_create(&bench_graph, width * depth, 4);
+	for (int layer = 1; layer < depth; layer++) {
+		for (int i = 0; i < width; i++) {
+			const int to = layer * width + i;
+			flush_bench_graph_add_relation(&bench_graph, to - width, to);
+			flush_bench_graph_add_relation(
+			        &bench_graph, (layer - 1) * width + (i + 1) % width, to);
+		}
+	}
+	/* Single root, so the flush reaches the whole graph. */
+	for (int i = 1; i < width; i++) {
+		flush_bench_graph_add_relation(&bench_graph, 0, i);
+	}
+	flush_bench("Deep", &bench_graph);
+	flush_bench_graph_free(&bench_graph);
+}
+
+/* Long chain of IDs. */
+static void flush_bench_chain(const int num_ids)
+{
+	FlushBenchGraph bench_graph;
+	flush_bench_graph_create(&bench_graph, num_ids, 4);
+	for (int i = 1; i < num_ids; i++) {
+		flush_bench_graph_add_relation(&bench_graph, i - 1, i);
+	}
+	flush_bench("Chain", &bench_graph);
+	flush_bench_graph_free(&bench_graph);
+}
+
+TEST(depsgraph_flush, ThreadedFlush)
+{
+	BLI_threadapi_init();
+	DEG_register_node_types();
+
+	printf("\n========== STARTING ThreadedFlush ==========\n");
+	printf("Graph    Operations   Tagged       Serial (sec)   Threaded (sec) Speedup\n");
+	flush_bench_wide(50000);
+	flush_bench_deep(1000, 50);
+	flush_bench_chain(20000);
+	printf("========== ENDED ThreadedFlush ==========\n\n");
+
+	DEG_free_node_types();
+	BLI_threadapi_exit();
+}
@@ -0,0 +1,126 @@
+# ##### BEGIN GPL LICENSE BLOCK #####
+#
+#  This program is free software; you can redistribute it and/or
+#  modify it under the terms of the GNU General Public License
+#  as published by the Free Software Foundation; either version 2
+#  of the License, or (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software Foundation,
+#  Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+#
+# ##### END GPL LICENSE BLOCK #####
+
+# <pep8 compliant>
+
+"""
+Times saving and loading a large scene, uncompressed, gzip and fast (chunked LZO) compressed.
+
+Example Usage:
+
+./blender.bin --background --factory-startup \
+    --python tests/python/bl_blendfile_io_performance.py -- \
+    --subdivisions=1000 --objects=8 --runs=5
+
+To time an existing file instead of a generated scene:
+
+./blender.bin --background --factory-startup /path/to/file.blend \
+    --python tests/python/bl_blendfile_io_performance.py -- \
+    --no-generate
+"""
+
+import os
+import sys
+import tempfile
+import time
+
+import bpy
+
+COMPRESS_MODES = (
+    # name, compress, compress_fast
+    ("none", False, False),
+    ("gzip", True, False),
+    ("fast", True, True),
+)
+
+
+def generate_scene(subdivisions, objects):
+    # Dense grids, so mesh data dominates the file size.
+    for i in range(objects):
+        bpy.ops.mesh.primitive_grid_add(
+            x_subdivisions=subdivisions,
+            y_subdivisions=subdivisions,
+            location=(i * 3.0, 0.0, 0.0),
+        )
+
+
+def time_best(func, runs):
+    best = None
+    for _ in range(runs):
+        time_start = time.time()
+        func()
+        time_elapsed = time.time() - time_start
+        if best is None or time_elapsed < best:
+            best = time_elapsed
+    return best
+
+
+def main():
+    import argparse
+
+    argv = sys.argv[sys.argv.index("--") + 1:] if "--" in sys.argv else []
+
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--subdivisions", type=int, default=1000, help="Grid subdivisions per object")
+    parser.add_argument("--objects", type=int, default=8, help="Number of grid objects to generate")
+    parser.add_argument("--runs", type=int, default=3, help="Number of runs, the fastest is reported")
+    parser.add_argument("--no-generate", dest="generate", action="store_false",
+                        help="Use the loaded file instead of generating a scene")
+    args = parser.parse_args(argv)
+
+    if args.generate:
+        generate_scene(args.subdivisions, args.objects)
+
+    temp_dir = tempfile.mkdtemp()
+    results = []
+
+    # Save all files first, loading replaces the scene.
+    filepaths = {}
+    for name, compress, compress_fast in COMPRESS_MODES:
+        filepath = os.path.join(temp_dir, "io_performance_%s.blend" % name)
+        filepaths[name] = filepath
+
+        def save():
+            bpy.ops.wm.save_as_mainfile(
+                filepath=filepath,
+                compress=compress,
+                compress_fast=compress_fast,
+                copy=True,
+            )
+        results.append([name, time_best(save, args.runs), 0.0, os.path.getsize(filepath)])
+
+    for result in results:
+        filepath = filepaths[result[0]]
+
+        def load():
+            bpy.ops.wm.open_mainfile(filepath=filepath, load_ui=False)
+        result[2] = time_best(load, args.runs)
+
+    print("\n========== Blend-file IO ==========")
+    print("Mode    Save (sec)  Load (sec)  Size (MB)")
+    for name, time_save, time_load, size in results:
+        print("%-7s %-11.4f %-11.4f %.2f" % (name, time_save, time_load, size / (1024.0 * 1024.0)))
+    print("===================================\n")
+
+    for filepath in filepaths.values():
+        os.remove(filepath)
+    os.rmdir(temp_dir)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,109 @@
+#!/usr/bin/env python3
+# Apache License, Version 2.0
+
+# Compare render performance of the BVH layouts of the Cycles CPU device.
+#
+# Renders every .blend file of the given directories (the Cycles render test
+# scenes are a good start) once per BVH layout and prints render time along
+# with camera samples per second, which is what ray traversal speed
+# translates to for the same scene and settings.
+#
+# ./cycles_bvh_benchmark.py --blender ./blender.bin --testdir ../lib/tests/cycles/ctests/mesh
+
+import argparse
+import os
+import re
+import subprocess
+import tempfile
+
+
+LAYOUTS = ("BVH4", "BVH8")
+
+SETUP_EXPR = (
+    "import bpy\n"
+    "bpy.app.debug_value = 256\n"
+    "scene = bpy.context.scene\n"
+    "scene.cycles.device = 'CPU'\n"
+    "scene.cycles.debug_bvh_layout = '{}'\n"
+    "render = scene.render\n"
+    "scale = render.resolution_percentage / 100.0\n"
+    "print('BENCHMARK_SAMPLES', int(render.resolution_x * scale) * "
+    "int(render.resolution_y * scale) * scene.cycles.samples)\n")
+
+
+def parse_time(text):
+    match = re.search(r"^\s*Time: (?:(\d+):)?(\d+):(\d+\.\d+)", text, re.MULTILINE)
+    if not match:
+        return None
+    hours = float(match.group(1) or 0)
+    return hours * 3600.0 + float(match.group(2)) * 60.0 + float(match.group(3))
+
+
+def render_file(blender, filepath, layout, output_dir):
+    command = [
+        blender,
+        "-b",
+        "-noaudio",
+        "--factory-startup",
+        "--enable-autoexec",
+        filepath,
+        "-E", "CYCLES",
+        "--python-expr", SETUP_EXPR.format(layout),
+        "-o", os.path.join(output_dir, "frame_"),
+        "-F", "PNG",
+        "-f", "1"]
+    try:
+        output = subprocess.check_output(command, stderr=subprocess.STDOUT)
+    except subprocess.CalledProcessError:
+        return None, None
+    output = output.decode("utf-8", "ignore")
+    match = re.search(r"^BENCHMARK_SAMPLES (\d+)", output, re.MULTILINE)
+    samples = int(match.group(1)) if match else None
+    return parse_time(output), samples
+
+
+def run_benchmark(blender, testdirs, num_runs):
+    output_dir = tempfile.mkdtemp()
+    totals = dict.fromkeys(LAYOUTS, 0.0)
+    print("{:<40} {:<6} {:>10} {:>14}".format("File", "Layout", "Time (s)", "Msamples/s"))
+    for testdir in testdirs:
+        for filename in sorted(os.listdir(testdir)):
+            if not filename.endswith(".blend"):
+                continue
+            filepath = os.path.join(testdir, filename)
+            for layout in LAYOUTS:
+                best_time, samples = None, None
+                for run in range(num_runs):
+                    time, samples = render_file(blender, filepath, layout, output_dir)
+                    if time is not None and (best_time is None or time < best_time):
+                        best_time = time
+                if best_time is None:
+                    print("{:<40} {:<6} {:>10}".format(filename, layout, "FAILED"))
+                    continue
+                totals[layout] += best_time
+                rate = (samples / best_time / 1e6) if samples else 0.0
+                print("{:<40} {:<6} {:>10.3f} {:>14.3f}".format(filename, layout, best_time, rate))
+    print("")
+    for layout in LAYOUTS:
+        print("Total {:<6} {:>10.3f}".format(layout, totals[layout]))
+    if totals[LAYOUTS[0]] > 0.0 and totals[LAYOUTS[1]] > 0.0:
+        print("Speedup {} over {}: {:.3f}x".format(
+            LAYOUTS[1], LAYOUTS[0], totals[LAYOUTS[0]] / totals[LAYOUTS[1]]))
+
+
+def create_argparse():
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--blender", required=True)
+    parser.add_argument("--testdir", required=True, nargs="+")
+    parser.add_argument("--runs", type=int, default=3)
+    return parser
+
+
+def main():
+    parser = create_argparse()
+    args = parser.parse_args()
+    run_benchmark(args.blender, args.testdir, args.runs)
+
+
+if __name__ == "__main__":
+    main()